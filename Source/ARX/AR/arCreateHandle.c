@@ -47,9 +47,15 @@
  *******************************************************/
 
 #include <ARX/AR/ar.h>
+#include "arLabelingBracket.h"
+#include "arLabelingBand.h"
+#include "arRefineCorners.h"
+#include <ARX/ARUtil/thread_sub.h>
 #include <stdio.h>
 #include <math.h>
 
+static void arRefineCornersInfoUpdate(ARHandle *handle);
+
 ARHandle *arCreateHandle(ARParamLT *paramLT)
 {
     ARHandle   *handle;
@@ -61,6 +67,10 @@ ARHandle *arCreateHandle(ARParamLT *paramLT)
     handle->labelInfo.bwImage       = NULL;
 #endif
     handle->arImageProcInfo         = NULL;
+    handle->arLabelingBracketInfo   = NULL;
+    handle->arLabelingThreadCount   = 1;
+    handle->arLabelingBandInfo      = NULL;
+    handle->arRefineCornersInfo     = NULL;
     handle->arPixelFormat           = AR_PIXEL_FORMAT_INVALID;
     handle->arPixelSize             = 0;
     handle->arLabelingMode          = AR_DEFAULT_LABELING_MODE;
@@ -84,7 +94,10 @@ ARHandle *arCreateHandle(ARParamLT *paramLT)
     handle->labelInfo.label_num = 0;
     handle->history_num         = 0;
 
-    arMalloc(handle->labelInfo.labelImage, AR_LABELING_LABEL_TYPE, handle->xsize*handle->ysize);
+    if (arLabelingInfoInit(&(handle->labelInfo), handle->xsize, handle->ysize) < 0) {
+        free(handle);
+        return NULL;
+    }
     
     handle->pattHandle = NULL;
     
@@ -95,6 +108,7 @@ ARHandle *arCreateHandle(ARParamLT *paramLT)
     handle->arLabelingThreshAutoAdaptiveBias = AR_LABELING_THRESH_ADAPTIVE_BIAS_DEFAULT;
     arSetLabelingThreshMode(handle, AR_LABELING_THRESH_MODE_DEFAULT);
     arSetLabelingThreshModeAutoInterval(handle, AR_LABELING_THRESH_AUTO_INTERVAL_DEFAULT);
+    arSetLabelingThreadCount(handle, AR_DEFAULT_LABELING_THREAD_COUNT);
     
     return handle;
 }
@@ -107,9 +121,21 @@ int arDeleteHandle(ARHandle *handle)
         arImageProcFinal(handle->arImageProcInfo);
         handle->arImageProcInfo = NULL;
     }
+    if (handle->arLabelingBracketInfo) {
+        arLabelingBracketFinal(handle->arLabelingBracketInfo);
+        handle->arLabelingBracketInfo = NULL;
+    }
+    if (handle->arLabelingBandInfo) {
+        arLabelingBandFinal(handle->arLabelingBandInfo);
+        handle->arLabelingBandInfo = NULL;
+    }
+    if (handle->arRefineCornersInfo) {
+        arRefineCornersFinal(handle->arRefineCornersInfo);
+        handle->arRefineCornersInfo = NULL;
+    }
     
     //if(handle->arParamLT != NULL) arParamLTFree(&handle->arParamLT);
-    free(handle->labelInfo.labelImage);
+    arLabelingInfoFinal(&(handle->labelInfo));
 #if !AR_DISABLE_LABELING_DEBUG_MODE
     if (handle->labelInfo.bwImage) free(handle->labelInfo.bwImage);
 #endif
@@ -190,6 +216,10 @@ void arSetLabelingThreshMode(ARHandle *handle, const AR_LABELING_THRESH_MODE mod
             arImageProcFinal(handle->arImageProcInfo);
             handle->arImageProcInfo = NULL;
         }
+        if (handle->arLabelingBracketInfo) {
+            arLabelingBracketFinal(handle->arLabelingBracketInfo);
+            handle->arLabelingBracketInfo = NULL;
+        }
 
         mode1 = mode;
         switch (mode) {
@@ -200,6 +230,7 @@ void arSetLabelingThreshMode(ARHandle *handle, const AR_LABELING_THRESH_MODE mod
                 break;
             case AR_LABELING_THRESH_MODE_AUTO_BRACKETING:
                 handle->arLabelingThreshAutoBracketOver = handle->arLabelingThreshAutoBracketUnder = 1;
+                handle->arLabelingBracketInfo = arLabelingBracketInit(handle->xsize, handle->ysize);
                 break;
             case AR_LABELING_THRESH_MODE_MANUAL:
                 break; // Do nothing.
@@ -236,6 +267,40 @@ void arSetLabelingThreshModeAutoInterval(ARHandle *handle, const int interval)
     handle->arLabelingThreshAutoIntervalTTL = 0;
 }
 
+void arSetLabelingThreadCount(ARHandle *handle, const int threadCount)
+{
+    int bandNum;
+
+    if (!handle) return;
+
+    if (threadCount == AR_LABELING_THREAD_COUNT_AUTO) {
+        bandNum = threadGetCPU();
+    } else if (threadCount >= 1) {
+        bandNum = threadCount;
+    } else {
+        ARLOGe("Invalid labeling thread count %d requested.\n", threadCount);
+        return;
+    }
+    if (bandNum > AR_LABELING_BAND_MAX) bandNum = AR_LABELING_BAND_MAX;
+
+    handle->arLabelingThreadCount = threadCount;
+    if (arLabelingBandGetBandNum(handle->arLabelingBandInfo) != bandNum) {
+        if (handle->arLabelingBandInfo) {
+            arLabelingBandFinal(handle->arLabelingBandInfo);
+            handle->arLabelingBandInfo = NULL;
+        }
+        if (bandNum > 1) handle->arLabelingBandInfo = arLabelingBandInit(handle->xsize, bandNum);
+    }
+    arRefineCornersInfoUpdate(handle);
+}
+
+int arGetLabelingThreadCount(const ARHandle *handle)
+{
+    if (!handle) return (AR_DEFAULT_LABELING_THREAD_COUNT);
+
+    return (handle->arLabelingThreadCount);
+}
+
 void arSetLabelingThreshAutoAdaptiveKernelSize(ARHandle *handle, const int labelingThreshAutoAdaptiveKernelSize)
 {
     if (!handle) return;
@@ -318,6 +383,7 @@ void arSetMatrixCodeType(ARHandle *handle, const AR_MATRIX_CODE_TYPE type)
     if (!handle) return;
 
     handle->matrixCodeType = type;
+    arPattBCHTableInit(type); // Returns -1 harmlessly for types that are not table-decoded.
 }
 
 AR_MATRIX_CODE_TYPE arGetMatrixCodeType(ARHandle *handle)
@@ -455,6 +521,27 @@ void arSetCornerRefinementMode(ARHandle *handle, int mode)
     }
     
     handle->arCornerRefinementMode = mode;
+    arRefineCornersInfoUpdate(handle);
+}
+
+// Corner refinement shares the labeling thread count, but only holds threads while it is enabled.
+static void arRefineCornersInfoUpdate(ARHandle *handle)
+{
+    int threadNum;
+
+    if (handle->arCornerRefinementMode == AR_CORNER_REFINEMENT_ENABLE) {
+        threadNum = arLabelingBandGetBandNum(handle->arLabelingBandInfo);
+        if (threadNum > AR_REFINE_CORNERS_THREAD_MAX) threadNum = AR_REFINE_CORNERS_THREAD_MAX;
+    } else {
+        threadNum = 1;
+    }
+    if (arRefineCornersGetThreadNum(handle->arRefineCornersInfo) == threadNum) return;
+
+    if (handle->arRefineCornersInfo) {
+        arRefineCornersFinal(handle->arRefineCornersInfo);
+        handle->arRefineCornersInfo = NULL;
+    }
+    if (threadNum > 1) handle->arRefineCornersInfo = arRefineCornersInit(threadNum);
 }
 
 void arSetAreaMax(ARHandle *handle, const ARdouble areaMax)
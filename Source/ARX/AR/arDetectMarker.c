@@ -39,7 +39,10 @@
 #include <stdio.h>
 #include <ARX/AR/ar.h>
 #include <ARX/AR/arImageProc.h>
+#include <ARX/ARUtil/stage_timing.h>
 #include "arRefineCorners.h"
+#include "arLabelingBracket.h"
+#include "arLabelingBand.h"
 #if DEBUG_PATT_GETID
 extern int cnt;
 #endif
@@ -89,12 +92,23 @@ cnt = 0;
             if (thresholds[1] < 0) thresholds[1] = 0;
             thresholds[2] = arHandle->arLabelingThresh;
             
-            for (i = 0; i < 3; i++) {
-                if (arLabeling(frame->buffLuma, arHandle->xsize, arHandle->ysize, arHandle->arDebug, arHandle->arLabelingMode, thresholds[i], arHandle->arImageProcMode, &(arHandle->labelInfo), NULL) < 0) return -1;
-                if (arDetectMarker2(arHandle->xsize, arHandle->ysize, &(arHandle->labelInfo), arHandle->arImageProcMode, arHandle->areaMax, arHandle->areaMin, arHandle->squareFitThresh, arHandle->markerInfo2, &(arHandle->marker2_num)) < 0) return -1;
-                if (arGetMarkerInfo(frame->buff, arHandle->xsize, arHandle->ysize, arHandle->arPixelFormat, arHandle->markerInfo2, arHandle->marker2_num, arHandle->pattHandle, arHandle->arImageProcMode, arHandle->arPatternDetectionMode, &(arHandle->arParamLT->paramLTf), arHandle->pattRatio, arHandle->markerInfo, &(arHandle->marker_num), arHandle->matrixCodeType) < 0) return -1;
-                marker_nums[i] = 0;
-                for (j = 0; j < arHandle->marker_num; j++) if (arHandle->markerInfo[j].idPatt != -1 || arHandle->markerInfo[j].idMatrix != -1) marker_nums[i]++;
+            if (arHandle->arLabelingBracketInfo) {
+                // Passes run concurrently, so can't be separated into stages. Report them all as labeling.
+                AR_STAGE_TIMING_BEGIN(AR_STAGE_SQUARE_LABELING);
+                if (arLabelingBracketDetect(arHandle->arLabelingBracketInfo, arHandle, frame, thresholds, marker_nums) < 0) return -1;
+                AR_STAGE_TIMING_END(AR_STAGE_SQUARE_LABELING);
+            } else {
+                for (i = 0; i < 3; i++) {
+                    AR_STAGE_TIMING_BEGIN(AR_STAGE_SQUARE_LABELING);
+                    if (arLabelingBanded(arHandle->arLabelingBandInfo, frame->buffLuma, arHandle->xsize, arHandle->ysize, arHandle->arDebug, arHandle->arLabelingMode, thresholds[i], arHandle->arImageProcMode, &(arHandle->labelInfo), NULL) < 0) return -1;
+                    AR_STAGE_TIMING_END(AR_STAGE_SQUARE_LABELING);
+                    AR_STAGE_TIMING_BEGIN(AR_STAGE_SQUARE_PATTERN_ID);
+                    if (arDetectMarker2(arHandle->xsize, arHandle->ysize, &(arHandle->labelInfo), arHandle->arImageProcMode, arHandle->areaMax, arHandle->areaMin, arHandle->squareFitThresh, arHandle->markerInfo2, &(arHandle->marker2_num)) < 0) return -1;
+                    if (arGetMarkerInfo(frame->buff, arHandle->xsize, arHandle->ysize, arHandle->arPixelFormat, arHandle->markerInfo2, arHandle->marker2_num, arHandle->pattHandle, arHandle->arImageProcMode, arHandle->arPatternDetectionMode, &(arHandle->arParamLT->paramLTf), arHandle->pattRatio, arHandle->markerInfo, &(arHandle->marker_num), arHandle->matrixCodeType) < 0) return -1;
+                    AR_STAGE_TIMING_END(AR_STAGE_SQUARE_PATTERN_ID);
+                    marker_nums[i] = 0;
+                    for (j = 0; j < arHandle->marker_num; j++) if (arHandle->markerInfo[j].idPatt != -1 || arHandle->markerInfo[j].idMatrix != -1) marker_nums[i]++;
+                }
             }
 
             if (arHandle->arDebug == AR_DEBUG_ENABLE) ARLOGe("Auto threshold (bracket) marker counts -[%3d: %3d] [%3d: %3d] [%3d: %3d]+.\n", thresholds[1], marker_nums[1], thresholds[2], marker_nums[2], thresholds[0], marker_nums[0]);
@@ -129,13 +143,14 @@ cnt = 0;
     }
     
     if (!detectionIsDone) {
+        AR_STAGE_TIMING_BEGIN(AR_STAGE_SQUARE_LABELING);
         if (arHandle->arLabelingThreshMode == AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE) {
             
             int ret;
             ret = arImageProcLumaHistAndBoxFilterWithBias(arHandle->arImageProcInfo, frame->buffLuma, arHandle->arLabelingThreshAutoAdaptiveKernelSize, arHandle->arLabelingThreshAutoAdaptiveBias);
             if (ret < 0) return (ret);
             
-            ret = arLabeling(frame->buffLuma, arHandle->arImageProcInfo->imageX, arHandle->arImageProcInfo->imageY,
+            ret = arLabelingBanded(arHandle->arLabelingBandInfo, frame->buffLuma, arHandle->arImageProcInfo->imageX, arHandle->arImageProcInfo->imageY,
                              arHandle->arDebug, arHandle->arLabelingMode,
                              0, AR_IMAGE_PROC_FRAME_IMAGE,
                              &(arHandle->labelInfo), arHandle->arImageProcInfo->image2);
@@ -159,7 +174,7 @@ cnt = 0;
                 }
             }
             
-            if( arLabeling(frame->buffLuma, arHandle->xsize, arHandle->ysize,
+            if( arLabelingBanded(arHandle->arLabelingBandInfo, frame->buffLuma, arHandle->xsize, arHandle->ysize,
                            arHandle->arDebug, arHandle->arLabelingMode,
                            arHandle->arLabelingThresh, arHandle->arImageProcMode,
                            &(arHandle->labelInfo), NULL) < 0 ) {
@@ -167,7 +182,9 @@ cnt = 0;
             }
             
         }
+        AR_STAGE_TIMING_END(AR_STAGE_SQUARE_LABELING);
         
+        AR_STAGE_TIMING_BEGIN(AR_STAGE_SQUARE_PATTERN_ID);
         if( arDetectMarker2( arHandle->xsize, arHandle->ysize,
                             &(arHandle->labelInfo), arHandle->arImageProcMode,
                             arHandle->areaMax, arHandle->areaMin, arHandle->squareFitThresh,
@@ -183,24 +200,13 @@ cnt = 0;
                             arHandle->matrixCodeType ) < 0 ) {
             return -1;
         }
+        AR_STAGE_TIMING_END(AR_STAGE_SQUARE_PATTERN_ID);
     } // !detectionIsDone
     
     if (arHandle->arCornerRefinementMode == AR_CORNER_REFINEMENT_ENABLE) {
         // Refine marker co-ordinates.
-        ARfloat obVertex[4][2];
-        for (int i = 0; i < 4; i++) {
-            float arXIn = (float)arHandle->markerInfo->vertex[i][0];
-            float arYIn = (float)arHandle->markerInfo->vertex[i][1];
-            arParamIdeal2ObservLTf(&arHandle->arParamLT->paramLTf, arXIn, arYIn, &obVertex[i][0], &obVertex[i][1]);
-        }
-        arRefineCorners((float (*)[2])obVertex, frame->buffLuma, arHandle->xsize, arHandle->ysize);
-        for (int i = 0; i < 4; i++) {
-            float newX, newY;
-            arParamObserv2IdealLTf(&arHandle->arParamLT->paramLTf, obVertex[i][0], obVertex[i][1], &newX, &newY);
-            arHandle->markerInfo->vertex[i][0] = (ARdouble)newX;
-            arHandle->markerInfo->vertex[i][1] = (ARdouble)newY;
-        }
-        //free(obVertex);
+        arRefineCornersMarkers(arHandle->arRefineCornersInfo, arHandle->markerInfo, arHandle->marker_num, &(arHandle->arParamLT->paramLTf),
+                               frame->buffLuma, arHandle->xsize, arHandle->ysize);
     }
     
     // If history mode is not enabled, just perform a basic confidence cutoff.
@@ -50,7 +50,59 @@
 #include <stdio.h>
 #include <ARX/AR/ar.h>
 #include <ARX/AR/config.h>
+#include <string.h> // memset()
 #include "arLabelingSub/arLabelingPrivate.h"
+#include "arLabelingBand.h"
+
+// A provisional label is only allocated at a pixel none of whose already-scanned 8-neighbours is labeled,
+// so no two provisional labels start at adjacent pixels. A w x h pixel area can therefore hold at most
+// ceil(w/2)*ceil(h/2) of them. The labeled area excludes the one-pixel border, and banded labeling
+// rounds up once per band, so allow for an extra half row of labels per band.
+int arLabelingInfoInit( ARLabelInfo *labelInfo, int xsize, int ysize )
+{
+    int workSize;
+
+    if (!labelInfo || xsize < 3 || ysize < 3) return (-1);
+
+    memset(labelInfo, 0, sizeof(ARLabelInfo));
+    workSize = ((xsize - 1)/2) * ((ysize - 1)/2 + (AR_LABELING_BAND_MAX + 1)/2);
+#if !AR_LABELING_32_BIT
+    if (workSize > AR_LABELING_WORK_SIZE_MAX) workSize = AR_LABELING_WORK_SIZE_MAX;
+#endif
+    labelInfo->work_size = workSize;
+    labelInfo->labelImage = (AR_LABELING_LABEL_TYPE *)malloc(xsize*ysize*sizeof(AR_LABELING_LABEL_TYPE));
+    labelInfo->area  = (int *)malloc(workSize*sizeof(int));
+    labelInfo->clip  = (int (*)[4])malloc(workSize*sizeof(int[4]));
+    labelInfo->pos   = (ARdouble (*)[2])malloc(workSize*sizeof(ARdouble[2]));
+    labelInfo->work  = (int *)malloc(workSize*sizeof(int));
+    labelInfo->work2 = (int *)malloc(workSize*7*sizeof(int));
+    if (!labelInfo->labelImage || !labelInfo->area || !labelInfo->clip || !labelInfo->pos || !labelInfo->work || !labelInfo->work2) {
+        ARLOGe("Out of memory!!\n");
+        arLabelingInfoFinal(labelInfo);
+        return (-1);
+    }
+    return (0);
+}
+
+void arLabelingInfoFinal( ARLabelInfo *labelInfo )
+{
+    if (!labelInfo) return;
+
+    free(labelInfo->labelImage);
+    labelInfo->labelImage = NULL;
+    free(labelInfo->area);
+    labelInfo->area = NULL;
+    free(labelInfo->clip);
+    labelInfo->clip = NULL;
+    free(labelInfo->pos);
+    labelInfo->pos = NULL;
+    free(labelInfo->work);
+    labelInfo->work = NULL;
+    free(labelInfo->work2);
+    labelInfo->work2 = NULL;
+    labelInfo->work_size = 0;
+    labelInfo->label_num = 0;
+}
 
 int arLabeling( ARUint8 *imageLuma, int xsize, int ysize,
                 int debugMode, int labelingMode, int labelingThresh, int imageProcMode,
@@ -0,0 +1,327 @@
+/*
+ *  arLabelingBand.c
+ *  artoolkitX
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ *  Author(s): Philip Lamb
+ *
+ */
+
+
+#include "arLabelingBand.h"
+#include "arLabelingSub/arLabelingPrivate.h"
+#include <string.h> // memset()
+#include <ARX/ARUtil/thread_sub.h>
+
+typedef struct {
+    ARUint8                *image;
+    int                     xsize;
+    int                     ysize;
+    int                     debugMode;
+    int                     labelingMode;
+    int                     labelingThresh;
+    int                     imageProcMode;
+    ARUint8                *image_thresh;
+    ARLabelInfo            *labelInfo;
+    int                     rowStart;
+    int                     rowEnd;
+    int                     labelBase;
+    int                     labelMax;
+    AR_LABELING_LABEL_TYPE *zeroRow;
+    int                     labelCount;       // Result: number of provisional labels, or -1 on error.
+} ARLabelingBand;
+
+struct _ARLabelingBandInfo {
+    int                     bandNum;
+    int                     xsizeMax;
+    AR_LABELING_LABEL_TYPE *zeroRow;
+    ARLabelingBand          band[AR_LABELING_BAND_MAX];
+    THREAD_HANDLE_T        *threadHandle[AR_LABELING_BAND_MAX]; // Band 0 is labeled on the calling thread, so threadHandle[0] is unused.
+};
+
+static int labelBand(ARLabelingBand *b)
+{
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+    if (b->debugMode == AR_DEBUG_DISABLE) {
+#endif
+        if (b->labelingMode == AR_LABELING_BLACK_REGION) {
+            if (b->image_thresh) return arLabelingSubDBZBand(b->image, b->xsize, b->ysize, b->image_thresh, b->labelInfo, b->rowStart, b->rowEnd, b->labelBase, b->labelMax, b->zeroRow);
+            if (b->imageProcMode == AR_IMAGE_PROC_FRAME_IMAGE) {
+                return arLabelingSubDBRCBand(b->image, b->xsize, b->ysize, b->labelingThresh, b->labelInfo, b->rowStart, b->rowEnd, b->labelBase, b->labelMax, b->zeroRow);
+            } else /* imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE */ {
+                return arLabelingSubDBICBand(b->image, b->xsize, b->ysize, b->labelingThresh, b->labelInfo, b->rowStart, b->rowEnd, b->labelBase, b->labelMax, b->zeroRow);
+            }
+        } else /* labelingMode == AR_LABELING_WHITE_REGION */ {
+            if (b->image_thresh) return arLabelingSubDWZBand(b->image, b->xsize, b->ysize, b->image_thresh, b->labelInfo, b->rowStart, b->rowEnd, b->labelBase, b->labelMax, b->zeroRow);
+            if (b->imageProcMode == AR_IMAGE_PROC_FRAME_IMAGE) {
+                return arLabelingSubDWRCBand(b->image, b->xsize, b->ysize, b->labelingThresh, b->labelInfo, b->rowStart, b->rowEnd, b->labelBase, b->labelMax, b->zeroRow);
+            } else /* imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE */ {
+                return arLabelingSubDWICBand(b->image, b->xsize, b->ysize, b->labelingThresh, b->labelInfo, b->rowStart, b->rowEnd, b->labelBase, b->labelMax, b->zeroRow);
+            }
+        }
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+    } else /* debugMode == AR_DEBUG_ENABLE */ {
+        if (b->labelingMode == AR_LABELING_BLACK_REGION) {
+            if (b->image_thresh) return arLabelingSubEBZBand(b->image, b->xsize, b->ysize, b->image_thresh, b->labelInfo, b->rowStart, b->rowEnd, b->labelBase, b->labelMax, b->zeroRow);
+            if (b->imageProcMode == AR_IMAGE_PROC_FRAME_IMAGE) {
+                return arLabelingSubEBRCBand(b->image, b->xsize, b->ysize, b->labelingThresh, b->labelInfo, b->rowStart, b->rowEnd, b->labelBase, b->labelMax, b->zeroRow);
+            } else /* imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE */ {
+                return arLabelingSubEBICBand(b->image, b->xsize, b->ysize, b->labelingThresh, b->labelInfo, b->rowStart, b->rowEnd, b->labelBase, b->labelMax, b->zeroRow);
+            }
+        } else /* labelingMode == AR_LABELING_WHITE_REGION */ {
+            if (b->image_thresh) return arLabelingSubEWZBand(b->image, b->xsize, b->ysize, b->image_thresh, b->labelInfo, b->rowStart, b->rowEnd, b->labelBase, b->labelMax, b->zeroRow);
+            if (b->imageProcMode == AR_IMAGE_PROC_FRAME_IMAGE) {
+                return arLabelingSubEWRCBand(b->image, b->xsize, b->ysize, b->labelingThresh, b->labelInfo, b->rowStart, b->rowEnd, b->labelBase, b->labelMax, b->zeroRow);
+            } else /* imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE */ {
+                return arLabelingSubEWICBand(b->image, b->xsize, b->ysize, b->labelingThresh, b->labelInfo, b->rowStart, b->rowEnd, b->labelBase, b->labelMax, b->zeroRow);
+            }
+        }
+    }
+#endif
+}
+
+static void *labelBandWorker(THREAD_HANDLE_T *threadHandle)
+{
+    ARLabelingBand *b = (ARLabelingBand *)threadGetArg(threadHandle);
+
+    while (threadStartWait(threadHandle) == 0) {
+        b->labelCount = labelBand(b);
+        threadEndSignal(threadHandle);
+    }
+    return (NULL);
+}
+
+// Provisional labels always refer to a smaller (earlier) label, with roots referring to themselves.
+static int findRoot(const int *work, int label)
+{
+    while (work[label - 1] != label) label = work[label - 1];
+    return (label);
+}
+
+ARLabelingBandInfo *arLabelingBandInit(const int xsize, const int bandNum)
+{
+    ARLabelingBandInfo *lbi;
+    int i;
+
+    if (bandNum < 2) return (NULL);
+
+    lbi = (ARLabelingBandInfo *)calloc(1, sizeof(ARLabelingBandInfo));
+    if (!lbi) {
+        ARLOGe("Out of memory!!\n");
+        return (NULL);
+    }
+    lbi->bandNum = (bandNum > AR_LABELING_BAND_MAX ? AR_LABELING_BAND_MAX : bandNum);
+    lbi->xsizeMax = xsize;
+    lbi->zeroRow = (AR_LABELING_LABEL_TYPE *)calloc(xsize, sizeof(AR_LABELING_LABEL_TYPE));
+    if (!lbi->zeroRow) {
+        ARLOGe("Out of memory!!\n");
+        goto bail;
+    }
+    for (i = 1; i < lbi->bandNum; i++) {
+        lbi->threadHandle[i] = threadInit(i, &(lbi->band[i]), labelBandWorker);
+        if (!lbi->threadHandle[i]) {
+            ARLOGe("Unable to start labeling worker thread.\n");
+            goto bail;
+        }
+    }
+    return (lbi);
+
+bail:
+    arLabelingBandFinal(lbi);
+    return (NULL);
+}
+
+void arLabelingBandFinal(ARLabelingBandInfo *lbi)
+{
+    int i;
+
+    if (!lbi) return;
+
+    for (i = 1; i < lbi->bandNum; i++) {
+        if (lbi->threadHandle[i]) {
+            threadWaitQuit(lbi->threadHandle[i]);
+            threadFree(&(lbi->threadHandle[i]));
+        }
+    }
+    free(lbi->zeroRow);
+    free(lbi);
+}
+
+int arLabelingBandGetBandNum(const ARLabelingBandInfo *lbi)
+{
+    if (!lbi) return (1);
+    return (lbi->bandNum);
+}
+
+int arLabelingBanded(ARLabelingBandInfo *lbi, ARUint8 *imageLuma, int xsize, int ysize,
+                     int debugMode, int labelingMode, int labelingThresh, int imageProcMode,
+                     ARLabelInfo *labelInfo, ARUint8 *image_thresh)
+{
+    int       lxsize, lysize;
+    int       bandNum, rowNum;
+    int       labelBase, labelMax;
+    int       b, i, j, x, dx;
+    int       ret;
+    int      *work, *work2;
+    int      *area, *clip;
+    ARdouble *pos;
+    AR_LABELING_LABEL_TYPE *pnt1, *pnt2;
+
+    if (!lbi) return arLabeling(imageLuma, xsize, ysize, debugMode, labelingMode, labelingThresh, imageProcMode, labelInfo, image_thresh);
+
+    // Adaptive thresholding always labels the full frame.
+    if (image_thresh || imageProcMode == AR_IMAGE_PROC_FRAME_IMAGE) {
+        lxsize = xsize;
+        lysize = ysize;
+    } else {
+        lxsize = xsize / 2;
+        lysize = ysize / 2;
+    }
+
+    rowNum = lysize - 2;
+    bandNum = rowNum / AR_LABELING_BAND_ROWS_MIN;
+    if (bandNum > lbi->bandNum) bandNum = lbi->bandNum;
+    if (bandNum < 2 || xsize > lbi->xsizeMax) return arLabeling(imageLuma, xsize, ysize, debugMode, labelingMode, labelingThresh, imageProcMode, labelInfo, image_thresh);
+
+    // Set top and bottom rows, and leftmost and rightmost columns, of labelImage to 0.
+    memset(&(labelInfo->labelImage[0]), 0, lxsize*sizeof(AR_LABELING_LABEL_TYPE));
+    memset(&(labelInfo->labelImage[(lysize - 1)*lxsize]), 0, lxsize*sizeof(AR_LABELING_LABEL_TYPE));
+    pnt1 = &(labelInfo->labelImage[0]);
+    pnt2 = &(labelInfo->labelImage[lxsize - 1]);
+    for (i = 0; i < lysize; i++) {
+        *pnt1 = *pnt2 = 0;
+        pnt1 += lxsize;
+        pnt2 += lxsize;
+    }
+
+    // Each band labels its own rows, allocating provisional labels from its own slice of the work table.
+    // A band of n rows allocates at most ((lxsize - 1)/2)*((n + 1)/2) labels (see arLabelingInfoInit()),
+    // so slices of that size never overflow. With 16-bit labels the table may be too small to hold them
+    // all, in which case it is shared equally and an overflowing band falls back to serial labeling.
+    labelBase = 0;
+    for (b = 0; b < bandNum; b++) {
+        labelBase += ((lxsize - 1)/2) * ((rowNum*(b + 1)/bandNum - rowNum*b/bandNum + 1)/2);
+    }
+    labelMax = (labelBase > labelInfo->work_size ? labelInfo->work_size / bandNum : 0);
+    labelBase = 0;
+    for (b = 0; b < bandNum; b++) {
+        lbi->band[b].image = imageLuma;
+        lbi->band[b].xsize = xsize;
+        lbi->band[b].ysize = ysize;
+        lbi->band[b].debugMode = debugMode;
+        lbi->band[b].labelingMode = labelingMode;
+        lbi->band[b].labelingThresh = labelingThresh;
+        lbi->band[b].imageProcMode = imageProcMode;
+        lbi->band[b].image_thresh = image_thresh;
+        lbi->band[b].labelInfo = labelInfo;
+        lbi->band[b].rowStart = 1 + rowNum*b/bandNum;
+        lbi->band[b].rowEnd = 1 + rowNum*(b + 1)/bandNum;
+        lbi->band[b].labelBase = labelBase;
+        lbi->band[b].labelMax = (labelMax ? labelMax : ((lxsize - 1)/2) * ((lbi->band[b].rowEnd - lbi->band[b].rowStart + 1)/2));
+        labelBase += lbi->band[b].labelMax;
+        lbi->band[b].zeroRow = (b == 0 ? NULL : lbi->zeroRow);
+        if (b > 0) threadStartSignal(lbi->threadHandle[b]);
+    }
+    lbi->band[0].labelCount = labelBand(&(lbi->band[0]));
+    ret = 0;
+    for (b = 0; b < bandNum; b++) {
+        if (b > 0) threadEndWait(lbi->threadHandle[b]);
+        if (lbi->band[b].labelCount < 0) ret = -1;
+    }
+    // Only possible with 16-bit labels. A band which overflowed its slice of the work table may
+    // still fit in the whole table, so rather than drop regions, label the frame again serially.
+    if (ret < 0) {
+        ARLOGd("Labeling band overflow, falling back to serial labeling.\n");
+        return arLabeling(imageLuma, xsize, ysize, debugMode, labelingMode, labelingThresh, imageProcMode, labelInfo, image_thresh);
+    }
+
+    // Merge labels which are 8-connected across each seam. The larger root always refers to the smaller,
+    // so that label order is the same as for a single raster scan.
+    work = labelInfo->work;
+    work2 = labelInfo->work2;
+    for (b = 1; b < bandNum; b++) {
+        pnt1 = &(labelInfo->labelImage[(lbi->band[b].rowStart - 1)*lxsize]);
+        pnt2 = &(labelInfo->labelImage[lbi->band[b].rowStart*lxsize]);
+        for (x = 1; x < lxsize - 1; x++) {
+            if (pnt2[x] == 0) continue;
+            for (dx = -1; dx <= 1; dx++) {
+                int m, n;
+                if (pnt1[x + dx] == 0) continue;
+                m = findRoot(work, pnt1[x + dx]);
+                n = findRoot(work, pnt2[x]);
+                if (m < n) work[n - 1] = m;
+                else if (m > n) work[m - 1] = n;
+            }
+        }
+    }
+
+    // Replace each provisional label with its final label number. As each label refers to an
+    // earlier one, one pass in increasing label order suffices.
+    j = 1;
+    for (b = 0; b < bandNum; b++) {
+        for (i = lbi->band[b].labelBase + 1; i <= lbi->band[b].labelBase + lbi->band[b].labelCount; i++) {
+            work[i - 1] = (work[i - 1] == i ? j++ : work[work[i - 1] - 1]);
+        }
+    }
+    labelInfo->label_num = j - 1;
+    if (labelInfo->label_num == 0) {
+        return 0;
+    }
+
+    area = &(labelInfo->area[0]);
+    clip = &(labelInfo->clip[0][0]);
+    pos  = &(labelInfo->pos[0][0]);
+    memset(area, 0, labelInfo->label_num *     sizeof(int));
+    memset(pos,  0, labelInfo->label_num * 2 * sizeof(ARdouble));
+    for (i = 0; i < labelInfo->label_num; i++) {
+        clip[i*4+0] = lxsize;
+        clip[i*4+1] = 0;
+        clip[i*4+2] = lysize;
+        clip[i*4+3] = 0;
+    }
+    for (b = 0; b < bandNum; b++) {
+        for (i = lbi->band[b].labelBase; i < lbi->band[b].labelBase + lbi->band[b].labelCount; i++) {
+            j = work[i] - 1;
+            area[j]    += work2[i*7+0];
+            pos[j*2+0] += work2[i*7+1];
+            pos[j*2+1] += work2[i*7+2];
+            if( clip[j*4+0] > work2[i*7+3] ) clip[j*4+0] = work2[i*7+3];
+            if( clip[j*4+1] < work2[i*7+4] ) clip[j*4+1] = work2[i*7+4];
+            if( clip[j*4+2] > work2[i*7+5] ) clip[j*4+2] = work2[i*7+5];
+            if( clip[j*4+3] < work2[i*7+6] ) clip[j*4+3] = work2[i*7+6];
+        }
+    }
+    for (i = 0; i < labelInfo->label_num; i++) {
+        pos[i*2+0] /= area[i];
+        pos[i*2+1] /= area[i];
+    }
+
+    return 0;
+}
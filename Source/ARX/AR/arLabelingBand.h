@@ -0,0 +1,74 @@
+/*
+ *  arLabelingBand.h
+ *  artoolkitX
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ *  Author(s): Philip Lamb
+ *
+ */
+
+
+#ifndef AR_LABELING_BAND_H
+#define AR_LABELING_BAND_H
+
+#include <ARX/AR/ar.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AR_LABELING_BAND_MAX          16 // Maximum number of bands (and threads) used by banded labeling.
+#define AR_LABELING_BAND_ROWS_MIN     32 // Bands are never made shorter than this many rows.
+
+// Allocate worker threads for labeling images up to xsize pixels wide in bandNum horizontal bands.
+// Returns NULL if bandNum is less than 2 or the workers could not be started.
+ARLabelingBandInfo *arLabelingBandInit(const int xsize, const int bandNum);
+
+// Stop the worker threads and free all resources held by lbi.
+void arLabelingBandFinal(ARLabelingBandInfo *lbi);
+
+// Number of bands lbi was created with.
+int arLabelingBandGetBandNum(const ARLabelingBandInfo *lbi);
+
+// Drop-in replacement for arLabeling(). Labels each band on its own thread, then merges labels
+// which meet at band seams. Labels, areas, clips and centroids are identical to those from
+// arLabeling(). Each band allocates provisional labels from its own slice of labelInfo's work table,
+// sized from the band's rows so that it cannot overflow (with 16-bit labels, the slices may be smaller,
+// and if any band overflows, the frame is relabeled with arLabeling()). If lbi is NULL, or the image
+// is too short to split, calls arLabeling() directly.
+int arLabelingBanded(ARLabelingBandInfo *lbi, ARUint8 *imageLuma, int xsize, int ysize,
+                     int debugMode, int labelingMode, int labelingThresh, int imageProcMode,
+                     ARLabelInfo *labelInfo, ARUint8 *image_thresh);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AR_LABELING_BAND_H
@@ -0,0 +1,163 @@
+/*
+ *  arLabelingBracket.c
+ *  artoolkitX
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ *  Author(s): Philip Lamb
+ *
+ */
+
+
+#include "arLabelingBracket.h"
+#include "arLabelingBand.h"
+#include <ARX/ARUtil/thread_sub.h>
+
+#define AR_LABELING_BRACKET_WORKER_COUNT 2
+
+typedef struct {
+    ARHandle          *arHandle;
+    AR2VideoBufferT   *frame;
+    int                thresh;
+    ARLabelInfo        labelInfo;
+    int                marker2_num;
+    ARMarkerInfo2      markerInfo2[AR_SQUARE_MAX];
+    int                marker_num;
+    ARMarkerInfo       markerInfo[AR_SQUARE_MAX];
+    int                marker_count;
+    int                ret;
+} ARLabelingBracketPass;
+
+struct _ARLabelingBracketInfo {
+    ARLabelingBracketPass *pass[AR_LABELING_BRACKET_WORKER_COUNT];
+    THREAD_HANDLE_T       *threadHandle[AR_LABELING_BRACKET_WORKER_COUNT];
+};
+
+// Run one complete labeling/detection/matching pass at threshold 'thresh', writing into the supplied buffers.
+// Only reads from arHandle, so may be called concurrently with other passes on the same handle,
+// provided each concurrent pass has its own bandInfo (or NULL).
+static int bracketPass(ARHandle *arHandle, ARLabelingBandInfo *bandInfo, AR2VideoBufferT *frame, const int debugMode, const int thresh,
+                       ARLabelInfo *labelInfo, ARMarkerInfo2 *markerInfo2, int *marker2_num, ARMarkerInfo *markerInfo, int *marker_num,
+                       int *marker_count)
+{
+    int j;
+
+    if (arLabelingBanded(bandInfo, frame->buffLuma, arHandle->xsize, arHandle->ysize, debugMode, arHandle->arLabelingMode, thresh, arHandle->arImageProcMode, labelInfo, NULL) < 0) return -1;
+    if (arDetectMarker2(arHandle->xsize, arHandle->ysize, labelInfo, arHandle->arImageProcMode, arHandle->areaMax, arHandle->areaMin, arHandle->squareFitThresh, markerInfo2, marker2_num) < 0) return -1;
+    if (arGetMarkerInfo(frame->buff, arHandle->xsize, arHandle->ysize, arHandle->arPixelFormat, markerInfo2, *marker2_num, arHandle->pattHandle, arHandle->arImageProcMode, arHandle->arPatternDetectionMode, &(arHandle->arParamLT->paramLTf), arHandle->pattRatio, markerInfo, marker_num, arHandle->matrixCodeType) < 0) return -1;
+    *marker_count = 0;
+    for (j = 0; j < *marker_num; j++) if (markerInfo[j].idPatt != -1 || markerInfo[j].idMatrix != -1) (*marker_count)++;
+    return 0;
+}
+
+static void *bracketWorker(THREAD_HANDLE_T *threadHandle)
+{
+    ARLabelingBracketPass *pass = (ARLabelingBracketPass *)threadGetArg(threadHandle);
+
+    while (threadStartWait(threadHandle) == 0) {
+        // Debug images are only produced by the pass at the current threshold, as in the serial case.
+        pass->ret = bracketPass(pass->arHandle, NULL, pass->frame, AR_DEBUG_DISABLE, pass->thresh,
+                                &(pass->labelInfo), pass->markerInfo2, &(pass->marker2_num), pass->markerInfo, &(pass->marker_num),
+                                &(pass->marker_count));
+        threadEndSignal(threadHandle);
+    }
+    return (NULL);
+}
+
+ARLabelingBracketInfo *arLabelingBracketInit(const int xsize, const int ysize)
+{
+    ARLabelingBracketInfo *abi;
+    int i;
+
+    if (threadGetCPU() < 2) return (NULL);
+
+    abi = (ARLabelingBracketInfo *)calloc(1, sizeof(ARLabelingBracketInfo));
+    if (!abi) return (NULL);
+
+    for (i = 0; i < AR_LABELING_BRACKET_WORKER_COUNT; i++) {
+        abi->pass[i] = (ARLabelingBracketPass *)calloc(1, sizeof(ARLabelingBracketPass));
+        if (!abi->pass[i]) goto bail;
+        if (arLabelingInfoInit(&(abi->pass[i]->labelInfo), xsize, ysize) < 0) goto bail;
+        abi->threadHandle[i] = threadInit(i, abi->pass[i], bracketWorker);
+        if (!abi->threadHandle[i]) goto bail;
+    }
+    return (abi);
+
+bail:
+    ARLOGe("Unable to start auto-bracketing worker threads. Bracketed passes will run serially.\n");
+    arLabelingBracketFinal(abi);
+    return (NULL);
+}
+
+void arLabelingBracketFinal(ARLabelingBracketInfo *abi)
+{
+    int i;
+
+    if (!abi) return;
+
+    for (i = 0; i < AR_LABELING_BRACKET_WORKER_COUNT; i++) {
+        if (abi->threadHandle[i]) {
+            threadWaitQuit(abi->threadHandle[i]);
+            threadFree(&(abi->threadHandle[i]));
+        }
+        if (abi->pass[i]) {
+            arLabelingInfoFinal(&(abi->pass[i]->labelInfo));
+            free(abi->pass[i]);
+        }
+    }
+    free(abi);
+}
+
+int arLabelingBracketDetect(ARLabelingBracketInfo *abi, ARHandle *arHandle, AR2VideoBufferT *frame, const int thresholds[3], int marker_nums[3])
+{
+    int i;
+    int ret;
+
+    if (!abi || !arHandle || !frame) return (-1);
+
+    for (i = 0; i < AR_LABELING_BRACKET_WORKER_COUNT; i++) {
+        abi->pass[i]->arHandle = arHandle;
+        abi->pass[i]->frame = frame;
+        abi->pass[i]->thresh = thresholds[i];
+        threadStartSignal(abi->threadHandle[i]);
+    }
+
+    // Pass at the current threshold runs on this thread, into the handle's own buffers.
+    ret = bracketPass(arHandle, arHandle->arLabelingBandInfo, frame, arHandle->arDebug, thresholds[2],
+                      &(arHandle->labelInfo), arHandle->markerInfo2, &(arHandle->marker2_num), arHandle->markerInfo, &(arHandle->marker_num),
+                      &(marker_nums[2]));
+
+    for (i = 0; i < AR_LABELING_BRACKET_WORKER_COUNT; i++) {
+        threadEndWait(abi->threadHandle[i]);
+        if (abi->pass[i]->ret < 0) ret = -1;
+        marker_nums[i] = abi->pass[i]->marker_count;
+    }
+
+    return (ret);
+}
@@ -0,0 +1,66 @@
+/*
+ *  arLabelingBracket.h
+ *  artoolkitX
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ *  Author(s): Philip Lamb
+ *
+ */
+
+
+#ifndef AR_LABELING_BRACKET_H
+#define AR_LABELING_BRACKET_H
+
+#include <ARX/AR/ar.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Allocate label buffers and worker threads for the two bracketed passes of
+// AR_LABELING_THRESH_MODE_AUTO_BRACKETING. Returns NULL if fewer than two CPUs
+// are available or allocation fails, in which case passes should run serially.
+ARLabelingBracketInfo *arLabelingBracketInit(const int xsize, const int ysize);
+
+// Stop the worker threads and free all resources held by abi.
+void arLabelingBracketFinal(ARLabelingBracketInfo *abi);
+
+// Label, detect and match markers at thresholds[0] and thresholds[1] on the worker
+// threads while doing the same at thresholds[2] on the calling thread. Results of
+// the thresholds[2] pass are left in arHandle's labelInfo, markerInfo2 and markerInfo,
+// exactly as for a serial run. For each pass, the number of identified markers
+// is placed in marker_nums[]. Returns 0 on success or -1 if any pass failed.
+int arLabelingBracketDetect(ARLabelingBracketInfo *abi, ARHandle *arHandle, AR2VideoBufferT *frame, const int thresholds[3], int marker_nums[3]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AR_LABELING_BRACKET_H
@@ -40,6 +40,11 @@
 #define AR_LABELING_PRIVATE_H
 
 #include <ARX/AR/config.h>
+#if HAVE_ARM_NEON || HAVE_ARM64_NEON
+#  include <arm_neon.h>
+#elif HAVE_INTEL_SIMD
+#  include <emmintrin.h> // SSE2.
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -71,6 +76,66 @@ int arLabelingSubDWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
 int arLabelingSubEBZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo );
 int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo );
 
+/*  Single band of a banded labeling. See arLabelingSub.h. */
+
+int arLabelingSubDBICBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow );
+int arLabelingSubDBRCBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow );
+int arLabelingSubDWICBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow );
+int arLabelingSubDWRCBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow );
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+int arLabelingSubEBICBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow );
+int arLabelingSubEBRCBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow );
+int arLabelingSubEWICBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow );
+int arLabelingSubEWRCBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow );
+#endif
+int arLabelingSubDBZBand( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow );
+int arLabelingSubDWZBand( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow );
+int arLabelingSubEBZBand( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow );
+int arLabelingSubEWZBand( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow );
+
+// Define AR_LABELING_DISABLE_SIMD to 1 to build the plain scalar labeling, e.g. as a
+// reference for the SIMD paths (see Utilities/check_labeling).
+#if (HAVE_ARM_NEON || HAVE_ARM64_NEON || HAVE_INTEL_SIMD) && !AR_LABELING_DISABLE_SIMD
+#  define AR_LABELING_SIMD_RUN 16
+
+/*
+    Returns non-zero if all AR_LABELING_SIMD_RUN consecutive pixels starting at pnt lie
+    outside the region being labeled. Pixels are read every 'step' bytes, where step is
+    1 (frame image) or 2 (field image). If pnt_thresh is non-NULL, per-pixel thresholds
+    are read from it with the same spacing, otherwise the single threshold 'thresh' is
+    used. The in-region test is identical to the scalar one: pixel <= threshold for
+    black regions, pixel > threshold for white regions.
+ */
+static inline int arLabelingSubRunIsOutside(const ARUint8 *pnt, const ARUint8 *pnt_thresh, const ARUint8 thresh, const int step, const int whiteRegion)
+{
+#  if HAVE_ARM_NEON || HAVE_ARM64_NEON
+    uint8x16_t p, t, in;
+    uint64x2_t in64;
+
+    p = (step == 2 ? vld2q_u8(pnt).val[0] : vld1q_u8(pnt));
+    if (pnt_thresh) t = (step == 2 ? vld2q_u8(pnt_thresh).val[0] : vld1q_u8(pnt_thresh));
+    else t = vdupq_n_u8(thresh);
+    in = (whiteRegion ? vcgtq_u8(p, t) : vcleq_u8(p, t));
+    in64 = vreinterpretq_u64_u8(in);
+    return ((vgetq_lane_u64(in64, 0) | vgetq_lane_u64(in64, 1)) == 0);
+#  else
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    __m128i p, t;
+    int     le;
+
+    if (step == 2) p = _mm_packus_epi16(_mm_and_si128(_mm_loadu_si128((const __m128i *)pnt), mask), _mm_and_si128(_mm_loadu_si128((const __m128i *)(pnt + 16)), mask));
+    else p = _mm_loadu_si128((const __m128i *)pnt);
+    if (pnt_thresh) {
+        if (step == 2) t = _mm_packus_epi16(_mm_and_si128(_mm_loadu_si128((const __m128i *)pnt_thresh), mask), _mm_and_si128(_mm_loadu_si128((const __m128i *)(pnt_thresh + 16)), mask));
+        else t = _mm_loadu_si128((const __m128i *)pnt_thresh);
+    } else t = _mm_set1_epi8((char)thresh);
+    // Unsigned saturating subtract is zero exactly where p <= t.
+    le = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(p, t), _mm_setzero_si128()));
+    return (le == (whiteRegion ? 0xffff : 0x0000));
+#  endif
+}
+#endif // (HAVE_ARM_NEON || HAVE_ARM64_NEON || HAVE_INTEL_SIMD) && !AR_LABELING_DISABLE_SIMD
+
 #ifdef __cplusplus
 }
 #endif
@@ -53,55 +53,80 @@
 #include "arLabelingPrivate.h"
 
 #define AR_PIXEL_SIZE     1
+#ifdef AR_LABELING_FRAME_IMAGE_F
+#  define AR_PIXEL_STEP   AR_PIXEL_SIZE
+#else
+#  define AR_PIXEL_STEP   (AR_PIXEL_SIZE*2)
+#endif
+#ifdef AR_LABELING_WHITE_REGION_F
+#  define AR_LABELING_WHITE 1
+#else
+#  define AR_LABELING_WHITE 0
+#endif
 
+// Label rows [rowStart, rowEnd) of the image, allocating provisional labels labelBase+1 to labelBase+labelMax
+// in labelInfo->work and labelInfo->work2. If zeroRow is non-NULL, the row above rowStart is treated as background
+// (zeroRow must point to lxsize zeros). Returns the number of provisional labels allocated, or -1 on overflow.
 #ifndef AR_LABELING_ADAPTIVE
 #  ifndef AR_LABELING_DEBUG_ENABLE_F
 #    ifndef AR_LABELING_WHITE_REGION_F
 #      ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDBIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBICBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow )
+#      define AR_LABELING_SUB_BAND arLabelingSubDBICBand
 #      else
-int arLabelingSubDBRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBRCBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow )
+#      define AR_LABELING_SUB_BAND arLabelingSubDBRCBand
 #      endif // !AR_LABELING_FRAME_IMAGE_F
 #    else
 #      ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDWIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWICBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow )
+#      define AR_LABELING_SUB_BAND arLabelingSubDWICBand
 #      else
-int arLabelingSubDWRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWRCBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow )
+#      define AR_LABELING_SUB_BAND arLabelingSubDWRCBand
 #      endif // !AR_LABELING_FRAME_IMAGE_F
 #    endif // !AR_LABELING_WHITE_REGION_F
 #  else
 #    ifndef AR_LABELING_WHITE_REGION_F
 #      ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEBIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBICBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow )
+#      define AR_LABELING_SUB_BAND arLabelingSubEBICBand
 #      else
-int arLabelingSubEBRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBRCBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow )
+#      define AR_LABELING_SUB_BAND arLabelingSubEBRCBand
 #      endif // !AR_LABELING_FRAME_IMAGE_F
 #    else
 #      ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEWIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWICBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow )
+#      define AR_LABELING_SUB_BAND arLabelingSubEWICBand
 #      else
-int arLabelingSubEWRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWRCBand( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow )
+#      define AR_LABELING_SUB_BAND arLabelingSubEWRCBand
 #      endif // !AR_LABELING_FRAME_IMAGE_F
 #    endif // !AR_LABELING_WHITE_REGION_F
 #  endif // !AR_LABELING_DEBUG_ENABLE_F
 #else
 #  ifndef AR_LABELING_DEBUG_ENABLE_F
 #    ifndef AR_LABELING_WHITE_REGION_F
-int arLabelingSubDBZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBZBand( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow )
+#    define AR_LABELING_SUB_BAND arLabelingSubDBZBand
 #    else
-int arLabelingSubDWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWZBand( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow )
+#    define AR_LABELING_SUB_BAND arLabelingSubDWZBand
 #    endif // !AR_LABELING_WHITE_REGION_F
 #  else
 #    ifndef AR_LABELING_WHITE_REGION_F
-int arLabelingSubEBZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBZBand( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow )
+#    define AR_LABELING_SUB_BAND arLabelingSubEBZBand
 #    else
-int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWZBand( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo, int rowStart, int rowEnd, int labelBase, int labelMax, AR_LABELING_LABEL_TYPE *zeroRow )
+#    define AR_LABELING_SUB_BAND arLabelingSubEWZBand
 #    endif // !AR_LABELING_WHITE_REGION_F
 #  endif // !AR_LABELING_DEBUG_ENABLE_F
 #endif
 
 {
-    int       lxsize, lysize;
+    int       lxsize;
     ARUint8  *pnt;                     /*  image pointer into source image  */
 #ifdef AR_LABELING_ADAPTIVE
     ARUint8  *pnt_thresh;
@@ -115,74 +140,60 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
     int       i,j,k,l;                  /*  for loop            */
     int       *wk;                      /*  pointer for work    */
     int       m,n;                      /*  work                */
-    int       *label_num;
-    int       *area;
-    int       *clip;
-    ARdouble  *pos;
+#ifdef AR_LABELING_SIMD_RUN
+    int       runEnabled;
+#endif
+
+#ifdef AR_LABELING_SIMD_RUN
+    // The SIMD comparison operates on 8-bit thresholds, so fall back to the scalar path for out-of-range values.
+#  ifdef AR_LABELING_ADAPTIVE
+    runEnabled = 1;
+#  else
+    runEnabled = (labelingThresh >= 0 && labelingThresh <= 255);
+#  endif
+#endif
 
 #ifdef AR_LABELING_FRAME_IMAGE_F
     lxsize = xsize;
-    lysize = ysize;
 #else
     lxsize = xsize / 2;
-    lysize = ysize / 2;
 #endif
 
-#ifdef AR_LABELING_DEBUG_ENABLE_F
-    //memset( labelInfo->bwImage, 0, lxsize*lysize );
-#endif
-
-	// Set top and bottom rows of labelImage to 0.
-    pnt1 = &(labelInfo->labelImage[0]); // Leftmost pixel of top row of image.
-    pnt2 = &(labelInfo->labelImage[(lysize - 1)*lxsize]); // Leftmost pixel of bottom row of image.
-    for(i = 0; i < lxsize; i++) {
-        *(pnt1++) = *(pnt2++) = 0;
-    }
-
-	// Set leftmost and rightmost columns of labelImage to 0.
-    pnt1 = &(labelInfo->labelImage[0]); // Leftmost pixel of top row of image.
-    pnt2 = &(labelInfo->labelImage[lxsize - 1]); // Rightmost pixel of top row of image.
-    for(i = 0; i < lysize; i++) {
-        *pnt1 = *pnt2 = 0;
-        pnt1 += lxsize;
-        pnt2 += lxsize;
-    }
-
     wk_max = 0;
     work = labelInfo->work;
     work2 = labelInfo->work2;
-    pnt2 = &(labelInfo->labelImage[lxsize + 1]); // Start on 2nd pixel of 2nd row.
+    pnt2 = &(labelInfo->labelImage[rowStart*lxsize + 1]); // Start on 2nd pixel of first row of band.
 #ifdef AR_LABELING_DEBUG_ENABLE_F
-    dpnt = &(labelInfo->bwImage[lxsize + 1]);
+    dpnt = &(labelInfo->bwImage[rowStart*lxsize + 1]);
 #  ifdef AR_LABELING_FRAME_IMAGE_F
-    pnt = &(image[(xsize + 1)*AR_PIXEL_SIZE]); // Start on 2nd pixel of 2nd row.
+    pnt = &(image[(rowStart*xsize + 1)*AR_PIXEL_SIZE]); // Start on 2nd pixel of first row of band.
 #    ifdef AR_LABELING_ADAPTIVE
-    pnt_thresh = &(image_thresh[(xsize + 1)*AR_PIXEL_SIZE]);
-    for(j = 1; j < lysize - 1; j++, pnt += AR_PIXEL_SIZE*2, pnt_thresh += AR_PIXEL_SIZE*2, pnt2 += 2, dpnt += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
+    pnt_thresh = &(image_thresh[(rowStart*xsize + 1)*AR_PIXEL_SIZE]);
+    for(j = rowStart; j < rowEnd; j++, pnt += AR_PIXEL_SIZE*2, pnt_thresh += AR_PIXEL_SIZE*2, pnt2 += 2, dpnt += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
         for(i = 1; i < lxsize - 1; i++, pnt += AR_PIXEL_SIZE, pnt_thresh += AR_PIXEL_SIZE, pnt2++, dpnt++) { // Process columns.
 #    else
-    for(j = 1; j < lysize - 1; j++, pnt += AR_PIXEL_SIZE*2, pnt2 += 2, dpnt += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
+    for(j = rowStart; j < rowEnd; j++, pnt += AR_PIXEL_SIZE*2, pnt2 += 2, dpnt += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
         for(i = 1; i < lxsize - 1; i++, pnt += AR_PIXEL_SIZE, pnt2++, dpnt++) { // Process columns.
 #    endif
 #  else
-    pnt = &(image[(xsize*2 + 2)*AR_PIXEL_SIZE]);
-    for(j = 1; j < lysize - 1; j++, pnt += AR_PIXEL_SIZE*4, pnt2 += 2, dpnt += 2) {
+    pnt = &(image[(xsize*2 + 2 + (rowStart - 1)*(lxsize*2 + xsize))*AR_PIXEL_SIZE]); // Each row advances by lxsize*2 + xsize pixels.
+    for(j = rowStart; j < rowEnd; j++, pnt += AR_PIXEL_SIZE*4, pnt2 += 2, dpnt += 2) {
         for(i = 1; i < lxsize - 1; i++, pnt += AR_PIXEL_SIZE*2, pnt2++, dpnt++) {
 #  endif
 #else
 #  ifdef AR_LABELING_FRAME_IMAGE_F
-    pnt = &(image[(xsize + 1)*AR_PIXEL_SIZE]); // Start on 2nd pixel of 2nd row.
+    pnt = &(image[(rowStart*xsize + 1)*AR_PIXEL_SIZE]); // Start on 2nd pixel of first row of band.
 #    ifdef AR_LABELING_ADAPTIVE
-    pnt_thresh = &(image_thresh[(xsize + 1)*AR_PIXEL_SIZE]);
-    for(j = 1; j < lysize - 1; j++, pnt += AR_PIXEL_SIZE*2, pnt_thresh += AR_PIXEL_SIZE*2, pnt2 += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
+    pnt_thresh = &(image_thresh[(rowStart*xsize + 1)*AR_PIXEL_SIZE]);
+    for(j = rowStart; j < rowEnd; j++, pnt += AR_PIXEL_SIZE*2, pnt_thresh += AR_PIXEL_SIZE*2, pnt2 += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
         for(i = 1; i < lxsize - 1; i++, pnt += AR_PIXEL_SIZE, pnt_thresh += AR_PIXEL_SIZE, pnt2++) { // Process columns.
 #    else
-    for(j = 1; j < lysize - 1; j++, pnt += AR_PIXEL_SIZE*2, pnt2 += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
+    for(j = rowStart; j < rowEnd; j++, pnt += AR_PIXEL_SIZE*2, pnt2 += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
         for(i = 1; i < lxsize - 1; i++, pnt += AR_PIXEL_SIZE, pnt2++) { // Process columns.
 #    endif
 #  else
-    pnt = &(image[(xsize*2 + 2)*AR_PIXEL_SIZE]);
-    for(j = 1; j < lysize - 1; j++, pnt += AR_PIXEL_SIZE*4, pnt2 += 2) {
+    pnt = &(image[(xsize*2 + 2 + (rowStart - 1)*(lxsize*2 + xsize))*AR_PIXEL_SIZE]); // Each row advances by lxsize*2 + xsize pixels.
+    for(j = rowStart; j < rowEnd; j++, pnt += AR_PIXEL_SIZE*4, pnt2 += 2) {
         for(i = 1; i < lxsize - 1; i++, pnt += AR_PIXEL_SIZE*2, pnt2++) {
 #  endif
 #endif // AR_LABELING_DEBUG_ENABLE_F
@@ -206,7 +217,8 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
 #  ifdef AR_LABELING_DEBUG_ENABLE_F
                 *dpnt = 255;
 #  endif
-                pnt1 = &(pnt2[-lxsize]);
+                // The row above the first row of a band belongs to another band, so is read as background.
+                pnt1 = (j == rowStart && zeroRow) ? &(zeroRow[i]) : &(pnt2[-lxsize]);
                 if( *pnt1 > 0 ) {
                     *pnt2 = *pnt1;
                     l = ((*pnt2) - 1) * 7;
@@ -221,7 +233,7 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
                         n = work[*(pnt1-1)-1];
                         if( m > n ) {
                             *pnt2 = n;
-                            wk = &(work[0]);
+                            wk = &(work[labelBase]);
                             for(k = 0; k < wk_max; k++) {
                                 if( *wk == m ) *wk = n;
                                 wk++;
@@ -229,7 +241,7 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
                         }
                         else if( m < n ) {
                             *pnt2 = m;
-                            wk = &(work[0]);
+                            wk = &(work[labelBase]);
                             for(k = 0; k < wk_max; k++) {
                                 if( *wk == n ) *wk = m;
                                 wk++;
@@ -247,7 +259,7 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
                         n = work[*(pnt2-1)-1];
                         if( m > n ) {
                             *pnt2 = n;
-                            wk = &(work[0]);
+                            wk = &(work[labelBase]);
                             for(k = 0; k < wk_max; k++) {
                                 if( *wk == m ) *wk = n;
                                 wk++;
@@ -255,7 +267,7 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
                         }
                         else if( m < n ) {
                             *pnt2 = m;
-                            wk = &(work[0]);
+                            wk = &(work[labelBase]);
                             for(k = 0; k < wk_max; k++) {
                                 if( *wk == n ) *wk = m;
                                 wk++;
@@ -296,12 +308,11 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
                 }
                 else {
                     wk_max++;
-                    if( wk_max > AR_LABELING_WORK_SIZE ) {
-                        ARLOGe("Error: labeling work overflow.\n");
-                        return(-1);
+                    if( wk_max > labelMax ) {
+                        return(-1); // Labeling work overflow. Reported by the caller.
                     }
-                    work[wk_max-1] = *pnt2 = wk_max;
-                    l = (wk_max-1)*7;
+                    work[labelBase+wk_max-1] = *pnt2 = labelBase + wk_max;
+                    l = (labelBase+wk_max-1)*7;
                     work2[l+0] = 1; // area
                     work2[l+1] = i; // pos[0]
                     work2[l+2] = j; // pos[1]
@@ -316,6 +327,26 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
                 *pnt2 = 0;
 #ifdef AR_LABELING_DEBUG_ENABLE_F
 				*dpnt = 0;
+#endif
+#ifdef AR_LABELING_SIMD_RUN
+                // Skip over any following blocks of pixels which are all also not in region.
+                if (runEnabled) {
+#  ifdef AR_LABELING_ADAPTIVE
+                    while (i + AR_LABELING_SIMD_RUN < lxsize - 1 && arLabelingSubRunIsOutside(pnt + AR_PIXEL_STEP, pnt_thresh + AR_PIXEL_STEP, 0, AR_PIXEL_STEP, AR_LABELING_WHITE)) {
+                        pnt_thresh += AR_LABELING_SIMD_RUN*AR_PIXEL_STEP;
+#  else
+                    while (i + AR_LABELING_SIMD_RUN < lxsize - 1 && arLabelingSubRunIsOutside(pnt + AR_PIXEL_STEP, NULL, (ARUint8)labelingThresh, AR_PIXEL_STEP, AR_LABELING_WHITE)) {
+#  endif
+                        memset(pnt2 + 1, 0, AR_LABELING_SIMD_RUN*sizeof(AR_LABELING_LABEL_TYPE));
+#  ifdef AR_LABELING_DEBUG_ENABLE_F
+                        memset(dpnt + 1, 0, AR_LABELING_SIMD_RUN);
+                        dpnt += AR_LABELING_SIMD_RUN;
+#  endif
+                        pnt += AR_LABELING_SIMD_RUN*AR_PIXEL_STEP;
+                        pnt2 += AR_LABELING_SIMD_RUN;
+                        i += AR_LABELING_SIMD_RUN;
+                    }
+                }
 #endif
             }
         }
@@ -324,6 +355,107 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
 #endif
     }
 
+    return (wk_max);
+}
+
+#ifndef AR_LABELING_ADAPTIVE
+#  ifndef AR_LABELING_DEBUG_ENABLE_F
+#    ifndef AR_LABELING_WHITE_REGION_F
+#      ifndef AR_LABELING_FRAME_IMAGE_F
+int arLabelingSubDBIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+#      else
+int arLabelingSubDBRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+#      endif // !AR_LABELING_FRAME_IMAGE_F
+#    else
+#      ifndef AR_LABELING_FRAME_IMAGE_F
+int arLabelingSubDWIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+#      else
+int arLabelingSubDWRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+#      endif // !AR_LABELING_FRAME_IMAGE_F
+#    endif // !AR_LABELING_WHITE_REGION_F
+#  else
+#    ifndef AR_LABELING_WHITE_REGION_F
+#      ifndef AR_LABELING_FRAME_IMAGE_F
+int arLabelingSubEBIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+#      else
+int arLabelingSubEBRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+#      endif // !AR_LABELING_FRAME_IMAGE_F
+#    else
+#      ifndef AR_LABELING_FRAME_IMAGE_F
+int arLabelingSubEWIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+#      else
+int arLabelingSubEWRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+#      endif // !AR_LABELING_FRAME_IMAGE_F
+#    endif // !AR_LABELING_WHITE_REGION_F
+#  endif // !AR_LABELING_DEBUG_ENABLE_F
+#else
+#  ifndef AR_LABELING_DEBUG_ENABLE_F
+#    ifndef AR_LABELING_WHITE_REGION_F
+int arLabelingSubDBZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo )
+#    else
+int arLabelingSubDWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo )
+#    endif // !AR_LABELING_WHITE_REGION_F
+#  else
+#    ifndef AR_LABELING_WHITE_REGION_F
+int arLabelingSubEBZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo )
+#    else
+int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo )
+#    endif // !AR_LABELING_WHITE_REGION_F
+#  endif // !AR_LABELING_DEBUG_ENABLE_F
+#endif
+{
+    int       lxsize, lysize;
+    AR_LABELING_LABEL_TYPE  *pnt1, *pnt2;             /*  image pointer into destination (label) image  */
+    int      *work, *work2;
+    int       wk_max;                   /*  work                */
+    int       i,j;                      /*  for loop            */
+    int       *wk;                      /*  pointer for work    */
+    int       *label_num;
+    int       *area;
+    int       *clip;
+    ARdouble  *pos;
+
+#ifdef AR_LABELING_FRAME_IMAGE_F
+    lxsize = xsize;
+    lysize = ysize;
+#else
+    lxsize = xsize / 2;
+    lysize = ysize / 2;
+#endif
+
+#ifdef AR_LABELING_DEBUG_ENABLE_F
+    //memset( labelInfo->bwImage, 0, lxsize*lysize );
+#endif
+
+	// Set top and bottom rows of labelImage to 0.
+    pnt1 = &(labelInfo->labelImage[0]); // Leftmost pixel of top row of image.
+    pnt2 = &(labelInfo->labelImage[(lysize - 1)*lxsize]); // Leftmost pixel of bottom row of image.
+    for(i = 0; i < lxsize; i++) {
+        *(pnt1++) = *(pnt2++) = 0;
+    }
+
+	// Set leftmost and rightmost columns of labelImage to 0.
+    pnt1 = &(labelInfo->labelImage[0]); // Leftmost pixel of top row of image.
+    pnt2 = &(labelInfo->labelImage[lxsize - 1]); // Rightmost pixel of top row of image.
+    for(i = 0; i < lysize; i++) {
+        *pnt1 = *pnt2 = 0;
+        pnt1 += lxsize;
+        pnt2 += lxsize;
+    }
+
+    // Label the whole image as a single band.
+#ifndef AR_LABELING_ADAPTIVE
+    wk_max = AR_LABELING_SUB_BAND(image, xsize, ysize, labelingThresh, labelInfo, 1, lysize - 1, 0, labelInfo->work_size, NULL);
+#else
+    wk_max = AR_LABELING_SUB_BAND(image, xsize, ysize, image_thresh, labelInfo, 1, lysize - 1, 0, labelInfo->work_size, NULL);
+#endif
+    if (wk_max < 0) {
+        ARLOGe("Error: labeling work overflow.\n");
+        return (-1);
+    }
+    work = labelInfo->work;
+    work2 = labelInfo->work2;
+
     label_num = &(labelInfo->label_num);
     area = &(labelInfo->area[0]);
     clip = &(labelInfo->clip[0][0]);
@@ -52,34 +52,35 @@
 #include <ARX/AR/ar.h>
 #include <ARX/AR/arMulti.h>
 
+static void      arMultiAssociateMarkers(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config);
 static ARdouble  arGetTransMatMultiSquare2(AR3DHandle *handle, ARMarkerInfo *marker_info, int marker_num,
                                          ARMultiMarkerInfoT *config, int robustFlag);
 
 ARdouble  arGetTransMatMultiSquare(AR3DHandle *handle, ARMarkerInfo *marker_info, int marker_num,
                                  ARMultiMarkerInfoT *config)
 {
+    arMultiAssociateMarkers(marker_info, marker_num, config);
     return arGetTransMatMultiSquare2(handle, marker_info, marker_num, config, 0);
 }
 
 ARdouble  arGetTransMatMultiSquareRobust(AR3DHandle *handle, ARMarkerInfo *marker_info, int marker_num,
                                        ARMultiMarkerInfoT *config)
 {
+    arMultiAssociateMarkers(marker_info, marker_num, config);
     return arGetTransMatMultiSquare2(handle, marker_info, marker_num, config, 1);
 }
 
-static ARdouble  arGetTransMatMultiSquare2(AR3DHandle *handle, ARMarkerInfo *marker_info, int marker_num,
-                                         ARMultiMarkerInfoT *config, int robustFlag)
+ARdouble  arGetTransMatMultiSquareAssociated(AR3DHandle *handle, ARMarkerInfo *marker_info, int marker_num,
+                                           ARMultiMarkerInfoT *config, int robustFlag)
+{
+    return arGetTransMatMultiSquare2(handle, marker_info, marker_num, config, robustFlag);
+}
+
+// Pass 1: find the best unmatched detected marker for each submarker.
+static void arMultiAssociateMarkers(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config)
 {
-    ARdouble              *pos2d, *pos3d;
-    ARdouble              trans1[3][4], trans2[3][4];
-    ARdouble              err, err2;
-    int                   max, maxArea;
-    int                   vnum;
-    int                   dir;
     int                   i, j, k;
-    //char  mes[12];
 
-    //ARLOGd("-- Pass1--\n");
     for( i = 0; i < config->marker_num; i++ ) {
         k = -1;
         if( config->marker[i].patt_type == AR_MULTI_PATTERN_TYPE_TEMPLATE ) {
@@ -111,6 +112,19 @@ static ARdouble  arGetTransMatMultiSquare2(AR3DHandle *handle, ARMarkerInfo *mar
         }
         //if(k>=0) ARLOGd(" *%d\n",i);
     }
+}
+
+static ARdouble  arGetTransMatMultiSquare2(AR3DHandle *handle, ARMarkerInfo *marker_info, int marker_num,
+                                         ARMultiMarkerInfoT *config, int robustFlag)
+{
+    ARdouble              *pos2d, *pos3d;
+    ARdouble              trans1[3][4], trans2[3][4];
+    ARdouble              err, err2;
+    int                   max, maxArea;
+    int                   vnum;
+    int                   dir;
+    int                   i, j, k;
+    //char  mes[12];
 
     //ARLOGd("-- Pass2--\n");
     vnum = 0;
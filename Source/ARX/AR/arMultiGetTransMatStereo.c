@@ -52,6 +52,9 @@
 #include <ARX/AR/ar.h>
 #include <ARX/AR/arMulti.h>
 
+static void      arMultiAssociateMarkersStereo(ARMarkerInfo *marker_infoL, int marker_numL,
+                                               ARMarkerInfo *marker_infoR, int marker_numR,
+                                               ARMultiMarkerInfoT *config);
 static ARdouble  arGetTransMatMultiSquareStereo2(AR3DStereoHandle *handle,
                                                ARMarkerInfo *marker_infoL, int marker_numL,
                                                ARMarkerInfo *marker_infoR, int marker_numR, 
@@ -63,6 +66,7 @@ ARdouble  arGetTransMatMultiSquareStereo(AR3DStereoHandle *handle,
                                        ARMarkerInfo *marker_infoR, int marker_numR, 
                                        ARMultiMarkerInfoT *config)
 {
+    arMultiAssociateMarkersStereo(marker_infoL, marker_numL, marker_infoR, marker_numR, config);
     return arGetTransMatMultiSquareStereo2(handle, marker_infoL, marker_numL, marker_infoR, marker_numR, 
                                            config, 0);
 }
@@ -72,24 +76,25 @@ ARdouble  arGetTransMatMultiSquareStereoRobust(AR3DStereoHandle *handle,
                                              ARMarkerInfo *marker_infoR, int marker_numR, 
                                              ARMultiMarkerInfoT *config)
 {
+    arMultiAssociateMarkersStereo(marker_infoL, marker_numL, marker_infoR, marker_numR, config);
     return arGetTransMatMultiSquareStereo2(handle, marker_infoL, marker_numL, marker_infoR, marker_numR, 
                                            config, 1);
 }
 
+ARdouble  arGetTransMatMultiSquareStereoAssociated(AR3DStereoHandle *handle,
+                                                 ARMarkerInfo *marker_infoL, int marker_numL,
+                                                 ARMarkerInfo *marker_infoR, int marker_numR,
+                                                 ARMultiMarkerInfoT *config, int robustFlag)
+{
+    return arGetTransMatMultiSquareStereo2(handle, marker_infoL, marker_numL, marker_infoR, marker_numR,
+                                           config, robustFlag);
+}
 
-static ARdouble  arGetTransMatMultiSquareStereo2(AR3DStereoHandle *handle,
-                                               ARMarkerInfo *marker_infoL, int marker_numL,
-                                               ARMarkerInfo *marker_infoR, int marker_numR, 
-                                               ARMultiMarkerInfoT *config, int robustFlag)
-
+// Find the best unmatched detected marker in each view for each submarker.
+static void arMultiAssociateMarkersStereo(ARMarkerInfo *marker_infoL, int marker_numL,
+                                          ARMarkerInfo *marker_infoR, int marker_numR,
+                                          ARMultiMarkerInfoT *config)
 {
-    ARdouble                *pos2dL = NULL, *pos3dL = NULL;
-    ARdouble                *pos2dR = NULL, *pos3dR = NULL;
-    ARdouble                trans1[3][4], trans2[3][4];
-    ARdouble                err, err2;
-    int                   max, maxArea;
-    int                   vnumL, vnumR;
-    int                   dir;
     int                   i, j, k;
 
     for( i = 0; i < config->marker_num; i++ ) {
@@ -159,6 +164,23 @@ static ARdouble  arGetTransMatMultiSquareStereo2(AR3DStereoHandle *handle,
             }
         }
     }
+}
+
+
+static ARdouble  arGetTransMatMultiSquareStereo2(AR3DStereoHandle *handle,
+                                               ARMarkerInfo *marker_infoL, int marker_numL,
+                                               ARMarkerInfo *marker_infoR, int marker_numR, 
+                                               ARMultiMarkerInfoT *config, int robustFlag)
+
+{
+    ARdouble                *pos2dL = NULL, *pos3dL = NULL;
+    ARdouble                *pos2dR = NULL, *pos3dR = NULL;
+    ARdouble                trans1[3][4], trans2[3][4];
+    ARdouble                err, err2;
+    int                   max, maxArea;
+    int                   vnumL, vnumR;
+    int                   dir;
+    int                   i, j, k;
 
     vnumL = 0;
     for( i = 0; i < config->marker_num; i++ ) {
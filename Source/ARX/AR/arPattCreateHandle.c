@@ -81,6 +81,10 @@ ARPattHandle *arPattCreateHandle2(const int pattSize, const int patternCountMax)
             arMalloc(pattHandle->pattBW[i*4 + j], int, pattSize*pattSize);
         }
     }
+    pattHandle->pattBankStride = (pattSize*pattSize*3 + 7) & ~7;
+    pattHandle->pattBankStrideBW = (pattSize*pattSize + 7) & ~7;
+    arMallocClear(pattHandle->pattBank, int16_t, patternCountMax*4*pattHandle->pattBankStride);
+    arMallocClear(pattHandle->pattBankBW, int16_t, patternCountMax*4*pattHandle->pattBankStrideBW);
 
     return pattHandle;
 }
@@ -104,6 +108,8 @@ int arPattDeleteHandle(ARPattHandle *pattHandle)
 	free(pattHandle->pattf);
 	free(pattHandle->pattpow);
 	free(pattHandle->pattpowBW);
+	free(pattHandle->pattBank);
+	free(pattHandle->pattBankBW);
 	
 	free(pattHandle);
 	pattHandle = NULL;
@@ -51,6 +51,16 @@
 #include <math.h>
 #include <stdint.h>
 #include <stdbool.h>
+#if defined(_WINRT)
+#  include <windows.h> // InitOnceExecuteOnce()
+#elif !defined(ARUTIL_DISABLE_PTHREADS)
+#  include <pthread.h>
+#endif
+#if HAVE_ARM_NEON || HAVE_ARM64_NEON
+#  include <arm_neon.h>
+#elif HAVE_INTEL_SIMD
+#  include <emmintrin.h> // SSE2.
+#endif
 #if DEBUG_PATT_GETID
 #  ifndef __APPLE__
 #    include <GL/gl.h>
@@ -1689,16 +1699,53 @@ static void get_cpara( ARdouble world[4][2], ARdouble vertex[4][2],
     arMatrixFree( c );
 }
 
+// Returns the dot product of two int16_t vectors of length n, which must be a multiple of 8.
+static int pattern_correlate( const int16_t *a, const int16_t *b, const int n )
+{
+    int i;
+#if HAVE_ARM_NEON || HAVE_ARM64_NEON
+    int32x4_t acc = vdupq_n_s32(0);
+    for (i = 0; i < n; i += 8) {
+        int16x8_t va = vld1q_s16(a + i);
+        int16x8_t vb = vld1q_s16(b + i);
+        acc = vmlal_s16(acc, vget_low_s16(va), vget_low_s16(vb));
+        acc = vmlal_s16(acc, vget_high_s16(va), vget_high_s16(vb));
+    }
+#  if HAVE_ARM64_NEON
+    return (vaddvq_s32(acc));
+#  else
+    int32x2_t acc2 = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+    acc2 = vpadd_s32(acc2, acc2);
+    return (vget_lane_s32(acc2, 0));
+#  endif
+#elif HAVE_INTEL_SIMD
+    __m128i acc = _mm_setzero_si128();
+    for (i = 0; i < n; i += 8) {
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i))));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (_mm_cvtsi128_si32(acc));
+#else
+    int sum = 0;
+    for (i = 0; i < n; i++) sum += a[i] * b[i];
+    return (sum);
+#endif
+}
+
 static int pattern_match( ARPattHandle *pattHandle, int mode, ARUint8 *data, int size, int *code, int *dir, ARdouble *cf )
 {
-    int   *input = NULL;
+    int16_t input[AR_PATT_SIZE1_MAX*AR_PATT_SIZE1_MAX*3]; // Zero-mean input, zero-padded to the bank stride. AR_PATT_SIZE1_MAX is a multiple of 8.
+    const int16_t *bank;
+    const ARdouble *pow;
+    int    stride, count;
     int    sum, ave;
     int    res1, res2;
-    int    i, j, k, l;
+    int    i, j, k;
     ARdouble datapow;
     ARdouble sum2, max;
 
-    if ( pattHandle == NULL || 0 >= size ) {
+    if ( pattHandle == NULL || 0 >= size || size > AR_PATT_SIZE1_MAX ) {
         *code = 0;
         *dir  = 0;
         *cf   = -_1_0;
@@ -1706,173 +1753,71 @@ static int pattern_match( ARPattHandle *pattHandle, int mode, ARUint8 *data, int
     }
 
     if ( mode == AR_TEMPLATE_MATCHING_COLOR ) {
-        const int SIZE_SQD_X3 = size*size*3;
-        
-        arMalloc( input, int, SIZE_SQD_X3 );
-        if ( NULL == input ) {
-            return -1;
-        }
-
-        sum = ave = 0;
-        for (i=0; i < SIZE_SQD_X3; i++) {
-            ave += (255-data[i]);
-        }
-        ave /= (SIZE_SQD_X3);
-
-        for (i=0; i < SIZE_SQD_X3; i++) {
-            input[i] = (255-data[i]) - ave;
-            sum += input[i]*input[i];
-        }
-
-        datapow = SQRT( (ARdouble)sum );
-        //if( datapow == 0.0 ) {
-        if ( datapow/(size*SQRT_3_0) < AR_PATT_CONTRAST_THRESH1 ) {
-            *code = 0;
-            *dir  = 0;
-            *cf   = -_1_0;
-            free( input );
-            return -2; // Insufficient contrast.
-        }
-
-        res1 = res2 = -1;
-        k = -1; // Best match in search space.
-        max = _0_0;
-        for ( l = 0; l < pattHandle->patt_num; l++ ) { // Consider the whole search space.
-            k++;
-            while( pattHandle->pattf[k] == 0 ) k++; // No pattern at this slot.
-            if( pattHandle->pattf[k] == 2 ) continue; // Pattern at this slot is deactivated.
-            for( j = 0; j < 4; j++ ) { // The 4 rotated variants of the pattern.
-                sum = 0;
-                for(i=0; i < SIZE_SQD_X3; i++)
-                    sum += input[i] * pattHandle->patt[k * 4 + j][i]; // Correlation operation.
-                sum2 = sum / pattHandle->pattpow[k*4 + j] / datapow;
-                if( sum2 > max ) { max = sum2; res1 = j; res2 = k; }
-            }
-        }
-        *dir  = res1;
-        *code = res2;
-        *cf   = max;
+        count  = size*size*3;
+        stride = pattHandle->pattBankStride;
+        bank   = pattHandle->pattBank;
+        pow    = pattHandle->pattpow;
+    } else if ( mode == AR_TEMPLATE_MATCHING_MONO ) {
+        count  = size*size;
+        stride = pattHandle->pattBankStrideBW;
+        bank   = pattHandle->pattBankBW;
+        pow    = pattHandle->pattpowBW;
+    } else {
+        return -1;
+    }
 
-        free( input );
-        return 0;
+    sum = ave = 0;
+    for (i=0; i < count; i++) {
+        ave += (255-data[i]);
     }
-    else if ( mode == AR_TEMPLATE_MATCHING_MONO ) {
-        const int SIZE_SQD = size*size;
+    ave /= count;
 
-        arMalloc( input, int, SIZE_SQD );
-        if ( NULL == input ) {
-            return -1;
-        }
-        
-        sum = ave = 0;
-        for ( i=0; i < SIZE_SQD; i++ ) {
-            ave += (255-data[i]);
-        }
-        ave /= (SIZE_SQD);
+    for (i=0; i < count; i++) {
+        input[i] = (int16_t)((255-data[i]) - ave);
+        sum += input[i]*input[i];
+    }
+    for (; i < stride; i++) input[i] = 0;
 
-        for ( i=0; i < SIZE_SQD; i++ ) {
-            input[i] = (255-data[i]) - ave;
-            sum += input[i] * input[i];
-        }
+    datapow = SQRT( (ARdouble)sum );
+    //if( datapow == 0.0 ) {
+    if ( (mode == AR_TEMPLATE_MATCHING_COLOR ? datapow/(size*SQRT_3_0) : datapow/size) < AR_PATT_CONTRAST_THRESH1 ) {
+        *code = 0;
+        *dir  = 0;
+        *cf   = -_1_0;
+        return -2; // Insufficient contrast.
+    }
 
-        datapow = SQRT( (ARdouble)sum );
-        //if( datapow == 0.0 ) {
-        if ( datapow/size < AR_PATT_CONTRAST_THRESH1 ) {
-            *code = 0;
-            *dir  = 0;
-            *cf   = -_1_0;
-            free( input );
-            return -2; // Insufficient contrast.
-        }
-
-        res1 = res2 = -1;
-        k = -1;
-        max = _0_0;
-        for ( l = 0; l < pattHandle->patt_num; l++ ) {
-            k++;
-            while ( pattHandle->pattf[k] == 0 ) k++;
-            if ( pattHandle->pattf[k] == 2 ) continue;
-            for ( j = 0; j < 4; j++ ) {
-                sum = 0;
-                for ( i=0; i < SIZE_SQD; i++ )
-                    sum += input[i] * (pattHandle->pattBW[k * 4 + j][i]);
-                sum2 = sum / pattHandle->pattpowBW[k * 4 + j] / datapow;
-                if ( sum2 > max ) { max = sum2; res1 = j; res2 = k; }
-            }
+    res1 = res2 = -1;
+    max = _0_0;
+    for ( k = 0; k < pattHandle->patt_num_max; k++ ) { // Consider the whole search space.
+        if ( pattHandle->pattf[k] != 1 ) continue; // No pattern at this slot, or pattern is deactivated.
+        for ( j = 0; j < 4; j++ ) { // The 4 rotated variants of the pattern.
+            sum = pattern_correlate(input, &(bank[(k*4 + j)*stride]), stride); // Correlation operation.
+            sum2 = sum / pow[k*4 + j] / datapow;
+            if ( sum2 > max ) { max = sum2; res1 = j; res2 = k; }
         }
-        *dir  = res1;
-        *code = res2;
-        *cf   = max;
-
-        free( input );
-        return 0;
-    }
-    else {
-        return -1;
     }
+    *dir  = res1;
+    *code = res2;
+    *cf   = max;
+
+    return 0;
 }
 
-static int decode_bch(const AR_MATRIX_CODE_TYPE matrixCodeType, const uint64_t in, uint8_t recd127[127], uint64_t *out_p)
+static const int bch_15_alpha_to[15] = {1, 2, 4, 8, 3, 6, 12, 11, 5, 10, 7, 14, 15, 13, 9};
+static const int bch_15_index_of[16] = {-1, 0, 1, 4, 2, 8, 5, 10, 3, 14, 9, 7, 6, 13, 11, 12};
+static const int bch_31_alpha_to[31] = {1, 2, 4, 8, 16, 5, 10, 20, 13, 26, 17, 7, 14, 28, 29, 31, 27, 19, 3, 6, 12, 24, 21, 15, 30, 25, 23, 11, 22, 9, 18};
+static const int bch_31_index_of[32] = {-1, 0, 1, 18, 2, 5, 19, 11, 3, 29, 6, 27, 20, 8, 12, 23, 4, 10, 30, 17, 7, 22, 28, 26, 21, 25, 9, 16, 13, 14, 24, 15};
+static const int bch_127_alpha_to[127] = {1, 2, 4, 8, 16, 32, 64, 3, 6, 12, 24, 48, 96, 67, 5, 10, 20, 40, 80, 35, 70, 15, 30, 60, 120, 115, 101, 73, 17, 34, 68, 11, 22, 44, 88, 51, 102, 79, 29, 58, 116, 107, 85, 41, 82, 39, 78, 31, 62, 124, 123, 117, 105, 81, 33, 66, 7, 14, 28, 56, 112, 99, 69, 9, 18, 36, 72, 19, 38, 76, 27, 54, 108, 91, 53, 106, 87, 45, 90, 55, 110, 95, 61, 122, 119, 109, 89, 49, 98, 71, 13, 26, 52, 104, 83, 37, 74, 23, 46, 92, 59, 118, 111, 93, 57, 114, 103, 77, 25, 50, 100, 75, 21, 42, 84, 43, 86, 47, 94, 63, 126, 127, 125, 121, 113, 97, 65};
+static const int bch_127_index_of[128] = {-1, 0, 1, 7, 2, 14, 8, 56, 3, 63, 15, 31, 9, 90, 57, 21, 4, 28, 64, 67, 16, 112, 32, 97, 10, 108, 91, 70, 58, 38, 22, 47, 5, 54, 29, 19, 65, 95, 68, 45, 17, 43, 113, 115, 33, 77, 98, 117, 11, 87, 109, 35, 92, 74, 71, 79, 59, 104, 39, 100, 23, 82, 48, 119, 6, 126, 55, 13, 30, 62, 20, 89, 66, 27, 96, 111, 69, 107, 46, 37, 18, 53, 44, 94, 114, 42, 116, 76, 34, 86, 78, 73, 99, 103, 118, 81, 12, 125, 88, 61, 110, 26, 36, 106, 93, 52, 75, 41, 72, 85, 80, 102, 60, 124, 105, 25, 40, 51, 101, 84, 24, 123, 83, 50, 49, 122, 120, 121};
+
+// Corrects up to t errors in recd[0..length-1] in place.
+// Returns -1 if the errors are uncorrectable, else the number of errors corrected.
+static int decode_bch_recd(const int t, const int n, const int length, const int *alpha_to, const int *index_of, uint8_t *recd)
 {
-    uint64_t in_bitwise;
-    uint8_t *recd;
-    uint64_t out_bit;
-    int t, n, length, k;
-    uint8_t recd64[64];
-    const int *alpha_to, *index_of;
-    const int bch_15_alpha_to[15] = {1, 2, 4, 8, 3, 6, 12, 11, 5, 10, 7, 14, 15, 13, 9};
-    const int bch_15_index_of[16] = {-1, 0, 1, 4, 2, 8, 5, 10, 3, 14, 9, 7, 6, 13, 11, 12};
-    const int bch_31_alpha_to[31] = {1, 2, 4, 8, 16, 5, 10, 20, 13, 26, 17, 7, 14, 28, 29, 31, 27, 19, 3, 6, 12, 24, 21, 15, 30, 25, 23, 11, 22, 9, 18};
-    const int bch_31_index_of[32] = {-1, 0, 1, 18, 2, 5, 19, 11, 3, 29, 6, 27, 20, 8, 12, 23, 4, 10, 30, 17, 7, 22, 28, 26, 21, 25, 9, 16, 13, 14, 24, 15};
-    const int bch_127_alpha_to[127] = {1, 2, 4, 8, 16, 32, 64, 3, 6, 12, 24, 48, 96, 67, 5, 10, 20, 40, 80, 35, 70, 15, 30, 60, 120, 115, 101, 73, 17, 34, 68, 11, 22, 44, 88, 51, 102, 79, 29, 58, 116, 107, 85, 41, 82, 39, 78, 31, 62, 124, 123, 117, 105, 81, 33, 66, 7, 14, 28, 56, 112, 99, 69, 9, 18, 36, 72, 19, 38, 76, 27, 54, 108, 91, 53, 106, 87, 45, 90, 55, 110, 95, 61, 122, 119, 109, 89, 49, 98, 71, 13, 26, 52, 104, 83, 37, 74, 23, 46, 92, 59, 118, 111, 93, 57, 114, 103, 77, 25, 50, 100, 75, 21, 42, 84, 43, 86, 47, 94, 63, 126, 127, 125, 121, 113, 97, 65};
-    const int bch_127_index_of[128] = {-1, 0, 1, 7, 2, 14, 8, 56, 3, 63, 15, 31, 9, 90, 57, 21, 4, 28, 64, 67, 16, 112, 32, 97, 10, 108, 91, 70, 58, 38, 22, 47, 5, 54, 29, 19, 65, 95, 68, 45, 17, 43, 113, 115, 33, 77, 98, 117, 11, 87, 109, 35, 92, 74, 71, 79, 59, 104, 39, 100, 23, 82, 48, 119, 6, 126, 55, 13, 30, 62, 20, 89, 66, 27, 96, 111, 69, 107, 46, 37, 18, 53, 44, 94, 114, 42, 116, 76, 34, 86, 78, 73, 99, 103, 118, 81, 12, 125, 88, 61, 110, 26, 36, 106, 93, 52, 75, 41, 72, 85, 80, 102, 60, 124, 105, 25, 40, 51, 101, 84, 24, 123, 83, 50, 49, 122, 120, 121};
     int i, j, u, q, t2, count = 0, syn_error = 0;
 	int elp[20][18], d[20], l[20], u_lu[20], s[19], loc[127], reg[10]; // int elp[t2 + 2, t2], d[t2 + 2], l[t2 + 2], u_lu[t2 + 2], s[t2 + 1], loc[n], reg[t + 1].
-    
-    if (matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_9_3 || matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_5_5 || matrixCodeType == AR_MATRIX_CODE_5x5_BCH_22_12_5 || matrixCodeType == AR_MATRIX_CODE_5x5_BCH_22_7_7) {
-        if (matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_9_3 || matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_5_5) {
-            if (matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_9_3) {
-                t = 1; k = 9;
-            } else { // matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_5_5
-                t = 2; k = 5;
-            }
-            n = 15;
-            length = 13;
-            alpha_to = bch_15_alpha_to;
-            index_of = bch_15_index_of;
-        } else { // matrixCodeType == AR_MATRIX_CODE_5x5_BCH_22_12_5 || matrixCodeType == AR_MATRIX_CODE_5x5_BCH_22_7_7
-            if (matrixCodeType == AR_MATRIX_CODE_5x5_BCH_22_12_5) {
-                t = 2; k = 12;
-            } else { // matrixCodeType == AR_MATRIX_CODE_5x5_BCH_22_7_7
-                t = 3; k = 7;
-            }
-            n = 31;
-            length = 22;
-            alpha_to = bch_31_alpha_to;
-            index_of = bch_31_index_of;
-        }
-        // Unpack input into recd64[]. recd64[0] is least significant bit.
-        in_bitwise = in;
-        for (i = 0; i < length; i++) {
-            recd64[i] = (uint8_t)(in_bitwise & 1);
-            in_bitwise = in_bitwise >> 1;
-        }
-        recd = recd64;
-    } else if (matrixCodeType == AR_MATRIX_CODE_GLOBAL_ID) {
-        t = 9; k = 64;
-        n = 127;
-        length = 120;
-        alpha_to = bch_127_alpha_to;
-        index_of = bch_127_index_of;
-        recd = recd127;
-    } else {
-#ifdef DEBUG_BCH
-        ARLOGe("Error: unsupported BCH code.\n");
-#endif
-        return (-1); // Unsupported code.
-    }
-    
-    
+
     /*
      * Simon Rockliff's implementation of Berlekamp's algorithm.
      * Copyright (c) 1994-7,  Robert Morelos-Zaragoza. All rights reserved.
@@ -2037,6 +1982,209 @@ static int decode_bch(const AR_MATRIX_CODE_TYPE matrixCodeType, const uint64_t i
         }
 	} // End syn_error.
     
+    if (syn_error) return (l[u]);
+    else return (0);
+}
+
+// Parameters of the shortened BCH codes used by matrix codes, and their syndrome decoding tables.
+// The table for each code is indexed by the concatenation of the odd syndromes s1, s3, .. s(2t-1)
+// in polynomial form (m bits each), which determine the error pattern found by decode_bch_recd().
+// Each entry holds the error mask in bits 0-23 and (errors corrected + 1) in bits 24-31, with 0 meaning uncorrectable.
+typedef struct {
+    AR_MATRIX_CODE_TYPE matrixCodeType;
+    int t, k, n, m, length;
+    const int *alpha_to, *index_of;
+    uint32_t (*syndrome)[256];  // Per input byte, the syndrome contribution of each byte value.
+    uint32_t *table;            // 1 << (m*t) entries.
+    int built;                  // Only valid after the table's build has run. See bch_table_get().
+} BCHTable;
+
+static uint32_t bch_13_9_3_syndrome[2][256], bch_13_9_3_table[1 << 4];
+static uint32_t bch_13_5_5_syndrome[2][256], bch_13_5_5_table[1 << 8];
+static uint32_t bch_22_12_5_syndrome[3][256], bch_22_12_5_table[1 << 10];
+static uint32_t bch_22_7_7_syndrome[3][256], bch_22_7_7_table[1 << 15];
+
+static BCHTable bchTables[4] = {
+    {AR_MATRIX_CODE_4x4_BCH_13_9_3,  1,  9, 15, 4, 13, bch_15_alpha_to, bch_15_index_of, bch_13_9_3_syndrome,  bch_13_9_3_table,  0},
+    {AR_MATRIX_CODE_4x4_BCH_13_5_5,  2,  5, 15, 4, 13, bch_15_alpha_to, bch_15_index_of, bch_13_5_5_syndrome,  bch_13_5_5_table,  0},
+    {AR_MATRIX_CODE_5x5_BCH_22_12_5, 2, 12, 31, 5, 22, bch_31_alpha_to, bch_31_index_of, bch_22_12_5_syndrome, bch_22_12_5_table, 0},
+    {AR_MATRIX_CODE_5x5_BCH_22_7_7,  3,  7, 31, 5, 22, bch_31_alpha_to, bch_31_index_of, bch_22_7_7_syndrome,  bch_22_7_7_table,  0}
+};
+
+static int get_bch_table_index(const AR_MATRIX_CODE_TYPE matrixCodeType)
+{
+    int i;
+    for (i = 0; i < 4; i++) {
+        if (bchTables[i].matrixCodeType == matrixCodeType) return (i);
+    }
+    return (-1);
+}
+
+static uint32_t bch_syndrome_slow(const BCHTable *bch, const uint32_t in)
+{
+    uint32_t syn = 0, si;
+    int i, j;
+    
+    for (i = 0; i < bch->t; i++) {
+        si = 0;
+        for (j = 0; j < bch->length; j++) {
+            if (in & (1u << j)) si ^= bch->alpha_to[((2*i + 1) * j) % bch->n];
+        }
+        syn |= si << (bch->m * i);
+    }
+    return (syn);
+}
+
+static uint32_t bch_syndrome(const BCHTable *bch, const uint32_t in)
+{
+    uint32_t syn = bch->syndrome[0][in & 0xff] ^ bch->syndrome[1][(in >> 8) & 0xff];
+    if (bch->length > 16) syn ^= bch->syndrome[2][(in >> 16) & 0xff];
+    return (syn);
+}
+
+static void bch_table_build(BCHTable *bch)
+{
+    uint8_t *seen;
+    uint8_t recd64[64];
+    uint32_t in, syn, corrected, synCount, synFound;
+    int i, b, ret;
+    
+    // The syndrome is linear in the input, so it can be summed per byte.
+    for (b = 0; b < (bch->length + 7)/8; b++) {
+        for (i = 0; i < 256; i++) bch->syndrome[b][i] = bch_syndrome_slow(bch, ((uint32_t)i << (8*b)) & ((1u << bch->length) - 1));
+    }
+    
+    // Every syndrome is reachable from some input, so enumerate inputs until each
+    // syndrome has been seen once, decoding a representative input for each.
+    synCount = 1u << (bch->m * bch->t);
+    arMallocClear(seen, uint8_t, synCount);
+    synFound = 0;
+    for (in = 0; in < (1u << bch->length) && synFound < synCount; in++) {
+        syn = bch_syndrome(bch, in);
+        if (seen[syn]) continue;
+        seen[syn] = 1;
+        synFound++;
+        for (i = 0; i < bch->length; i++) recd64[i] = (uint8_t)((in >> i) & 1);
+        ret = decode_bch_recd(bch->t, bch->n, bch->length, bch->alpha_to, bch->index_of, recd64);
+        if (ret < 0) {
+            bch->table[syn] = 0;
+        } else {
+            corrected = 0;
+            for (i = 0; i < bch->length; i++) corrected |= (uint32_t)recd64[i] << i;
+            bch->table[syn] = ((uint32_t)(ret + 1) << 24) | (in ^ corrected);
+        }
+    }
+    free(seen);
+    if (synFound < synCount) {
+        ARLOGe("Error: unable to build BCH decoding table.\n");
+        return;
+    }
+    
+    bch->built = 1;
+}
+
+// The tables are shared by all handles, which may be used from different threads, so each is
+// built exactly once, and every reader synchronises with the build before looking at it.
+#if defined(_WINRT)
+static BOOL CALLBACK bch_table_build_once(PINIT_ONCE once, PVOID param, PVOID *context)
+{
+    bch_table_build((BCHTable *)param);
+    return (TRUE);
+}
+static INIT_ONCE bchTableOnce[4] = {INIT_ONCE_STATIC_INIT, INIT_ONCE_STATIC_INIT, INIT_ONCE_STATIC_INIT, INIT_ONCE_STATIC_INIT};
+#elif !defined(ARUTIL_DISABLE_PTHREADS)
+static void bch_table_build_0(void) { bch_table_build(&bchTables[0]); }
+static void bch_table_build_1(void) { bch_table_build(&bchTables[1]); }
+static void bch_table_build_2(void) { bch_table_build(&bchTables[2]); }
+static void bch_table_build_3(void) { bch_table_build(&bchTables[3]); }
+static void (* const bchTableBuild[4])(void) = {bch_table_build_0, bch_table_build_1, bch_table_build_2, bch_table_build_3};
+static pthread_once_t bchTableOnce[4] = {PTHREAD_ONCE_INIT, PTHREAD_ONCE_INIT, PTHREAD_ONCE_INIT, PTHREAD_ONCE_INIT};
+#else
+static int bchTableOnce[4] = {0, 0, 0, 0}; // Without thread support, there is only one thread to build.
+#endif
+
+// Returns the built table for matrixCodeType, building it if need be, or NULL if the type is not table-decoded.
+static BCHTable *bch_table_get(const AR_MATRIX_CODE_TYPE matrixCodeType)
+{
+    int i;
+    
+    if ((i = get_bch_table_index(matrixCodeType)) < 0) return (NULL);
+#if defined(_WINRT)
+    InitOnceExecuteOnce(&bchTableOnce[i], bch_table_build_once, &bchTables[i], NULL);
+#elif !defined(ARUTIL_DISABLE_PTHREADS)
+    pthread_once(&bchTableOnce[i], bchTableBuild[i]);
+#else
+    if (!bchTableOnce[i]) {
+        bch_table_build(&bchTables[i]);
+        bchTableOnce[i] = 1;
+    }
+#endif
+    return (bchTables[i].built ? &bchTables[i] : NULL);
+}
+
+int arPattBCHTableInit(const AR_MATRIX_CODE_TYPE matrixCodeType)
+{
+    return (bch_table_get(matrixCodeType) ? 0 : -1);
+}
+
+static int decode_bch(const AR_MATRIX_CODE_TYPE matrixCodeType, const uint64_t in, uint8_t recd127[127], uint64_t *out_p)
+{
+    uint64_t in_bitwise;
+    uint8_t *recd;
+    uint64_t out_bit;
+    int t, n, length, k;
+    uint8_t recd64[64];
+    const int *alpha_to, *index_of;
+    BCHTable *bch;
+    uint32_t entry, corrected;
+    int i, ret;
+    
+    if (matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_9_3 || matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_5_5 || matrixCodeType == AR_MATRIX_CODE_5x5_BCH_22_12_5 || matrixCodeType == AR_MATRIX_CODE_5x5_BCH_22_7_7) {
+        if ((bch = bch_table_get(matrixCodeType))) {
+            // Table-driven decode.
+            corrected = (uint32_t)in & ((1u << bch->length) - 1);
+            entry = bch->table[bch_syndrome(bch, corrected)];
+            if (!entry) {
+#ifdef DEBUG_BCH
+                ARLOGe("Uncorrectable.\n");
+#endif
+                return (-1);
+            }
+            corrected ^= entry & 0x00ffffff;
+            *out_p = (uint64_t)((corrected >> (bch->length - bch->k)) & ((1u << bch->k) - 1));
+            return ((int)(entry >> 24) - 1);
+        }
+        // No table, so run the decoder directly.
+        bch = &bchTables[get_bch_table_index(matrixCodeType)];
+        t = bch->t; k = bch->k;
+        n = bch->n;
+        length = bch->length;
+        alpha_to = bch->alpha_to;
+        index_of = bch->index_of;
+        // Unpack input into recd64[]. recd64[0] is least significant bit.
+        in_bitwise = in;
+        for (i = 0; i < length; i++) {
+            recd64[i] = (uint8_t)(in_bitwise & 1);
+            in_bitwise = in_bitwise >> 1;
+        }
+        recd = recd64;
+    } else if (matrixCodeType == AR_MATRIX_CODE_GLOBAL_ID) {
+        t = 9; k = 64;
+        n = 127;
+        length = 120;
+        alpha_to = bch_127_alpha_to;
+        index_of = bch_127_index_of;
+        recd = recd127;
+    } else {
+#ifdef DEBUG_BCH
+        ARLOGe("Error: unsupported BCH code.\n");
+#endif
+        return (-1); // Unsupported code.
+    }
+    
+    ret = decode_bch_recd(t, n, length, alpha_to, index_of, recd);
+    if (ret < 0) return (ret);
+    
     // Pack the result into *out_p. Data bits begin with LSB at recd[length - k] through to MSB at recd[length - 1];
     *out_p = 0LL;
     out_bit = 1LL;
@@ -2045,8 +2193,7 @@ static int decode_bch(const AR_MATRIX_CODE_TYPE matrixCodeType, const uint64_t i
         out_bit <<= 1;
     }
     
-    if (syn_error) return (l[u]);
-    else return (0);
+    return (ret);
 }
 
 //const signed char hamming63EncoderTable[8] = {0, 7, 25, 30, 42, 45, 51, 52};
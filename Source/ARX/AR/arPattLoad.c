@@ -58,6 +58,7 @@ int arPattLoadFromBuffer(ARPattHandle *pattHandle, const char *buffer) {
     int     patno;
     int     h, i1, i2, i3;
     int     i, j, l, m;
+    int16_t *bank;
 	char   *buffPtr;
 	const char *delims = " \t\n\r";
     
@@ -131,6 +132,18 @@ int arPattLoadFromBuffer(ARPattHandle *pattHandle, const char *buffer) {
         }
         pattHandle->pattpowBW[patno*4 + h] = sqrt((ARdouble)m);
         if( pattHandle->pattpowBW[patno*4 + h] == 0.0 ) pattHandle->pattpowBW[patno*4 + h] = 0.0000001;
+
+        // Copy into the contiguous bank used for matching.
+        bank = &(pattHandle->pattBank[(patno*4 + h)*pattHandle->pattBankStride]);
+        for( i = 0; i < pattHandle->pattSize*pattHandle->pattSize*3; i++ ) {
+            j = pattHandle->patt[patno*4 + h][i];
+            bank[i] = (int16_t)(j < INT16_MIN ? INT16_MIN : (j > INT16_MAX ? INT16_MAX : j));
+        }
+        bank = &(pattHandle->pattBankBW[(patno*4 + h)*pattHandle->pattBankStrideBW]);
+        for( i = 0; i < pattHandle->pattSize*pattHandle->pattSize; i++ ) {
+            j = pattHandle->pattBW[patno*4 + h][i];
+            bank[i] = (int16_t)(j < INT16_MIN ? INT16_MIN : (j > INT16_MAX ? INT16_MAX : j));
+        }
     }
 
     free(bufCopy);
@@ -0,0 +1,285 @@
+/*
+ *  arRefineCorners.c
+ *  artoolkitX
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Dan Bell & Philip Lamb.
+ *
+ *  Author(s): Dan Bell, Philip Lamb.
+ *
+ */
+
+#include "arRefineCorners.h"
+#include <math.h>
+#include <float.h>
+#include <ARX/ARUtil/thread_sub.h>
+
+//#define DEBUG_REFINECORNERS
+
+#define AR_REFINE_CORNERS_WIN       5       // Half-width of the search window; the window is (2*WIN + 1) pixels square.
+#define AR_REFINE_CORNERS_WIN_W     (AR_REFINE_CORNERS_WIN*2 + 1)
+#define AR_REFINE_CORNERS_PATCH_W   (AR_REFINE_CORNERS_WIN_W + 2) // Window plus one pixel border for gradients.
+#define AR_REFINE_CORNERS_ITER_MAX  40
+#define AR_REFINE_CORNERS_EPS       0.001f  // Stop iterating once the corner moves less than this many pixels.
+
+typedef struct {
+    ARMarkerInfo      *markerInfo;
+    int                markerNum;
+    ARParamLTf        *paramLTf;
+    const ARUint8     *buff;
+    int                width;
+    int                height;
+    int                first;       // Index of first marker refined by this job.
+    int                step;        // Stride between markers refined by this job.
+} ARRefineCornersJob;
+
+struct _ARRefineCornersInfo {
+    int                threadNum;
+    ARRefineCornersJob job[AR_REFINE_CORNERS_THREAD_MAX];
+    THREAD_HANDLE_T   *threadHandle[AR_REFINE_CORNERS_THREAD_MAX]; // Job 0 runs on the calling thread, so threadHandle[0] is unused.
+};
+
+// Gaussian weighting of the window, exp(-x^2/WIN^2) * exp(-y^2/WIN^2). The weight of each row and column
+// is precomputed here (values are expf() of the exponent, rounded to float), so there is no shared state to initialise.
+#if AR_REFINE_CORNERS_WIN != 5
+#  error refineMaskX must be regenerated for the new AR_REFINE_CORNERS_WIN.
+#endif
+static const float refineMaskX[AR_REFINE_CORNERS_WIN_W] = {
+    0.36787945f, 0.52729243f, 0.697676301f, 0.852143764f, 0.960789442f, 1.0f,
+    0.960789442f, 0.852143764f, 0.697676301f, 0.52729243f, 0.36787945f
+};
+
+// Bilinearly sample a PATCH_W x PATCH_W patch centred on (cx, cy), replicating edge pixels.
+static void getPatch(const ARUint8 *buff, const int width, const int height, const float cx, const float cy, float *patch)
+{
+    const float ox = cx - (AR_REFINE_CORNERS_PATCH_W - 1)*0.5f;
+    const float oy = cy - (AR_REFINE_CORNERS_PATCH_W - 1)*0.5f;
+    const int ix = (int)floorf(ox);
+    const int iy = (int)floorf(oy);
+    const float ax = ox - (float)ix;
+    const float ay = oy - (float)iy;
+    const float w00 = (1.0f - ax)*(1.0f - ay), w01 = ax*(1.0f - ay), w10 = (1.0f - ax)*ay, w11 = ax*ay;
+    int xs[AR_REFINE_CORNERS_PATCH_W + 1];
+    int i, j, y0, y1;
+    
+    for (j = 0; j <= AR_REFINE_CORNERS_PATCH_W; j++) {
+        int x = ix + j;
+        xs[j] = (x < 0 ? 0 : (x >= width ? width - 1 : x));
+    }
+    for (i = 0; i < AR_REFINE_CORNERS_PATCH_W; i++) {
+        const ARUint8 *row0, *row1;
+        y0 = iy + i;     y0 = (y0 < 0 ? 0 : (y0 >= height ? height - 1 : y0));
+        y1 = iy + i + 1; y1 = (y1 < 0 ? 0 : (y1 >= height ? height - 1 : y1));
+        row0 = buff + y0*width;
+        row1 = buff + y1*width;
+        for (j = 0; j < AR_REFINE_CORNERS_PATCH_W; j++) {
+            patch[i*AR_REFINE_CORNERS_PATCH_W + j] = w00*row0[xs[j]] + w01*row0[xs[j + 1]] + w10*row1[xs[j]] + w11*row1[xs[j + 1]];
+        }
+    }
+}
+
+// Iteratively move the corner to the point where the image gradients in the surrounding window are
+// orthogonal to the vector to the corner (the method of Förstner, as used by OpenCV's cornerSubPix()).
+static void refineCorner(const ARUint8 *buff, const int width, const int height, float *x, float *y)
+{
+    float patch[AR_REFINE_CORNERS_PATCH_W*AR_REFINE_CORNERS_PATCH_W];
+    const float x0 = *x, y0 = *y;
+    float cx = x0, cy = y0, nx, ny, err;
+    int iter, i, j;
+    
+    for (iter = 0; iter < AR_REFINE_CORNERS_ITER_MAX; iter++) {
+        float a = 0.0f, b = 0.0f, c = 0.0f, bb1 = 0.0f, bb2 = 0.0f;
+        double det, scale;
+        
+        getPatch(buff, width, height, cx, cy, patch);
+        for (i = 0; i < AR_REFINE_CORNERS_WIN_W; i++) {
+            const float *p = &patch[(i + 1)*AR_REFINE_CORNERS_PATCH_W + 1];
+            const float my = refineMaskX[i];
+            const float py = (float)(i - AR_REFINE_CORNERS_WIN);
+            // Inner loop has no dependencies between iterations other than the sums, so it vectorizes.
+            for (j = 0; j < AR_REFINE_CORNERS_WIN_W; j++) {
+                const float gx = p[j + 1] - p[j - 1];
+                const float gy = p[j + AR_REFINE_CORNERS_PATCH_W] - p[j - AR_REFINE_CORNERS_PATCH_W];
+                const float m = my*refineMaskX[j];
+                const float gxx = gx*gx*m, gxy = gx*gy*m, gyy = gy*gy*m;
+                const float px = (float)(j - AR_REFINE_CORNERS_WIN);
+                a += gxx;
+                b += gxy;
+                c += gyy;
+                bb1 += gxx*px + gxy*py;
+                bb2 += gxy*px + gyy*py;
+            }
+        }
+        det = (double)a*c - (double)b*b;
+        if (fabs(det) <= DBL_EPSILON*DBL_EPSILON) break;
+        scale = 1.0/det;
+        nx = (float)(cx + c*scale*bb1 - b*scale*bb2);
+        ny = (float)(cy - b*scale*bb1 + a*scale*bb2);
+        err = (nx - cx)*(nx - cx) + (ny - cy)*(ny - cy);
+        cx = nx;
+        cy = ny;
+        if (cx < 0.0f || cx >= (float)width || cy < 0.0f || cy >= (float)height) break;
+        if (err <= AR_REFINE_CORNERS_EPS*AR_REFINE_CORNERS_EPS) break;
+    }
+    
+    // If the corner wandered out of the window, convergence was poor, so keep the original.
+    if (fabsf(cx - x0) > AR_REFINE_CORNERS_WIN || fabsf(cy - y0) > AR_REFINE_CORNERS_WIN) return;
+#ifdef DEBUG_REFINECORNERS
+    if ((fabsf(x0 - cx) > 0.1f) || (fabsf(y0 - cy) > 0.1f)) {
+        ARLOGd("arRefineCorners adjusted vertex from (%.1f, %.1f) to (%.1f, %.1f).\n", x0, y0, cx, cy);
+    }
+#endif
+    *x = cx;
+    *y = cy;
+}
+
+void arRefineCorners(float vertex[4][2], const unsigned char *buff, int width, int height)
+{
+    int i;
+    
+    // Only refine if all corners lie inside the image, away from the top and left edges.
+    for (i = 0; i < 4; i++) {
+        if (vertex[i][0] < 1.0f || vertex[i][0] >= (float)width || vertex[i][1] < 1.0f || vertex[i][1] >= (float)height) return;
+    }
+    for (i = 0; i < 4; i++) refineCorner(buff, width, height, &vertex[i][0], &vertex[i][1]);
+}
+
+static void refineMarkers(ARRefineCornersJob *job)
+{
+    float obVertex[4][2];
+    int i, j;
+    
+    for (j = job->first; j < job->markerNum; j += job->step) {
+        ARMarkerInfo *marker = &(job->markerInfo[j]);
+        for (i = 0; i < 4; i++) {
+            arParamIdeal2ObservLTf(job->paramLTf, (float)marker->vertex[i][0], (float)marker->vertex[i][1], &obVertex[i][0], &obVertex[i][1]);
+        }
+        arRefineCorners(obVertex, job->buff, job->width, job->height);
+        for (i = 0; i < 4; i++) {
+            float newX, newY;
+            arParamObserv2IdealLTf(job->paramLTf, obVertex[i][0], obVertex[i][1], &newX, &newY);
+            marker->vertex[i][0] = (ARdouble)newX;
+            marker->vertex[i][1] = (ARdouble)newY;
+        }
+    }
+}
+
+static void *refineMarkersWorker(THREAD_HANDLE_T *threadHandle)
+{
+    ARRefineCornersJob *job = (ARRefineCornersJob *)threadGetArg(threadHandle);
+    
+    while (threadStartWait(threadHandle) == 0) {
+        refineMarkers(job);
+        threadEndSignal(threadHandle);
+    }
+    return (NULL);
+}
+
+ARRefineCornersInfo *arRefineCornersInit(const int threadNum)
+{
+    ARRefineCornersInfo *rci;
+    int i;
+    
+    if (threadNum < 2) return (NULL);
+    
+    rci = (ARRefineCornersInfo *)calloc(1, sizeof(ARRefineCornersInfo));
+    if (!rci) {
+        ARLOGe("Out of memory!!\n");
+        return (NULL);
+    }
+    rci->threadNum = (threadNum > AR_REFINE_CORNERS_THREAD_MAX ? AR_REFINE_CORNERS_THREAD_MAX : threadNum);
+    for (i = 1; i < rci->threadNum; i++) {
+        rci->threadHandle[i] = threadInit(i, &(rci->job[i]), refineMarkersWorker);
+        if (!rci->threadHandle[i]) {
+            ARLOGe("Unable to start corner refinement worker thread.\n");
+            arRefineCornersFinal(rci);
+            return (NULL);
+        }
+    }
+    return (rci);
+}
+
+void arRefineCornersFinal(ARRefineCornersInfo *rci)
+{
+    int i;
+    
+    if (!rci) return;
+    
+    for (i = 1; i < rci->threadNum; i++) {
+        if (rci->threadHandle[i]) {
+            threadWaitQuit(rci->threadHandle[i]);
+            threadFree(&(rci->threadHandle[i]));
+        }
+    }
+    free(rci);
+}
+
+int arRefineCornersGetThreadNum(const ARRefineCornersInfo *rci)
+{
+    if (!rci) return (1);
+    return (rci->threadNum);
+}
+
+void arRefineCornersMarkers(ARRefineCornersInfo *rci, ARMarkerInfo *markerInfo, const int markerNum, ARParamLTf *paramLTf,
+                            const ARUint8 *buffLuma, const int width, const int height)
+{
+    ARRefineCornersJob job;
+    int threadNum, t;
+    
+    if (!markerInfo || markerNum <= 0 || !paramLTf || !buffLuma) return;
+    
+    threadNum = arRefineCornersGetThreadNum(rci);
+    if (threadNum > markerNum) threadNum = markerNum;
+    if (threadNum < 2) {
+        job.markerInfo = markerInfo;
+        job.markerNum = markerNum;
+        job.paramLTf = paramLTf;
+        job.buff = buffLuma;
+        job.width = width;
+        job.height = height;
+        job.first = 0;
+        job.step = 1;
+        refineMarkers(&job);
+        return;
+    }
+    
+    // Markers are dealt out to the threads in turn.
+    for (t = 0; t < threadNum; t++) {
+        rci->job[t].markerInfo = markerInfo;
+        rci->job[t].markerNum = markerNum;
+        rci->job[t].paramLTf = paramLTf;
+        rci->job[t].buff = buffLuma;
+        rci->job[t].width = width;
+        rci->job[t].height = height;
+        rci->job[t].first = t;
+        rci->job[t].step = threadNum;
+        if (t > 0) threadStartSignal(rci->threadHandle[t]);
+    }
+    refineMarkers(&(rci->job[0]));
+    for (t = 1; t < threadNum; t++) threadEndWait(rci->threadHandle[t]);
+}
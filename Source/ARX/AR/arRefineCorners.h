@@ -43,10 +43,27 @@
 extern "C" {
 #endif
 
+#define AR_REFINE_CORNERS_THREAD_MAX 16 // Maximum number of threads used to refine markers.
+
 // Given corner locations 'vertex' in observed coordinates, refine location.
 // buff is a luma-only buffer of dimensions width x height.
 void arRefineCorners(float vertex[4][2], const unsigned char *buff, int width, int height);
 
+// Start threadNum - 1 worker threads for refining corners of multiple markers.
+// Returns NULL if threadNum is less than 2 or the workers could not be started.
+ARRefineCornersInfo *arRefineCornersInit(const int threadNum);
+
+// Stop the worker threads and free all resources held by rci.
+void arRefineCornersFinal(ARRefineCornersInfo *rci);
+
+// Number of threads rci was created with.
+int arRefineCornersGetThreadNum(const ARRefineCornersInfo *rci);
+
+// Refine the corners (in ideal coordinates) of all markers in markerInfo, using paramLTf to convert to and from
+// observed coordinates in buffLuma. With rci non-NULL, markers are shared between its threads.
+void arRefineCornersMarkers(ARRefineCornersInfo *rci, ARMarkerInfo *markerInfo, const int markerNum, ARParamLTf *paramLTf,
+                            const ARUint8 *buffLuma, const int width, const int height);
+
 #ifdef __cplusplus
 }
 #endif
@@ -250,11 +250,12 @@ typedef struct {
     ARUint8        *bwImage;
 #endif
     int             label_num;
-    int             area[AR_LABELING_WORK_SIZE];
-    int             clip[AR_LABELING_WORK_SIZE][4];
-    ARdouble        pos[AR_LABELING_WORK_SIZE][2];
-    int             work[AR_LABELING_WORK_SIZE];
-    int             work2[AR_LABELING_WORK_SIZE*7]; ///< area, pos[2], clip[4].
+    int             work_size;      ///< Number of labels the tables below can hold. Set by arLabelingInfoInit().
+    int            *area;
+    int           (*clip)[4];
+    ARdouble      (*pos)[2];
+    int            *work;
+    int            *work2;          ///< work_size*7 elements: area, pos[2], clip[4].
 } ARLabelInfo;
 
 /* --------------------------------------------------*/
@@ -275,6 +276,10 @@ typedef struct {
     ARdouble       *pattpowBW;      ///< Root-mean-square of the pattern intensities.
     //ARdouble        pattRatio;      ///< 
     int             pattSize;       ///< Number of rows/columns in the pattern.
+    int16_t        *pattBank;       ///< Contiguous copy of patt, pattBankStride values per orientation (zero-padded), used for correlation during template matching.
+    int16_t        *pattBankBW;     ///< Contiguous copy of pattBW, pattBankStrideBW values per orientation (zero-padded), used for correlation during template matching.
+    int             pattBankStride; ///< Number of values per orientation in pattBank; pattSize*pattSize*3 rounded up to a multiple of 8.
+    int             pattBankStrideBW; ///< Number of values per orientation in pattBankBW; pattSize*pattSize rounded up to a multiple of 8.
 } ARPattHandle;
 
 /*!
@@ -331,6 +336,10 @@ typedef enum {
     AR_MATRIX_CODE_GLOBAL_ID = 0x0e | AR_MATRIX_CODE_TYPE_ECC_BCH___19
 } AR_MATRIX_CODE_TYPE;
 
+typedef struct _ARLabelingBracketInfo ARLabelingBracketInfo; ///< Opaque type holding worker state for AR_LABELING_THRESH_MODE_AUTO_BRACKETING.
+typedef struct _ARLabelingBandInfo ARLabelingBandInfo; ///< Opaque type holding worker state for multi-threaded labeling.
+typedef struct _ARRefineCornersInfo ARRefineCornersInfo; ///< Opaque type holding worker state for multi-threaded corner refinement.
+
 /*!
     @brief   Structure holding state of an instance of the square marker tracker.
     @details
@@ -373,6 +382,10 @@ typedef struct {
     ARdouble           areaMax;
     ARdouble           areaMin;
     ARdouble           squareFitThresh;
+    ARLabelingBracketInfo *arLabelingBracketInfo;           ///< When threshold mode is AR_LABELING_THRESH_MODE_AUTO_BRACKETING, holds the label buffers and worker threads used to run the bracketed threshold passes concurrently. NULL otherwise.
+    int                arLabelingThreadCount;               ///< To query this value, call arGetLabelingThreadCount(). To set this value, call arSetLabelingThreadCount().
+    ARLabelingBandInfo *arLabelingBandInfo;                 ///< When labeling with more than one thread, holds the worker threads. NULL otherwise.
+    ARRefineCornersInfo *arRefineCornersInfo;               ///< When corner refinement is enabled and more than one thread is in use, holds the worker threads used to refine markers concurrently. NULL otherwise.
 } ARHandle;
 
 
@@ -431,7 +444,8 @@ typedef struct {
         Note that the pointer is only copied, and so the ARParamLT structure must remain
         valid until the ARHandle is disposed of by calling arDeleteHandle.
     @result     An ARHandle which should be passed to other functions which
-		deal with the operations of the artoolkitX tracker.
+		deal with the operations of the artoolkitX tracker, or NULL if the handle's
+        labeling tables could not be allocated.
     @see arSetPixelFormat
     @see arDeleteHandle
 */
@@ -614,6 +628,37 @@ AR_EXTERN void arSetLabelingThreshModeAutoInterval(ARHandle *handle, const int i
  */
 AR_EXTERN int arGetLabelingThreshModeAutoInterval(const ARHandle *handle);
 
+/*!
+    @brief   Set the number of threads used to label the image.
+    @details
+        With more than one thread, the image is split into horizontal bands, one per
+        thread, which are labeled concurrently and then merged where regions cross the
+        band seams. Labeling results are identical to single-threaded labeling. Each band
+        has its own share of the labeling tables, sized from its rows so that it cannot run
+        out of provisional labels. (With 16-bit labels, a frame in which any band runs out
+        is labeled again on a single thread.) Bands are
+        never made shorter than 32 rows, so small images may use fewer threads than requested.
+        When corner refinement is enabled, the same number of threads is used to refine
+        the corners of detected markers.
+    @param      handle An ARHandle referring to the current AR tracker
+        for which the labeling thread count will be set.
+    @param      threadCount Number of threads, in the range [1, 16], or
+        AR_LABELING_THREAD_COUNT_AUTO to use one thread per CPU. Default value
+        is AR_DEFAULT_LABELING_THREAD_COUNT.
+    @see arGetLabelingThreadCount
+ */
+AR_EXTERN void arSetLabelingThreadCount(ARHandle *handle, const int threadCount);
+
+/*!
+    @brief   Get the number of threads used to label the image.
+    @param      handle An ARHandle referring to the current AR tracker
+        to be queried for its labeling thread count.
+    @result Value last set with arSetLabelingThreadCount(), which may be
+        AR_LABELING_THREAD_COUNT_AUTO.
+    @see arSetLabelingThreadCount
+ */
+AR_EXTERN int arGetLabelingThreadCount(const ARHandle *handle);
+
 AR_EXTERN void arSetLabelingThreshAutoAdaptiveKernelSize(ARHandle *handle, const int labelingThreshAutoAdaptiveKernelSize);
 
 AR_EXTERN int arGetLabelingThreshAutoAdaptiveKernelSize(ARHandle *handle);
@@ -843,8 +888,11 @@ AR_EXTERN ARdouble arGetSquareFitThresh(ARHandle *handle);
 
 /*!
     @brief   Enable or disable square tracking subpixel corner refinement.
-    @details If compiled with OpenCV available, the square tracker allows
-        marker corner locations to be subpixel-refined.
+    @details When enabled, the corner locations of every detected marker are
+        refined to subpixel accuracy by iteratively fitting to the image gradients
+        in a small window around each corner. If more than one thread has been
+        set with arSetLabelingThreadCount(), markers are refined concurrently on
+        the same number of threads.
     @param      handle Handle to settings structure in which to enable or disable subpixel corner refinement.
 	@param      mode
 		Options for this field are:
@@ -920,6 +968,29 @@ AR_EXTERN ARMarkerInfo  *arGetMarker( ARHandle *arHandle );
 
 /* ------------------------------ */
 
+/*!
+    @brief   Allocate the label image and labeling tables of an ARLabelInfo.
+    @details
+        The tables are sized from the frame so that labeling any xsize x ysize image, whether
+        on one thread or in bands, cannot run out of provisional labels. (With 16-bit labels,
+        the tables are capped at AR_LABELING_WORK_SIZE_MAX labels instead.) The debug image
+        bwImage is not allocated, and is set to NULL.
+    @param      labelInfo The ARLabelInfo to initialise.
+    @param      xsize Width of the largest image which will be labeled.
+    @param      ysize Height of the largest image which will be labeled.
+    @result     0 if successful, or -1 if memory could not be allocated.
+    @see arLabelingInfoFinal
+ */
+AR_EXTERN int            arLabelingInfoInit( ARLabelInfo *labelInfo, int xsize, int ysize );
+
+/*!
+    @brief   Free the label image and labeling tables allocated by arLabelingInfoInit().
+    @details The debug image bwImage is not freed.
+    @param      labelInfo The ARLabelInfo to finalise.
+    @see arLabelingInfoInit
+ */
+AR_EXTERN void           arLabelingInfoFinal( ARLabelInfo *labelInfo );
+
 AR_EXTERN int            arLabeling( ARUint8 *imageLuma, int xsize, int ysize,
                            int debugMode, int labelingMode, int labelingThresh, int imageProcMode,
                            ARLabelInfo *labelInfo, ARUint8 *image_thresh );
@@ -1209,6 +1280,23 @@ AR_EXTERN int arPattGetIDGlobal( ARPattHandle *pattHandle, int imageProcMode, in
               int *codePatt, int *dirPatt, ARdouble *cfPatt, int *codeMatrix, int *dirMatrix, ARdouble *cfMatrix,
               const AR_MATRIX_CODE_TYPE matrixCodeType, int *errorCorrected, uint64_t *codeGlobalID_p );
 
+/*!
+    @brief   Build the lookup table used to decode a BCH matrix code type.
+    @details Once built, matrix codes of this type are decoded with a syndrome table
+        lookup rather than by running the Berlekamp decoder on each candidate square.
+        Results are identical either way. Tables are shared by all handles and are
+        built exactly once per code type, and it is safe to call this function, or to
+        decode, from several threads at once. arSetMatrixCodeType() calls this function
+        so that the table is ready before the first frame; otherwise the table is built
+        on the first decode of that code type.
+    @param      matrixCodeType One of AR_MATRIX_CODE_4x4_BCH_13_9_3, AR_MATRIX_CODE_4x4_BCH_13_5_5,
+        AR_MATRIX_CODE_5x5_BCH_22_12_5 or AR_MATRIX_CODE_5x5_BCH_22_7_7.
+    @result     0 if the table was built or already existed, or -1 if the code type
+        is not table-decodable.
+    @see    arSetMatrixCodeType
+ */
+AR_EXTERN int arPattBCHTableInit(const AR_MATRIX_CODE_TYPE matrixCodeType);
+
 /*!
     @brief   Extract the image (i.e. locate and unwarp) of the pattern-space portion of a detected square.
     @param      imageProcMode See discussion of arSetImageProcMode().
@@ -77,6 +77,10 @@
 #define  AR_CORNER_REFINEMENT_ENABLE          1
 #define  AR_DEFAULT_CORNER_REFINEMENT_MODE    AR_CORNER_REFINEMENT_DISABLE
 
+/* for arLabelingThreadCount */
+#define  AR_LABELING_THREAD_COUNT_AUTO        -1
+#define  AR_DEFAULT_LABELING_THREAD_COUNT     1
+
 /* for arGetTransMat */
 #define  AR_MAX_LOOP_COUNT                    5
 #define  AR_LOOP_BREAK_THRESH                 0.5
@@ -102,12 +106,18 @@
 #define   AR_AREA_MIN                        70		// Minimum area (in pixels) of connected regions considered valid candidate for marker detection.
 #define   AR_SQUARE_FIT_THRESH                1.0   // Tolerance value for accepting connected region as square. Greater value = more tolerant.
 
-#define   AR_LABELING_32_BIT                  0     // 0 = 16 bits per label, 1 = 32 bits per label.
+// The labeling tables are allocated per handle and sized from the frame (see arLabelingInfoInit()), so that
+// no image, however cluttered, can overflow them. That guarantee only holds with 32-bit labels; with 16-bit
+// labels the tables are capped at AR_LABELING_WORK_SIZE_MAX, and cluttered high-resolution frames may overflow.
+#if AR_ENABLE_MINIMIZE_MEMORY_FOOTPRINT
+#  define AR_LABELING_32_BIT                0     // 0 = 16 bits per label, 1 = 32 bits per label.
+#else
+#  define AR_LABELING_32_BIT                1
+#endif
 #if AR_LABELING_32_BIT
-#  define AR_LABELING_WORK_SIZE      1024*32*16
 #  define AR_LABELING_LABEL_TYPE        ARInt32
 #else
-#  define AR_LABELING_WORK_SIZE         1024*32     // This number may not exceed 65535 when using 16-bits labels.
+#  define AR_LABELING_WORK_SIZE_MAX       32767     // Largest label representable in an ARInt16.
 #  define AR_LABELING_LABEL_TYPE        ARInt16
 #endif
 
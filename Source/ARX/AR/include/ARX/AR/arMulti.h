@@ -139,6 +139,24 @@ AR_EXTERN ARdouble  arGetTransMatMultiSquareStereoRobust(AR3DStereoHandle *handl
                                              ARMarkerInfo *marker_infoR, int marker_numR,
                                              ARMultiMarkerInfoT *config);
 
+/**
+ *  As arGetTransMatMultiSquare() (robustFlag 0) or arGetTransMatMultiSquareRobust() (robustFlag 1), but
+ *  uses submarker-to-detected-marker associations already made by the caller, e.g. from an index of
+ *  detected markers by ID. For each submarker i, config->marker[i].visible must hold the index into
+ *  marker_info of the matching detected marker, or -1, and the matching marker's dir must be set.
+ */
+AR_EXTERN ARdouble  arGetTransMatMultiSquareAssociated(AR3DHandle *handle, ARMarkerInfo *marker_info, int marker_num,
+                                           ARMultiMarkerInfoT *config, int robustFlag);
+
+/**
+ *  Stereo equivalent of arGetTransMatMultiSquareAssociated(). config->marker[i].visibleR must also hold
+ *  the index into marker_infoR of the matching detected marker in the right view, or -1.
+ */
+AR_EXTERN ARdouble  arGetTransMatMultiSquareStereoAssociated(AR3DStereoHandle *handle,
+                                                 ARMarkerInfo *marker_infoL, int marker_numL,
+                                                 ARMarkerInfo *marker_infoR, int marker_numR,
+                                                 ARMultiMarkerInfoT *config, int robustFlag);
+
 
 #ifdef __cplusplus
 }
@@ -152,6 +152,8 @@ typedef struct {
     ARParam      param;         ///< A copy of original ARParam from which the lookup table was calculated.
     ARParamLTf   paramLTf;      ///< The lookup table.
     //ARParamLTi   paramLTi;
+    void        *cacheMap;      ///< If non-NULL, paramLTf.i2o and paramLTf.o2i point into this read-only memory mapping of a lookup table cache file. See arParamLTCreateCached().
+    size_t       cacheMapSize;  ///< The length in bytes of the mapping at cacheMap.
 } ARParamLT;
 
 AR_EXTERN int    arParamDisp( const ARParam *param );
@@ -440,6 +442,63 @@ AR_EXTERN ARParamLT  *arParamLTCreate( ARParam *param, int offset );
  */
 AR_EXTERN int         arParamLTFree( ARParamLT **paramLT_p );
 
+/*!
+    @brief Version of the lookup table cache file format written by arParamLTCacheSave().
+ */
+#define AR_PARAM_LT_CACHE_VERSION 1
+
+/*!
+    @brief Save a lookup-table camera parameter to a cache file which can be memory-mapped by arParamLTCacheLoad().
+    @details The cache file holds a checksummed header (including a copy of the ARParam and the
+        lookup table dimensions) followed by the i2o and o2i tables, laid out so that they can be
+        used in place from a read-only mapping. The file is in the native byte order and ARdouble
+        size of the writing machine, and is rejected by readers for which these differ.
+
+        The file is written under a temporary name and then renamed into place, so that
+        concurrent readers never see a partially-written file.
+    @param path Filesystem path of the cache file to write.
+    @param paramLT The lookup-table camera parameter to save.
+    @result 0 if successful, or -1 if an error occurred.
+    @see arParamLTCacheLoad
+ */
+AR_EXTERN int         arParamLTCacheSave( const char *path, const ARParamLT *paramLT );
+
+/*!
+    @brief Memory-map a lookup-table camera parameter from a cache file written by arParamLTCacheSave().
+    @details The lookup tables are not copied; paramLTf.i2o and paramLTf.o2i point into a read-only
+        shared mapping of the file, so that processes using the same cache file share its pages.
+        The tables must therefore not be written to. The file is verified before use: its version,
+        byte order and ARdouble size must match, the header and table checksums must be correct,
+        and, if param is non-NULL, the stored camera parameters and offset must match param and offset.
+    @param path Filesystem path of the cache file to read.
+    @param param If non-NULL, the camera parameters the cached lookup table must have been generated from.
+    @param offset If param is non-NULL, the offset the cached lookup table must have been generated with.
+    @result A pointer to a newly-allocated ARParamLT structure, or NULL if the file could not be
+        mapped or failed verification. Dispose of it by calling arParamLTFree().
+    @see arParamLTCacheSave
+    @see arParamLTCreateCached
+ */
+AR_EXTERN ARParamLT  *arParamLTCacheLoad( const char *path, const ARParam *param, int offset );
+
+/*!
+    @brief Obtain a lookup-table camera parameter, using a memory-mapped cache of previously-generated tables if possible.
+    @details Equivalent to arParamLTCreate(), except that the tables are looked up in a cache file in
+        directory cacheDir, named from a hash of param and offset. If a valid cache file exists, it is
+        mapped with arParamLTCacheLoad() and no tables are generated. Otherwise, the tables are generated
+        by arParamLTCreate(), saved to the cache file, and then used from the mapping of that file.
+        Any failure to read or write the cache falls back to the generated tables.
+    @param param A pointer to an ARParam structure from which the lookup table will be generated.
+    @param offset As for arParamLTCreate().
+    @param cacheDir Path to an existing directory in which to store cache files. If NULL, this
+        function behaves exactly as arParamLTCreate().
+    @result A pointer to a newly-allocated ARParamLT structure, or NULL if an error
+        occurred. Once the ARParamLT is no longer needed, it should be disposed
+        of by calling arParamLTFree() on it.
+    @see arParamLTCreate
+    @see arParamLTCacheLoad
+ */
+AR_EXTERN ARParamLT  *arParamLTCreateCached( ARParam *param, int offset, const char *cacheDir );
+
 /*!
     @brief   Use a lookup-table camera parameter to convert idealised (zero-distortion) window coordinates to observed (distorted) coordinates.
     @details
@@ -38,9 +38,49 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <math.h>
 #include <ARX/AR/ar.h>
 #include <ARX/AR/param.h>
+#ifdef _WIN32
+#  include <windows.h>
+#  include <process.h>
+#  define getpid _getpid
+#else
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+// Legacy .lt files hold the ARParamLT structure up to (but not including) the cache mapping fields.
+#define PARAM_LT_FILE_HEADER_SIZE (offsetof(ARParamLT, cacheMap))
+
+#define PARAM_LT_CACHE_MAGIC      "ARXPLTC"
+#define PARAM_LT_CACHE_BYTE_ORDER 0x01020304u
+#define PARAM_LT_CACHE_ALIGN      64
+
+typedef struct {
+    char      magic[8];
+    uint32_t  version;
+    uint32_t  byteOrder;
+    uint32_t  headerSize;
+    uint32_t  sizeofARdouble;
+    int32_t   xsize;
+    int32_t   ysize;
+    int32_t   xOff;
+    int32_t   yOff;
+    uint64_t  tableOffset;      // Byte offset from start of file to the i2o table. o2i immediately follows i2o.
+    uint64_t  tableSize;        // Total bytes in both tables.
+    uint64_t  paramHash;
+    uint64_t  tableChecksum;
+    uint64_t  headerChecksum;   // Calculated with this field set to 0.
+    ARParam   param;
+} ARParamLTCacheHeader;
+
+static uint64_t paramLTChecksum(uint64_t h, const void *data, size_t size);
+static uint64_t paramLTHashParam(const ARParam *param, int offset);
 
 
 int arParamLTSave( char *filename, char *ext, ARParamLT *paramLT )
@@ -59,7 +99,7 @@ int arParamLTSave( char *filename, char *ext, ARParamLT *paramLT )
     }
     free(buf);
 
-    if( fwrite( paramLT, sizeof(ARParamLT), 1, fp ) != 1 ) {
+    if( fwrite( paramLT, PARAM_LT_FILE_HEADER_SIZE, 1, fp ) != 1 ) {
         fclose(fp);
         return -1;
     }
@@ -108,11 +148,13 @@ ARParamLT *arParamLTLoad( char *filename, char *ext )
     
     arMalloc(paramLT, ARParamLT, 1);
     
-    if( fread( paramLT, sizeof(ARParamLT), 1, fp ) != 1 ) {
+    if( fread( paramLT, PARAM_LT_FILE_HEADER_SIZE, 1, fp ) != 1 ) {
         fclose(fp);
         free(paramLT);
         return NULL;
     }
+    paramLT->cacheMap = NULL;
+    paramLT->cacheMapSize = 0;
 
     arMalloc(paramLT->paramLTf.i2o, float, paramLT->paramLTf.xsize*paramLT->paramLTf.ysize*2);
     arMalloc(paramLT->paramLTf.o2i, float, paramLT->paramLTf.xsize*paramLT->paramLTf.ysize*2);
@@ -179,6 +221,8 @@ ARParamLT  *arParamLTCreate( ARParam *param, int offset )
     
     arMalloc(paramLT, ARParamLT, 1);
     paramLT->param = *param;
+    paramLT->cacheMap = NULL;
+    paramLT->cacheMapSize = 0;
     
     paramLT->paramLTf.xsize = param->xsize + offset*2;
     paramLT->paramLTf.ysize = param->ysize + offset*2;
@@ -222,8 +266,16 @@ int arParamLTFree( ARParamLT **paramLT_p )
 {
     if (!paramLT_p || !(*paramLT_p)) return (-1);
     
-    free((*paramLT_p)->paramLTf.i2o);
-    free((*paramLT_p)->paramLTf.o2i);
+    if ((*paramLT_p)->cacheMap) {
+#ifdef _WIN32
+        UnmapViewOfFile((*paramLT_p)->cacheMap);
+#else
+        munmap((*paramLT_p)->cacheMap, (*paramLT_p)->cacheMapSize);
+#endif
+    } else {
+        free((*paramLT_p)->paramLTf.i2o);
+        free((*paramLT_p)->paramLTf.o2i);
+    }
     //free((*paramLT_p)->paramLTi.i2o);
     //free((*paramLT_p)->paramLTi.o2i);
     free(*paramLT_p);
@@ -231,6 +283,264 @@ int arParamLTFree( ARParamLT **paramLT_p )
     return 0;
 }
 
+// 64-bit FNV-1a variant consuming 8 bytes per step.
+static uint64_t paramLTChecksum(uint64_t h, const void *data, size_t size)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t w;
+
+    while (size >= 8) {
+        memcpy(&w, p, 8);
+        h = (h ^ w) * 0x100000001b3ULL;
+        p += 8;
+        size -= 8;
+    }
+    while (size--) h = (h ^ *p++) * 0x100000001b3ULL;
+    return (h);
+}
+
+// Hash of only those fields of param which affect the lookup table (i.e. not structure padding).
+static uint64_t paramLTHashParam(const ARParam *param, int offset)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    int32_t  i[4];
+    int      dist_factor_num;
+
+    i[0] = param->xsize;
+    i[1] = param->ysize;
+    i[2] = param->dist_function_version;
+    i[3] = offset;
+    h = paramLTChecksum(h, i, sizeof(i));
+    h = paramLTChecksum(h, param->mat, sizeof(param->mat));
+    if (param->dist_function_version >= 1 && param->dist_function_version <= AR_DIST_FUNCTION_VERSION_MAX) {
+        dist_factor_num = arParamVersionInfo[param->dist_function_version - 1].dist_factor_num;
+    } else {
+        dist_factor_num = AR_DIST_FACTOR_NUM_MAX;
+    }
+    h = paramLTChecksum(h, param->dist_factor, sizeof(ARdouble)*dist_factor_num);
+    return (h);
+}
+
+static int paramLTCacheHeaderInit(ARParamLTCacheHeader *header, const ARParamLT *paramLT)
+{
+    size_t tableSize = sizeof(float)*paramLT->paramLTf.xsize*paramLT->paramLTf.ysize*2;
+
+    memset(header, 0, sizeof(ARParamLTCacheHeader));
+    memcpy(header->magic, PARAM_LT_CACHE_MAGIC, sizeof(PARAM_LT_CACHE_MAGIC));
+    header->version = AR_PARAM_LT_CACHE_VERSION;
+    header->byteOrder = PARAM_LT_CACHE_BYTE_ORDER;
+    header->headerSize = (uint32_t)sizeof(ARParamLTCacheHeader);
+    header->sizeofARdouble = (uint32_t)sizeof(ARdouble);
+    header->xsize = paramLT->paramLTf.xsize;
+    header->ysize = paramLT->paramLTf.ysize;
+    header->xOff = paramLT->paramLTf.xOff;
+    header->yOff = paramLT->paramLTf.yOff;
+    header->tableOffset = (sizeof(ARParamLTCacheHeader) + PARAM_LT_CACHE_ALIGN - 1) & ~(uint64_t)(PARAM_LT_CACHE_ALIGN - 1);
+    header->tableSize = tableSize*2;
+    header->paramHash = paramLTHashParam(&paramLT->param, paramLT->paramLTf.xOff);
+    header->tableChecksum = paramLTChecksum(0xcbf29ce484222325ULL, paramLT->paramLTf.i2o, tableSize);
+    header->tableChecksum = paramLTChecksum(header->tableChecksum, paramLT->paramLTf.o2i, tableSize);
+    memcpy(&header->param, &paramLT->param, sizeof(ARParam)); // Include padding bytes, as the checksum covers them.
+    header->headerChecksum = paramLTChecksum(0xcbf29ce484222325ULL, header, sizeof(ARParamLTCacheHeader));
+    return 0;
+}
+
+int arParamLTCacheSave( const char *path, const ARParamLT *paramLT )
+{
+    ARParamLTCacheHeader header;
+    FILE        *fp;
+    char        *tmpPath;
+    size_t       len, tableSize;
+    static const unsigned char pad[PARAM_LT_CACHE_ALIGN] = {0};
+
+    if (!path || !paramLT) return -1;
+
+    paramLTCacheHeaderInit(&header, paramLT);
+    tableSize = (size_t)header.tableSize/2;
+
+    len = strlen(path) + 32;
+    arMalloc(tmpPath, char, len);
+    snprintf(tmpPath, len, "%s.%d.tmp", path, (int)getpid());
+    if ((fp = fopen(tmpPath, "wb")) == NULL) {
+        ARLOGe("Error: Unable to open file '%s' for writing.\n", tmpPath);
+        free(tmpPath);
+        return -1;
+    }
+    if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+        fwrite(pad, 1, (size_t)header.tableOffset - sizeof(header), fp) != (size_t)header.tableOffset - sizeof(header) ||
+        fwrite(paramLT->paramLTf.i2o, 1, tableSize, fp) != tableSize ||
+        fwrite(paramLT->paramLTf.o2i, 1, tableSize, fp) != tableSize) {
+        ARLOGe("Error writing lookup table cache file '%s'.\n", tmpPath);
+        fclose(fp);
+        remove(tmpPath);
+        free(tmpPath);
+        return -1;
+    }
+    if (fclose(fp) != 0) {
+        remove(tmpPath);
+        free(tmpPath);
+        return -1;
+    }
+#ifdef _WIN32
+    if (!MoveFileExA(tmpPath, path, MOVEFILE_REPLACE_EXISTING)) {
+#else
+    if (rename(tmpPath, path) != 0) {
+#endif
+        ARLOGe("Error: Unable to rename '%s' to '%s'.\n", tmpPath, path);
+        remove(tmpPath);
+        free(tmpPath);
+        return -1;
+    }
+    free(tmpPath);
+
+    return 0;
+}
+
+static int paramLTCacheParamEqual(const ARParam *a, const ARParam *b)
+{
+    int dist_factor_num;
+
+    if (a->xsize != b->xsize || a->ysize != b->ysize || a->dist_function_version != b->dist_function_version) return 0;
+    if (memcmp(a->mat, b->mat, sizeof(a->mat)) != 0) return 0;
+    if (a->dist_function_version >= 1 && a->dist_function_version <= AR_DIST_FUNCTION_VERSION_MAX) {
+        dist_factor_num = arParamVersionInfo[a->dist_function_version - 1].dist_factor_num;
+    } else {
+        dist_factor_num = AR_DIST_FACTOR_NUM_MAX;
+    }
+    return (memcmp(a->dist_factor, b->dist_factor, sizeof(ARdouble)*dist_factor_num) == 0);
+}
+
+ARParamLT *arParamLTCacheLoad( const char *path, const ARParam *param, int offset )
+{
+    ARParamLTCacheHeader header;
+    const ARParamLTCacheHeader *h;
+    ARParamLT   *paramLT;
+    void        *map;
+    size_t       mapSize;
+    uint64_t     checksum;
+
+    if (!path) return NULL;
+
+#ifdef _WIN32
+    {
+        HANDLE        file, mapping;
+        LARGE_INTEGER fileSize;
+
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) return NULL;
+        if (!GetFileSizeEx(file, &fileSize) || (uint64_t)fileSize.QuadPart < sizeof(ARParamLTCacheHeader)) {
+            CloseHandle(file);
+            return NULL;
+        }
+        mapSize = (size_t)fileSize.QuadPart;
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        CloseHandle(file);
+        if (!mapping) return NULL;
+        map = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping); // The view holds its own reference.
+        if (!map) return NULL;
+    }
+#  define PARAM_LT_CACHE_UNMAP() UnmapViewOfFile(map)
+#else
+    {
+        int         fd;
+        struct stat st;
+
+        if ((fd = open(path, O_RDONLY)) == -1) return NULL;
+        if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(ARParamLTCacheHeader)) {
+            close(fd);
+            return NULL;
+        }
+        mapSize = (size_t)st.st_size;
+        map = mmap(NULL, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd); // The mapping holds its own reference.
+        if (map == MAP_FAILED) return NULL;
+    }
+#  define PARAM_LT_CACHE_UNMAP() munmap(map, mapSize)
+#endif
+
+    h = (const ARParamLTCacheHeader *)map;
+    if (memcmp(h->magic, PARAM_LT_CACHE_MAGIC, sizeof(PARAM_LT_CACHE_MAGIC)) != 0 ||
+        h->version != AR_PARAM_LT_CACHE_VERSION ||
+        h->byteOrder != PARAM_LT_CACHE_BYTE_ORDER ||
+        h->headerSize != sizeof(ARParamLTCacheHeader) ||
+        h->sizeofARdouble != sizeof(ARdouble)) {
+        ARLOGw("Lookup table cache file '%s' is of an incompatible version or platform.\n", path);
+        goto bail;
+    }
+    memcpy(&header, h, sizeof(header));
+    header.headerChecksum = 0;
+    if (paramLTChecksum(0xcbf29ce484222325ULL, &header, sizeof(header)) != h->headerChecksum) {
+        ARLOGw("Lookup table cache file '%s' has a corrupt header.\n", path);
+        goto bail;
+    }
+    if (header.xsize <= 0 || header.ysize <= 0 ||
+        header.tableSize != (uint64_t)sizeof(float)*header.xsize*header.ysize*4 ||
+        header.tableOffset % PARAM_LT_CACHE_ALIGN != 0 ||
+        header.tableOffset + header.tableSize > mapSize) {
+        ARLOGw("Lookup table cache file '%s' is truncated.\n", path);
+        goto bail;
+    }
+    if (param && (header.xOff != offset || header.yOff != offset || !paramLTCacheParamEqual(&header.param, param))) {
+        ARLOGw("Lookup table cache file '%s' does not match camera parameters.\n", path);
+        goto bail;
+    }
+    checksum = paramLTChecksum(0xcbf29ce484222325ULL, (const unsigned char *)map + header.tableOffset, (size_t)header.tableSize);
+    if (checksum != header.tableChecksum) {
+        ARLOGw("Lookup table cache file '%s' has corrupt tables.\n", path);
+        goto bail;
+    }
+
+    arMalloc(paramLT, ARParamLT, 1);
+    paramLT->param = header.param;
+    paramLT->paramLTf.xsize = header.xsize;
+    paramLT->paramLTf.ysize = header.ysize;
+    paramLT->paramLTf.xOff = header.xOff;
+    paramLT->paramLTf.yOff = header.yOff;
+    paramLT->paramLTf.i2o = (float *)((unsigned char *)map + header.tableOffset);
+    paramLT->paramLTf.o2i = paramLT->paramLTf.i2o + header.xsize*header.ysize*2;
+    paramLT->cacheMap = map;
+    paramLT->cacheMapSize = mapSize;
+    return paramLT;
+
+bail:
+    PARAM_LT_CACHE_UNMAP();
+    return NULL;
+#undef PARAM_LT_CACHE_UNMAP
+}
+
+ARParamLT *arParamLTCreateCached( ARParam *param, int offset, const char *cacheDir )
+{
+    ARParamLT   *paramLT, *paramLTMapped;
+    char        *path;
+    size_t       len;
+
+    if (!param) return NULL;
+    if (!cacheDir) return arParamLTCreate(param, offset);
+
+    len = strlen(cacheDir) + 64;
+    arMalloc(path, char, len);
+    snprintf(path, len, "%s/paramLT-%016llx.ltc", cacheDir, (unsigned long long)paramLTHashParam(param, offset));
+
+    if ((paramLT = arParamLTCacheLoad(path, param, offset))) {
+        ARLOGd("Using lookup table cache file '%s'.\n", path);
+        free(path);
+        return paramLT;
+    }
+
+    if (!(paramLT = arParamLTCreate(param, offset))) {
+        free(path);
+        return NULL;
+    }
+    // Use the saved copy, so that the tables are shared with other users of the cache.
+    if (arParamLTCacheSave(path, paramLT) == 0 && (paramLTMapped = arParamLTCacheLoad(path, param, offset))) {
+        arParamLTFree(&paramLT);
+        paramLT = paramLTMapped;
+    }
+    free(path);
+    return paramLT;
+}
+
 /*
 int arParamIdeal2ObservLTi( const ARParamLTi *paramLTi, const int    ix, const int    iy, int    *ox, int    *oy)
 {
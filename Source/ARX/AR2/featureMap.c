@@ -42,6 +42,27 @@
 #include <stdlib.h>
 #include <ARX/AR2/config.h>
 #include <ARX/AR2/featureSet.h>
+#include <ARX/ARUtil/thread_sub.h>
+
+typedef struct {
+    ARUint8         *imageBW;
+    int              xsize;
+    int              ysize;
+    float           *fimage;        // Output feature map.
+    float           *fimage2;       // Edge strength.
+    int              ts1;
+    int              ts2;
+    int              search_size1;
+    int              search_size2;
+    float            max_sim_thresh;
+    float            sd_thresh;
+    int              minFeature;    // Edge strength (x1000) below which pixels are not considered.
+    ARUint32        *wsum;          // AR2_FEATURE_MAP_MODE_INCREMENTAL only: sum of the window centred on each pixel,
+    ARUint32        *wsum2;         // and sum of squares. 0 where the window would leave the image.
+    int              first;         // First row processed by this job.
+    int              step;          // Stride between rows processed by this job.
+    THREAD_HANDLE_T *threadHandle;  // NULL for the job run on the calling thread.
+} AR2FeatureMapJobT;
 
 static int make_template( ARUint8 *imageBW, int xsize, int ysize,
                           int cx, int cy, int ts1, int ts2, float  sd_thresh,
@@ -51,6 +72,16 @@ static int get_similarity( ARUint8 *imageBW, int xsize, int ysize,
                            float  *template, float  vlen, int ts1, int ts2,
                            int cx, int cy, float  *sim);
 
+static void gen_window_sums( ARUint8 *imageBW, int xsize, int ysize, int ts1, int ts2,
+                             ARUint32 *wsum, ARUint32 *wsum2 );
+
+static int get_similarity_incremental( ARUint8 *imageBW, int xsize, int ysize,
+                                       ARUint32 *wsum, ARUint32 *wsum2, int ts1, int ts2,
+                                       int tx, int ty, double tvar, int cx, int cy, float *sim );
+
+static void genFeatureMapRows( AR2FeatureMapJobT *job );
+static void *genFeatureMapWorker( THREAD_HANDLE_T *threadHandle );
+
 int ar2FreeFeatureMap( AR2FeatureMapT *featureMap )
 {
     free( featureMap->map );
@@ -121,25 +152,49 @@ AR2FeatureMapT *ar2GenFeatureMap( AR2ImageT *image,
                                   int ts1, int ts2,
                                   int search_size1, int search_size2,
                                   float  max_sim_thresh, float  sd_thresh )
+{
+    return ar2GenFeatureMap2( image, ts1, ts2, search_size1, search_size2, max_sim_thresh, sd_thresh,
+                              AR2_FEATURE_MAP_MODE_EXACT, AR2_FEATURE_MAP_DEFAULT_THREAD_NUM );
+}
+
+AR2FeatureMapT *ar2GenFeatureMap2( AR2ImageT *image,
+                                  int ts1, int ts2,
+                                  int search_size1, int search_size2,
+                                  float  max_sim_thresh, float  sd_thresh, int mode, int threadNum )
 {
     AR2FeatureMapT  *featureMap;
-    float           *fimage, *fp;
+    float           *fimage;
     float           *fimage2, *fp2;
-    float           *template;
     ARUint8         *p;
     float           dx, dy;
     int             xsize, ysize;
     int             hist[1000], sum;
     int             i, j, k;
-    float           vlen;
-    float           max, sim;
-    int             ii, jj;
+    ARUint32        *wsum, *wsum2;
+    AR2FeatureMapJobT job[AR2_FEATURE_MAP_THREAD_MAX];
+    int             t;
 
     xsize = image->xsize;
     ysize = image->ysize;
+    // Window sums of squares are held in 32 bits.
+    if( mode == AR2_FEATURE_MAP_MODE_INCREMENTAL && (ts1+ts2+1)*(ts1+ts2+1) > 0xFFFFFFFFu/(255*255) ) {
+        ARLOGw("Template too large for incremental feature map; using exact mode.\n");
+        mode = AR2_FEATURE_MAP_MODE_EXACT;
+    }
     arMalloc(fimage,   float,  xsize*ysize);
     arMalloc(fimage2,  float,  xsize*ysize);
-    arMalloc(template, float , (ts1+ts2+1)*(ts1+ts2+1));
+    if( mode == AR2_FEATURE_MAP_MODE_INCREMENTAL ) {
+        arMalloc(wsum,  ARUint32, xsize*ysize);
+        arMalloc(wsum2, ARUint32, xsize*ysize);
+#if AR2_CAPABLE_ADAPTIVE_TEMPLATE
+        gen_window_sums( image->imgBWBlur[1], xsize, ysize, ts1, ts2, wsum, wsum2 );
+#else
+        gen_window_sums( image->imgBW, xsize, ysize, ts1, ts2, wsum, wsum2 );
+#endif
+    }
+    else {
+        wsum = wsum2 = NULL;
+    }
 
 
     fp2 = fimage2;
@@ -194,14 +249,96 @@ AR2FeatureMapT *ar2GenFeatureMap( AR2ImageT *image,
     ARLOGi(" Filtered features = %7d[pixel]\n", j);
 
 
-    fp = fimage;
-    fp2 = fimage2;
-    for( i = 0; i < xsize; i++ ) {
-        *(fp++) = 1.0f;
-        fp2++;
+    // Rows are dealt out in turn to the calling thread and threadNum - 1 worker threads. Each pixel's similarity
+    // depends only on the images, so the result does not depend on the number of threads.
+    if( threadNum == AR2_FEATURE_MAP_DEFAULT_THREAD_NUM ) threadNum = threadGetCPU();
+    if( threadNum > ysize - 2 ) threadNum = ysize - 2;
+    if( threadNum > AR2_FEATURE_MAP_THREAD_MAX ) threadNum = AR2_FEATURE_MAP_THREAD_MAX;
+    if( threadNum < 1 ) threadNum = 1;
+    for( t = 0; t < threadNum; t++ ) {
+#if AR2_CAPABLE_ADAPTIVE_TEMPLATE
+        job[t].imageBW = image->imgBWBlur[1];
+#else
+        job[t].imageBW = image->imgBW;
+#endif
+        job[t].xsize = xsize;
+        job[t].ysize = ysize;
+        job[t].fimage = fimage;
+        job[t].fimage2 = fimage2;
+        job[t].ts1 = ts1;
+        job[t].ts2 = ts2;
+        job[t].search_size1 = search_size1;
+        job[t].search_size2 = search_size2;
+        job[t].max_sim_thresh = max_sim_thresh;
+        job[t].sd_thresh = sd_thresh;
+        job[t].minFeature = k;
+        job[t].wsum = wsum;
+        job[t].wsum2 = wsum2;
+        job[t].first = t + 1;
+        job[t].step = threadNum;
+        job[t].threadHandle = NULL;
     }
-    for( j = 1; j < ysize-1; j++ ) {
-        ARLOGi("\r%4d/%4d.", j+1, ysize); fflush(stdout);
+    for( t = 1; t < threadNum; t++ ) {
+        if( (job[t].threadHandle = threadInit(t, &job[t], genFeatureMapWorker)) == NULL ) {
+            ARLOGe("Unable to start feature map worker thread.\n");
+            break;
+        }
+    }
+    if( t < threadNum ) {
+        // Fall back to the calling thread alone.
+        while( --t > 0 ) {
+            threadWaitQuit( job[t].threadHandle );
+            threadFree( &(job[t].threadHandle) );
+        }
+        threadNum = 1;
+        job[0].step = 1;
+    }
+    ARLOGi("Feature map threads = %d\n", threadNum);
+
+    for( i = 0; i < xsize; i++ ) fimage[i] = 1.0f;
+    for( t = 1; t < threadNum; t++ ) threadStartSignal( job[t].threadHandle );
+    genFeatureMapRows( &job[0] );
+    for( t = 1; t < threadNum; t++ ) {
+        threadEndWait( job[t].threadHandle );
+        threadWaitQuit( job[t].threadHandle );
+        threadFree( &(job[t].threadHandle) );
+    }
+    for( i = 0; i < xsize; i++ ) fimage[(ysize-1)*xsize + i] = 1.0f;
+    ARLOGi("\n");
+    free(fimage2);
+    free(wsum);
+    free(wsum2);
+
+    arMalloc( featureMap, AR2FeatureMapT, 1 );
+    featureMap->map = fimage;
+    featureMap->xsize = xsize;
+    featureMap->ysize = ysize;
+
+    return featureMap;
+}
+
+
+static void genFeatureMapRows( AR2FeatureMapJobT *job )
+{
+    float           *fp, *fp2;
+    float           *template;
+    float           vlen;
+    float           max, sim;
+    double          tvar = 0.0; // Only used when job->wsum is set.
+    int             xsize, n;
+    int             i, j;
+    int             ii, jj;
+
+    xsize = job->xsize;
+    n = (job->ts1+job->ts2+1)*(job->ts1+job->ts2+1);
+    arMalloc(template, float , n);
+
+    for( j = job->first; j < job->ysize-1; j += job->step ) {
+        if( job->first == 1 ) {
+            ARLOGi("\r%4d/%4d.", j+1, job->ysize); fflush(stdout);
+        }
+        fp = &(job->fimage[j*xsize]);
+        fp2 = &(job->fimage2[j*xsize]);
         *(fp++) = 1.0f;
         fp2++;
         for( i = 1; i < xsize-1; i++ ) {
@@ -210,64 +347,69 @@ AR2FeatureMapT *ar2GenFeatureMap( AR2ImageT *image,
                 fp2++;
                 continue;
             }
-            if( (int)(*fp2 * 1000) < k ) {
+            if( (int)(*fp2 * 1000) < job->minFeature ) {
                 *(fp++) = 1.0f;
                 fp2++;
                 continue;
             }
-#if AR2_CAPABLE_ADAPTIVE_TEMPLATE
-            if( make_template(image->imgBWBlur[1], xsize, ysize, i, j, ts1, ts2, sd_thresh, template, &vlen) < 0 ) {
-#else
-            if( make_template(image->imgBW, xsize, ysize, i, j, ts1, ts2, sd_thresh, template, &vlen) < 0 ) {
-#endif
+            if( job->wsum ) {
+                // The same tests as make_template(), on n^2*variance of the template window.
+                tvar = (double)n*job->wsum2[j*xsize + i] - (double)job->wsum[j*xsize + i]*job->wsum[j*xsize + i];
+                if( j - job->ts1 < 0 || j + job->ts2 >= job->ysize || i - job->ts1 < 0 || i + job->ts2 >= xsize
+                 || tvar == 0.0 || tvar < (double)job->sd_thresh*job->sd_thresh*n*n ) {
+                    *(fp++) = 1.0f;
+                    fp2++;
+                    continue;
+                }
+            }
+            else if( make_template(job->imageBW, xsize, job->ysize, i, j, job->ts1, job->ts2, job->sd_thresh, template, &vlen) < 0 ) {
                 *(fp++) = 1.0f;
                 fp2++;
                 continue;
             }
 
             max = -1.0f;
-            for( jj = -search_size1; jj <= search_size1; jj++ ) {
-                for( ii = -search_size1; ii <= search_size1; ii++ ) {
+            for( jj = -job->search_size1; jj <= job->search_size1; jj++ ) {
+                for( ii = -job->search_size1; ii <= job->search_size1; ii++ ) {
 
-                    if( ii*ii + jj*jj <= search_size2*search_size2 ) continue;
+                    if( ii*ii + jj*jj <= job->search_size2*job->search_size2 ) continue;
                     //if( jj >= -search_size2 && jj <= search_size2 && ii >= -search_size2 && ii <= search_size2 ) continue;
 
-#if AR2_CAPABLE_ADAPTIVE_TEMPLATE
-                    if( get_similarity(image->imgBWBlur[1], xsize, ysize, template, vlen, ts1, ts2, i+ii, j+jj, &sim) < 0 ) continue;
-#else
-                    if( get_similarity(image->imgBW, xsize, ysize, template, vlen, ts1, ts2, i+ii, j+jj, &sim) < 0 ) continue;
-#endif
+                    if( job->wsum ) {
+                        if( get_similarity_incremental(job->imageBW, xsize, job->ysize, job->wsum, job->wsum2, job->ts1, job->ts2,
+                                                       i, j, tvar, i+ii, j+jj, &sim) < 0 ) continue;
+                    }
+                    else {
+                        if( get_similarity(job->imageBW, xsize, job->ysize, template, vlen, job->ts1, job->ts2, i+ii, j+jj, &sim) < 0 ) continue;
+                    }
 
                     if( sim > max ) {
                         max = sim;
-                        if( max > max_sim_thresh ) break;
+                        if( max > job->max_sim_thresh ) break;
                     }
                 }
-                if( max > max_sim_thresh ) break;
+                if( max > job->max_sim_thresh ) break;
             }
             *(fp++) = (float)max;
             fp2++;
         }
         *(fp++) = 1.0f;
-        fp2++;
     }
-  	for (i = 0; i < xsize; i++) {
-  		*(fp++) = 1.0f;
-  		fp2++;
-  	}
-    ARLOGi("\n");
-    free(fimage2);
+
     free(template);
+}
 
-    arMalloc( featureMap, AR2FeatureMapT, 1 );
-    featureMap->map = fimage;
-    featureMap->xsize = xsize;
-    featureMap->ysize = ysize;
+static void *genFeatureMapWorker( THREAD_HANDLE_T *threadHandle )
+{
+    AR2FeatureMapJobT *job = (AR2FeatureMapJobT *)threadGetArg(threadHandle);
 
-    return featureMap;
+    while( threadStartWait(threadHandle) == 0 ) {
+        genFeatureMapRows( job );
+        threadEndSignal(threadHandle);
+    }
+    return NULL;
 }
 
-
 AR2FeatureCoordT *ar2SelectFeature( AR2ImageT *image, AR2FeatureMapT *featureMap,
                                     int ts1, int ts2, int search_size2, int occ_size,
                                     float  max_sim_thresh, float  min_sim_thresh, float  sd_thresh, int *num )
@@ -689,3 +831,91 @@ static int get_similarity( ARUint8 *imageBW, int xsize, int ysize,
 
     return 0;
 }
+
+// Sums and sums of squares over the (ts1+ts2+1)-pixel-square window centred on each pixel, for every pixel whose
+// window lies inside the image. Column sums are slid down the image and window sums slid along each row.
+static void gen_window_sums( ARUint8 *imageBW, int xsize, int ysize, int ts1, int ts2,
+                             ARUint32 *wsum, ARUint32 *wsum2 )
+{
+    ARUint32  *csum, *csum2;
+    ARUint32   s, s2;
+    ARUint8   *ip, *ip2;
+    int        ts, i, j;
+
+    for( i = 0; i < xsize*ysize; i++ ) wsum[i] = wsum2[i] = 0;
+    ts = ts1 + ts2 + 1;
+    if( ts > xsize || ts > ysize ) return;
+
+    arMallocClear(csum,  ARUint32, xsize);
+    arMallocClear(csum2, ARUint32, xsize);
+    for( j = 0; j < ts - 1; j++ ) {
+        ip = &imageBW[j*xsize];
+        for( i = 0; i < xsize; i++ ) {
+            csum[i]  += ip[i];
+            csum2[i] += ip[i] * ip[i];
+        }
+    }
+    for( j = ts1; j < ysize - ts2; j++ ) {
+        // Add the window's bottom row, and after the first window, remove the row above the window.
+        ip = &imageBW[(j+ts2)*xsize];
+        for( i = 0; i < xsize; i++ ) {
+            csum[i]  += ip[i];
+            csum2[i] += ip[i] * ip[i];
+        }
+        if( j > ts1 ) {
+            ip2 = &imageBW[(j-ts1-1)*xsize];
+            for( i = 0; i < xsize; i++ ) {
+                csum[i]  -= ip2[i];
+                csum2[i] -= ip2[i] * ip2[i];
+            }
+        }
+        s = s2 = 0;
+        for( i = 0; i < ts - 1; i++ ) {
+            s  += csum[i];
+            s2 += csum2[i];
+        }
+        for( i = ts1; i < xsize - ts2; i++ ) {
+            s  += csum[i+ts2];
+            s2 += csum2[i+ts2];
+            if( i > ts1 ) {
+                s  -= csum[i-ts1-1];
+                s2 -= csum2[i-ts1-1];
+            }
+            wsum[j*xsize + i]  = s;
+            wsum2[j*xsize + i] = s2;
+        }
+    }
+    free(csum);
+    free(csum2);
+}
+
+// As get_similarity(), with the template taken directly from the image window centred on (tx, ty), whose n^2*variance
+// is tvar. The correlation is accumulated in integers and the window statistics come from the precomputed sums, so
+// only rounding in the final division and square root differs from the exact result.
+static int get_similarity_incremental( ARUint8 *imageBW, int xsize, int ysize,
+                                       ARUint32 *wsum, ARUint32 *wsum2, int ts1, int ts2,
+                                       int tx, int ty, double tvar, int cx, int cy, float *sim )
+{
+    ARUint8   *ip, *tp;
+    ARUint32   sxy;
+    double     n, var;
+    int        ts, i, j;
+
+    if( cy - ts1 < 0 || cy + ts2 >= ysize || cx - ts1 < 0 || cx + ts2 >= xsize ) return -1;
+
+    ts = ts1 + ts2 + 1;
+    n = (double)(ts*ts);
+    var = n*wsum2[cy*xsize + cx] - (double)wsum[cy*xsize + cx]*wsum[cy*xsize + cx];
+    if( var == 0.0 ) return -1;
+
+    sxy = 0;
+    for( j = -ts1; j <= ts2; j++ ) {
+        ip = &imageBW[(cy+j)*xsize + (cx-ts1)];
+        tp = &imageBW[(ty+j)*xsize + (tx-ts1)];
+        for( i = 0; i < ts; i++ ) sxy += (ARUint32)ip[i] * tp[i];
+    }
+
+    *sim = (float)((n*sxy - (double)wsum[cy*xsize + cx]*wsum[ty*xsize + tx]) / sqrt(var*tvar));
+
+    return 0;
+}
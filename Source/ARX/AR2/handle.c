@@ -110,8 +110,11 @@ static AR2HandleT *ar2CreateHandleSub( int pixFormat, int xsize, int ysize, int
     }
     ar2Handle->threadNum = threadNum;
     ARLOGi("Tracking thread = %d\n", threadNum);
+    pthread_mutex_init(&(ar2Handle->queueLock), NULL);
     for( i = 0; i < ar2Handle->threadNum; i++ ) {
         arMalloc( ar2Handle->arg[i].mfImage, ARUint8, xsize*ysize );
+        ar2Handle->arg[i].scratch = ar2GenMatchingScratch( ar2Handle->templateSize1, ar2Handle->templateSize2 );
+        ar2Handle->arg[i].candidate = NULL;
         ar2Handle->arg[i].templ = NULL;
 #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
         ar2Handle->arg[i].templ2 = NULL;
@@ -132,12 +135,14 @@ int ar2DeleteHandle( AR2HandleT **ar2Handle )
         threadWaitQuit( (*ar2Handle)->threadHandle[i] );
         threadFree( &((*ar2Handle)->threadHandle[i]) );
         if( (*ar2Handle)->arg[i].mfImage   != NULL )  free( (*ar2Handle)->arg[i].mfImage );
+        if( (*ar2Handle)->arg[i].scratch   != NULL )  ar2FreeMatchingScratch( (*ar2Handle)->arg[i].scratch );
         if( (*ar2Handle)->arg[i].templ  != NULL ) ar2FreeTemplate( (*ar2Handle)->arg[i].templ );
 #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
         if( (*ar2Handle)->arg[i].templ2 != NULL ) ar2FreeTemplate ( (*ar2Handle)->arg[i].templ2 );
 #endif
     }
 
+    pthread_mutex_destroy(&((*ar2Handle)->queueLock));
     if( (*ar2Handle)->icpHandle != NULL ) icpDeleteHandle( &((*ar2Handle)->icpHandle) );
     //if( (*ar2Handle)->cparamLT  != NULL ) arParamLTFree( (*ar2Handle)->cparamLT );
     free( *ar2Handle );
@@ -107,6 +107,7 @@ extern "C" {
 
 
 #define AR2_THREAD_MAX                              8
+#define AR2_FEATURE_MAP_THREAD_MAX                  64          // Maximum threads used by ar2GenFeatureMap().
 
 #define AR2_DEFAULT_SEARCH_SIZE	                    25          // Default radius of feature search window.
 
@@ -128,6 +129,7 @@ extern "C" {
 /* tracking2d.c */
 #define AR2_DEFAULT_TRACKING_SD_THRESH              5.0F
 #define AR2_SEARCH_FEATURE_MAX                      40
+#define AR2_SEARCH_FEATURE_TRY_FACTOR               2           // Templates tried per frame are limited to this multiple of the search feature number.
 
 
 /* genFeatureSet.c */
@@ -81,6 +81,21 @@ AR2_EXTERN AR2FeatureMapT *ar2GenFeatureMap( AR2ImageT *image,
                                   int search_size1, int search_size2,
                                   float  max_sim_thresh, float  sd_thresh );
 
+// Methods for computing the self-similarity scores in a feature map.
+#define AR2_FEATURE_MAP_MODE_EXACT          0   // Template statistics recomputed at every position. Used by ar2GenFeatureMap().
+#define AR2_FEATURE_MAP_MODE_INCREMENTAL    1   // Window sums from running sums, and integer correlation. Several times faster.
+// Incremental scores are accurate to float precision, whereas the float sums of AR2_FEATURE_MAP_MODE_EXACT lose up to
+// about 2e-3 with the default template size, so the two modes' scores below max_sim_thresh differ by up to that much.
+// Scores above max_sim_thresh are the first found over the threshold and may differ by more. Feature selection
+// matches except where a candidate's score lies within that tolerance of a selection threshold. Checked by Utilities/check_feature_map.
+
+#define AR2_FEATURE_MAP_DEFAULT_THREAD_NUM  -1  // One thread per CPU. Used by ar2GenFeatureMap().
+
+AR2_EXTERN AR2FeatureMapT *ar2GenFeatureMap2( AR2ImageT *image,
+                                  int ts1, int ts2,
+                                  int search_size1, int search_size2,
+                                  float  max_sim_thresh, float  sd_thresh, int mode, int threadNum );
+
 AR2_EXTERN AR2FeatureMapT *ar2ReadFeatureMap( char *filename, char *ext );
 
 AR2_EXTERN int ar2SaveFeatureMap( char *filename, char *ext, AR2FeatureMapT *featureMap );
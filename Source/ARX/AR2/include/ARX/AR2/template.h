@@ -82,6 +82,13 @@ typedef struct {
     float   sx, sy;
 } AR2TemplateCandidateT;
 
+// Working memory for ar2GetBestMatching(), reusable from one match to the next.
+typedef struct {
+    ARUint32    *subImage1;         /* integral image        */
+    ARUint32    *subImage2;         /* integral image of squares */
+    int          size;              /* elements in each      */
+} AR2MatchingScratchT;
+
 
 
 #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
@@ -106,7 +113,10 @@ AR_EXTERN int ar2SetTemplateSub ( const ARParamLT *cparamLT, const float  trans[
 #endif
 
 
-AR_EXTERN int ar2GetBestMatching ( ARUint8 *img, ARUint8 *mfImage, int xsize, int ysize, AR_PIXEL_FORMAT pixFormat,
+AR_EXTERN AR2MatchingScratchT *ar2GenMatchingScratch ( int ts1, int ts2 );
+AR_EXTERN int                  ar2FreeMatchingScratch( AR2MatchingScratchT *scratch );
+
+AR_EXTERN int ar2GetBestMatching ( ARUint8 *img, ARUint8 *mfImage, AR2MatchingScratchT *scratch, int xsize, int ysize, AR_PIXEL_FORMAT pixFormat,
                          AR2TemplateT *mtemp, int rx, int ry,
                          int search[3][2], int *bx, int *by, float *val);
 
@@ -54,6 +54,15 @@
 #include <ARX/AR2/featureSet.h>
 #include <ARX/AR2/template.h>
 #include <ARX/AR2/marker.h>
+#if !defined(_WINRT)
+#  include <pthread.h>
+#else
+#  define pthread_mutex_t               CRITICAL_SECTION
+#  define pthread_mutex_init(pm, a)     InitializeCriticalSectionEx(pm, 4000, CRITICAL_SECTION_NO_DEBUG_INFO)
+#  define pthread_mutex_lock(pm)        EnterCriticalSection(pm)
+#  define pthread_mutex_unlock(pm)      LeaveCriticalSection(pm)
+#  define pthread_mutex_destroy(pm)     DeleteCriticalSection(pm)
+#endif
 
 #define    AR2_TRACKING_6DOF                   1
 #define    AR2_TRACKING_HOMOGRAPHY             2
@@ -100,9 +109,10 @@ typedef struct _AR2Tracking2DParamT  AR2Tracking2DParamT;
 struct _AR2Tracking2DParamT {
     struct _AR2HandleT      *ar2Handle;  // Reference to parent AR2HandleT.
     AR2SurfaceSetT          *surfaceSet;
-    AR2TemplateCandidateT   *candidate;
+    AR2TemplateCandidateT   *candidate;  // Template being matched, or NULL if none.
     ARUint8                 *dataPtr;    // Input image.
     ARUint8                 *mfImage;    // (Internally allocated buffer same size as input image).
+    AR2MatchingScratchT     *scratch;    // (Internally allocated working memory for template matching).
     AR2TemplateT            *templ;
 #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
     AR2Template2T           *templ2;
@@ -141,6 +151,15 @@ struct _AR2HandleT {
     int                       threadNum;
     struct _AR2Tracking2DParamT       arg[AR2_THREAD_MAX];
     THREAD_HANDLE_T          *threadHandle[AR2_THREAD_MAX];
+    /*--- Work queue from which the tracking threads pull templates. ---*/
+    pthread_mutex_t           queueLock;
+    AR2TemplateCandidateT    *queueCandidate; // Candidate list templates are being selected from, or NULL once exhausted.
+    int                       queueSelected;  // Number of templates handed out.
+    int                       queueInFlight;  // Number of templates handed out but not yet matched.
+    int                       queueMatched;   // Number of good matches, stored in pos2d, pos3d, pos and usedFeature.
+#if AR2_CAPABLE_ADAPTIVE_TEMPLATE
+    float                     queueBlur;      // Sum of the blur levels of the good matches.
+#endif
 };
 
 
@@ -47,6 +47,7 @@
 struct my_error_mgr {
     struct jpeg_error_mgr pub;	/* "public" fields */    
     jmp_buf setjmp_buffer;	/* for return to caller */
+    char lastErrorMsg[JMSG_LENGTH_MAX]; /* per call, so that images may be read on several threads at once */
 };
 typedef struct my_error_mgr * my_error_ptr;
 
@@ -137,7 +138,6 @@ int ar2FreeJpegImage( AR2JpegImageT **jpegImage )
 
 #define BUFFER_HEIGHT 5
 
-static char jpegLastErrorMsg[JMSG_LENGTH_MAX] = "";
 static void my_error_exit (j_common_ptr cinfo)
 {
     /* cinfo->err really points to a my_error_mgr struct, so coerce pointer */
@@ -148,7 +148,7 @@ static void my_error_exit (j_common_ptr cinfo)
     //(*cinfo->err->output_message) (cinfo);
 
     /* Create the message */
-    (*(cinfo->err->format_message)) (cinfo, jpegLastErrorMsg);
+    (*(cinfo->err->format_message)) (cinfo, myerr->lastErrorMsg);
 
     /* Return control to the setjmp point */
     longjmp(myerr->setjmp_buffer, 1);
@@ -177,7 +177,7 @@ static unsigned char *jpgread (FILE *fp, int *w, int *h, int *nc, float *dpi)
          * We need to clean up the JPEG object, close the input file, and return.
          */
         jpeg_destroy_decompress(&cinfo);
-        ARLOGe("Error reading JPEG file: %s\n", jpegLastErrorMsg);
+        ARLOGe("Error reading JPEG file: %s\n", jerr.lastErrorMsg);
         return NULL;
     }
 
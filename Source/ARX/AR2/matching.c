@@ -44,6 +44,18 @@
 #include <ARX/AR2/config.h>
 #include <ARX/AR2/template.h>
 
+// The vector kernels below assume template pixels sample every second image pixel.
+#if AR2_TEMP_SCALE == 2 && (HAVE_ARM_NEON || HAVE_ARM64_NEON || HAVE_INTEL_SIMD)
+#  define AR2_MATCHING_SIMD 1
+#  if HAVE_ARM_NEON || HAVE_ARM64_NEON
+#    include <arm_neon.h>
+#  else
+#    include <emmintrin.h> // SSE2.
+#  endif
+#else
+#  define AR2_MATCHING_SIMD 0
+#endif
+
 #define  USE_SEARCH1    1
 #define  USE_SEARCH2    1
 #define  USE_SEARCH3    1
@@ -60,11 +72,48 @@ static void updateCandidate            ( int x, int y, int wval,
 static int ar2GetBestMatchingSubFineOpt( ARUint8 *img, int xsize, int ysize, int sx1, int sy1, AR2TemplateT *mtemp,
                                          ARUint32 *subImage1, ARUint32 *subImage2, int sx2, int sy2, int *val);
 #endif
+#if AR2_MATCHING_SIMD
+static void ar2GetTemplateSums         ( const ARUint8 *img, int xsize, const AR2TemplateT *mtemp, int *sum1, int *sum2, int *sum3 );
+static int  ar2GetTemplateProductSum   ( const ARUint8 *img, int xsize, const AR2TemplateT *mtemp );
+#endif
+
+// Number of elements in each of the integral images used to refine a match of a template of the given size.
+static int ar2GetMatchingScratchSize( int xsize, int ysize )
+{
+    return ((xsize + 1)*AR2_TEMP_SCALE + (SKIP_INTERVAL*2)) * ((ysize + 1)*AR2_TEMP_SCALE + (SKIP_INTERVAL*2));
+}
+
+/*!
+    @brief Allocate working memory for ar2GetBestMatching() with templates generated by ar2GenTemplate( ts1, ts2 ).
+ */
+AR2MatchingScratchT *ar2GenMatchingScratch( int ts1, int ts2 )
+{
+    AR2MatchingScratchT *scratch;
+
+    arMalloc( scratch, AR2MatchingScratchT, 1 );
+    scratch->size = ar2GetMatchingScratchSize( ts1 + ts2 + 1, ts1 + ts2 + 1 );
+    arMalloc( scratch->subImage1, ARUint32, scratch->size );
+    arMalloc( scratch->subImage2, ARUint32, scratch->size );
+
+    return scratch;
+}
+
+int ar2FreeMatchingScratch( AR2MatchingScratchT *scratch )
+{
+    if( scratch == NULL ) return -1;
+    free( scratch->subImage1 );
+    free( scratch->subImage2 );
+    free( scratch );
+
+    return 0;
+}
 
 /*!
     @brief Get best match for a candidate feature template.
     @param img Incoming image to match against.
     @param mfImage Buffer same size as img, to provide working memory for status of matched features.
+    @param scratch Working memory from ar2GenMatchingScratch(), grown if too small for mtemp, or NULL
+        to allocate working memory for this call only.
     @param xsize Horizontal size of img and mfImage.
     @param ysize Vertical size of img and mfImage.
     @param pixFormat Pixel format of img.
@@ -78,7 +127,7 @@ static int ar2GetBestMatchingSubFineOpt( ARUint8 *img, int xsize, int ysize, int
     @result -1 in case of error or no match, or 0 otherwise.
  */
  
-int ar2GetBestMatching( ARUint8 *img, ARUint8 *mfImage, int xsize, int ysize, AR_PIXEL_FORMAT pixFormat,
+int ar2GetBestMatching( ARUint8 *img, ARUint8 *mfImage, AR2MatchingScratchT *scratch, int xsize, int ysize, AR_PIXEL_FORMAT pixFormat,
                         AR2TemplateT *mtemp, int rx, int ry,
                          int search[3][2], int *bx, int *by, float *val)
 {
@@ -100,6 +149,7 @@ int ar2GetBestMatching( ARUint8 *img, ARUint8 *mfImage, int xsize, int ysize, AR
     ARUint32    subImage11[AR2_TEMP_SCALE];
     ARUint32    subImage21[AR2_TEMP_SCALE];
     ARUint8    *p3, *p4;
+    int         subImageSize;
 #endif
 
     // First pass: initialise.
@@ -187,8 +237,22 @@ int ar2GetBestMatching( ARUint8 *img, ARUint8 *mfImage, int xsize, int ysize, AR
         }
     }
 #else
-    arMalloc( subImage1, ARUint32, ( (mtemp->xsize + 1)*AR2_TEMP_SCALE + (SKIP_INTERVAL*2)) * ((mtemp->ysize + 1)*AR2_TEMP_SCALE + (SKIP_INTERVAL*2) ) );
-    arMalloc( subImage2, ARUint32, ( (mtemp->xsize + 1)*AR2_TEMP_SCALE + (SKIP_INTERVAL*2)) * ((mtemp->ysize + 1)*AR2_TEMP_SCALE + (SKIP_INTERVAL*2) ) );
+    subImageSize = ar2GetMatchingScratchSize( mtemp->xsize, mtemp->ysize );
+    if( scratch == NULL ) {
+        arMalloc( subImage1, ARUint32, subImageSize );
+        arMalloc( subImage2, ARUint32, subImageSize );
+    }
+    else {
+        if( scratch->size < subImageSize ) {
+            free( scratch->subImage1 );
+            free( scratch->subImage2 );
+            scratch->size = subImageSize;
+            arMalloc( scratch->subImage1, ARUint32, scratch->size );
+            arMalloc( scratch->subImage2, ARUint32, scratch->size );
+        }
+        subImage1 = scratch->subImage1;
+        subImage2 = scratch->subImage2;
+    }
 
     for(l = 0; l < keep_num; l++) {
         if( mtemp->validNum != mtemp->xsize*mtemp->ysize
@@ -265,8 +329,10 @@ int ar2GetBestMatching( ARUint8 *img, ARUint8 *mfImage, int xsize, int ysize, AR
             }
         }
     }
-    free(subImage1);
-    free(subImage2);
+    if( scratch == NULL ) {
+        free(subImage1);
+        free(subImage2);
+    }
 #endif
 
     return ret;
@@ -306,6 +372,12 @@ static int ar2GetBestMatchingSubFine( ARUint8 *img, int xsize, int ysize, AR_PIX
         ssy = -(mtemp->yts1);
         eey =   mtemp->yts2;
         p2 = p3 = &img[((sy + ssy*AR2_TEMP_SCALE)*xsize + sx + ssx*AR2_TEMP_SCALE)];
+#if AR2_MATCHING_SIMD
+        if( mtemp->xsize > 8 ) {
+            ar2GetTemplateSums( p2, xsize, mtemp, &sum1, &sum2, &sum3 );
+        }
+        else
+#endif
         for( j = ssy; j <= eey; j++ ) {
             for( i = ssx; i <= eex; i++ ) {
                 if( *p1 != AR2_TEMPLATE_NULL_PIXEL ) {
@@ -418,6 +490,12 @@ static int ar2GetBestMatchingSubFineOpt( ARUint8 *img, int xsize, int ysize, int
     p1 = mtemp->img1;
     sum3 = 0;
     p2 = p3 = &img[sy1*xsize + sx1];
+#if AR2_MATCHING_SIMD
+    if( mtemp->xsize > 8 ) {
+        sum3 = ar2GetTemplateProductSum( p2, xsize, mtemp );
+    }
+    else
+#endif
     for( j = 0; j < mtemp->ysize; j++ ) {
         for( i = 0; i < mtemp->xsize; i++ ) {
             sum3 += (*p2) * *(p1++);
@@ -450,6 +528,180 @@ static int ar2GetBestMatchingSubFineOpt( ARUint8 *img, int xsize, int ysize, int
 }
 #endif
 
+#if AR2_MATCHING_SIMD
+//
+// Vector kernels for the template-vs-image sums. Each group of 8 template pixels covers 15 image bytes (the even bytes of a
+// 16-byte load). The last 1-8 pixels of each template row are taken from a load that ends on the row's final image pixel
+// (the odd bytes), with its leading lanes masked off, so no image byte outside the template's footprint is ever read.
+// This requires rows of at least 9 pixels. All arithmetic is exact integer arithmetic, so results match the scalar code.
+//
+
+#  if HAVE_ARM_NEON || HAVE_ARM64_NEON
+static const uint16_t laneIndex[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+
+static int horizontalSum( uint32x4_t acc )
+{
+#    if HAVE_ARM64_NEON
+    return (int)vaddvq_u32(acc);
+#    else
+    uint32x2_t acc2 = vadd_u32(vget_low_u32(acc), vget_high_u32(acc));
+    acc2 = vpadd_u32(acc2, acc2);
+    return (int)vget_lane_u32(acc2, 0);
+#    endif
+}
+
+static void ar2GetTemplateSums( const ARUint8 *img, int xsize, const AR2TemplateT *mtemp, int *sum1, int *sum2, int *sum3 )
+{
+    const ARUint16  *p1 = mtemp->img1;
+    const int        n = mtemp->xsize;
+    const int        body = ((n - 1)/8)*8; // Pixels in each row handled by whole groups; the remaining 1-8 are the tail.
+    const uint16x8_t lowBytes = vdupq_n_u16(0x00FF);
+    const uint16x8_t nullPixel = vdupq_n_u16(AR2_TEMPLATE_NULL_PIXEL);
+    const uint16x8_t allLanes = vdupq_n_u16(0xFFFF);
+    const uint16x8_t tailLanes = vcgeq_u16(vld1q_u16(laneIndex), vdupq_n_u16((uint16_t)(8 - (n - body))));
+    uint32x4_t       acc1 = vdupq_n_u32(0), acc2 = vdupq_n_u32(0), acc3 = vdupq_n_u32(0);
+    uint16x8_t       p, t, valid;
+    int              i, j;
+
+    for( j = 0; j < mtemp->ysize; j++ ) {
+        for( i = 0; i <= body; i += 8 ) {
+            if( i < body ) {
+                p = vandq_u16(vreinterpretq_u16_u8(vld1q_u8(&img[i*AR2_TEMP_SCALE])), lowBytes);
+                t = vld1q_u16(&p1[i]);
+                valid = allLanes;
+            }
+            else {
+                p = vshrq_n_u16(vreinterpretq_u16_u8(vld1q_u8(&img[(n - 8)*AR2_TEMP_SCALE - 1])), 8);
+                t = vld1q_u16(&p1[n - 8]);
+                valid = tailLanes;
+            }
+            valid = vbicq_u16(valid, vceqq_u16(t, nullPixel));
+            p = vandq_u16(p, valid);
+            t = vandq_u16(t, valid);
+            acc1 = vpadalq_u16(acc1, p);
+            acc2 = vmlal_u16(acc2, vget_low_u16(p), vget_low_u16(p));
+            acc2 = vmlal_u16(acc2, vget_high_u16(p), vget_high_u16(p));
+            acc3 = vmlal_u16(acc3, vget_low_u16(p), vget_low_u16(t));
+            acc3 = vmlal_u16(acc3, vget_high_u16(p), vget_high_u16(t));
+        }
+        p1 += n;
+        img += AR2_TEMP_SCALE*xsize;
+    }
+    *sum1 = horizontalSum(acc1);
+    *sum2 = horizontalSum(acc2);
+    *sum3 = horizontalSum(acc3);
+}
+
+// As for ar2GetTemplateSums(), but for templates without null pixels, and computing only the sum of products.
+static int ar2GetTemplateProductSum( const ARUint8 *img, int xsize, const AR2TemplateT *mtemp )
+{
+    const ARUint16  *p1 = mtemp->img1;
+    const int        n = mtemp->xsize;
+    const int        body = ((n - 1)/8)*8;
+    const uint16x8_t lowBytes = vdupq_n_u16(0x00FF);
+    const uint16x8_t tailLanes = vcgeq_u16(vld1q_u16(laneIndex), vdupq_n_u16((uint16_t)(8 - (n - body))));
+    uint32x4_t       acc = vdupq_n_u32(0);
+    uint16x8_t       p, t;
+    int              i, j;
+
+    for( j = 0; j < mtemp->ysize; j++ ) {
+        for( i = 0; i < body; i += 8 ) {
+            p = vandq_u16(vreinterpretq_u16_u8(vld1q_u8(&img[i*AR2_TEMP_SCALE])), lowBytes);
+            t = vld1q_u16(&p1[i]);
+            acc = vmlal_u16(acc, vget_low_u16(p), vget_low_u16(t));
+            acc = vmlal_u16(acc, vget_high_u16(p), vget_high_u16(t));
+        }
+        p = vshrq_n_u16(vreinterpretq_u16_u8(vld1q_u8(&img[(n - 8)*AR2_TEMP_SCALE - 1])), 8);
+        t = vandq_u16(vld1q_u16(&p1[n - 8]), tailLanes);
+        acc = vmlal_u16(acc, vget_low_u16(p), vget_low_u16(t));
+        acc = vmlal_u16(acc, vget_high_u16(p), vget_high_u16(t));
+        p1 += n;
+        img += AR2_TEMP_SCALE*xsize;
+    }
+    return horizontalSum(acc);
+}
+
+#  else // HAVE_INTEL_SIMD
+
+static int horizontalSum( __m128i acc )
+{
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(acc);
+}
+
+// Pixel and template values are at most 255 (or AR2_TEMPLATE_NULL_PIXEL, which is masked out), so signed 16-bit
+// multiply-adds cannot overflow.
+static void ar2GetTemplateSums( const ARUint8 *img, int xsize, const AR2TemplateT *mtemp, int *sum1, int *sum2, int *sum3 )
+{
+    const ARUint16 *p1 = mtemp->img1;
+    const int       n = mtemp->xsize;
+    const int       body = ((n - 1)/8)*8; // Pixels in each row handled by whole groups; the remaining 1-8 are the tail.
+    const __m128i   lowBytes = _mm_set1_epi16(0x00FF);
+    const __m128i   nullPixel = _mm_set1_epi16(AR2_TEMPLATE_NULL_PIXEL);
+    const __m128i   ones = _mm_set1_epi16(1);
+    const __m128i   allLanes = _mm_set1_epi16(-1);
+    const __m128i   tailLanes = _mm_cmpgt_epi16(_mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7), _mm_set1_epi16((short)(7 - (n - body))));
+    __m128i         acc1 = _mm_setzero_si128(), acc2 = _mm_setzero_si128(), acc3 = _mm_setzero_si128();
+    __m128i         p, t, valid;
+    int             i, j;
+
+    for( j = 0; j < mtemp->ysize; j++ ) {
+        for( i = 0; i <= body; i += 8 ) {
+            if( i < body ) {
+                p = _mm_and_si128(_mm_loadu_si128((const __m128i *)&img[i*AR2_TEMP_SCALE]), lowBytes);
+                t = _mm_loadu_si128((const __m128i *)&p1[i]);
+                valid = allLanes;
+            }
+            else {
+                p = _mm_srli_epi16(_mm_loadu_si128((const __m128i *)&img[(n - 8)*AR2_TEMP_SCALE - 1]), 8);
+                t = _mm_loadu_si128((const __m128i *)&p1[n - 8]);
+                valid = tailLanes;
+            }
+            valid = _mm_andnot_si128(_mm_cmpeq_epi16(t, nullPixel), valid);
+            p = _mm_and_si128(p, valid);
+            t = _mm_and_si128(t, valid);
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(p, ones));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(p, p));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(p, t));
+        }
+        p1 += n;
+        img += AR2_TEMP_SCALE*xsize;
+    }
+    *sum1 = horizontalSum(acc1);
+    *sum2 = horizontalSum(acc2);
+    *sum3 = horizontalSum(acc3);
+}
+
+// As for ar2GetTemplateSums(), but for templates without null pixels, and computing only the sum of products.
+static int ar2GetTemplateProductSum( const ARUint8 *img, int xsize, const AR2TemplateT *mtemp )
+{
+    const ARUint16 *p1 = mtemp->img1;
+    const int       n = mtemp->xsize;
+    const int       body = ((n - 1)/8)*8;
+    const __m128i   lowBytes = _mm_set1_epi16(0x00FF);
+    const __m128i   tailLanes = _mm_cmpgt_epi16(_mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7), _mm_set1_epi16((short)(7 - (n - body))));
+    __m128i         acc = _mm_setzero_si128();
+    __m128i         p, t;
+    int             i, j;
+
+    for( j = 0; j < mtemp->ysize; j++ ) {
+        for( i = 0; i < body; i += 8 ) {
+            p = _mm_and_si128(_mm_loadu_si128((const __m128i *)&img[i*AR2_TEMP_SCALE]), lowBytes);
+            t = _mm_loadu_si128((const __m128i *)&p1[i]);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(p, t));
+        }
+        p = _mm_srli_epi16(_mm_loadu_si128((const __m128i *)&img[(n - 8)*AR2_TEMP_SCALE - 1]), 8);
+        t = _mm_and_si128(_mm_loadu_si128((const __m128i *)&p1[n - 8]), tailLanes);
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(p, t));
+        p1 += n;
+        img += AR2_TEMP_SCALE*xsize;
+    }
+    return horizontalSum(acc);
+}
+#  endif
+#endif // AR2_MATCHING_SIMD
+
 static void updateCandidate( int x, int y, int wval,
                              int *keep_num, int cx[KEEP_NUM], int cy[KEEP_NUM], int cval[KEEP_NUM] )
 {
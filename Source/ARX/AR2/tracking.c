@@ -67,13 +67,11 @@ static int    getDeltaS( float  H[8], float  dU[], float  J_U_H[][8], int n );
 
 int ar2Tracking( AR2HandleT *ar2Handle, AR2SurfaceSetT *surfaceSet, ARUint8 *dataPtr, float  trans[3][4], float  *err )
 {
-    AR2TemplateCandidateT  *candidatePtr;
-    AR2TemplateCandidateT  *cp[AR2_THREAD_MAX];
 #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
     float                   aveBlur;
 #endif
-    int                     num, num2;
-    int                     i, j, k;
+    int                     num;
+    int                     i, j;
 
     if (!ar2Handle || !surfaceSet || !dataPtr || !trans || !err) return (-1);
 
@@ -97,81 +95,32 @@ int ar2Tracking( AR2HandleT *ar2Handle, AR2SurfaceSetT *surfaceSet, ARUint8 *dat
         extractVisibleFeaturesHomography(ar2Handle->xsize, ar2Handle->ysize, ar2Handle->wtrans1, surfaceSet, ar2Handle->candidate, ar2Handle->candidate2);
     }
 
-    candidatePtr = ar2Handle->candidate;
+    // Start the tracking threads, which pull templates from the work queue until enough good matches
+    // have been found or the candidates run out. See ar2Tracking2d().
+    ar2Handle->queueCandidate = ar2Handle->candidate;
+    ar2Handle->queueSelected = 0;
+    ar2Handle->queueInFlight = 0;
+    ar2Handle->queueMatched = 0;
 #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
-    aveBlur = 0.0F;
+    ar2Handle->queueBlur = 0.0F;
 #endif
-    i = 0; // Counts up to searchFeatureNum.
-    num = 0;
-    while( i < ar2Handle->searchFeatureNum ) {
-        num2 = num;
-        for( j = 0; j < ar2Handle->threadNum; j++ ) {
-            if( i == ar2Handle->searchFeatureNum ) break;
-
-            k = ar2SelectTemplate( candidatePtr, surfaceSet->prevFeature, num2, ar2Handle->pos, ar2Handle->xsize, ar2Handle->ysize );
-            if( k < 0 ) {
-                if( candidatePtr == ar2Handle->candidate ) {
-                    candidatePtr = ar2Handle->candidate2;
-                    k = ar2SelectTemplate( candidatePtr, surfaceSet->prevFeature, num2, ar2Handle->pos, ar2Handle->xsize, ar2Handle->ysize );
-                    if( k < 0 ) break; // PRL 2012-05-15: Give up if we can't select template from alternate candidate either.
-                }
-                else break;
-            }
-
-            cp[j] = &(candidatePtr[k]);
-            ar2Handle->pos[num2][0] = candidatePtr[k].sx;
-            ar2Handle->pos[num2][1] = candidatePtr[k].sy;
-            ar2Handle->arg[j].ar2Handle  = ar2Handle;
-            ar2Handle->arg[j].surfaceSet = surfaceSet;
-            ar2Handle->arg[j].candidate  = &(candidatePtr[k]);
-            ar2Handle->arg[j].dataPtr    = dataPtr;
-
-            threadStartSignal( ar2Handle->threadHandle[j] );
-            num2++;
-            if( num2 == 5 ) num2 = num;
-            i++;
-        }
-        k = j;
-        if( k == 0 ) break;
-
-        for( j = 0; j < k; j++ ) {
-            threadEndWait( ar2Handle->threadHandle[j] );
-
-            if( ar2Handle->arg[j].ret == 0 && ar2Handle->arg[j].result.sim > ar2Handle->simThresh ) {
-                if( ar2Handle->trackingMode == AR2_TRACKING_6DOF ) {
-#ifdef ARDOUBLE_IS_FLOAT
-                    arParamObserv2Ideal(ar2Handle->cparamLT->param.dist_factor,
-                                        ar2Handle->arg[j].result.pos2d[0], ar2Handle->arg[j].result.pos2d[1],
-                                        &ar2Handle->pos2d[num][0], &ar2Handle->pos2d[num][1], ar2Handle->cparamLT->param.dist_function_version);
-#else
-                    ARdouble pos2d0, pos2d1;
-                    arParamObserv2Ideal(ar2Handle->cparamLT->param.dist_factor,                    
-                                        (ARdouble)(ar2Handle->arg[j].result.pos2d[0]), (ARdouble)(ar2Handle->arg[j].result.pos2d[1]),
-                                        &pos2d0, &pos2d1, ar2Handle->cparamLT->param.dist_function_version);
-                    ar2Handle->pos2d[num][0] = (float)pos2d0;
-                    ar2Handle->pos2d[num][1] = (float)pos2d1;
-#endif
-                }
-                else {
-                    ar2Handle->pos2d[num][0] = ar2Handle->arg[j].result.pos2d[0];
-                    ar2Handle->pos2d[num][1] = ar2Handle->arg[j].result.pos2d[1];
-                }
-                ar2Handle->pos3d[num][0] = ar2Handle->arg[j].result.pos3d[0];
-                ar2Handle->pos3d[num][1] = ar2Handle->arg[j].result.pos3d[1];
-                ar2Handle->pos3d[num][2] = ar2Handle->arg[j].result.pos3d[2];
-                ar2Handle->pos[num][0] = cp[j]->sx;
-                ar2Handle->pos[num][1] = cp[j]->sy;
-                ar2Handle->usedFeature[num].snum  = cp[j]->snum;
-                ar2Handle->usedFeature[num].level = cp[j]->level;
-                ar2Handle->usedFeature[num].num   = cp[j]->num;
-                ar2Handle->usedFeature[num].flag  = 0;
+    for( j = 0; j < ar2Handle->threadNum; j++ ) {
+        ar2Handle->arg[j].ar2Handle  = ar2Handle;
+        ar2Handle->arg[j].surfaceSet = surfaceSet;
+        ar2Handle->arg[j].candidate  = NULL;
+        ar2Handle->arg[j].dataPtr    = dataPtr;
+    }
+    for( j = 0; j < ar2Handle->threadNum; j++ ) {
+        threadStartSignal( ar2Handle->threadHandle[j] );
+    }
+    for( j = 0; j < ar2Handle->threadNum; j++ ) {
+        threadEndWait( ar2Handle->threadHandle[j] );
+    }
+    num = ar2Handle->queueMatched;
 #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
-                aveBlur += ar2Handle->arg[j].result.blurLevel;
+    aveBlur = ar2Handle->queueBlur;
 #endif
-                num++;
-            }
-        }
-    }
+
     for( i = 0; i < num; i++ ) {
         surfaceSet->prevFeature[i] = ar2Handle->usedFeature[i];
     }
@@ -45,16 +45,19 @@
 #include <ARX/AR2/template.h>
 #include <ARX/AR2/searchPoint.h>
 #include <ARX/AR2/tracking.h>
+#include <ARX/ARUtil/profile.h>
 
 #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
 static int ar2Tracking2dSub ( AR2HandleT *handle, AR2SurfaceSetT *surfaceSet, AR2TemplateCandidateT *candidate,
-                              ARUint8 *dataPtr, ARUint8 *mfImage, AR2TemplateT **templ,
+                              ARUint8 *dataPtr, ARUint8 *mfImage, AR2MatchingScratchT *scratch, AR2TemplateT **templ,
                               AR2Template2T **templ2, AR2Tracking2DResultT *result );
 #else
 static int ar2Tracking2dSub ( AR2HandleT *handle, AR2SurfaceSetT *surfaceSet, AR2TemplateCandidateT *candidate,
-                              ARUint8 *dataPtr, ARUint8 *mfImage, AR2TemplateT **templ,
+                              ARUint8 *dataPtr, ARUint8 *mfImage, AR2MatchingScratchT *scratch, AR2TemplateT **templ,
                               AR2Tracking2DResultT *result );
 #endif
+static int  ar2Tracking2dGetCandidate( AR2Tracking2DParamT *arg );
+static void ar2Tracking2dPutResult   ( AR2Tracking2DParamT *arg );
 
 void *ar2Tracking2d( THREAD_HANDLE_T *threadHandle )
 {
@@ -68,13 +71,19 @@ void *ar2Tracking2d( THREAD_HANDLE_T *threadHandle )
     for(;;) {
         if( threadStartWait(threadHandle) < 0 ) break;
 
+        // Keep matching templates until the work queue has no more to hand out.
+        while( ar2Tracking2dGetCandidate(arg) ) {
+            int profile = arUtilProfileBegin("AR2 template");
 #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
-        arg->ret = ar2Tracking2dSub( arg->ar2Handle, arg->surfaceSet, arg->candidate,
-                                     arg->dataPtr, arg->mfImage, &(arg->templ), &(arg->templ2), &(arg->result) );
+            arg->ret = ar2Tracking2dSub( arg->ar2Handle, arg->surfaceSet, arg->candidate,
+                                         arg->dataPtr, arg->mfImage, arg->scratch, &(arg->templ), &(arg->templ2), &(arg->result) );
 #else
-        arg->ret = ar2Tracking2dSub( arg->ar2Handle, arg->surfaceSet, arg->candidate,
-                                     arg->dataPtr, arg->mfImage, &(arg->templ), &(arg->result) );
+            arg->ret = ar2Tracking2dSub( arg->ar2Handle, arg->surfaceSet, arg->candidate,
+                                         arg->dataPtr, arg->mfImage, arg->scratch, &(arg->templ), &(arg->result) );
 #endif
+            arUtilProfileEnd(profile);
+            ar2Tracking2dPutResult(arg);
+        }
         threadEndSignal(threadHandle);
     }
     ARLOGi("End tracking_thread #%d.\n", ID);
@@ -82,14 +91,111 @@ void *ar2Tracking2d( THREAD_HANDLE_T *threadHandle )
     return NULL;
 }
 
+// Select the next template to match from the work queue into arg->candidate.
+// Returns 0 if there are no more templates to hand out, because enough good matches
+// have been made or are in progress, or the try limit has been reached, or the candidates have run out.
+static int ar2Tracking2dGetCandidate( AR2Tracking2DParamT *arg )
+{
+    AR2HandleT              *handle = arg->ar2Handle;
+    AR2TemplateCandidateT   *candidatePtr;
+    int                      num, i, k;
+
+    pthread_mutex_lock( &(handle->queueLock) );
+    arg->candidate = NULL;
+    candidatePtr = handle->queueCandidate;
+    if( candidatePtr == NULL
+     || handle->queueMatched + handle->queueInFlight >= handle->searchFeatureNum
+     || handle->queueSelected >= handle->searchFeatureNum * AR2_SEARCH_FEATURE_TRY_FACTOR ) {
+        pthread_mutex_unlock( &(handle->queueLock) );
+        return 0;
+    }
+
+    // Select with reference to the positions of the good matches so far, followed by those of the templates still being matched.
+    num = handle->queueMatched;
+    for( i = 0; i < handle->threadNum; i++ ) {
+        if( handle->arg[i].candidate == NULL ) continue;
+        handle->pos[num][0] = handle->arg[i].candidate->sx;
+        handle->pos[num][1] = handle->arg[i].candidate->sy;
+        num++;
+    }
+    k = ar2SelectTemplate( candidatePtr, arg->surfaceSet->prevFeature, num, handle->pos, handle->xsize, handle->ysize );
+    if( k < 0 && candidatePtr == handle->candidate ) {
+        candidatePtr = handle->queueCandidate = handle->candidate2;
+        k = ar2SelectTemplate( candidatePtr, arg->surfaceSet->prevFeature, num, handle->pos, handle->xsize, handle->ysize );
+    }
+    if( k < 0 ) {
+        handle->queueCandidate = NULL;
+        pthread_mutex_unlock( &(handle->queueLock) );
+        return 0;
+    }
+
+    arg->candidate = &(candidatePtr[k]);
+    handle->queueSelected++;
+    handle->queueInFlight++;
+    pthread_mutex_unlock( &(handle->queueLock) );
+    return 1;
+}
+
+// Record the result of matching arg->candidate, and return it to the work queue.
+static void ar2Tracking2dPutResult( AR2Tracking2DParamT *arg )
+{
+    AR2HandleT              *handle = arg->ar2Handle;
+    float                    pos2d[2];
+    int                      num;
+
+    if( arg->ret == 0 && arg->result.sim > handle->simThresh ) {
+        if( handle->trackingMode == AR2_TRACKING_6DOF ) {
+#ifdef ARDOUBLE_IS_FLOAT
+            arParamObserv2Ideal(handle->cparamLT->param.dist_factor,
+                                arg->result.pos2d[0], arg->result.pos2d[1],
+                                &pos2d[0], &pos2d[1], handle->cparamLT->param.dist_function_version);
+#else
+            ARdouble pos2d0, pos2d1;
+            arParamObserv2Ideal(handle->cparamLT->param.dist_factor,
+                                (ARdouble)(arg->result.pos2d[0]), (ARdouble)(arg->result.pos2d[1]),
+                                &pos2d0, &pos2d1, handle->cparamLT->param.dist_function_version);
+            pos2d[0] = (float)pos2d0;
+            pos2d[1] = (float)pos2d1;
+#endif
+        }
+        else {
+            pos2d[0] = arg->result.pos2d[0];
+            pos2d[1] = arg->result.pos2d[1];
+        }
+
+        pthread_mutex_lock( &(handle->queueLock) );
+        num = handle->queueMatched++;
+        handle->pos2d[num][0] = pos2d[0];
+        handle->pos2d[num][1] = pos2d[1];
+        handle->pos3d[num][0] = arg->result.pos3d[0];
+        handle->pos3d[num][1] = arg->result.pos3d[1];
+        handle->pos3d[num][2] = arg->result.pos3d[2];
+        handle->pos[num][0] = arg->candidate->sx;
+        handle->pos[num][1] = arg->candidate->sy;
+        handle->usedFeature[num].snum  = arg->candidate->snum;
+        handle->usedFeature[num].level = arg->candidate->level;
+        handle->usedFeature[num].num   = arg->candidate->num;
+        handle->usedFeature[num].flag  = 0;
+#if AR2_CAPABLE_ADAPTIVE_TEMPLATE
+        handle->queueBlur += arg->result.blurLevel;
+#endif
+    }
+    else {
+        pthread_mutex_lock( &(handle->queueLock) );
+    }
+    handle->queueInFlight--;
+    arg->candidate = NULL;
+    pthread_mutex_unlock( &(handle->queueLock) );
+}
+
 
 #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
 static int ar2Tracking2dSub ( AR2HandleT *handle, AR2SurfaceSetT *surfaceSet, AR2TemplateCandidateT *candidate,
-                              ARUint8 *dataPtr, ARUint8 *mfImage, AR2TemplateT **templ,
+                              ARUint8 *dataPtr, ARUint8 *mfImage, AR2MatchingScratchT *scratch, AR2TemplateT **templ,
                               AR2Template2T **templ2, AR2Tracking2DResultT *result )
 #else
 static int ar2Tracking2dSub ( AR2HandleT *handle, AR2SurfaceSetT *surfaceSet, AR2TemplateCandidateT *candidate,
-                              ARUint8 *dataPtr, ARUint8 *mfImage, AR2TemplateT **templ,
+                              ARUint8 *dataPtr, ARUint8 *mfImage, AR2MatchingScratchT *scratch, AR2TemplateT **templ,
                               AR2Tracking2DResultT *result )
 #endif
 {
@@ -182,6 +288,7 @@ static int ar2Tracking2dSub ( AR2HandleT *handle, AR2SurfaceSetT *surfaceSet, AR
     if( handle->blurMethod == AR2_CONSTANT_BLUR ) {
         if( ar2GetBestMatching( dataPtr,
                                 mfImage,
+                                scratch,
                                 handle->xsize,
                                 handle->ysize,
                                 handle->pixFormat,
@@ -214,6 +321,7 @@ static int ar2Tracking2dSub ( AR2HandleT *handle, AR2SurfaceSetT *surfaceSet, AR
 #else
     if( ar2GetBestMatching( dataPtr,
                             mfImage,
+                            scratch,
                             handle->xsize,
                             handle->ysize,
                             handle->pixFormat,
@@ -48,6 +48,8 @@
 #  include "trackingSub.h"
 #endif
 #include <ARX/AR/paramGL.h>
+#include <ARX/ARUtil/profile.h>
+#include <ARX/ARUtil/time.h>
 
 #include <stdarg.h>
 
@@ -69,6 +71,8 @@ ARController::ARController() :
     m_updateFrameStamp0({0,0}),
     m_updateFrameStamp1({0,0}),
     m_arVideoViews{NULL},
+    m_parallelTrackerUpdate(false),
+    m_trackerUpdateWorkers{NULL},
     m_error(ARX_ERROR_NONE)
 {
 }
@@ -335,6 +339,7 @@ bool ARController::update()
 	}
 
     // Checkout frame(s).
+    double timeStart = arUtilTimeMonotonic();
     AR2VideoBufferT *image0, *image1 = NULL;
     image0 = m_videoSource0->checkoutFrameIfNewerThan(m_updateFrameStamp0);
     if (!image0) {
@@ -349,12 +354,18 @@ bool ARController::update()
         m_updateFrameStamp1 = image1->time;
     }
     m_updateFrameStamp0 = image0->time;
+    m_timingStats[TIMING_STAGE_FRAME_CHECKOUT].add(arUtilTimeMonotonic() - timeStart);
+    int profile = arUtilProfileBegin("update");
 
     //
     // Tracker updates.
     //
 
     bool ret = true;
+    ARTrackerVideo *trackers[kTrackerCountMax];
+    const char *trackerNames[kTrackerCountMax];
+    ARTimingStats *trackerTimingStats[kTrackerCountMax];
+    int trackerCount = 0;
 
     if (m_squareTracker->wantsUpdate()) {
         if (!m_squareTracker->isRunning()) {
@@ -362,7 +373,9 @@ bool ARController::update()
             else ret = m_squareTracker->start(m_videoSource0->getCameraParameters(), m_videoSource0->getPixelFormat(), m_videoSource1->getCameraParameters(), m_videoSource1->getPixelFormat(), m_transL2R);
             if (!ret) goto done;
         }
-        m_squareTracker->update(image0, image1);
+        trackerNames[trackerCount] = "square";
+        trackerTimingStats[trackerCount] = &m_timingStats[TIMING_STAGE_SQUARE_UPDATE];
+        trackers[trackerCount++] = m_squareTracker.get();
     }
 #if HAVE_NFT
     if (m_nftTracker->wantsUpdate()) {
@@ -371,7 +384,9 @@ bool ARController::update()
             else ret = m_nftTracker->start(m_videoSource0->getCameraParameters(), m_videoSource0->getPixelFormat(), m_videoSource1->getCameraParameters(), m_videoSource1->getPixelFormat(), m_transL2R);
             if (!ret) goto done;
         }
-        m_nftTracker->update(image0, image1);
+        trackerNames[trackerCount] = "NFT";
+        trackerTimingStats[trackerCount] = &m_timingStats[TIMING_STAGE_NFT_UPDATE];
+        trackers[trackerCount++] = m_nftTracker.get();
     }
 #endif
 #if HAVE_2D
@@ -381,19 +396,132 @@ bool ARController::update()
             else ret = m_twoDTracker->start(m_videoSource0->getCameraParameters(), m_videoSource0->getPixelFormat(), m_videoSource1->getCameraParameters(), m_videoSource1->getPixelFormat(), m_transL2R);
             if (!ret) goto done;
         }
-        m_twoDTracker->update(image0, image1);
+        trackerNames[trackerCount] = "2D";
+        trackerTimingStats[trackerCount] = &m_timingStats[TIMING_STAGE_2D_UPDATE];
+        trackers[trackerCount++] = m_twoDTracker.get();
     }
 #endif
+
+    if (!m_parallelTrackerUpdate || trackerCount < 2) {
+        for (int i = 0; i < trackerCount; i++) {
+            trackerUpdateTimed(trackers[i], trackerNames[i], trackerTimingStats[i], image0, image1);
+        }
+    } else {
+        // The frame(s) remain checked out until all workers have finished, so all trackers
+        // read from the same buffer. Each tracker only writes to its own trackables.
+        bool dispatched[kTrackerCountMax - 1];
+        for (int i = 1; i < trackerCount; i++) {
+            int w = i - 1;
+            if (!m_trackerUpdateWorkers[w]) {
+                m_trackerUpdateWorkers[w] = threadInit(w, &m_trackerUpdateWorkerData[w], trackerUpdateWorker);
+                if (!m_trackerUpdateWorkers[w]) {
+                    ARLOGe("Error starting tracker update worker thread. Tracker will be updated serially.\n");
+                }
+            }
+            if (m_trackerUpdateWorkers[w]) {
+                m_trackerUpdateWorkerData[w].tracker = trackers[i];
+                m_trackerUpdateWorkerData[w].trackerName = trackerNames[i];
+                m_trackerUpdateWorkerData[w].timingStats = trackerTimingStats[i];
+                m_trackerUpdateWorkerData[w].buff0 = image0;
+                m_trackerUpdateWorkerData[w].buff1 = image1;
+                threadStartSignal(m_trackerUpdateWorkers[w]);
+                dispatched[w] = true;
+            } else {
+                dispatched[w] = false;
+            }
+        }
+        // First tracker runs on the calling thread.
+        trackerUpdateTimed(trackers[0], trackerNames[0], trackerTimingStats[0], image0, image1);
+        for (int i = 1; i < trackerCount; i++) {
+            int w = i - 1;
+            if (dispatched[w]) threadEndWait(m_trackerUpdateWorkers[w]);
+            else {
+                trackerUpdateTimed(trackers[i], trackerNames[i], trackerTimingStats[i], image0, image1);
+            }
+        }
+    }
+
+    // Pose filtering happens inside each trackable's update, so collect the time spent from the trackables.
+    {
+        double filterTime = 0.0;
+        for (int i = 0; i < trackerCount; i++) filterTime += trackers[i]->takeFilterTime();
+        if (filterTime > 0.0) m_timingStats[TIMING_STAGE_POSE_FILTER].add(filterTime);
+    }
+
 done:
     // Checkin frames.
     m_videoSource0->checkinFrame();
     if (m_videoSourceIsStereo) m_videoSource1->checkinFrame();
+    arUtilProfileEnd(profile);
+    m_timingStats[TIMING_STAGE_UPDATE].add(arUtilTimeMonotonic() - timeStart);
 
     ARLOGd("ARX::ARController::update(): done.\n");
 
     return ret;
 }
 
+// Updates tracker, recording the time taken in stats and as a profiler scope.
+// The libraries' own stage timing hooks (ARUtil/stage_timing.h) time the stages within each tracker,
+// and report them to a single process-wide callback, so they can't stand in for the per-controller,
+// per-tracker statistics kept here.
+// static
+void ARController::trackerUpdateTimed(ARTrackerVideo *tracker, const char *trackerName, ARTimingStats *stats, AR2VideoBufferT *buff0, AR2VideoBufferT *buff1)
+{
+    int profile = arUtilProfileBegin(trackerName);
+    double t0 = arUtilTimeMonotonic();
+    tracker->update(buff0, buff1);
+    stats->add(arUtilTimeMonotonic() - t0);
+    arUtilProfileEnd(profile);
+}
+
+// Worker thread.
+// static
+void *ARController::trackerUpdateWorker(THREAD_HANDLE_T *threadHandle)
+{
+    TrackerUpdateWorkerData *data = (TrackerUpdateWorkerData *)threadGetArg(threadHandle);
+
+    while (threadStartWait(threadHandle) == 0) {
+        trackerUpdateTimed(data->tracker, data->trackerName, data->timingStats, data->buff0, data->buff1);
+        threadEndSignal(threadHandle);
+    }
+    return (NULL);
+}
+
+void ARController::trackerUpdateWorkersFinal()
+{
+    for (int w = 0; w < kTrackerCountMax - 1; w++) {
+        if (m_trackerUpdateWorkers[w]) {
+            threadWaitQuit(m_trackerUpdateWorkers[w]);
+            threadFree(&m_trackerUpdateWorkers[w]);
+        }
+    }
+}
+
+bool ARController::getTimingStats(TimingStage stage, ARTimingStats::Summary *summary)
+{
+    if (stage < 0 || stage >= TIMING_STAGE_COUNT || !summary) return false;
+    m_timingStats[stage].summarise(summary);
+    return true;
+}
+
+void ARController::resetTimingStats()
+{
+    for (int i = 0; i < TIMING_STAGE_COUNT; i++) m_timingStats[i].reset();
+}
+
+void ARController::setTimingStatsWindowSize(int samples)
+{
+    for (int i = 0; i < TIMING_STAGE_COUNT; i++) m_timingStats[i].setWindowSize(samples);
+}
+
+void ARController::setParallelTrackerUpdate(bool on)
+{
+    if (!on && m_parallelTrackerUpdate) {
+        trackerUpdateWorkersFinal();
+    }
+    m_parallelTrackerUpdate = on;
+}
+
 bool ARController::stopRunning()
 {
 	ARLOGd("ARX::ARController::stopRunning()\n");
@@ -402,6 +530,7 @@ bool ARController::stopRunning()
 		return false;
 	}
 
+    trackerUpdateWorkersFinal();
     m_squareTracker->stop();
 #if HAVE_NFT
     m_nftTracker->stop();
@@ -0,0 +1,82 @@
+/*
+ *  ARMarkerInfoIndex.cpp
+ *  artoolkitX
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ *  Author(s): Philip Lamb
+ *
+ */
+
+#include <ARX/ARMarkerInfoIndex.h>
+#include <algorithm>
+#include <iterator>
+
+void ARMarkerInfoIndex::build(const ARMarkerInfo *markerInfo, int markerNum)
+{
+    m_template.clear();
+    m_matrix.clear();
+    m_globalID.clear();
+    m_merged.clear();
+    if (!markerInfo) return;
+
+    for (int j = 0; j < markerNum; j++) {
+        if (markerInfo[j].idPatt >= 0) m_template[markerInfo[j].idPatt].push_back(j);
+        // Same test as used when matching: a zero barcode ID with non-zero globalID denotes a global ID marker.
+        if (markerInfo[j].idMatrix == 0 && markerInfo[j].globalID != 0ULL) m_globalID[markerInfo[j].globalID].push_back(j);
+        else if (markerInfo[j].idMatrix >= 0) m_matrix[markerInfo[j].idMatrix].push_back(j);
+    }
+}
+
+const std::vector<int>& ARMarkerInfoIndex::templateCandidates(int pattID) const
+{
+    auto it = m_template.find(pattID);
+    if (it == m_template.end()) return m_empty;
+    return it->second;
+}
+
+const std::vector<int>& ARMarkerInfoIndex::matrixCandidates(int pattID, uint64_t globalID) const
+{
+    auto itM = m_matrix.find(pattID);
+    auto itG = (globalID != 0ULL ? m_globalID.find(globalID) : m_globalID.end());
+    if (itG == m_globalID.end()) {
+        if (itM == m_matrix.end()) return m_empty;
+        return itM->second;
+    } else if (itM == m_matrix.end()) {
+        return itG->second;
+    }
+    // Markers matching both IDs are rare, so the merged list is only made on demand, and then kept until the next build().
+    auto key = std::make_pair(pattID, globalID);
+    auto itC = m_merged.find(key);
+    if (itC != m_merged.end()) return itC->second;
+    std::vector<int> &candidates = m_merged[key];
+    candidates.reserve(itM->second.size() + itG->second.size());
+    std::merge(itM->second.begin(), itM->second.end(), itG->second.begin(), itG->second.end(), std::back_inserter(candidates));
+    return candidates;
+}
@@ -0,0 +1,115 @@
+/*
+ *  ARTimingStats.cpp
+ *  artoolkitX
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ *  Author(s): Philip Lamb
+ *
+ */
+
+#include <ARX/ARTimingStats.h>
+#include <algorithm>
+#include <math.h>
+
+ARTimingStats::ARTimingStats() :
+    m_windowSize(kWindowSizeDefault),
+    m_next(0)
+{
+    pthread_mutex_init(&m_lock, NULL);
+    m_samples.reserve(m_windowSize);
+}
+
+ARTimingStats::~ARTimingStats()
+{
+    pthread_mutex_destroy(&m_lock);
+}
+
+void ARTimingStats::add(double seconds)
+{
+    pthread_mutex_lock(&m_lock);
+    if ((int)m_samples.size() < m_windowSize) {
+        m_samples.push_back(seconds);
+    } else {
+        m_samples[m_next] = seconds;
+        m_next = (m_next + 1) % m_windowSize;
+    }
+    pthread_mutex_unlock(&m_lock);
+}
+
+void ARTimingStats::summarise(Summary *summary)
+{
+    if (!summary) return;
+
+    pthread_mutex_lock(&m_lock);
+    std::vector<double> samples(m_samples);
+    pthread_mutex_unlock(&m_lock);
+
+    summary->count = (int)samples.size();
+    if (samples.empty()) {
+        summary->min = summary->mean = summary->p95 = summary->max = 0.0;
+        return;
+    }
+    double sum = 0.0;
+    summary->min = summary->max = samples[0];
+    for (double s : samples) {
+        sum += s;
+        if (s < summary->min) summary->min = s;
+        if (s > summary->max) summary->max = s;
+    }
+    summary->mean = sum / samples.size();
+    size_t rank = (size_t)ceil(0.95 * samples.size());
+    if (rank < 1) rank = 1;
+    std::nth_element(samples.begin(), samples.begin() + (rank - 1), samples.end());
+    summary->p95 = samples[rank - 1];
+}
+
+void ARTimingStats::reset()
+{
+    pthread_mutex_lock(&m_lock);
+    m_samples.clear();
+    m_next = 0;
+    pthread_mutex_unlock(&m_lock);
+}
+
+void ARTimingStats::setWindowSize(int samples)
+{
+    if (samples < 1) return;
+    pthread_mutex_lock(&m_lock);
+    m_windowSize = samples;
+    m_samples.clear();
+    m_samples.reserve(m_windowSize);
+    m_next = 0;
+    pthread_mutex_unlock(&m_lock);
+}
+
+int ARTimingStats::windowSize()
+{
+    return m_windowSize;
+}
@@ -47,6 +47,7 @@
 #endif
 #include <ARX/ARController.h>
 #include <ARX/AR/paramGL.h>
+#include <ARX/ARUtil/time.h>
 
 #ifdef _WIN32
 #  define MAXPATHLEN MAX_PATH
@@ -60,6 +61,7 @@ ARTrackable::ARTrackable(TrackableType type) :
     m_ftmi(NULL),
     m_filterCutoffFrequency(AR_FILTER_TRANS_MAT_CUTOFF_FREQ_DEFAULT),
     m_filterSampleRate(AR_FILTER_TRANS_MAT_SAMPLE_RATE_DEFAULT),
+    m_filterTime(0.0),
 #ifdef ARDOUBLE_IS_FLOAT
     m_positionScaleFactor(1.0f),
 #else
@@ -95,9 +97,11 @@ bool ARTrackable::update(const ARdouble transL2R[3][4])
         
         // Filter the pose estimate.
         if (m_ftmi) {
+            double t0 = arUtilTimeMonotonic();
             if (arFilterTransMat(m_ftmi, trans, !visiblePrev) < 0) {
                 ARLOGe("arFilterTransMat error with trackable %d.\n", UID);
             }
+            m_filterTime += arUtilTimeMonotonic() - t0;
         }
         
         if (!visiblePrev) {
@@ -160,6 +164,13 @@ void ARTrackable::setFilterSampleRate(ARdouble rate)
     if (m_ftmi) arFilterTransMatSetParams(m_ftmi, m_filterSampleRate, m_filterCutoffFrequency);
 }
 
+double ARTrackable::takeFilterTime()
+{
+    double t = m_filterTime;
+    m_filterTime = 0.0;
+    return t;
+}
+
 ARdouble ARTrackable::filterCutoffFrequency()
 {
     return m_filterCutoffFrequency;
@@ -92,7 +92,34 @@ bool ARTrackableMultiSquare::unload()
 	return true;
 }
 
-bool ARTrackableMultiSquare::updateWithDetectedMarkers(ARMarkerInfo* markerInfo, int markerNum, AR3DHandle *ar3DHandle)
+void ARTrackableMultiSquare::associateSubmarkers(ARMarkerInfo* markerInfo, const ARMarkerInfoIndex *index, bool right)
+{
+    // Same selection as arGetTransMatMultiSquare(), but only over the detected markers carrying each submarker's ID.
+    for (int i = 0; i < config->marker_num; i++) {
+        int k = -1;
+        if (config->marker[i].patt_type == AR_MULTI_PATTERN_TYPE_TEMPLATE) {
+            for (int j : index->templateCandidates(config->marker[i].patt_id)) {
+                if (markerInfo[j].matched) continue;
+                if (markerInfo[j].cfPatt < config->cfPattCutoff) continue;
+                if (k == -1) k = j;
+                else if (markerInfo[k].cfPatt < markerInfo[j].cfPatt) k = j;
+            }
+            if (k >= 0) markerInfo[k].dir = markerInfo[k].dirPatt;
+        } else {
+            for (int j : index->matrixCandidates(config->marker[i].patt_id, config->marker[i].globalID)) {
+                if (markerInfo[j].matched) continue;
+                if (markerInfo[j].cfMatrix < config->cfMatrixCutoff) continue;
+                if (k == -1) k = j;
+                else if (markerInfo[k].cfMatrix < markerInfo[j].cfMatrix) k = j;
+            }
+            if (k >= 0) markerInfo[k].dir = markerInfo[k].dirMatrix;
+        }
+        if (right) config->marker[i].visibleR = k;
+        else config->marker[i].visible = k;
+    }
+}
+
+bool ARTrackableMultiSquare::updateWithDetectedMarkers(ARMarkerInfo* markerInfo, int markerNum, AR3DHandle *ar3DHandle, const ARMarkerInfoIndex *index)
 {
 	if (!m_loaded || !config) return false;			// Can't update without multimarker config
 
@@ -102,7 +129,10 @@ bool ARTrackableMultiSquare::updateWithDetectedMarkers(ARMarkerInfo* markerInfo,
 	
 		ARdouble err;
 
-		if (robustFlag) {
+		if (index) {
+			associateSubmarkers(markerInfo, index, false);
+			err = arGetTransMatMultiSquareAssociated(ar3DHandle, markerInfo, markerNum, config, robustFlag ? 1 : 0);
+		} else if (robustFlag) {
 			err = arGetTransMatMultiSquareRobust(ar3DHandle, markerInfo, markerNum, config);		
 		} else {
 			err = arGetTransMatMultiSquare(ar3DHandle, markerInfo, markerNum, config);
@@ -119,7 +149,7 @@ bool ARTrackableMultiSquare::updateWithDetectedMarkers(ARMarkerInfo* markerInfo,
 	return (ARTrackable::update()); // Parent class will finish update.
 }
 
-bool ARTrackableMultiSquare::updateWithDetectedMarkersStereo(ARMarkerInfo* markerInfoL, int markerNumL, ARMarkerInfo* markerInfoR, int markerNumR, AR3DStereoHandle *handle, ARdouble transL2R[3][4])
+bool ARTrackableMultiSquare::updateWithDetectedMarkersStereo(ARMarkerInfo* markerInfoL, int markerNumL, ARMarkerInfo* markerInfoR, int markerNumR, AR3DStereoHandle *handle, ARdouble transL2R[3][4], const ARMarkerInfoIndex *indexL, const ARMarkerInfoIndex *indexR)
 {
 	if (!m_loaded || !config) return false;			// Can't update without multimarker config
     
@@ -129,7 +159,11 @@ bool ARTrackableMultiSquare::updateWithDetectedMarkersStereo(ARMarkerInfo* marke
         
 		ARdouble err;
         
-		if (robustFlag) {
+		if (indexL && indexR) {
+			associateSubmarkers(markerInfoL, indexL, false);
+			associateSubmarkers(markerInfoR, indexR, true);
+			err = arGetTransMatMultiSquareStereoAssociated(handle, markerInfoL, markerNumL, markerInfoR, markerNumR, config, robustFlag ? 1 : 0);
+		} else if (robustFlag) {
 			err = arGetTransMatMultiSquareStereoRobust(handle, markerInfoL, markerNumL, markerInfoR, markerNumR, config);
 		} else {
 			err = arGetTransMatMultiSquareStereo(handle, markerInfoL, markerNumL, markerInfoR, markerNumR, config);
@@ -174,7 +174,53 @@ void ARTrackableSquare::setConfidenceCutoff(ARdouble value)
     }
 }
 
-bool ARTrackableSquare::updateWithDetectedMarkers(ARMarkerInfo* markerInfo, int markerNum, AR3DHandle *ar3DHandle) {
+int ARTrackableSquare::findDetectedMarker(ARMarkerInfo* markerInfo, int markerNum, const ARMarkerInfoIndex *index)
+{
+    // With an index, examine only the detected markers carrying our ID. Otherwise, iterate over all detected markers.
+    const std::vector<int> *candidates = NULL;
+    if (index) candidates = &(patt_type == AR_PATTERN_TYPE_TEMPLATE ? index->templateCandidates(patt_id) : index->matrixCandidates(patt_id, globalID));
+    const int candidateNum = candidates ? (int)candidates->size() : markerNum;
+
+    int k = -1;
+    if (patt_type == AR_PATTERN_TYPE_TEMPLATE) {
+        for (int c = 0; c < candidateNum; c++) {
+            const int j = candidates ? (*candidates)[c] : c;
+            if (markerInfo[j].matched) continue;
+            if (patt_id != markerInfo[j].idPatt) continue;
+            // The pattern of detected trapezoid matches marker[k].
+            if (k == -1) {
+                if (markerInfo[j].cfPatt > m_cfMin) k = j; // Count as a match if match confidence exceeds cfMin.
+            } else if (markerInfo[j].cfPatt > markerInfo[k].cfPatt) k = j; // Or if it exceeds match confidence of a different already matched trapezoid (i.e. assume only one instance of each marker).
+        }
+        if (k != -1) {
+            markerInfo[k].id = markerInfo[k].idPatt;
+            markerInfo[k].cf = markerInfo[k].cfPatt;
+            markerInfo[k].dir = markerInfo[k].dirPatt;
+        }
+    } else {
+        for (int c = 0; c < candidateNum; c++) {
+            const int j = candidates ? (*candidates)[c] : c;
+            if (markerInfo[j].matched) continue;
+            // Check if we need to examine the globalID rather than patt_id.
+            if (markerInfo[j].idMatrix == 0 && markerInfo[j].globalID != 0ULL) {
+                if (markerInfo[j].globalID != globalID ) continue;
+            } else {
+                if (markerInfo[j].idMatrix != patt_id ) continue;
+            }
+            if (k == -1) {
+                if (markerInfo[j].cfMatrix >= m_cfMin) k = j; // Count as a match if match confidence exceeds cfMin.
+            } else if (markerInfo[j].cfMatrix > markerInfo[k].cfMatrix) k = j; // Or if it exceeds match confidence of a different already matched trapezoid (i.e. assume only one instance of each marker).
+        }
+        if (k != -1) {
+            markerInfo[k].id = markerInfo[k].idMatrix;
+            markerInfo[k].cf = markerInfo[k].cfMatrix;
+            markerInfo[k].dir = markerInfo[k].dirMatrix;
+        }
+    }
+    return k;
+}
+
+bool ARTrackableSquare::updateWithDetectedMarkers(ARMarkerInfo* markerInfo, int markerNum, AR3DHandle *ar3DHandle, const ARMarkerInfoIndex *index) {
 
     ARLOGd("ARTrackableSquare::updateWithDetectedMarkers(...)\n");
     
@@ -186,41 +232,7 @@ bool ARTrackableSquare::updateWithDetectedMarkers(ARMarkerInfo* markerInfo, int
 
 	if (markerInfo) {
 
-        int k = -1;
-        if (patt_type == AR_PATTERN_TYPE_TEMPLATE) { 
-            // Iterate over all detected markers.
-            for (int j = 0; j < markerNum; j++ ) {
-                if (markerInfo[j].matched) continue;
-                if (patt_id != markerInfo[j].idPatt) continue;
-                // The pattern of detected trapezoid matches marker[k].
-                if (k == -1) {
-                    if (markerInfo[j].cfPatt > m_cfMin) k = j; // Count as a match if match confidence exceeds cfMin.
-                } else if (markerInfo[j].cfPatt > markerInfo[k].cfPatt) k = j; // Or if it exceeds match confidence of a different already matched trapezoid (i.e. assume only one instance of each marker).
-            }
-            if (k != -1) {
-                markerInfo[k].id = markerInfo[k].idPatt;
-                markerInfo[k].cf = markerInfo[k].cfPatt;
-                markerInfo[k].dir = markerInfo[k].dirPatt;
-            }
-        } else {
-            for (int j = 0; j < markerNum; j++) {
-                if (markerInfo[j].matched) continue;
-                // Check if we need to examine the globalID rather than patt_id.
-                if (markerInfo[j].idMatrix == 0 && markerInfo[j].globalID != 0ULL) {
-                    if (markerInfo[j].globalID != globalID ) continue;
-                } else {
-                    if (markerInfo[j].idMatrix != patt_id ) continue;
-                }
-                if (k == -1) {
-                    if (markerInfo[j].cfMatrix >= m_cfMin) k = j; // Count as a match if match confidence exceeds cfMin.
-                } else if (markerInfo[j].cfMatrix > markerInfo[k].cfMatrix) k = j; // Or if it exceeds match confidence of a different already matched trapezoid (i.e. assume only one instance of each marker).
-            }
-            if (k != -1) {
-                markerInfo[k].id = markerInfo[k].idMatrix;
-                markerInfo[k].cf = markerInfo[k].cfMatrix;
-                markerInfo[k].dir = markerInfo[k].dirMatrix;
-            }
-        }
+        int k = findDetectedMarker(markerInfo, markerNum, index);
         
 		// Consider marker visible if a match was found.
         if (k != -1) {
@@ -244,7 +256,7 @@ bool ARTrackableSquare::updateWithDetectedMarkers(ARMarkerInfo* markerInfo, int
 	return (ARTrackable::update()); // Parent class will finish update.
 }
 
-bool ARTrackableSquare::updateWithDetectedMarkersStereo(ARMarkerInfo* markerInfoL, int markerNumL, ARMarkerInfo* markerInfoR, int markerNumR, AR3DStereoHandle *handle, ARdouble transL2R[3][4]) {
+bool ARTrackableSquare::updateWithDetectedMarkersStereo(ARMarkerInfo* markerInfoL, int markerNumL, ARMarkerInfo* markerInfoR, int markerNumR, AR3DStereoHandle *handle, ARdouble transL2R[3][4], const ARMarkerInfoIndex *indexL, const ARMarkerInfoIndex *indexR) {
     
     ARLOGd("ARTrackableSquare::updateWithDetectedMarkersStereo(...)\n");
     
@@ -256,71 +268,8 @@ bool ARTrackableSquare::updateWithDetectedMarkersStereo(ARMarkerInfo* markerInfo
     
 	if (markerInfoL && markerInfoR) {
         
-        int kL = -1, kR = -1;
-        if (patt_type == AR_PATTERN_TYPE_TEMPLATE) {
-            // Iterate over all detected markers.
-            for (int j = 0; j < markerNumL; j++ ) {
-                if (markerInfoL[j].matched) continue;
-                if (patt_id != markerInfoL[j].idPatt) continue;
-                // The pattern of detected trapezoid matches marker[kL].
-                if (kL == -1) {
-                    if (markerInfoL[j].cfPatt > m_cfMin) kL = j; // Count as a match if match confidence exceeds cfMin.
-                } else if (markerInfoL[j].cfPatt > markerInfoL[kL].cfPatt) kL = j; // Or if it exceeds match confidence of a different already matched trapezoid (i.e. assume only one instance of each marker).
-            }
-            if (kL != -1) {
-                markerInfoL[kL].id = markerInfoL[kL].idPatt;
-                markerInfoL[kL].cf = markerInfoL[kL].cfPatt;
-                markerInfoL[kL].dir = markerInfoL[kL].dirPatt;
-            }
-            for (int j = 0; j < markerNumR; j++ ) {
-                if (markerInfoR[j].matched) continue;
-                if (patt_id != markerInfoR[j].idPatt) continue;
-                // The pattern of detected trapezoid matches marker[kR].
-                if (kR == -1) {
-                    if (markerInfoR[j].cfPatt > m_cfMin) kR = j; // Count as a match if match confidence exceeds cfMin.
-                } else if (markerInfoR[j].cfPatt > markerInfoR[kR].cfPatt) kR = j; // Or if it exceeds match confidence of a different already matched trapezoid (i.e. assume only one instance of each marker).
-            }
-            if (kR != -1) {
-                markerInfoR[kR].id = markerInfoR[kR].idPatt;
-                markerInfoR[kR].cf = markerInfoR[kR].cfPatt;
-                markerInfoR[kR].dir = markerInfoR[kR].dirPatt;
-            }
-        } else {
-            for (int j = 0; j < markerNumL; j++) {
-                if (markerInfoL[j].matched) continue;
-                // Check if we need to examine the globalID rather than patt_id.
-                if (markerInfoL[j].idMatrix == 0 && markerInfoL[j].globalID != 0ULL) {
-                    if (markerInfoL[j].globalID != globalID ) continue;
-                } else {
-                    if (markerInfoL[j].idMatrix != patt_id ) continue;
-                }
-                if (kL == -1) {
-                    if (markerInfoL[j].cfMatrix >= m_cfMin) kL = j; // Count as a match if match confidence exceeds cfMin.
-                } else if (markerInfoL[j].cfMatrix > markerInfoL[kL].cfMatrix) kL = j; // Or if it exceeds match confidence of a different already matched trapezoid (i.e. assume only one instance of each marker).
-            }
-            if (kL != -1) {
-                markerInfoL[kL].id = markerInfoL[kL].idMatrix;
-                markerInfoL[kL].cf = markerInfoL[kL].cfMatrix;
-                markerInfoL[kL].dir = markerInfoL[kL].dirMatrix;
-            }
-            for (int j = 0; j < markerNumR; j++) {
-                if (markerInfoR[j].matched) continue;
-                // Check if we need to examine the globalID rather than patt_id.
-                if (markerInfoR[j].idMatrix == 0 && markerInfoR[j].globalID != 0ULL) {
-                    if (markerInfoR[j].globalID != globalID ) continue;
-                } else {
-                    if (markerInfoR[j].idMatrix != patt_id ) continue;
-                }
-                if (kR == -1) {
-                    if (markerInfoR[j].cfMatrix >= m_cfMin) kR = j; // Count as a match if match confidence exceeds cfMin.
-                } else if (markerInfoR[j].cfMatrix > markerInfoR[kR].cfMatrix) kR = j; // Or if it exceeds match confidence of a different already matched trapezoid (i.e. assume only one instance of each marker).
-            }
-            if (kR != -1) {
-                markerInfoR[kR].id = markerInfoR[kR].idMatrix;
-                markerInfoR[kR].cf = markerInfoR[kR].cfMatrix;
-                markerInfoR[kR].dir = markerInfoR[kR].dirMatrix;
-            }
-        }
+        int kL = findDetectedMarker(markerInfoL, markerNumL, indexL);
+        int kR = findDetectedMarker(markerInfoR, markerNumR, indexR);
         
         if (kL != -1 || kR != -1) {
             if (kL != -1) markerInfoL[kL].matched = 1;
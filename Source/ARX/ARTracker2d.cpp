@@ -44,6 +44,7 @@
 #include <ARX/ARTrackable2d.h>
 #include "trackingSub.h"
 #include <ARX/OCVT/PlanarTracker.h>
+#include <ARX/ARUtil/stage_timing.h>
 #include <algorithm>
 
 ARTracker2d::ARTracker2d() :
@@ -221,7 +222,9 @@ bool ARTracker2d::update(AR2VideoBufferT *buff)
     }
 
     if (!m_threaded) {
+        AR_STAGE_TIMING_BEGIN(AR_STAGE_2D_MATCHING);
         m_2DTracker->ProcessFrameData(buff->buffLuma);
+        AR_STAGE_TIMING_END(AR_STAGE_2D_MATCHING);
         updateTrackablesFromTracker();
     } else {
         // First, see if a frane has been completely processed.
@@ -254,7 +257,9 @@ void *ARTracker2d::trackingWorker(THREAD_HANDLE_T *threadHandle)
 
     while (threadStartWait(threadHandle) == 0) {
         // Do tracking.
+        AR_STAGE_TIMING_BEGIN(AR_STAGE_2D_MATCHING);
         tracker2D->m_2DTracker->ProcessFrameData(tracker2D->m_trackingBuffcopy);
+        AR_STAGE_TIMING_END(AR_STAGE_2D_MATCHING);
         threadEndSignal(threadHandle);
     }
 
@@ -378,6 +383,13 @@ void ARTracker2d::deleteAllTrackables()
     unloadTwoDData();
 }
 
+double ARTracker2d::takeFilterTime()
+{
+    double t = 0.0;
+    for (auto& trackable : m_trackables) t += trackable->takeFilterTime();
+    return t;
+}
+
 bool ARTracker2d::loadImageDatabase(std::string fileName)
 {
     deleteAllTrackables();
@@ -43,6 +43,7 @@
 #if HAVE_NFT
 #include <ARX/ARTrackableNFT.h>
 #include "trackingSub.h"
+#include <ARX/ARUtil/stage_timing.h>
 #include <algorithm>
 
 ARTrackerNFT::ARTrackerNFT() :
@@ -264,6 +265,7 @@ bool ARTrackerNFT::update(AR2VideoBufferT *buff)
         }
         
         // Do AR2 tracking and update NFT markers.
+        AR_STAGE_TIMING_BEGIN(AR_STAGE_NFT_AR2);
         int page = 0;
         int pagesTracked = 0;
         bool success = true;
@@ -287,6 +289,7 @@ bool ARTrackerNFT::update(AR2VideoBufferT *buff)
         }
         
         m_kpmRequired = (pagesTracked < (m_nftMultiMode ? page : 1));
+        AR_STAGE_TIMING_END(AR_STAGE_NFT_AR2);
         
     } // trackingThreadHandle
 
@@ -406,5 +409,12 @@ void ARTrackerNFT::deleteAllTrackables()
     unloadNFTData();
 }
 
+double ARTrackerNFT::takeFilterTime()
+{
+    double t = 0.0;
+    for (auto& trackable : m_trackables) t += trackable->takeFilterTime();
+    return t;
+}
+
 
 #endif // HAVE_NFT
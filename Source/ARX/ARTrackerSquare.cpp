@@ -43,6 +43,7 @@
 #include <ARX/ARTrackableMultiSquare.h>
 #include <ARX/ARTrackableMultiSquareAuto.h>
 #include <ARX/AR/ar.h>
+#include <ARX/ARUtil/stage_timing.h>
 #include <algorithm>
 
 ARTrackerSquare::ARTrackerSquare() :
@@ -51,6 +52,7 @@ ARTrackerSquare::ARTrackerSquare() :
     m_thresholdMode(AR_LABELING_THRESH_MODE_DEFAULT),
     m_imageProcMode(AR_DEFAULT_IMAGE_PROC_MODE),
     m_labelingMode(AR_DEFAULT_LABELING_MODE),
+    m_labelingThreadCount(AR_DEFAULT_LABELING_THREAD_COUNT),
     m_pattRatio(AR_PATT_RATIO),
     m_patternDetectionMode(AR_DEFAULT_PATTERN_DETECTION_MODE),
     m_matrixCodeType(AR_MATRIX_CODE_TYPE_DEFAULT),
@@ -60,6 +62,7 @@ ARTrackerSquare::ARTrackerSquare() :
     m_matrixModeAutoCreateNewTrackables(false),
     m_matrixModeAutoCreateNewTrackablesDefaultWidth(k_matrixModeAutoCreateNewTrackablesDefaultWidth_default),
     m_matrixModeAutoCreateNewTrackablesCallback(nullptr),
+    m_matrixModeAutoCreateNewTrackablesCallbackUserdata(nullptr),
     m_arHandle0(NULL),
     m_arHandle1(NULL),
     m_arPattHandle(NULL),
@@ -187,6 +190,24 @@ int ARTrackerSquare::labelingMode() const
     return m_labelingMode;
 }
 
+void ARTrackerSquare::setLabelingThreadCount(int threadCount)
+{
+    m_labelingThreadCount = threadCount;
+    if (m_arHandle0) {
+        arSetLabelingThreadCount(m_arHandle0, m_labelingThreadCount);
+        ARLOGi("Labeling thread count set to %d\n", m_labelingThreadCount);
+    }
+    if (m_arHandle1) {
+        arSetLabelingThreadCount(m_arHandle1, m_labelingThreadCount);
+        ARLOGi("Labeling thread count set to %d\n", m_labelingThreadCount);
+    }
+}
+
+int ARTrackerSquare::labelingThreadCount() const
+{
+    return m_labelingThreadCount;
+}
+
 void ARTrackerSquare::setPatternDetectionMode(int mode)
 {
     m_patternDetectionMode = mode;
@@ -310,6 +331,7 @@ bool ARTrackerSquare::start(ARParamLT *paramLT0, AR_PIXEL_FORMAT pixelFormat0, A
     arSetImageProcMode(m_arHandle0, m_imageProcMode);
     arSetDebugMode(m_arHandle0, m_debugMode);
     arSetLabelingMode(m_arHandle0, m_labelingMode);
+    arSetLabelingThreadCount(m_arHandle0, m_labelingThreadCount);
     arSetPattRatio(m_arHandle0, m_pattRatio);
     arSetPatternDetectionMode(m_arHandle0, m_patternDetectionMode);
     arSetMatrixCodeType(m_arHandle0, m_matrixCodeType);
@@ -332,6 +354,7 @@ bool ARTrackerSquare::start(ARParamLT *paramLT0, AR_PIXEL_FORMAT pixelFormat0, A
         arSetImageProcMode(m_arHandle1, m_imageProcMode);
         arSetDebugMode(m_arHandle1, m_debugMode);
         arSetLabelingMode(m_arHandle1, m_labelingMode);
+        arSetLabelingThreadCount(m_arHandle1, m_labelingThreadCount);
         arSetPattRatio(m_arHandle1, m_pattRatio);
         arSetPatternDetectionMode(m_arHandle1, m_patternDetectionMode);
         arSetMatrixCodeType(m_arHandle1, m_matrixCodeType);
@@ -402,28 +425,33 @@ bool ARTrackerSquare::update(AR2VideoBufferT *buff0, AR2VideoBufferT *buff1)
     }
 
     // Update square markers.
+    // Index the detected markers by ID once, so each trackable only examines its own.
+    AR_STAGE_TIMING_BEGIN(AR_STAGE_SQUARE_POSE);
     bool success = true;
+    m_markerInfoIndex0.build(markerInfo0, markerNum0);
     if (!buff1) {
         for (std::vector<std::shared_ptr<ARTrackable>>::iterator it = m_trackables.begin(); it != m_trackables.end(); ++it) {
             if ((*it)->type == ARTrackable::SINGLE) {
-                success &= (std::static_pointer_cast<ARTrackableSquare>(*it))->updateWithDetectedMarkers(markerInfo0, markerNum0, m_ar3DHandle);
+                success &= (std::static_pointer_cast<ARTrackableSquare>(*it))->updateWithDetectedMarkers(markerInfo0, markerNum0, m_ar3DHandle, &m_markerInfoIndex0);
             } else if ((*it)->type == ARTrackable::MULTI) {
-                success &= (std::static_pointer_cast<ARTrackableMultiSquare>(*it))->updateWithDetectedMarkers(markerInfo0, markerNum0, m_ar3DHandle);
+                success &= (std::static_pointer_cast<ARTrackableMultiSquare>(*it))->updateWithDetectedMarkers(markerInfo0, markerNum0, m_ar3DHandle, &m_markerInfoIndex0);
             } else if ((*it)->type == ARTrackable::MULTI_AUTO) {
                 success &= (std::static_pointer_cast<ARTrackableMultiSquareAuto>(*it))->updateWithDetectedMarkers(markerInfo0, markerNum0, m_arHandle0->xsize, m_arHandle0->ysize, m_ar3DHandle);
             }
         }
     } else {
+        m_markerInfoIndex1.build(markerInfo1, markerNum1);
         for (std::vector<std::shared_ptr<ARTrackable>>::iterator it = m_trackables.begin(); it != m_trackables.end(); ++it) {
             if ((*it)->type == ARTrackable::SINGLE) {
-                success &= (std::static_pointer_cast<ARTrackableSquare>(*it))->updateWithDetectedMarkersStereo(markerInfo0, markerNum0, markerInfo1, markerNum1, m_ar3DStereoHandle, m_transL2R);
+                success &= (std::static_pointer_cast<ARTrackableSquare>(*it))->updateWithDetectedMarkersStereo(markerInfo0, markerNum0, markerInfo1, markerNum1, m_ar3DStereoHandle, m_transL2R, &m_markerInfoIndex0, &m_markerInfoIndex1);
             } else if ((*it)->type == ARTrackable::MULTI) {
-                success &= (std::static_pointer_cast<ARTrackableMultiSquare>(*it))->updateWithDetectedMarkersStereo(markerInfo0, markerNum0, markerInfo1, markerNum1, m_ar3DStereoHandle, m_transL2R);
+                success &= (std::static_pointer_cast<ARTrackableMultiSquare>(*it))->updateWithDetectedMarkersStereo(markerInfo0, markerNum0, markerInfo1, markerNum1, m_ar3DStereoHandle, m_transL2R, &m_markerInfoIndex0, &m_markerInfoIndex1);
             } else if ((*it)->type == ARTrackable::MULTI_AUTO) {
                 success &= (std::static_pointer_cast<ARTrackableMultiSquareAuto>(*it))->updateWithDetectedMarkersStereo(markerInfo0, markerNum0, m_arHandle0->xsize, m_arHandle0->ysize, markerInfo1, markerNum1, m_arHandle1->xsize, m_arHandle1->ysize, m_ar3DStereoHandle, m_transL2R);
             }
         }
     }
+    AR_STAGE_TIMING_END(AR_STAGE_SQUARE_POSE);
 
     // If the user wants unmatched markers to be added as new trackables, and we're doing barcode (matrix code)
     // detection, look for unmatched valid barcode markers, and add them.
@@ -467,7 +495,7 @@ bool ARTrackerSquare::update(AR2VideoBufferT *buff0, AR2VideoBufferT *buff1)
         for (std::shared_ptr<ARTrackableSquare> trackable : newTrackables) {
             m_trackables.push_back(trackable);
             if (m_matrixModeAutoCreateNewTrackablesCallback) {
-                (*m_matrixModeAutoCreateNewTrackablesCallback)(*trackable);
+                (*m_matrixModeAutoCreateNewTrackablesCallback)(*trackable, m_matrixModeAutoCreateNewTrackablesCallbackUserdata);
             }
         }
     }
@@ -720,6 +748,13 @@ void ARTrackerSquare::deleteAllTrackables()
     m_trackables.clear();
 }
 
+double ARTrackerSquare::takeFilterTime()
+{
+    double t = 0.0;
+    for (auto& trackable : m_trackables) t += trackable->takeFilterTime();
+    return t;
+}
+
 // ----------------------------------------------------------------------------------------------------
 #pragma mark Square tracker debug texture
 // ----------------------------------------------------------------------------------------------------
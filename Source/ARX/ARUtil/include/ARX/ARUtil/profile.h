@@ -36,25 +36,104 @@
  *
  */
 
+/*!
+    @file profile.h
+    @brief Scope-based profiling.
+    @details
+        Code to be profiled is bracketed by calls to arUtilProfileBegin and arUtilProfileEnd.
+        Scopes may be nested, and each thread keeps its own stack of open scopes, so the
+        profiler may be used from any number of threads at once. Each scope is identified by its
+        path, i.e. its name prefixed by the names of the scopes enclosing it, e.g.
+        "update/square/labeling". Statistics for the same path are aggregated across all threads,
+        including threads which have since exited.
+
+        Profiling is disabled by default. While disabled, the cost of a Begin/End pair is a single
+        test in each call.
+ */
+
 #ifndef __ARUtil_profile_h__
 #define __ARUtil_profile_h__
 
 #include <ARX/ARUtil/types.h>
+#include <stdint.h>
 
 #define MAX_PROF_NUM     20
 
+#define AR_UTIL_PROFILE_DEPTH_MAX       16  ///< Scopes nested deeper than this are not profiled.
+#define AR_UTIL_PROFILE_SCOPES_MAX      128 ///< Maximum number of distinct scope paths profiled by each thread.
+#define AR_UTIL_PROFILE_PATH_MAX        256 ///< Size of ARUtilProfileStats.path, including nul-terminator.
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef struct {
+    char     path[AR_UTIL_PROFILE_PATH_MAX]; ///< Names of the scope and its enclosing scopes, separated by '/'.
+    int      depth;                          ///< Nesting depth of the scope. Outermost scopes have depth 0.
+    uint64_t count;                          ///< Number of times the scope was completed.
+    double   total;                          ///< Total time spent in the scope, in seconds.
+    double   min;                            ///< Shortest time spent in the scope, in seconds.
+    double   max;                            ///< Longest time spent in the scope, in seconds.
+} ARUtilProfileStats;
+
+/*!
+    @brief Enable or disable profiling.
+    @details Scopes which are open when profiling is enabled or disabled are discarded.
+    @param enable Non-zero to enable profiling, 0 to disable it.
+ */
+ARUTIL_EXTERN void arUtilProfileSetEnabled(int enable);
+
+/*!
+    @brief Check whether profiling is enabled.
+ */
+ARUTIL_EXTERN int arUtilProfileGetEnabled(void);
+
+/*!
+    @brief Open a profiling scope on the calling thread.
+    @param name Name of the scope. Must remain valid for the life of the process, e.g. a string literal.
+    @return A token to pass to arUtilProfileEnd, or 0 if the scope is not being profiled.
+ */
+ARUTIL_EXTERN int arUtilProfileBegin(const char *name);
+
+/*!
+    @brief Close a profiling scope on the calling thread, and add its duration to the statistics.
+    @details Any scopes opened inside this one and not yet closed (e.g. because of an early return)
+        are discarded.
+    @param token The value returned by the matching call to arUtilProfileBegin. If 0, this function does nothing.
+ */
+ARUTIL_EXTERN void arUtilProfileEnd(int token);
+
+/*!
+    @brief Clear the statistics of all threads, and discard any open scopes.
+ */
+ARUTIL_EXTERN void arUtilProfileReset(void);
+
+/*!
+    @brief Get aggregated statistics for all scopes profiled since the last reset.
+    @details Scopes are returned in depth-first order, so each scope follows its enclosing scope.
+    @param stats Array to fill, or NULL to just count the scopes.
+    @param statsCount Number of elements in stats. Scopes beyond this number are not returned.
+    @return The total number of scopes with statistics, which may be more than statsCount.
+ */
+ARUTIL_EXTERN int arUtilProfileGetStats(ARUtilProfileStats *stats, int statsCount);
+
+/*!
+    @brief Print the aggregated statistics of all scopes.
+ */
+ARUTIL_EXTERN void arUtilProfilePrint(void);
+
+//
+// Legacy interface.
+//
 
 /*!
     @brief   Reset profiling.
 	@details
-        The profiling facility provides a single profile per process.
         There are up to MAX_PROF_NUM timing buckets available, numbered 0 to MAX_PROF_NUM-1.
         Call this function before the first call to profileSet to have the first call to
         profileSet function set the initial time and timing bucket.
+        Buckets are profiled as scopes named "REGION n", so this function also enables
+        profiling and resets all statistics.
     @see profileSet
 */
 ARUTIL_EXTERN void profileClear (void);
@@ -63,10 +142,8 @@ ARUTIL_EXTERN void profileClear (void);
     @brief   Set profiling initial time and timing bucket, or add elapsed time to a bucket.
 	@details
         This function sets a profiling timing point and selects the timing bucket.
-        If being called for the first time, or the first time since profileClear was called,
-        it sets the initial time, and subsequent calls will log time into the timing bucket n.
-        On subsequent calls, the elapsed time since the last call will be added to the
-        previously set timing bucket, and will again set the timing bucket.
+        On each call, the elapsed time since the last call on the same thread will be added
+        to the previously set timing bucket, and the timing bucket n will be selected.
     @param      n The timing bucket to add to on the next call.
     @see profileClear profilePrint
 */
@@ -75,7 +152,7 @@ ARUTIL_EXTERN void profileSet   (int n);
 /*!
     @brief   Print all profiling buckets.
 	@details
-        Prints all non-zero timing buckets and the percentage time occupied and total time.
+        Equivalent to arUtilProfilePrint.
 */
 ARUTIL_EXTERN void profilePrint (void);
 
@@ -0,0 +1,127 @@
+/*
+ *  stage_timing.h
+ *  artoolkitX
+ *
+ *  Timing of the main stages of the tracking pipeline.
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ */
+
+/*!
+    @file stage_timing.h
+    @brief Timing of the main stages of the tracking pipeline.
+    @details
+        The video and tracking libraries report the duration of each of their main
+        processing stages to a single process-wide callback. When no callback is set,
+        the cost of each timing point is a single test.
+
+        Stages may run on threads other than the one which calls ARController::update
+        (for example, KPM matching runs on its own thread), so the callback may be invoked
+        from several threads at once, and must be thread-safe. A stage may be reported
+        more than once per video frame, e.g. labeling when auto-bracketing thresholds.
+
+        Each timing point also opens a scope (named as per arUtilStageTimingName) in the
+        profiler in profile.h, so that stages appear in the profile when it is enabled.
+ */
+
+#ifndef __ARUtil_stage_timing_h__
+#define __ARUtil_stage_timing_h__
+
+#include <ARX/ARUtil/types.h>
+#include <ARX/ARUtil/time.h> // arUtilTimeMonotonic()
+#include <ARX/ARUtil/profile.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    AR_STAGE_VIDEO_LUMA = 0,    ///< Luma extraction from a video frame.
+    AR_STAGE_SQUARE_LABELING,   ///< Thresholding and connected-component labeling of square markers.
+    AR_STAGE_SQUARE_PATTERN_ID, ///< Square marker candidate fitting, and pattern and matrix code identification.
+    AR_STAGE_SQUARE_POSE,       ///< Pose estimation and filtering of square trackables.
+    AR_STAGE_NFT_KPM,           ///< KPM keypoint detection and matching of NFT trackables, on the KPM thread.
+    AR_STAGE_NFT_AR2,           ///< AR2 template tracking of NFT trackables.
+    AR_STAGE_2D_MATCHING,       ///< Feature detection, matching and optical flow tracking of 2D trackables.
+    AR_STAGE_COUNT
+} AR_STAGE;
+
+/*!
+    @brief Signature of a stage timing callback.
+    @param stage The stage which completed.
+    @param seconds Duration of the stage, in seconds.
+    @param userData The value passed to arUtilStageTimingSetCallback.
+ */
+typedef void (*ARUtilStageTimingCallback)(AR_STAGE stage, double seconds, void *userData);
+
+/*!
+    @brief Set or clear the process-wide stage timing callback.
+    @details The callback should be set or cleared only while no tracking is in progress.
+    @param callback The callback to invoke, or NULL to stop timing.
+    @param userData A value passed to each invocation of the callback.
+ */
+ARUTIL_EXTERN void arUtilStageTimingSetCallback(ARUtilStageTimingCallback callback, void *userData);
+
+/*!
+    @brief Get a short, human-readable, name for a stage, e.g. "labeling".
+    @return The name, or NULL if stage is not valid.
+ */
+ARUTIL_EXTERN const char *arUtilStageTimingName(AR_STAGE stage);
+
+/*!
+    @brief Check whether stage timing is in use.
+    @return Non-zero if a stage timing callback is set.
+ */
+ARUTIL_EXTERN int arUtilStageTimingEnabled(void);
+
+/*!
+    @brief Report the completion of a stage.
+    @param stage The stage which completed.
+    @param start The time the stage began, as returned by arUtilTimeMonotonic().
+ */
+ARUTIL_EXTERN void arUtilStageTimingRecord(AR_STAGE stage, double start);
+
+//
+// Timing points, for use by the libraries. BEGIN declares a variable in the enclosing scope,
+// so a stage can be timed at most once in any one scope.
+//
+#define AR_STAGE_TIMING_BEGIN(stage) \
+    int arStageProfile_##stage = arUtilProfileBegin(arUtilStageTimingName(stage)); \
+    double arStageTimingStart_##stage = (arUtilStageTimingEnabled() ? arUtilTimeMonotonic() : 0.0)
+#define AR_STAGE_TIMING_END(stage) do { \
+    if (arStageTimingStart_##stage != 0.0) arUtilStageTimingRecord(stage, arStageTimingStart_##stage); \
+    arUtilProfileEnd(arStageProfile_##stage); \
+} while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !__ARUtil_stage_timing_h__
@@ -69,6 +69,16 @@ ARUTIL_EXTERN double arUtilTimer(void);
  */
 ARUTIL_EXTERN void arUtilTimerReset(void);
 
+/*!
+    @brief Read a monotonic clock with sub-microsecond resolution where the system provides it.
+    @details
+        The clock is unaffected by changes to the system time, so differences between
+        readings are suitable for measuring elapsed time. Unlike arUtilTimer(), it has
+        no shared state, so may be read from any thread.
+    @return Seconds since an arbitrary, system-specific, starting point.
+ */
+ARUTIL_EXTERN double arUtilTimeMonotonic(void);
+
 #ifndef _WINRT
 /*!
     @brief   Relinquish CPU to the system for specified number of milliseconds.
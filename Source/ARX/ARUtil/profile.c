@@ -41,89 +41,423 @@
 #  include <android/log.h>
 #endif
 #include <stdio.h>
-#ifdef _WIN32
-#  include <sys/timeb.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ARX/ARUtil/profile.h>
+#include <ARX/ARUtil/time.h> // arUtilTimeMonotonic()
+
+#if !defined(_WINRT) && !defined(ARUTIL_DISABLE_PTHREADS)
+#  include <pthread.h>
+#  define HAVE_PROFILE 1
 #else
-#  include <sys/time.h>
+#  define HAVE_PROFILE 0
 #endif
-#include <ARX/ARUtil/profile.h>
 
 #ifdef __ANDROID__
 #  define LOG(...)  __android_log_print(ANDROID_LOG_INFO, "libARUtil", __VA_ARGS__)
-#  define LOGe(...) __android_log_print(ANDROID_LOG_ERROR, "libARUtil", __VA_ARGS__)
 #else
 #  define LOG(...)  printf(__VA_ARGS__)
-#  define LOGe(...) fprintf(stderr, __VA_ARGS__)
 #endif
 
-long profTable[MAX_PROF_NUM];
-int  profCount[MAX_PROF_NUM];
+#if HAVE_PROFILE
 
-static long s;
-static int us, num = -1;
+// Atomic access to the state which is shared between profiled threads and the readers of the statistics.
+#if defined(_MSC_VER) && !defined(__clang__)
+#  include <windows.h>
+#  define PROFILE_LOAD_ACQUIRE_32(p)      ((unsigned int)InterlockedCompareExchange((volatile LONG *)(p), 0, 0))
+#  define PROFILE_LOAD_RELAXED_32(p)      PROFILE_LOAD_ACQUIRE_32(p)
+#  define PROFILE_STORE_RELEASE_32(p, v)  InterlockedExchange((volatile LONG *)(p), (LONG)(v))
+#  define PROFILE_STORE_RELAXED_32(p, v)  PROFILE_STORE_RELEASE_32(p, v)
+#  define PROFILE_INCREMENT_32(p)         InterlockedIncrement((volatile LONG *)(p))
+#  define PROFILE_LOAD_RELAXED_64(p)      ((uint64_t)InterlockedCompareExchange64((volatile LONG64 *)(p), 0, 0))
+#  define PROFILE_STORE_RELAXED_64(p, v)  InterlockedExchange64((volatile LONG64 *)(p), (LONG64)(v))
+#  define PROFILE_FENCE_ACQUIRE()         MemoryBarrier()
+#  define PROFILE_FENCE_RELEASE()         MemoryBarrier()
+#else
+#  define PROFILE_LOAD_ACQUIRE_32(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#  define PROFILE_LOAD_RELAXED_32(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#  define PROFILE_STORE_RELEASE_32(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#  define PROFILE_STORE_RELAXED_32(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#  define PROFILE_INCREMENT_32(p)         __atomic_fetch_add((p), 1, __ATOMIC_ACQ_REL)
+#  define PROFILE_LOAD_RELAXED_64(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#  define PROFILE_STORE_RELAXED_64(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#  define PROFILE_FENCE_ACQUIRE()         __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#  define PROFILE_FENCE_RELEASE()         __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
 
-void profileClear(void)
+// Times are held in nanoseconds so that every statistic can be read and written atomically.
+typedef struct {
+    const char *name;
+    int         parent;     // Index of enclosing scope's node, or -1.
+    int         depth;
+    uint64_t    count;
+    uint64_t    total;
+    uint64_t    min;
+    uint64_t    max;
+} ProfileNode;
+
+// One per thread which has profiled something, plus one holding the statistics of threads which have exited.
+// Only the owning thread writes to its nodes, so Begin and End take no locks. Readers take a consistent copy
+// using seq, which the owner makes odd while it is updating statistics (a sequence lock). Nodes are only
+// ever appended; a node's name, parent and depth are written before nodeCount is advanced past it.
+// The stack and generation are only accessed by the owning thread.
+typedef struct _ProfileThread {
+    ProfileNode            nodes[AR_UTIL_PROFILE_SCOPES_MAX];
+    int                    nodeCount;
+    unsigned int           seq;
+    unsigned int           resetCount;  // Value of gResetCount when the statistics were last cleared.
+    int                    stack[AR_UTIL_PROFILE_DEPTH_MAX];
+    double                 stackStart[AR_UTIL_PROFILE_DEPTH_MAX];
+    int                    stackDepth;
+    unsigned int           generation;
+    struct _ProfileThread *next;
+} ProfileThread;
+
+static unsigned int gEnabled = 0;
+static unsigned int gGeneration = 0; // Incremented to discard open scopes on all threads.
+static unsigned int gResetCount = 0; // Incremented to discard the statistics of all threads.
+static pthread_once_t gKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t gKey;
+static pthread_mutex_t gThreadsLock = PTHREAD_MUTEX_INITIALIZER; // Protects gThreads and gExited.
+static ProfileThread *gThreads = NULL;
+static ProfileThread *gExited = NULL;
+
+// Find the node for name within parent, adding it if necessary. Only to be called by the owner of t,
+// or with exclusive access to t.
+static int profileNodeGet(ProfileThread *t, int parent, const char *name)
 {
-	num = -1;
+    int i;
+    ProfileNode *n;
+
+    for (i = 0; i < t->nodeCount; i++) {
+        n = &t->nodes[i];
+        if (n->parent == parent && (n->name == name || strcmp(n->name, name) == 0)) return (i);
+    }
+    if (t->nodeCount == AR_UTIL_PROFILE_SCOPES_MAX) return (-1);
+    n = &t->nodes[t->nodeCount];
+    n->name = name;
+    n->parent = parent;
+    n->depth = (parent < 0 ? 0 : t->nodes[parent].depth + 1);
+    n->count = n->total = n->min = n->max = 0;
+    PROFILE_STORE_RELEASE_32(&t->nodeCount, t->nodeCount + 1);
+    return (t->nodeCount - 1);
 }
 
-void profileSet(int n)
+// Called by the owner of t around any change to its statistics.
+static void profileWriteBegin(ProfileThread *t)
 {
+    PROFILE_STORE_RELAXED_32(&t->seq, t->seq + 1);
+    PROFILE_FENCE_RELEASE();
+}
+
+static void profileWriteEnd(ProfileThread *t)
+{
+    PROFILE_STORE_RELEASE_32(&t->seq, t->seq + 1);
+}
+
+// Copy the nodes of another thread's t into snap. Returns 0 if the statistics in t predate the last reset.
+static int profileThreadSnapshot(const ProfileThread *t, ProfileThread *snap)
+{
+    unsigned int seq;
     int i;
-#ifdef _WIN32
-    struct _timeb sys_time;
 
-    _ftime_s(&sys_time);
-    if(num != -1) {
-		profTable[num] += ((long)sys_time.time - s) * 1000000L + sys_time.millitm * 1000L - us;
-        profCount[num]++;
+    for (;;) {
+        seq = PROFILE_LOAD_ACQUIRE_32(&t->seq);
+        if (seq & 1) continue; // Owner is mid-update.
+        snap->nodeCount = PROFILE_LOAD_ACQUIRE_32(&t->nodeCount);
+        for (i = 0; i < snap->nodeCount; i++) {
+            const ProfileNode *n = &t->nodes[i];
+            ProfileNode *s = &snap->nodes[i];
+            s->name = n->name;
+            s->parent = n->parent;
+            s->depth = n->depth;
+            s->count = PROFILE_LOAD_RELAXED_64(&n->count);
+            s->total = PROFILE_LOAD_RELAXED_64(&n->total);
+            s->min = PROFILE_LOAD_RELAXED_64(&n->min);
+            s->max = PROFILE_LOAD_RELAXED_64(&n->max);
+        }
+        snap->resetCount = PROFILE_LOAD_RELAXED_32(&t->resetCount);
+        PROFILE_FENCE_ACQUIRE();
+        if (PROFILE_LOAD_RELAXED_32(&t->seq) == seq) break;
     }
-#else
-    struct timeval     time;
-
-#  if defined(__linux) || defined(__APPLE__) || defined(EMSCRIPTEN)
-    gettimeofday( &time, NULL );
-#  else
-    gettimeofday( &time );
-#  endif
-    if(num != -1) {
-        profTable[num] += (time.tv_sec  - s) * 1000000L + time.tv_usec - us; // Add elapsed microseconds to previously set profile,
-        profCount[num]++; // and count one more measurement.
+    return (snap->resetCount == PROFILE_LOAD_ACQUIRE_32(&gResetCount));
+}
+
+// Add the statistics of src to dst. Caller must have exclusive access to dst, and src must be a snapshot,
+// or owned by the calling thread.
+static void profileThreadMerge(ProfileThread *dst, const ProfileThread *src)
+{
+    int map[AR_UTIL_PROFILE_SCOPES_MAX];
+    int i, j;
+
+    // Nodes are always added after their parent, so parents are mapped before their children.
+    for (i = 0; i < src->nodeCount; i++) {
+        const ProfileNode *s = &src->nodes[i];
+        map[i] = -1;
+        if (s->parent >= 0 && map[s->parent] < 0) continue;
+        j = profileNodeGet(dst, (s->parent < 0 ? -1 : map[s->parent]), s->name);
+        if (j < 0) continue;
+        map[i] = j;
+        if (!s->count) continue;
+        ProfileNode *d = &dst->nodes[j];
+        if (!d->count || s->min < d->min) d->min = s->min;
+        if (s->max > d->max) d->max = s->max;
+        d->count += s->count;
+        d->total += s->total;
     }
-#endif
-    else {
-        for(i = 0; i < MAX_PROF_NUM; i++) {
-            profTable[i] = 0;
-            profCount[i] = 0;
+}
+
+static void profileThreadExit(void *arg)
+{
+    ProfileThread *t = (ProfileThread *)arg, **tp;
+
+    pthread_mutex_lock(&gThreadsLock);
+    for (tp = &gThreads; *tp; tp = &((*tp)->next)) {
+        if (*tp == t) {
+            *tp = t->next;
+            break;
         }
     }
+    if (t->resetCount == PROFILE_LOAD_ACQUIRE_32(&gResetCount)) {
+        if (!gExited) gExited = (ProfileThread *)calloc(1, sizeof(ProfileThread));
+        if (gExited) profileThreadMerge(gExited, t);
+    }
+    pthread_mutex_unlock(&gThreadsLock);
+    free(t);
+}
 
-#ifdef _WIN32
-    s = (long)sys_time.time;
-    us = sys_time.millitm * 1000L;
-#else
-    s = time.tv_sec;
-    us = time.tv_usec;
-#endif
-    num = n;
+static void profileKeyCreate(void)
+{
+    pthread_key_create(&gKey, profileThreadExit);
 }
 
-void profilePrint(void)
+static ProfileThread *profileThreadGet(int create)
+{
+    ProfileThread *t;
+
+    pthread_once(&gKeyOnce, profileKeyCreate);
+    t = (ProfileThread *)pthread_getspecific(gKey);
+    if (!t && create) {
+        if (!(t = (ProfileThread *)calloc(1, sizeof(ProfileThread)))) return (NULL);
+        t->generation = PROFILE_LOAD_ACQUIRE_32(&gGeneration);
+        t->resetCount = PROFILE_LOAD_ACQUIRE_32(&gResetCount);
+        pthread_setspecific(gKey, t);
+        pthread_mutex_lock(&gThreadsLock);
+        t->next = gThreads;
+        gThreads = t;
+        pthread_mutex_unlock(&gThreadsLock);
+    }
+    return (t);
+}
+
+// Called by the owner of t. If profiling has been re-enabled or reset since t last profiled anything,
+// discards its open scopes and, after a reset, its statistics. Returns 0 if open scopes were discarded.
+static int profileThreadSync(ProfileThread *t)
 {
+    unsigned int generation, resetCount;
     int i;
-    double sum = 0;
 
-    LOG("\n=== PROFILE RESULT ===\n");
-    for(i = 0; i < MAX_PROF_NUM; i++) {
-        sum += profTable[i];
+    generation = PROFILE_LOAD_ACQUIRE_32(&gGeneration);
+    if (t->generation == generation) return (1);
+    t->generation = generation;
+    t->stackDepth = 0;
+    resetCount = PROFILE_LOAD_ACQUIRE_32(&gResetCount);
+    if (t->resetCount != resetCount) {
+        profileWriteBegin(t);
+        for (i = 0; i < t->nodeCount; i++) {
+            ProfileNode *n = &t->nodes[i];
+            PROFILE_STORE_RELAXED_64(&n->count, 0);
+            PROFILE_STORE_RELAXED_64(&n->total, 0);
+            PROFILE_STORE_RELAXED_64(&n->min, 0);
+            PROFILE_STORE_RELAXED_64(&n->max, 0);
+        }
+        PROFILE_STORE_RELAXED_32(&t->resetCount, resetCount);
+        profileWriteEnd(t);
+    }
+    return (0);
+}
+
+void arUtilProfileSetEnabled(int enable)
+{
+    PROFILE_INCREMENT_32(&gGeneration);
+    PROFILE_STORE_RELEASE_32(&gEnabled, (enable ? 1u : 0u));
+}
+
+int arUtilProfileGetEnabled(void)
+{
+    return ((int)PROFILE_LOAD_ACQUIRE_32(&gEnabled));
+}
+
+int arUtilProfileBegin(const char *name)
+{
+    ProfileThread *t;
+    int node;
+
+    if (!PROFILE_LOAD_ACQUIRE_32(&gEnabled) || !name) return (0);
+    if (!(t = profileThreadGet(1))) return (0);
+    profileThreadSync(t);
+    if (t->stackDepth == AR_UTIL_PROFILE_DEPTH_MAX) return (0);
+
+    node = profileNodeGet(t, (t->stackDepth ? t->stack[t->stackDepth - 1] : -1), name);
+    if (node < 0) return (0);
+
+    t->stack[t->stackDepth] = node;
+    t->stackStart[t->stackDepth] = arUtilTimeMonotonic();
+    return (++t->stackDepth);
+}
+
+void arUtilProfileEnd(int token)
+{
+    ProfileThread *t;
+    ProfileNode *n;
+    double d;
+    uint64_t ns;
+
+    if (token <= 0) return;
+    if (!(t = profileThreadGet(0))) return;
+    if (!profileThreadSync(t)) return;
+    if (t->stackDepth < token) return; // Already closed.
+
+    d = arUtilTimeMonotonic() - t->stackStart[token - 1];
+    ns = (d > 0.0 ? (uint64_t)(d*1.0e9 + 0.5) : 0);
+    t->stackDepth = token - 1;
+    n = &t->nodes[t->stack[token - 1]];
+    profileWriteBegin(t);
+    if (!n->count || ns < n->min) PROFILE_STORE_RELAXED_64(&n->min, ns);
+    if (ns > n->max) PROFILE_STORE_RELAXED_64(&n->max, ns);
+    PROFILE_STORE_RELAXED_64(&n->count, n->count + 1);
+    PROFILE_STORE_RELAXED_64(&n->total, n->total + ns);
+    profileWriteEnd(t);
+}
+
+void arUtilProfileReset(void)
+{
+    // Each thread clears its own statistics when it next profiles something; until then, readers ignore them.
+    pthread_mutex_lock(&gThreadsLock);
+    PROFILE_INCREMENT_32(&gResetCount);
+    PROFILE_INCREMENT_32(&gGeneration);
+    if (gExited) {
+        free(gExited);
+        gExited = NULL;
     }
+    pthread_mutex_unlock(&gThreadsLock);
+}
 
-    for(i = 0; i < MAX_PROF_NUM; i++) {
-        if(profTable[i] == 0) {
-            continue;
+// Emit node and its descendants depth-first. Returns the updated count of scopes with statistics.
+static int profileStatsEmit(const ProfileThread *all, int node, const char *parentPath, ARUtilProfileStats *stats, int statsCount, int count)
+{
+    char path[AR_UTIL_PROFILE_PATH_MAX];
+    const ProfileNode *n = &all->nodes[node];
+    int i;
+
+    if (parentPath[0]) snprintf(path, sizeof(path), "%s/%s", parentPath, n->name);
+    else snprintf(path, sizeof(path), "%s", n->name);
+    if (n->count) {
+        if (stats && count < statsCount) {
+            ARUtilProfileStats *s = &stats[count];
+            strncpy(s->path, path, AR_UTIL_PROFILE_PATH_MAX);
+            s->path[AR_UTIL_PROFILE_PATH_MAX - 1] = '\0';
+            s->depth = n->depth;
+            s->count = n->count;
+            s->total = (double)n->total*1.0e-9;
+            s->min = (double)n->min*1.0e-9;
+            s->max = (double)n->max*1.0e-9;
         }
-        LOG("REGION %2d : %6.3lf%% (%lf sec)\n", i,
-                profTable[i] / sum * 100.0, profTable[i] / profCount[i] / 1000000.0);
+        count++;
+    }
+    for (i = node + 1; i < all->nodeCount; i++) {
+        if (all->nodes[i].parent == node) count = profileStatsEmit(all, i, path, stats, statsCount, count);
+    }
+    return (count);
+}
+
+int arUtilProfileGetStats(ARUtilProfileStats *stats, int statsCount)
+{
+    ProfileThread *all, *snap, *t;
+    int i, count = 0;
+
+    if (!(all = (ProfileThread *)calloc(2, sizeof(ProfileThread)))) return (0);
+    snap = all + 1;
+    pthread_mutex_lock(&gThreadsLock);
+    for (t = gThreads; t; t = t->next) {
+        if (profileThreadSnapshot(t, snap)) profileThreadMerge(all, snap);
+    }
+    if (gExited) profileThreadMerge(all, gExited);
+    pthread_mutex_unlock(&gThreadsLock);
+
+    for (i = 0; i < all->nodeCount; i++) {
+        if (all->nodes[i].parent < 0) count = profileStatsEmit(all, i, "", stats, statsCount, count);
+    }
+    free(all);
+    return (count);
+}
+
+#else // !HAVE_PROFILE
+
+void arUtilProfileSetEnabled(int enable) {}
+int arUtilProfileGetEnabled(void) { return (0); }
+int arUtilProfileBegin(const char *name) { return (0); }
+void arUtilProfileEnd(int token) {}
+void arUtilProfileReset(void) {}
+int arUtilProfileGetStats(ARUtilProfileStats *stats, int statsCount) { return (0); }
+
+#endif // HAVE_PROFILE
+
+void arUtilProfilePrint(void)
+{
+    ARUtilProfileStats *stats;
+    int count, i;
+
+    count = arUtilProfileGetStats(NULL, 0);
+    LOG("\n=== PROFILE RESULT ===\n");
+    if (count <= 0) return;
+    if (!(stats = (ARUtilProfileStats *)malloc(count * sizeof(ARUtilProfileStats)))) return;
+    count = arUtilProfileGetStats(stats, count);
+    LOG("%-40s %10s %12s %12s %12s %12s\n", "scope", "count", "total (s)", "mean (ms)", "min (ms)", "max (ms)");
+    for (i = 0; i < count; i++) {
+        LOG("%*s%-*s %10llu %12.6f %12.6f %12.6f %12.6f\n", stats[i].depth*2, "", 40 - stats[i].depth*2, strrchr(stats[i].path, '/') ? strrchr(stats[i].path, '/') + 1 : stats[i].path,
+                (unsigned long long)stats[i].count, stats[i].total, stats[i].total/stats[i].count*1000.0, stats[i].min*1000.0, stats[i].max*1000.0);
     }
+    free(stats);
+}
+
+//
+// Legacy interface.
+//
+
+static const char *regionNames[MAX_PROF_NUM] = {
+    "REGION 0",  "REGION 1",  "REGION 2",  "REGION 3",  "REGION 4",
+    "REGION 5",  "REGION 6",  "REGION 7",  "REGION 8",  "REGION 9",
+    "REGION 10", "REGION 11", "REGION 12", "REGION 13", "REGION 14",
+    "REGION 15", "REGION 16", "REGION 17", "REGION 18", "REGION 19"
+};
+
+#if HAVE_PROFILE
+static pthread_once_t gRegionKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t gRegionKey; // Token of the calling thread's open region, as an intptr_t.
+
+static void profileRegionKeyCreate(void)
+{
+    pthread_key_create(&gRegionKey, NULL);
 }
+#endif
 
+void profileClear(void)
+{
+    arUtilProfileSetEnabled(1);
+    arUtilProfileReset();
+}
+
+void profileSet(int n)
+{
+#if HAVE_PROFILE
+    pthread_once(&gRegionKeyOnce, profileRegionKeyCreate);
+    arUtilProfileEnd((int)(intptr_t)pthread_getspecific(gRegionKey));
+    pthread_setspecific(gRegionKey, (void *)(intptr_t)(n >= 0 && n < MAX_PROF_NUM ? arUtilProfileBegin(regionNames[n]) : 0));
+#endif
+}
+
+void profilePrint(void)
+{
+    arUtilProfilePrint();
+}
@@ -0,0 +1,86 @@
+/*
+ *  stage_timing.c
+ *  artoolkitX
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ */
+
+#include <ARX/ARUtil/stage_timing.h>
+#include <stddef.h>
+
+// The callback is published with release semantics after its user data, and read with acquire semantics before it,
+// so a thread which sees the callback also sees the user data it was set with.
+#if defined(_MSC_VER) && !defined(__clang__)
+#  include <windows.h>
+#  define STAGE_TIMING_LOAD_ACQUIRE_PTR(p)      InterlockedCompareExchangePointer((PVOID volatile *)(p), NULL, NULL)
+#  define STAGE_TIMING_STORE_RELEASE_PTR(p, v)  InterlockedExchangePointer((PVOID volatile *)(p), (PVOID)(v))
+#else
+#  define STAGE_TIMING_LOAD_ACQUIRE_PTR(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#  define STAGE_TIMING_STORE_RELEASE_PTR(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+static ARUtilStageTimingCallback gCallback = NULL;
+static void *gCallbackUserData = NULL;
+
+static const char *gStageNames[AR_STAGE_COUNT] = {
+    "luma",
+    "labeling",
+    "pattern ID",
+    "pose",
+    "KPM",
+    "AR2",
+    "2D matching"
+};
+
+void arUtilStageTimingSetCallback(ARUtilStageTimingCallback callback, void *userData)
+{
+    // Clear the callback first, so that no thread pairs the old callback with the new user data.
+    STAGE_TIMING_STORE_RELEASE_PTR(&gCallback, NULL);
+    STAGE_TIMING_STORE_RELEASE_PTR(&gCallbackUserData, userData);
+    STAGE_TIMING_STORE_RELEASE_PTR(&gCallback, callback);
+}
+
+const char *arUtilStageTimingName(AR_STAGE stage)
+{
+    if (stage < 0 || stage >= AR_STAGE_COUNT) return (NULL);
+    return (gStageNames[stage]);
+}
+
+int arUtilStageTimingEnabled(void)
+{
+    return (STAGE_TIMING_LOAD_ACQUIRE_PTR(&gCallback) != NULL);
+}
+
+void arUtilStageTimingRecord(AR_STAGE stage, double start)
+{
+    ARUtilStageTimingCallback callback = (ARUtilStageTimingCallback)STAGE_TIMING_LOAD_ACQUIRE_PTR(&gCallback);
+
+    if (callback) (*callback)(stage, arUtilTimeMonotonic() - start, STAGE_TIMING_LOAD_ACQUIRE_PTR(&gCallbackUserData));
+}
@@ -44,6 +44,10 @@
 #ifdef _WIN32
 #  include <windows.h>
 #  include <sys/timeb.h>
+#elif defined(__APPLE__)
+#  include <time.h>
+#  include <sys/time.h>
+#  include <mach/mach_time.h>
 #else
 #  include <time.h>
 #  include <sys/time.h>
@@ -122,6 +126,28 @@ void arUtilTimerReset(void)
 #endif
 }
 
+double arUtilTimeMonotonic(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency = {0};
+    LARGE_INTEGER count;
+
+    if (!frequency.QuadPart) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&count);
+    return ((double)count.QuadPart / (double)frequency.QuadPart);
+#elif defined(__APPLE__)
+    static mach_timebase_info_data_t timebase = {0, 0};
+
+    if (!timebase.denom) mach_timebase_info(&timebase);
+    return ((double)mach_absolute_time() * (double)timebase.numer / (double)timebase.denom * 1.0e-9);
+#else
+    struct timespec    ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9);
+#endif
+}
+
 #ifndef _WINRT
 void arUtilSleep( int msec )
 {
@@ -41,6 +41,7 @@
 
 #include <string.h> // memset()
 #include <pthread.h>
+#include <atomic>
 #include <ARX/ARUtil/time.h>
 #include <ARX/ARUtil/system.h>
 #include <ARX/ARVideo/videoRGBA.h>
@@ -59,6 +60,33 @@ typedef enum {
     ARVideoExternalIncomingPixelFormat_RGBA_4444
 } ARVideoExternalIncomingPixelFormat;
 
+#define AR_VIDEO_EXTERNAL_QUEUE_DEPTH_DEFAULT 3
+#define AR_VIDEO_EXTERNAL_QUEUE_DEPTH_MAX 16
+
+// Frame slots are passed between the pushing thread (producer) and arVideoGetImage (consumer) by
+// atomic transitions of their state, so that neither side ever holds a lock while the other works.
+// Producer: EMPTY->FILLING->READY, and, when dropping the oldest frame, READY->FILLING.
+// Consumer: READY->CHECKED_OUT, and CHECKED_OUT->EMPTY when the next frame is checked out. Under
+// -queuefull=dropoldest, also READY->FILLING->EMPTY to discard frames older than the one checked out.
+// pushFinal frees the buffers of every slot it can claim, but only marks a CHECKED_OUT slot
+// (CHECKED_OUT->TEARDOWN), as the consumer may still be reading it. The consumer frees a TEARDOWN slot's
+// buffers when it releases it (TEARDOWN->EMPTY), under frameLock.
+typedef enum {
+    ARVideoExternalSlotState_EMPTY = 0,
+    ARVideoExternalSlotState_FILLING,
+    ARVideoExternalSlotState_READY,
+    ARVideoExternalSlotState_CHECKED_OUT,
+    ARVideoExternalSlotState_TEARDOWN
+} ARVideoExternalSlotState;
+
+typedef struct {
+    std::atomic<int>   state; // ARVideoExternalSlotState.
+    std::atomic<uint64_t> seq; // Push order. Written by the producer before the slot is made READY.
+    AR2VideoBufferT    buffer; // Includes time of capture of the frame.
+    void             (*releaseCallback)(void *); // Only used when copy is false.
+    void              *releaseCallbackUserdata;
+} ARVideoExternalSlot;
+
 struct _AR2VideoParamExternalT {
     // Frame-related.
     int                width; // Width of incoming frames, set in pushInit.
@@ -78,24 +106,25 @@ struct _AR2VideoParamExternalT {
     void              *openAsyncUserdata;
     bool               openingAsync; // true when openAsync is active. If set to false, indicates video closed and it will cleanup.
     //
-    pthread_mutex_t    frameLock;  // Protects: capturing, pushInited, pushNewFrameReady.
+    pthread_mutex_t    frameLock;  // Protects: pushInited (writes), allocation and freeing of slot buffers, and serialises blocking pushes with slots being freed.
     pthread_cond_t     pushInitedCond; // Condition variable used to block openAsync from returning until least one frame received (or close is called).
-    bool               pushInited; // videoPushInit called.
-    bool               capturing; // Between capStart and capStop.
-    bool               pushNewFrameReady; // New frame ready since last arVideoGetImage.
-    AR2VideoBufferT    buffers[2];
+    pthread_cond_t     slotFreeCond; // Signalled when a slot becomes EMPTY. Only waited on when queueBlock is true.
+    std::atomic<bool>  pushInited; // videoPushInit called.
+    std::atomic<bool>  capturing; // Between capStart and capStop.
+    ARVideoExternalSlot slots[AR_VIDEO_EXTERNAL_QUEUE_DEPTH_MAX];
+    int                slotCount; // Queue depth.
+    bool               queueBlock; // When all slots are full, true=push waits for a free slot, false=drop the oldest queued frame.
+    uint64_t           pushSeq; // Producer only.
+    int                slotCheckedOut; // Consumer only. Index of slot returned by the last arVideoGetImage, or -1.
     bool               copy;
     // Only valid when copy is true.
     bool               copyYWarning;
     bool               copyUVWarning;
-    // Only valid when copy is false.
-    int                bufferCheckoutState; // Only valid when copy is false; <0=no buffers checked out. 0=buffers[0] checked out, 1=buffers[1] checked out.
-    void             (*releaseCallbacks[2])(void *);
-    void              *releaseCallbacksUserdata[2];
     // Others.
 };
 
 static void cleanupVid(AR2VideoParamExternalT *vid);
+static void slotFreeBuffers(AR2VideoParamExternalT *vid, ARVideoExternalSlot *slot);
 static void *openAsyncThread(void *arg);
 
 int ar2VideoDispOptionExternal( void )
@@ -108,6 +137,13 @@ int ar2VideoDispOptionExternal( void )
     ARPRINT(" -nocopy\n");
     ARPRINT("    Don't copy frames, but instead hold a reference to the frame data. The caller\n");
     ARPRINT("    must keep the frame data valid until the release callback is called, or capture is stopped.\n");
+    ARPRINT(" -queue=N\n");
+    ARPRINT("    Number of frame slots between the pushing thread and the tracker (2 <-> %d, default %d).\n", AR_VIDEO_EXTERNAL_QUEUE_DEPTH_MAX, AR_VIDEO_EXTERNAL_QUEUE_DEPTH_DEFAULT);
+    ARPRINT(" -queuefull=[dropoldest|block]\n");
+    ARPRINT("    When all slots hold frames not yet retrieved, either discard the oldest (default, push never waits)\n");
+    ARPRINT("    or wait in the push call until the tracker retrieves a frame. When discarding, the tracker\n");
+    ARPRINT("    always gets the newest frame. When waiting, frames are delivered in order, so a slow tracker\n");
+    ARPRINT("    may run up to N-1 frames behind the camera.\n");
     ARPRINT(" -cachedir=/path/to/cparam_cache.db\n");
     ARPRINT("    Specifies the path in which to look for/store camera parameter cache files.\n");
     ARPRINT("    Default is app's cache directory, or on Android a folder 'cparam_cache' in the current working directory.\n");
@@ -135,6 +171,8 @@ AR2VideoParamExternalT *ar2VideoOpenAsyncExternal(const char *config, void (*cal
     int width = 0, height = 0;
     int convertToRGBA = 0;
     bool copy = true;
+    int queueDepth = AR_VIDEO_EXTERNAL_QUEUE_DEPTH_DEFAULT;
+    bool queueBlock = false;
 
     arMallocClear(vid, AR2VideoParamExternalT, 1);
 
@@ -150,6 +188,20 @@ AR2VideoParamExternalT *ar2VideoOpenAsyncExternal(const char *config, void (*cal
                 copy = true;
             } else if (strcmp(line, "-nocopy") == 0) {
                 copy = false;
+            } else if (strncmp(line, "-queue=", 7) == 0) {
+                if (sscanf(&line[7], "%d", &queueDepth) != 1 || queueDepth < 2 || queueDepth > AR_VIDEO_EXTERNAL_QUEUE_DEPTH_MAX) {
+                    ARLOGe("Error: Configuration option '-queue=' must be followed by an integer in the range [2, %d].\n", AR_VIDEO_EXTERNAL_QUEUE_DEPTH_MAX);
+                    err_i = 1;
+                }
+            } else if (strncmp(line, "-queuefull=", 11) == 0) {
+                if (strcmp(line+11, "dropoldest") == 0) {
+                    queueBlock = false;
+                } else if (strcmp(line+11, "block") == 0) {
+                    queueBlock = true;
+                } else {
+                    ARLOGe("Error: Configuration option '-queuefull=' must be followed by 'dropoldest' or 'block'.\n");
+                    err_i = 1;
+                }
             } else if (strncmp(line, "-width=", 7) == 0) {
                 if (sscanf(&line[7], "%d", &width) == 0) {
                     ARLOGe("Error: Configuration option '-width=' must be followed by width in integer pixels.\n");
@@ -292,6 +344,11 @@ AR2VideoParamExternalT *ar2VideoOpenAsyncExternal(const char *config, void (*cal
     if (width != 0 || height != 0) {
         ARLOGw("Warning: Video frame size is determined by pushed video. Configuration options '-width=' and '-height=' will be ignored.\n");
     }
+    if (!queueBlock && queueDepth < 3) {
+        // With one slot checked out and one being filled, a third is needed to always have a frame to drop.
+        ARLOGw("Warning: '-queuefull=dropoldest' requires a queue of at least 3; using 3.\n");
+        queueDepth = 3;
+    }
 
 #if USE_CPARAM_SEARCH
     // Initialisation required before cparamSearch can be used.
@@ -318,7 +375,11 @@ AR2VideoParamExternalT *ar2VideoOpenAsyncExternal(const char *config, void (*cal
     vid->pushInited = false;
     vid->openingAsync = false;
     vid->capturing = false;
-    vid->pushNewFrameReady = false;
+    vid->slotCount = queueDepth;
+    vid->queueBlock = queueBlock;
+    vid->pushSeq = 0;
+    vid->slotCheckedOut = -1;
+    for (i = 0; i < vid->slotCount; i++) vid->slots[i].state = ARVideoExternalSlotState_EMPTY;
     vid->cameraIndex = -1;
     vid->cameraPosition = AR_VIDEO_POSITION_UNKNOWN;
     vid->openAsyncCallback = callback;
@@ -337,6 +398,7 @@ AR2VideoParamExternalT *ar2VideoOpenAsyncExternal(const char *config, void (*cal
 
     pthread_mutex_init(&(vid->frameLock), NULL);
     pthread_cond_init(&(vid->pushInitedCond), NULL);
+    pthread_cond_init(&(vid->slotFreeCond), NULL);
 
     pthread_attr_t attr;
     pthread_attr_init(&attr);
@@ -358,6 +420,7 @@ bail1:
         ARLOGe("Unable to finalise cparamSearch.\n");
     }
 #endif
+    pthread_cond_destroy(&vid->slotFreeCond);
     pthread_cond_destroy(&vid->pushInitedCond);
     pthread_mutex_destroy(&vid->frameLock);
 bail:
@@ -411,11 +474,14 @@ static void *openAsyncThread(void *arg)
 
 static void cleanupVid(AR2VideoParamExternalT *vid)
 {
+    // Buffers of a slot which was checked out when pushFinal was called, if capture was not stopped since.
+    for (int i = 0; i < vid->slotCount; i++) slotFreeBuffers(vid, &vid->slots[i]);
 #if USE_CPARAM_SEARCH
     if (cparamSearchFinal() < 0) {
         ARLOGe("Unable to finalise cparamSearch.\n");
     }
 #endif
+    pthread_cond_destroy(&vid->slotFreeCond);
     pthread_cond_destroy(&vid->pushInitedCond);
     pthread_mutex_destroy(&vid->frameLock);
     free(vid->device_id);
@@ -446,78 +512,181 @@ int ar2VideoCloseExternal( AR2VideoParamExternalT *vid )
     return 0;
 }
 
-int ar2VideoCapStartExternal( AR2VideoParamExternalT *vid )
+// Allocate the buffers of a slot for the current frame size and format. Caller must hold frameLock.
+static void slotAllocBuffers(AR2VideoParamExternalT *vid, ARVideoExternalSlot *slot)
 {
-    int ret = -1;
+    AR2VideoBufferT *buffer = &slot->buffer;
+    int width = vid->width, height = vid->height;
+
+    memset(buffer, 0, sizeof(AR2VideoBufferT));
+    slot->releaseCallback = NULL;
+    slot->releaseCallbackUserdata = NULL;
+    if (vid->pixelFormat == AR_PIXEL_FORMAT_NV21 || vid->pixelFormat == AR_PIXEL_FORMAT_420f) {
+        buffer->bufPlaneCount = 2;
+        buffer->bufPlanes = (ARUint8 **)calloc(buffer->bufPlaneCount, sizeof(ARUint8 *));
+        if (vid->copy) {
+            buffer->bufPlanes[0] = (ARUint8 *)malloc(width * height);
+            buffer->bufPlanes[1] = (ARUint8 *)malloc(2 * (width / 2 * height / 2));
+            buffer->buffLuma = buffer->bufPlanes[0];
+        }
+        if (vid->convertToRGBA) {
+            buffer->buff = (ARUint8 *)malloc(width * height * 4);
+        } else {
+            buffer->buff = buffer->bufPlanes[0];
+        }
+    } else if (vid->copy) {
+        if (vid->pixelFormat == AR_PIXEL_FORMAT_RGBA) {
+            buffer->buff = (ARUint8 *)malloc(width * height * 4);
+        } else if (vid->pixelFormat == AR_PIXEL_FORMAT_RGB_565 || vid->pixelFormat == AR_PIXEL_FORMAT_RGBA_5551 || vid->pixelFormat == AR_PIXEL_FORMAT_RGBA_4444) {
+            buffer->buff = (ARUint8 *)malloc(width * height * 2);
+        } else if (vid->pixelFormat == AR_PIXEL_FORMAT_MONO) {
+            buffer->buff = (ARUint8 *)malloc(width * height);
+        }
+    }
+}
 
-    if (!vid) return -1; // Sanity check.
+// Free the buffers of a slot. Safe to call on a slot with no buffers. Caller must own the slot.
+static void slotFreeBuffers(AR2VideoParamExternalT *vid, ARVideoExternalSlot *slot)
+{
+    AR2VideoBufferT *buffer = &slot->buffer;
 
-    pthread_mutex_lock(&(vid->frameLock));
-    if (vid->capturing) goto done; // Already capturing.
-    vid->capturing = true;
-    vid->pushNewFrameReady = false;
+    if (buffer->bufPlaneCount > 0) {
+        if (vid->copy) {
+            for (int j = 0; j < buffer->bufPlaneCount; j++) free(buffer->bufPlanes[j]);
+        }
+        free(buffer->bufPlanes);
+        if (vid->convertToRGBA) free(buffer->buff);
+    } else if (vid->copy) {
+        free(buffer->buff);
+    }
+    memset(buffer, 0, sizeof(AR2VideoBufferT));
+}
 
-    ret = 0;
-done:
-    pthread_mutex_unlock(&(vid->frameLock));
-    return (ret);
+static void slotReleaseCallback(ARVideoExternalSlot *slot)
+{
+    if (slot->releaseCallback) {
+        (*slot->releaseCallback)(slot->releaseCallbackUserdata);
+        slot->releaseCallback = NULL;
+        slot->releaseCallbackUserdata = NULL;
+    }
 }
 
-static void releaseAndUpdate(AR2VideoParamExternalT *vid, int bufferIndex, void (*updatedReleaseCallback)(void *), void *updatedReleaseCallbackUserdata)
+// Release the frame held in a slot in state FILLING (if not copying) and mark the slot EMPTY.
+static void slotRelease(AR2VideoParamExternalT *vid, ARVideoExternalSlot *slot)
 {
-    if (vid->releaseCallbacks[bufferIndex]) {
-        (*vid->releaseCallbacks[bufferIndex])(vid->releaseCallbacksUserdata[bufferIndex]);
+    slotReleaseCallback(slot);
+    slot->state.store(ARVideoExternalSlotState_EMPTY, std::memory_order_release);
+    if (vid->queueBlock) {
+        pthread_mutex_lock(&(vid->frameLock));
+        pthread_cond_signal(&(vid->slotFreeCond));
+        pthread_mutex_unlock(&(vid->frameLock));
     }
-    vid->releaseCallbacks[bufferIndex] = updatedReleaseCallback;
-    vid->releaseCallbacksUserdata[bufferIndex] = updatedReleaseCallbackUserdata;
 }
 
-int ar2VideoCapStopExternal( AR2VideoParamExternalT *vid )
+// Release all slots in state 'from'.
+static void slotsReleaseAll(AR2VideoParamExternalT *vid, int from)
 {
-    int ret = -1;
+    for (int i = 0; i < vid->slotCount; i++) {
+        int expected = from;
+        if (vid->slots[i].state.compare_exchange_strong(expected, ARVideoExternalSlotState_FILLING, std::memory_order_acquire)) {
+            slotRelease(vid, &vid->slots[i]);
+        }
+    }
+}
 
+// Consumer side. Release the slot returned by the last arVideoGetImage, if any. If pushFinal was called
+// while it was checked out, free its buffers too, and if pushInit has since been called again, give it
+// buffers for the new frames.
+static void slotReleaseCheckedOut(AR2VideoParamExternalT *vid)
+{
+    if (vid->slotCheckedOut < 0) return;
+    ARVideoExternalSlot *slot = &vid->slots[vid->slotCheckedOut];
+    vid->slotCheckedOut = -1;
+
+    int expected = ARVideoExternalSlotState_CHECKED_OUT;
+    if (slot->state.compare_exchange_strong(expected, ARVideoExternalSlotState_FILLING, std::memory_order_acquire)) {
+        slotRelease(vid, slot);
+        return;
+    }
+    // TEARDOWN.
+    pthread_mutex_lock(&(vid->frameLock));
+    slotReleaseCallback(slot);
+    slotFreeBuffers(vid, slot);
+    if (vid->pushInited) slotAllocBuffers(vid, slot);
+    slot->state.store(ARVideoExternalSlotState_EMPTY, std::memory_order_release);
+    if (vid->queueBlock) pthread_cond_signal(&(vid->slotFreeCond));
+    pthread_mutex_unlock(&(vid->frameLock));
+}
+
+int ar2VideoCapStartExternal( AR2VideoParamExternalT *vid )
+{
     if (!vid) return -1; // Sanity check.
 
-    pthread_mutex_lock(&(vid->frameLock));
-    if (!vid->capturing) goto done; // Not capturing.
+    if (vid->capturing) return -1; // Already capturing.
+    // Discard any frame which completed after a previous capStop.
+    slotsReleaseAll(vid, ARVideoExternalSlotState_READY);
+    vid->capturing = true;
+
+    return (0);
+}
+
+int ar2VideoCapStopExternal( AR2VideoParamExternalT *vid )
+{
+    if (!vid) return -1; // Sanity check.
+
+    if (!vid->capturing) return -1; // Not capturing.
     vid->capturing = false;
-    vid->pushNewFrameReady = false;
-    if (!vid->copy) {
-        releaseAndUpdate(vid, 0, NULL, NULL);
-        releaseAndUpdate(vid, 1, NULL, NULL);
-        vid->bufferCheckoutState = -1;
+    slotsReleaseAll(vid, ARVideoExternalSlotState_READY);
+    slotReleaseCheckedOut(vid);
+    if (vid->queueBlock) {
+        // Wake any push waiting for a slot, so it can see that capture has stopped.
+        pthread_mutex_lock(&(vid->frameLock));
+        pthread_cond_broadcast(&(vid->slotFreeCond));
+        pthread_mutex_unlock(&(vid->frameLock));
     }
-    ret = 0;
-done:
-    pthread_mutex_unlock(&(vid->frameLock));
-    return (ret);
+
+    return (0);
 }
 
 AR2VideoBufferT *ar2VideoGetImageExternal( AR2VideoParamExternalT *vid )
 {
-    AR2VideoBufferT *ret = NULL;
-
     if (!vid || !vid->capturing) return NULL; // Sanity check.
-
-    pthread_mutex_lock(&(vid->frameLock));
-    if (vid->pushInited && vid->pushNewFrameReady) {
-        if (!vid->copy) {
-            // If we have a buffer checked out, we're OK to release it now.
-            if (vid->bufferCheckoutState >= 0) {
-                releaseAndUpdate(vid, vid->bufferCheckoutState, NULL, NULL);
+    if (!vid->pushInited) return NULL;
+
+    // When dropping frames, check out the newest READY slot, so that the tracker always works on the latest
+    // frame; otherwise, the oldest, so that frames are delivered in order. The producer may concurrently
+    // reclaim the chosen slot to drop it, in which case try again.
+    for (;;) {
+        int chosen = -1;
+        uint64_t chosenSeq = 0;
+        for (int i = 0; i < vid->slotCount; i++) {
+            if (vid->slots[i].state.load(std::memory_order_acquire) == ARVideoExternalSlotState_READY) {
+                if (chosen == -1 || (vid->queueBlock ? vid->slots[i].seq < chosenSeq : vid->slots[i].seq > chosenSeq)) {
+                    chosen = i;
+                    chosenSeq = vid->slots[i].seq;
+                }
             }
-            // Work out which buffer we'll be checking out. For the very first frame, it'll be
-            // buffer 0, otherwise it'll be the buffer that's NOT already checked out.
-            int newBufIndex = vid->bufferCheckoutState == 0 ? 1 : 0;
-            vid->bufferCheckoutState = newBufIndex;
-            ret = &vid->buffers[newBufIndex];
-        } else {
-            ret = &vid->buffers[0];
         }
-        vid->pushNewFrameReady = false;
+        if (chosen == -1) return NULL; // No new frame. The previously returned frame remains checked out.
+
+        int expected = ARVideoExternalSlotState_READY;
+        if (vid->slots[chosen].state.compare_exchange_strong(expected, ARVideoExternalSlotState_CHECKED_OUT, std::memory_order_acquire)) {
+            // The caller has finished with the previous frame, so it can be released now.
+            slotReleaseCheckedOut(vid);
+            vid->slotCheckedOut = chosen;
+            if (!vid->queueBlock) {
+                // Frames older than this one will never be wanted.
+                for (int i = 0; i < vid->slotCount; i++) {
+                    expected = ARVideoExternalSlotState_READY;
+                    if (vid->slots[i].state.compare_exchange_strong(expected, ARVideoExternalSlotState_FILLING, std::memory_order_acquire)) {
+                        if (vid->slots[i].seq < chosenSeq) slotRelease(vid, &vid->slots[i]);
+                        else vid->slots[i].state.store(ARVideoExternalSlotState_READY, std::memory_order_release); // Refilled meanwhile.
+                    }
+                }
+            }
+            return (&vid->slots[chosen].buffer);
+        }
     }
-    pthread_mutex_unlock(&(vid->frameLock));
-    return (ret);
 }
 
 int ar2VideoGetSizeExternal(AR2VideoParamExternalT *vid, int *x,int *y)
@@ -789,50 +958,16 @@ int ar2VideoPushInitExternal(AR2VideoParamExternalT *vid, int width, int height,
         goto done;
     }
 
-    // Prepare the vid->buffer structure.
-    if (!vid->copy) {
-        for (int i = 0; i < 2; i++) {
-            if (vid->pixelFormat == AR_PIXEL_FORMAT_NV21 || vid->pixelFormat == AR_PIXEL_FORMAT_420f) {
-                vid->buffers[i].bufPlaneCount = 2;
-                vid->buffers[i].bufPlanes = (ARUint8 **)calloc(vid->buffers[i].bufPlaneCount, sizeof(ARUint8 *));
-                if (vid->convertToRGBA) vid->buffers[i].buff = (ARUint8 *)malloc(width * height * 4);
-            } else {
-                vid->buffers[i].bufPlaneCount = 0;
-                vid->buffers[i].bufPlanes = NULL;
-            }
-            vid->buffers[i].buff = NULL;
-            vid->buffers[i].buffLuma = NULL;
-        }
-        vid->bufferCheckoutState = -1;
-    } else {
-        if (vid->pixelFormat == AR_PIXEL_FORMAT_NV21 || vid->pixelFormat == AR_PIXEL_FORMAT_420f) {
-            vid->buffers[0].bufPlaneCount = 2;
-            vid->buffers[0].bufPlanes = (ARUint8 **)calloc(vid->buffers[0].bufPlaneCount, sizeof(ARUint8 *));
-            vid->buffers[0].bufPlanes[0] = (ARUint8 *)malloc(width * height);
-            vid->buffers[0].bufPlanes[1] = (ARUint8 *)malloc(2 * (width / 2 * height / 2));
-            vid->buffers[0].buffLuma = vid->buffers[0].bufPlanes[0];
-            if (vid->convertToRGBA) {
-                vid->buffers[0].buff = (ARUint8 *)malloc(width * height * 4);
-            } else {
-                vid->buffers[0].buff = vid->buffers[0].bufPlanes[0];
-            }
-        } else {
-            vid->buffers[0].bufPlaneCount = 0;
-            vid->buffers[0].bufPlanes = NULL;
-            if (vid->pixelFormat == AR_PIXEL_FORMAT_RGBA) {
-                vid->buffers[0].buff = (ARUint8 *)malloc(width * height * 4);
-            } else if (vid->pixelFormat == AR_PIXEL_FORMAT_RGB_565 || vid->pixelFormat == AR_PIXEL_FORMAT_RGBA_5551 || vid->pixelFormat == AR_PIXEL_FORMAT_RGBA_4444) {
-                vid->buffers[0].buff = (ARUint8 *)malloc(width * height * 2);
-            } else if (vid->pixelFormat == AR_PIXEL_FORMAT_MONO) {
-                vid->buffers[0].buff = (ARUint8 *)malloc(width * height);
-            }
-            vid->buffers[0].buffLuma = NULL;
-        }
-    }
+    vid->pushSeq = 0;
     vid->width = width;
     vid->height = height;
     vid->cameraIndex = cameraIndex;
     vid->cameraPosition = cameraPosition;
+    // Prepare the buffers of each slot. A slot still checked out from before the last pushFinal (TEARDOWN)
+    // gets its buffers when the consumer releases it.
+    for (int i = 0; i < vid->slotCount; i++) {
+        if (vid->slots[i].state.load(std::memory_order_acquire) == ARVideoExternalSlotState_EMPTY) slotAllocBuffers(vid, &vid->slots[i]);
+    }
     vid->pushInited = true;
     ret = 0;
 
@@ -847,6 +982,51 @@ done:
 
 }
 
+// Producer side. Returns the index of a slot now in state FILLING, or -1 if capture stopped while waiting.
+static int slotClaimForPush(AR2VideoParamExternalT *vid)
+{
+    for (;;) {
+        for (int i = 0; i < vid->slotCount; i++) {
+            int expected = ARVideoExternalSlotState_EMPTY;
+            if (vid->slots[i].state.compare_exchange_strong(expected, ARVideoExternalSlotState_FILLING, std::memory_order_acquire)) return (i);
+        }
+
+        if (vid->queueBlock) {
+            pthread_mutex_lock(&(vid->frameLock));
+            bool empty = false;
+            for (int i = 0; i < vid->slotCount; i++) {
+                if (vid->slots[i].state.load(std::memory_order_acquire) == ARVideoExternalSlotState_EMPTY) empty = true;
+            }
+            if (!empty && vid->capturing) pthread_cond_wait(&(vid->slotFreeCond), &(vid->frameLock));
+            pthread_mutex_unlock(&(vid->frameLock));
+            if (!vid->capturing) return (-1);
+            continue;
+        }
+
+        // Queue is full; take over the slot holding the oldest frame not yet retrieved.
+        int oldest = -1;
+        uint64_t oldestSeq = 0;
+        for (int i = 0; i < vid->slotCount; i++) {
+            if (vid->slots[i].state.load(std::memory_order_acquire) == ARVideoExternalSlotState_READY) {
+                if (oldest == -1 || vid->slots[i].seq < oldestSeq) {
+                    oldest = i;
+                    oldestSeq = vid->slots[i].seq;
+                }
+            }
+        }
+        if (oldest == -1) continue; // Consumer checked it out in the meantime, and will soon free a slot.
+        int expected = ARVideoExternalSlotState_READY;
+        if (vid->slots[oldest].state.compare_exchange_strong(expected, ARVideoExternalSlotState_FILLING, std::memory_order_acquire)) {
+            if (vid->slots[oldest].releaseCallback) {
+                (*vid->slots[oldest].releaseCallback)(vid->slots[oldest].releaseCallbackUserdata);
+                vid->slots[oldest].releaseCallback = NULL;
+                vid->slots[oldest].releaseCallbackUserdata = NULL;
+            }
+            return (oldest);
+        }
+    }
+}
+
 int ar2VideoPushExternal(AR2VideoParamExternalT *vid,
                          ARUint8 *buf0p, int buf0Size, int buf0PixelStride, int buf0RowStride,
                          ARUint8 *buf1p, int buf1Size, int buf1PixelStride, int buf1RowStride,
@@ -859,15 +1039,14 @@ int ar2VideoPushExternal(AR2VideoParamExternalT *vid,
 
     //ARLOGd("ar2VideoPushExternal(buf0p=%p, buf0Size=%d, buf0PixelStride=%d, buf0RowStride=%d, buf1p=%p, buf1Size=%d, buf1PixelStride=%d, buf1RowStride=%d, buf2p=%p, buf2Size=%d, buf2PixelStride=%d, buf2RowStride=%d, buf3p=%p, buf3Size=%d, buf3PixelStride=%d, buf3RowStride=%d)\n", buf0p, buf0Size, buf0PixelStride, buf0RowStride, buf1p, buf1Size, buf1PixelStride, buf1RowStride, buf2p, buf2Size, buf2PixelStride, buf2RowStride, buf3p, buf3Size, buf3PixelStride, buf3RowStride);
 
-    pthread_mutex_lock(&(vid->frameLock));
-
-    int bufferIndex = 0;
-    AR2VideoBufferT *buffer = NULL;
+    int slotIndex;
+    ARVideoExternalSlot *slot;
+    AR2VideoBufferT *buffer;
+    bool retained = false; // If true, the frame is referenced by a slot and will be released from there.
 
     if (!vid->pushInited) goto done; // Failure to call ar2VideoPushInitExternal is an error.
     if (!vid->capturing) {
         // If ar2VideoCapStartExternal has not been called, it's not an error, but we shouldn't do anything. Throw the frame away.
-        if (releaseCallback) (*releaseCallback)(releaseCallbackUserdata);
         ret = 0;
         goto done;
     }
@@ -876,30 +1055,26 @@ int ar2VideoPushExternal(AR2VideoParamExternalT *vid,
         goto done;
     }
 
-    // If not copying, need to select destination buffer from our double-buffer set. First time around,
-    // vid->bufferCheckoutState will be -1, so defaults to 0 in this case. Otherwise, the buffer not currently checked out.
-    // If copying, use default buffer 0 (which will have been allocated in arVideoPushInit()).
-    if (!vid->copy) bufferIndex = vid->bufferCheckoutState == 0 ? 1 : 0;
-    buffer = &vid->buffers[bufferIndex];
+    slotIndex = slotClaimForPush(vid);
+    if (slotIndex < 0) {
+        ret = 0; // Capture stopped while waiting for a slot.
+        goto done;
+    }
+    slot = &vid->slots[slotIndex];
+    buffer = &slot->buffer;
 
     // Get time of capture as early as possible.
     arUtilTimeSinceEpoch(&buffer->time.sec, &buffer->time.usec);
 
-    if (!vid->copy) {
-        // If not copying, we need to release any callback saved for any previous frame pushed which hasn't yet
-        // been used by videoGetImage. Release previous incoming frame, and save release details for this frame.
-        releaseAndUpdate(vid, bufferIndex, releaseCallback, releaseCallbackUserdata);
-    }
-
     // Grab the incoming frame.
     if (vid->incomingPixelFormat == ARVideoExternalIncomingPixelFormat_NV21 || vid->incomingPixelFormat == ARVideoExternalIncomingPixelFormat_NV12) {
         if (!buf1p || buf1Size <= 0) {
             ARLOGe("ar2VideoPushExternal: Error: insufficient buffers for format NV21/NV12.\n");
-            goto done;
+            goto bail;
         }
         if ((vid->width * vid->height) != buf0Size || (2 * (vid->width/2 * vid->height/2)) != buf1Size) {
             ARLOGe("ar2VideoPushExternal: Error: unexpected buffer sizes (%d, %d) for format NV21/NV12.\n", buf0Size, buf1Size);
-            goto done;
+            goto bail;
         }
         if (!vid->copy) {
             buffer->bufPlanes[0] = buf0p;
@@ -910,7 +1085,7 @@ int ar2VideoPushExternal(AR2VideoParamExternalT *vid,
         }
         // Convert if the user requested RGBA.
         if (vid->convertToRGBA) {
-            videoRGBA((uint32_t *)&buffer->buff, buffer, vid->width, vid->height, vid->pixelFormat);
+            videoRGBA((uint32_t *)buffer->buff, buffer, vid->width, vid->height, vid->pixelFormat);
         } else {
             buffer->buff = buffer->bufPlanes[0];
         }
@@ -919,19 +1094,19 @@ int ar2VideoPushExternal(AR2VideoParamExternalT *vid,
     } else if (vid->incomingPixelFormat == ARVideoExternalIncomingPixelFormat_YUV_420_888) {
         if (!buf1p || buf1Size <= 0 || !buf2p || buf2Size <= 0) {
             ARLOGe("ar2VideoPushExternal: Error: insufficient buffers for format YUV_420_888.\n");
-            goto done;
+            goto bail;
         }
 
         if ((vid->width * vid->height) != buf0Size) {
             ARLOGe("ar2VideoPushExternal: Error: unexpected buffer size (%d) for format YUV_420_888.\n", buf0Size);
-            goto done;
+            goto bail;
         }
 
         if (!vid->copy) {
             // Make sure it's actually NV21.
             if (buf0RowStride != vid->width || buf1PixelStride != 2 || buf2PixelStride != 2 || buf1RowStride != vid->width || buf2RowStride != vid->width || ((buf1p - 1) != buf2p)) {
                 ARLOGe("ar2VideoPushExternal: Error: in nocopy mode, can't handle YUV_420_888 unless it's actually NV21.\n");
-                goto done;
+                goto bail;
             }
             buffer->bufPlanes[0] = buf0p;
             buffer->bufPlanes[1] = buf2p;
@@ -976,7 +1151,7 @@ int ar2VideoPushExternal(AR2VideoParamExternalT *vid,
 
         // Convert if the user requested RGBA.
         if (vid->convertToRGBA) {
-            videoRGBA((uint32_t *)&buffer->buff, buffer, vid->width, vid->height, vid->pixelFormat);
+            videoRGBA((uint32_t *)buffer->buff, buffer, vid->width, vid->height, vid->pixelFormat);
         } else {
             buffer->buff = buffer->bufPlanes[0];
         }
@@ -985,7 +1160,7 @@ int ar2VideoPushExternal(AR2VideoParamExternalT *vid,
     } else if (vid->incomingPixelFormat == ARVideoExternalIncomingPixelFormat_RGBA) {
         if ((vid->width * vid->height * 4) != buf0Size) {
             ARLOGe("ar2VideoPushExternal: Error: unexpected buffer size (%d) for format RGBA.\n", buf0Size);
-            goto done;
+            goto bail;
         }
         if (!vid->copy) {
             buffer->buff = buf0p;
@@ -996,7 +1171,7 @@ int ar2VideoPushExternal(AR2VideoParamExternalT *vid,
     } else if (vid->incomingPixelFormat == ARVideoExternalIncomingPixelFormat_MONO) {
         if ((vid->width * vid->height) != buf0Size) {
             ARLOGe("ar2VideoPushExternal: Error: unexpected buffer size (%d) for format MONO.\n", buf0Size);
-            goto done;
+            goto bail;
         }
         if (!vid->copy) {
             buffer->buff = buf0p;
@@ -1007,7 +1182,7 @@ int ar2VideoPushExternal(AR2VideoParamExternalT *vid,
     } else if (vid->incomingPixelFormat == ARVideoExternalIncomingPixelFormat_RGB_565 || vid->incomingPixelFormat == ARVideoExternalIncomingPixelFormat_RGBA_5551 || vid->incomingPixelFormat == ARVideoExternalIncomingPixelFormat_RGBA_4444) {
         if ((vid->width * vid->height * 2) != buf0Size) {
             ARLOGe("ar2VideoPushExternal: Error: unexpected buffer size (%d) for format RGB_565/RGBA_5551/RGBA_4444.\n", buf0Size);
-            goto done;
+            goto bail;
         }
         if (!vid->copy) {
             buffer->buff = buf0p;
@@ -1017,16 +1192,23 @@ int ar2VideoPushExternal(AR2VideoParamExternalT *vid,
         buffer->buffLuma = NULL;
     }
 
-    ret = 0;
     buffer->fillFlag = 1;
-    vid->pushNewFrameReady = true;
+    if (!vid->copy) {
+        slot->releaseCallback = releaseCallback;
+        slot->releaseCallbackUserdata = releaseCallbackUserdata;
+        retained = true;
+    }
+    slot->seq = ++vid->pushSeq;
+    slot->state.store(ARVideoExternalSlotState_READY, std::memory_order_release);
+    ret = 0;
+    goto done;
+
+bail:
+    slotRelease(vid, slot);
 
 done:
-    pthread_mutex_unlock(&(vid->frameLock));
-    
-    if (vid->copy && releaseCallback) {
-        // If we've copied the data and user wanted a callback to release, invoke it now.
-        // (This is probably not a commonly used path, but here for sake of completeness).
+    if (releaseCallback && !retained) {
+        // If we've copied the data (or not used the frame) and user wanted a callback to release, invoke it now.
         (*releaseCallback)(releaseCallbackUserdata);
     }
 
@@ -1038,58 +1220,39 @@ int ar2VideoPushFinalExternal(AR2VideoParamExternalT *vid)
 {
     ARLOGd("ar2VideoPushFinalExternal()\n");
 
-    int ret = -1;
-
     if (!vid) return -1; // Sanity check.
 
     pthread_mutex_lock(&(vid->frameLock));
+    if (!vid->pushInited) {
+        pthread_mutex_unlock(&(vid->frameLock));
+        return (-1);
+    }
+    vid->pushInited = false;
 
-    if (!vid->pushInited) goto done;
-
-    if (!vid->copy) {
-        for (int i = 0; i < 2; i++) {
-            if (vid->pixelFormat == AR_PIXEL_FORMAT_NV21 || vid->pixelFormat == AR_PIXEL_FORMAT_420f) {
-                free(vid->buffers[i].bufPlanes);
-                vid->buffers[i].bufPlanes = NULL;
-                vid->buffers[i].bufPlaneCount = 0;
-                if (vid->convertToRGBA) {
-                    free(vid->buffers[i].buff);
-                }
-            }
-            vid->buffers[i].buff = NULL;
-            vid->buffers[i].buffLuma = NULL;
-        }
-        releaseAndUpdate(vid, 0, NULL, NULL);
-        releaseAndUpdate(vid, 1, NULL, NULL);
-        vid->bufferCheckoutState = -1;
-    } else {
-        if (vid->buffers[0].bufPlaneCount > 0) {
-            for (int i = 0; i < vid->buffers[0].bufPlaneCount; i++) {
-                free(vid->buffers[0].bufPlanes[i]);
-                vid->buffers[0].bufPlanes[i] = NULL;
+    // Free the buffers of every slot except one the consumer has checked out, which it may still be reading.
+    // That one is marked for the consumer to free when it releases it.
+    for (int i = 0; i < vid->slotCount; i++) {
+        ARVideoExternalSlot *slot = &vid->slots[i];
+        for (;;) {
+            int expected = ARVideoExternalSlotState_EMPTY;
+            if (slot->state.compare_exchange_strong(expected, ARVideoExternalSlotState_FILLING, std::memory_order_acquire)
+                || (expected == ARVideoExternalSlotState_READY && slot->state.compare_exchange_strong(expected, ARVideoExternalSlotState_FILLING, std::memory_order_acquire))) {
+                slotReleaseCallback(slot);
+                slotFreeBuffers(vid, slot);
+                slot->state.store(ARVideoExternalSlotState_EMPTY, std::memory_order_release);
+                break;
             }
-            free(vid->buffers[0].bufPlanes);
-            vid->buffers[0].bufPlanes = NULL;
-            vid->buffers[0].bufPlaneCount = 0;
-            if (vid->convertToRGBA) {
-                free(vid->buffers[0].buff);
-            }
-        } else {
-            free(vid->buffers[0].buff);
+            if (expected == ARVideoExternalSlotState_TEARDOWN) break; // Still checked out from an earlier pushFinal.
+            if (expected == ARVideoExternalSlotState_CHECKED_OUT && slot->state.compare_exchange_strong(expected, ARVideoExternalSlotState_TEARDOWN, std::memory_order_acq_rel)) break;
+            // Changed state concurrently; try again.
         }
-        vid->buffers[0].buff = NULL;
-        vid->buffers[0].buffLuma = NULL;
     }
+    if (vid->queueBlock) pthread_cond_broadcast(&(vid->slotFreeCond));
     vid->width = vid->height = 0;
     vid->incomingPixelFormat = ARVideoExternalIncomingPixelFormat_UNKNOWN;
-    vid->pushInited = false;
-    vid->pushNewFrameReady = false;
-    ret = 0;
-
-done:
     pthread_mutex_unlock(&(vid->frameLock));
-    return (ret);
 
+    return (0);
 }
 
 #endif //  ARVIDEO_INPUT_EXTERNAL
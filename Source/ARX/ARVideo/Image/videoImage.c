@@ -43,10 +43,15 @@
 #ifdef ARVIDEO_INPUT_IMAGE
 
 #include <string.h> // memset()
+#include <pthread.h>
+#include <ARX/ARUtil/thread_sub.h> // threadGetCPU()
 #include "jpeglib.h"
 
 #define AR_VIDEO_IMAGE_XSIZE_DEFAULT   640
 #define AR_VIDEO_IMAGE_YSIZE_DEFAULT   480
+#define AR_VIDEO_IMAGE_PREFETCH_DEFAULT 4
+#define AR_VIDEO_IMAGE_PREFETCH_MAX 64
+#define AR_VIDEO_IMAGE_DECODE_THREADS_MAX 16
 #ifndef MIN
 #define MIN(x,y) (x < y ? x : y)
 #endif
@@ -58,6 +63,14 @@ struct _AR2VideoImageRef {
     char *pathname;
 };
 
+// A frame in the prefetch queue. Frame with sequence number seq is decoded into slots[seq % prefetch].
+typedef struct {
+    ARUint8           *buff;
+    AR2VideoImageRef  *imageRef;
+    int                state; // 0=free, 1=being decoded, 2=decoded.
+    int                ok;
+} AR2VideoImageSlot;
+
 struct _AR2VideoParamImageT {
     AR2VideoBufferT    buffer;
     int                width;
@@ -69,8 +82,23 @@ struct _AR2VideoParamImageT {
     AR2VideoImageRef  *nextImage;
     unsigned long      imageCount;
     int                loop;
+    // Prefetching.
+    int                prefetch; // Prefetch queue depth, or 0 to decode synchronously in ar2VideoGetImage.
+    int                decodeThreadCount;
+    int                decodeThreadsRunning;
+    int                decodeQuit;
+    pthread_t          decodeThreads[AR_VIDEO_IMAGE_DECODE_THREADS_MAX];
+    AR2VideoImageSlot  slots[AR_VIDEO_IMAGE_PREFETCH_MAX];
+    pthread_mutex_t    prefetchLock; // Protects all prefetch state, and nextImage while decode threads are running.
+    pthread_cond_t     prefetchCond; // Signalled when a frame is decoded, a slot is freed, or decode threads should quit.
+    unsigned long      seqHead; // Sequence number of the next frame to be assigned to a decode thread.
+    unsigned long      seqTail; // Sequence number of the next frame to be returned.
+    int                slotHeld; // Slot returned by the last ar2VideoGetImage, or -1.
 };
 
+static int prefetchStart(AR2VideoParamImageT *vid);
+static void prefetchStop(AR2VideoParamImageT *vid);
+
 #define OUTBUF_HEIGHT_MAX 16
 
 static int jpegGetSize(FILE *fp, int *w, int *h, int *nc, float *dpi)
@@ -244,6 +272,115 @@ static int jpegRead(FILE *fp, unsigned char *buf, int bufWidth, int bufHeight, A
     return (TRUE);
 }
 
+// Advance the image list cursor, wrapping if looping was requested.
+static void nextImageAdvance(AR2VideoParamImageT *vid)
+{
+    vid->nextImage = vid->nextImage->next; // Next item in linked list.
+    if (!vid->nextImage && vid->loop) vid->nextImage = vid->imageList; // If we've hit the end of the list and looping requested, go back to head of linked list.
+}
+
+// Returns TRUE if the image was opened and decoded.
+static int imageDecode(AR2VideoParamImageT *vid, const AR2VideoImageRef *imageRef, unsigned char *buf)
+{
+    FILE *infile;
+    int ok;
+
+    if ((infile = fopen(imageRef->pathname, "rb")) == NULL) {
+        ARLOGe("Error: unable to open JPEG file '%s' for reading.\n", imageRef->pathname);
+        ARLOGperror(NULL);
+        return (FALSE);
+    }
+    ok = jpegRead(infile, buf, vid->bufWidth, vid->bufHeight, vid->format);
+    fclose(infile);
+    return (ok);
+}
+
+static void *decodeThread(void *arg)
+{
+    AR2VideoParamImageT *vid = (AR2VideoParamImageT *)arg;
+    AR2VideoImageSlot   *slot;
+    int                  ok;
+
+    pthread_mutex_lock(&vid->prefetchLock);
+    while (!vid->decodeQuit) {
+        // Slots in use are those of frames [seqTail - 1 (if held), seqHead).
+        if (!vid->nextImage || vid->seqHead - vid->seqTail + (vid->slotHeld >= 0 ? 1 : 0) >= (unsigned long)vid->prefetch) {
+            pthread_cond_wait(&vid->prefetchCond, &vid->prefetchLock);
+            continue;
+        }
+        slot = &vid->slots[vid->seqHead % vid->prefetch];
+        vid->seqHead++;
+        slot->imageRef = vid->nextImage;
+        slot->state = 1;
+        nextImageAdvance(vid);
+        pthread_mutex_unlock(&vid->prefetchLock);
+
+        ok = imageDecode(vid, slot->imageRef, slot->buff);
+
+        pthread_mutex_lock(&vid->prefetchLock);
+        slot->ok = ok;
+        slot->state = 2;
+        pthread_cond_broadcast(&vid->prefetchCond);
+    }
+    pthread_mutex_unlock(&vid->prefetchLock);
+    return (NULL);
+}
+
+static int prefetchStart(AR2VideoParamImageT *vid)
+{
+    int i, size;
+
+    size = vid->bufHeight * vid->bufWidth * arVideoUtilGetPixelSize(vid->format);
+    for (i = 0; i < vid->prefetch; i++) {
+        vid->slots[i].buff = (ARUint8 *)malloc(size);
+        if (!vid->slots[i].buff) {
+            ARLOGe("Error: Out of memory!\n");
+            while (i--) free(vid->slots[i].buff);
+            return (-1);
+        }
+        vid->slots[i].state = 0;
+    }
+    vid->seqHead = vid->seqTail = 0;
+    vid->slotHeld = -1;
+    vid->decodeQuit = FALSE;
+    pthread_mutex_init(&vid->prefetchLock, NULL);
+    pthread_cond_init(&vid->prefetchCond, NULL);
+    for (i = 0; i < vid->decodeThreadCount; i++) {
+        if (pthread_create(&vid->decodeThreads[i], NULL, decodeThread, vid) != 0) {
+            ARLOGe("Error: Unable to create image decode thread.\n");
+            break;
+        }
+    }
+    vid->decodeThreadCount = i;
+    vid->decodeThreadsRunning = TRUE;
+    if (!i) {
+        prefetchStop(vid);
+        return (-1);
+    }
+    return (0);
+}
+
+// Stops decoding, discards prefetched frames, and rewinds the image list cursor to the next frame to be returned.
+static void prefetchStop(AR2VideoParamImageT *vid)
+{
+    int i;
+
+    if (!vid->decodeThreadsRunning) return;
+
+    pthread_mutex_lock(&vid->prefetchLock);
+    vid->decodeQuit = TRUE;
+    pthread_cond_broadcast(&vid->prefetchCond);
+    pthread_mutex_unlock(&vid->prefetchLock);
+    for (i = 0; i < vid->decodeThreadCount; i++) pthread_join(vid->decodeThreads[i], NULL);
+    pthread_cond_destroy(&vid->prefetchCond);
+    pthread_mutex_destroy(&vid->prefetchLock);
+
+    if (vid->seqTail < vid->seqHead) vid->nextImage = vid->slots[vid->seqTail % vid->prefetch].imageRef;
+    for (i = 0; i < vid->prefetch; i++) free(vid->slots[i].buff);
+    vid->buffer.buff = vid->buffer.buffLuma = NULL; // Pointed to a slot.
+    vid->decodeThreadsRunning = FALSE;
+}
+
 int ar2VideoDispOptionImage( void )
 {
     ARPRINT(" -module=Image\n");
@@ -268,6 +405,11 @@ int ar2VideoDispOptionImage( void )
     ARPRINT("    After reading last image, next read will return first image.\n");
     ARPRINT(" -noloop\n");
     ARPRINT("    After reading last image, no further images will be returned.\n");
+    ARPRINT(" -prefetch=N\n");
+    ARPRINT("    Decode up to N images ahead in background threads, in list order (default %d, max %d).\n", AR_VIDEO_IMAGE_PREFETCH_DEFAULT, AR_VIDEO_IMAGE_PREFETCH_MAX);
+    ARPRINT("    0=decode each image when requested.\n");
+    ARPRINT(" -decodethreads=N\n");
+    ARPRINT("    Number of background decode threads (default one fewer than the number of CPUs, max %d).\n", AR_VIDEO_IMAGE_DECODE_THREADS_MAX);
     ARPRINT("\n");
 
     return 0;
@@ -298,6 +440,11 @@ AR2VideoParamImageT *ar2VideoOpenImage( const char *config )
     vid->imageList = NULL;
     vid->imageCount = 0ul;
     vid->loop = FALSE;
+    vid->prefetch = AR_VIDEO_IMAGE_PREFETCH_DEFAULT;
+    vid->decodeThreadCount = threadGetCPU() - 1;
+    if (vid->decodeThreadCount < 1) vid->decodeThreadCount = 1;
+    else if (vid->decodeThreadCount > 4) vid->decodeThreadCount = 4;
+    vid->decodeThreadsRunning = FALSE;
 
     a = config;
     if( a != NULL) {
@@ -358,6 +505,14 @@ AR2VideoParamImageT *ar2VideoOpenImage( const char *config )
                 vid->loop = TRUE;
             } else if (strncmp(a, "-noloop", 7) == 0) {
                 vid->loop = FALSE;
+            } else if (strncmp(line, "-prefetch=", 10) == 0) {
+                if (sscanf(&line[10], "%d", &vid->prefetch) != 1 || vid->prefetch < 0 || vid->prefetch > AR_VIDEO_IMAGE_PREFETCH_MAX) {
+                    err_i = 1;
+                }
+            } else if (strncmp(line, "-decodethreads=", 15) == 0) {
+                if (sscanf(&line[15], "%d", &vid->decodeThreadCount) != 1 || vid->decodeThreadCount < 1 || vid->decodeThreadCount > AR_VIDEO_IMAGE_DECODE_THREADS_MAX) {
+                    err_i = 1;
+                }
             } else if( strcmp( line, "-module=Image" ) == 0 )    {
             } else {
                 err_i = 1;
@@ -418,6 +573,13 @@ AR2VideoParamImageT *ar2VideoOpenImage( const char *config )
     // Point to head of image list.
     vid->nextImage = vid->imageList;
 
+    if (vid->prefetch > 0 && vid->imageList) {
+        if (prefetchStart(vid) != 0) {
+            ar2VideoSetBufferSizeImage(vid, 0, 0);
+            goto bail;
+        }
+    }
+
     ARPRINT("Image video size %dx%d@%dBpp.\n", vid->width, vid->height, arVideoUtilGetPixelSize(vid->format));
 
     return vid;
@@ -431,6 +593,7 @@ int ar2VideoCloseImage( AR2VideoParamImageT *vid )
     AR2VideoImageRef *imageRefToFree;
 
     if (!vid) return (-1); // Sanity check.
+    prefetchStop(vid);
     while (vid->imageList) {
         imageRefToFree = vid->imageList;
         vid->imageList = vid->imageList->next;
@@ -456,37 +619,57 @@ int ar2VideoCapStopImage( AR2VideoParamImageT *vid )
 
 AR2VideoBufferT *ar2VideoGetImageImage( AR2VideoParamImageT *vid )
 {
-    FILE *infile;
+    AR2VideoImageSlot *slot;
     int ok;
 
     if (!vid) return (NULL); // Sanity check.
 
-    if (vid->nextImage) {
-        if ((infile = fopen(vid->nextImage->pathname, "rb")) == NULL) {
-            ARLOGe("Error: unable to open JPEG file '%s' for reading.\n", vid->nextImage->pathname);
-            ARLOGperror(NULL);
-        } else {
-            ok = jpegRead(infile, vid->buffer.buff, vid->bufWidth, vid->bufHeight, vid->format);
-            fclose(infile);
-            if (!ok)
-                return (NULL);
-            vid->buffer.fillFlag  = 1;
-            if (vid->format == AR_PIXEL_FORMAT_MONO) {
-                vid->buffer.buffLuma = vid->buffer.buff;
-            } else {
-                vid->buffer.buffLuma = NULL;
+    if (vid->decodeThreadsRunning) {
+        pthread_mutex_lock(&vid->prefetchLock);
+        // The frame returned by the previous call is no longer in use by the caller.
+        if (vid->slotHeld >= 0) {
+            vid->slots[vid->slotHeld].state = 0;
+            vid->slotHeld = -1;
+            pthread_cond_broadcast(&vid->prefetchCond);
+        }
+        // Wait for the next frame in list order.
+        for (;;) {
+            if (vid->seqTail < vid->seqHead) {
+                slot = &vid->slots[vid->seqTail % vid->prefetch];
+                if (slot->state == 2) break;
+            } else if (!vid->nextImage) {
+                pthread_mutex_unlock(&vid->prefetchLock);
+                return (NULL); // End of list.
             }
-            vid->buffer.time.sec  = 0;
-            vid->buffer.time.usec = 0;
+            pthread_cond_wait(&vid->prefetchCond, &vid->prefetchLock);
         }
+        vid->seqTail++;
+        if (!slot->ok) {
+            slot->state = 0;
+            pthread_cond_broadcast(&vid->prefetchCond);
+            pthread_mutex_unlock(&vid->prefetchLock);
+            return (NULL);
+        }
+        vid->slotHeld = (int)(slot - vid->slots);
+        pthread_mutex_unlock(&vid->prefetchLock);
+        vid->buffer.buff = slot->buff;
+    } else {
+        if (!vid->nextImage) return (NULL);
+        ok = imageDecode(vid, vid->nextImage, vid->buffer.buff);
+        nextImageAdvance(vid);
+        if (!ok) return (NULL);
+    }
 
-        vid->nextImage = vid->nextImage->next; // Next item in linked list.
-        if (!vid->nextImage && vid->loop) vid->nextImage = vid->imageList; // If we've hit the end of the list and looping requested, go back to head of linked list.
-
-        return &(vid->buffer);
+    vid->buffer.fillFlag  = 1;
+    if (vid->format == AR_PIXEL_FORMAT_MONO) {
+        vid->buffer.buffLuma = vid->buffer.buff;
     } else {
-        return (NULL);
+        vid->buffer.buffLuma = NULL;
     }
+    vid->buffer.time.sec  = 0;
+    vid->buffer.time.usec = 0;
+
+    return &(vid->buffer);
 }
 
 int ar2VideoGetSizeImage(AR2VideoParamImageT *vid, int *x,int *y)
@@ -507,11 +690,17 @@ AR_PIXEL_FORMAT ar2VideoGetPixelFormatImage( AR2VideoParamImageT *vid )
 int ar2VideoSetBufferSizeImage(AR2VideoParamImageT *vid, const int width, const int height)
 {
     int rowBytes;
+    int prefetching;
 
     if (!vid) return (-1);
 
+    // Prefetched frames were decoded at the old size, so discard them.
+    prefetching = vid->decodeThreadsRunning;
+    prefetchStop(vid);
+
+    // When prefetching, frames are returned in the slot buffers, so no separate buffer is needed.
     if (vid->buffer.buff) {
-        free (vid->buffer.buff);
+        if (!vid->prefetch) free (vid->buffer.buff);
         vid->buffer.buff = vid->buffer.buffLuma = NULL;
     }
 
@@ -520,11 +709,13 @@ int ar2VideoSetBufferSizeImage(AR2VideoParamImageT *vid, const int width, const
             ARLOGe("Error: Requested buffer size smaller than video size.\n");
             return (-1);
         }
-        rowBytes = width * arVideoUtilGetPixelSize(vid->format);
-        vid->buffer.buff = (unsigned char *)malloc(height * rowBytes);
-        if (!vid->buffer.buff) {
-            ARLOGe("Error: Out of memory!\n");
-            return (-1);
+        if (!vid->prefetch) {
+            rowBytes = width * arVideoUtilGetPixelSize(vid->format);
+            vid->buffer.buff = (unsigned char *)malloc(height * rowBytes);
+            if (!vid->buffer.buff) {
+                ARLOGe("Error: Out of memory!\n");
+                return (-1);
+            }
         }
         vid->buffer.buffLuma = NULL;
     }
@@ -532,6 +723,20 @@ int ar2VideoSetBufferSizeImage(AR2VideoParamImageT *vid, const int width, const
     vid->bufWidth = width;
     vid->bufHeight = height;
 
+    if (prefetching && width && height) {
+        if (prefetchStart(vid) != 0) {
+            // Carry on without prefetching, decoding each frame on request into a buffer of our own.
+            ARLOGe("Error: Unable to restart image prefetching. Continuing without prefetch.\n");
+            vid->prefetch = 0;
+            rowBytes = width * arVideoUtilGetPixelSize(vid->format);
+            vid->buffer.buff = (unsigned char *)malloc(height * rowBytes);
+            if (!vid->buffer.buff) {
+                ARLOGe("Error: Out of memory!\n");
+                return (-1);
+            }
+        }
+    }
+
     return (0);
 }
 
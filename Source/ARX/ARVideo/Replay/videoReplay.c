@@ -0,0 +1,493 @@
+/*
+ *  videoReplay.c
+ *  artoolkitX
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ */
+
+/*
+ *   Replay of raw video recordings made with ar2VideoRecordStart.
+ *   The recording is memory-mapped and frames are served directly from the mapping.
+ */
+
+#include "videoReplay.h"
+
+#ifdef ARVIDEO_INPUT_REPLAY
+
+#include <string.h>
+#include <ARX/ARVideo/videoRecord.h>
+#include <ARX/ARUtil/time.h>
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+#define AR_VIDEO_REPLAY_DEFAULT_FRAME_INTERVAL_USEC 33333ull
+
+struct _AR2VideoParamReplayT {
+    AR2VideoBufferT    buffer;
+    ARUint8           *bufPlanes[2];
+    void              *map;
+    size_t             mapSize;
+    uint64_t          *frameOffsets;        ///< Offset of each frame record in the mapping.
+    uint64_t           frameCount;
+    uint64_t           frameNext;           ///< Index of the next frame to be returned.
+    int                width;
+    int                height;
+    int                bufWidth;
+    int                bufHeight;
+    AR_PIXEL_FORMAT    format;
+    uint32_t           planeCount;
+    int                loop;
+    int                realtime;
+    int                capturing;
+    uint64_t           frameTime0;          ///< Recorded timestamp of the first frame, in microseconds.
+    uint64_t           duration;            ///< Time from the first frame to the point at which a loop restarts, in microseconds.
+    uint64_t           loopOffset;          ///< Added to recorded timestamps so that they continue to increase when looping.
+    uint64_t           startTime;           ///< Time at which playback of the current loop began, in microseconds. Used only when realtime.
+};
+
+static uint64_t timeNow(void)
+{
+    uint64_t sec;
+    uint32_t usec;
+    arUtilTimeSinceEpoch(&sec, &usec);
+    return (sec * 1000000ull + usec);
+}
+
+static size_t alignUp(size_t size)
+{
+    return ((size + AR_VIDEO_RECORD_ALIGNMENT - 1) / AR_VIDEO_RECORD_ALIGNMENT) * AR_VIDEO_RECORD_ALIGNMENT;
+}
+
+static const ARVideoRecordFrameHeaderT *frameHeader(AR2VideoParamReplayT *vid, uint64_t frame)
+{
+    return ((const ARVideoRecordFrameHeaderT *)((const uint8_t *)vid->map + vid->frameOffsets[frame]));
+}
+
+static uint64_t frameTime(const ARVideoRecordFrameHeaderT *fh)
+{
+    return (fh->timeSec * 1000000ull + fh->timeUsec);
+}
+
+int ar2VideoDispOptionReplay( void )
+{
+    ARPRINT(" -module=Replay\n");
+    ARPRINT("\n");
+    ARPRINT(" -file=filepath\n");
+    ARPRINT("    specifies the path of a raw video recording (as made by ar2VideoRecordStart\n");
+    ARPRINT("    or the ARTOOLKITX_VIDEO_RECORD environment variable) to play back.\n");
+    ARPRINT(" -loop\n");
+    ARPRINT("    Return to the first frame once all frames have been played.\n");
+    ARPRINT("    Timestamps continue to increase across loops.\n");
+    ARPRINT(" -realtime\n");
+    ARPRINT("    Play frames at the rate they were recorded, dropping frames if they are not\n");
+    ARPRINT("    requested quickly enough. By default, each request returns the next frame.\n");
+    ARPRINT("\n");
+
+    return 0;
+}
+
+static int mapFile(AR2VideoParamReplayT *vid, const char *path)
+{
+#ifdef _WIN32
+    HANDLE        file, mapping;
+    LARGE_INTEGER fileSize;
+
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return -1;
+    if (!GetFileSizeEx(file, &fileSize) || (uint64_t)fileSize.QuadPart < sizeof(ARVideoRecordFileHeaderT)) {
+        CloseHandle(file);
+        return -1;
+    }
+    vid->mapSize = (size_t)fileSize.QuadPart;
+    // Copy-on-write, so that a caller modifying a frame in place can't alter the recording.
+    mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return -1;
+    vid->map = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping); // The view holds its own reference.
+    if (!vid->map) return -1;
+#else
+    int         fd;
+    struct stat st;
+    void       *map;
+
+    if ((fd = open(path, O_RDONLY)) == -1) return -1;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(ARVideoRecordFileHeaderT)) {
+        close(fd);
+        return -1;
+    }
+    vid->mapSize = (size_t)st.st_size;
+    // Copy-on-write, so that a caller modifying a frame in place can't alter the recording.
+    map = mmap(NULL, vid->mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping holds its own reference.
+    if (map == MAP_FAILED) return -1;
+    vid->map = map;
+#endif
+    return 0;
+}
+
+static void unmapFile(AR2VideoParamReplayT *vid)
+{
+    if (!vid->map) return;
+#ifdef _WIN32
+    UnmapViewOfFile(vid->map);
+#else
+    munmap(vid->map, vid->mapSize);
+#endif
+    vid->map = NULL;
+}
+
+// Walk the frame records and build an index of them. Stops at the first incomplete or
+// inconsistent record, so that a recording which was not closed cleanly remains usable.
+static int indexFrames(AR2VideoParamReplayT *vid, const char *path)
+{
+    const ARVideoRecordFileHeaderT *header = (const ARVideoRecordFileHeaderT *)vid->map;
+    uint64_t offset;
+    uint64_t frameOffsetsSize = 0;
+    uint64_t lastTime;
+
+    if (memcmp(header->magic, AR_VIDEO_RECORD_MAGIC, sizeof(AR_VIDEO_RECORD_MAGIC)) != 0) {
+        ARLOGe("Error: '%s' is not a raw video recording.\n", path);
+        return -1;
+    }
+    if (header->version != AR_VIDEO_RECORD_VERSION || header->byteOrder != AR_VIDEO_RECORD_BYTE_ORDER ||
+        header->headerSize < sizeof(ARVideoRecordFileHeaderT) || header->headerSize % AR_VIDEO_RECORD_ALIGNMENT != 0 ||
+        header->frameHeaderSize != sizeof(ARVideoRecordFrameHeaderT)) {
+        ARLOGe("Error: raw video recording '%s' is of an incompatible version or platform.\n", path);
+        return -1;
+    }
+
+    vid->frameCount = 0;
+    offset = header->headerSize;
+    while (offset + sizeof(ARVideoRecordFrameHeaderT) <= vid->mapSize) {
+        const ARVideoRecordFrameHeaderT *fh = (const ARVideoRecordFrameHeaderT *)((const uint8_t *)vid->map + offset);
+        uint64_t dataSize = 0;
+        uint32_t i, planes;
+
+        if (fh->magic != AR_VIDEO_RECORD_FRAME_MAGIC || fh->recordSize % AR_VIDEO_RECORD_ALIGNMENT != 0 || fh->recordSize > vid->mapSize - offset) break;
+        planes = (fh->planeCount ? fh->planeCount : 1);
+        if (planes > 2) break;
+        for (i = 0; i < planes; i++) dataSize += alignUp(fh->planeSize[i]);
+        if (sizeof(ARVideoRecordFrameHeaderT) + dataSize > fh->recordSize) break;
+
+        if (vid->frameCount == 0) {
+            vid->format = (AR_PIXEL_FORMAT)fh->format;
+            vid->width = fh->width;
+            vid->height = fh->height;
+            vid->bufWidth = fh->bufWidth;
+            vid->bufHeight = fh->bufHeight;
+            vid->planeCount = fh->planeCount;
+            if (arVideoUtilGetPixelSize(vid->format) == 0 || vid->width <= 0 || vid->height <= 0 || vid->bufWidth < vid->width || vid->bufHeight < vid->height) {
+                ARLOGe("Error: raw video recording '%s' has invalid frame format.\n", path);
+                return -1;
+            }
+        } else if (fh->format != vid->format || fh->width != vid->width || fh->height != vid->height ||
+                   fh->bufWidth != vid->bufWidth || fh->bufHeight != vid->bufHeight || fh->planeCount != vid->planeCount) {
+            ARLOGw("Warning: raw video recording '%s' changes frame format at frame %llu. Only frames before this point will be played.\n", path, (unsigned long long)vid->frameCount);
+            break;
+        }
+
+        if (vid->frameCount == frameOffsetsSize) {
+            uint64_t *frameOffsets;
+            frameOffsetsSize = (frameOffsetsSize ? frameOffsetsSize * 2 : 256);
+            if (!(frameOffsets = (uint64_t *)realloc(vid->frameOffsets, frameOffsetsSize * sizeof(uint64_t)))) {
+                ARLOGe("Out of memory!\n");
+                return -1;
+            }
+            vid->frameOffsets = frameOffsets;
+        }
+        vid->frameOffsets[vid->frameCount++] = offset;
+        offset += fh->recordSize;
+    }
+
+    if (vid->frameCount == 0) {
+        ARLOGe("Error: raw video recording '%s' contains no frames.\n", path);
+        return -1;
+    }
+    if (header->frameCount == 0) {
+        ARLOGw("Warning: raw video recording '%s' was not completed cleanly. %llu frames are available.\n", path, (unsigned long long)vid->frameCount);
+    }
+
+    // When looping, leave the average frame interval between the last frame and the first.
+    vid->frameTime0 = frameTime(frameHeader(vid, 0));
+    lastTime = frameTime(frameHeader(vid, vid->frameCount - 1));
+    if (vid->frameCount > 1 && lastTime > vid->frameTime0) {
+        vid->duration = (lastTime - vid->frameTime0) + (lastTime - vid->frameTime0) / (vid->frameCount - 1);
+    } else {
+        vid->duration = AR_VIDEO_REPLAY_DEFAULT_FRAME_INTERVAL_USEC * vid->frameCount;
+    }
+
+    return 0;
+}
+
+AR2VideoParamReplayT *ar2VideoOpenReplay( const char *config )
+{
+    AR2VideoParamReplayT *vid;
+    const char *a;
+#   define B_SIZE ((unsigned int)256)
+    char b[B_SIZE];
+    char *path = NULL;
+
+    arMallocClear(vid, AR2VideoParamReplayT, 1);
+
+    a = config;
+    if (a != NULL) {
+        for (;;) {
+            while (*a == ' ' || *a == '\t') a++;
+            if (*a == '\0') break;
+
+            if (sscanf(a, "%s", b) == 0) break;
+            if (strncmp(b, "-file=", 6) == 0) {
+                if (!b[6]) {
+                    ar2VideoDispOptionReplay();
+                    goto bail;
+                }
+                free(path);
+                arMalloc(path, char, strlen(b + 6) + 1);
+                strcpy(path, b + 6);
+            }
+            else if (strcmp(b, "-loop") == 0) {
+                vid->loop = 1;
+            }
+            else if (strcmp(b, "-noloop") == 0) {
+                vid->loop = 0;
+            }
+            else if (strcmp(b, "-realtime") == 0) {
+                vid->realtime = 1;
+            }
+            else if (strcmp(b, "-module=Replay") == 0) {
+            }
+            else {
+                ARLOGe("Error: unrecognised video configuration option \"%s\".\n", a);
+                ar2VideoDispOptionReplay();
+                goto bail;
+            }
+
+            while (*a != ' ' && *a != '\t' && *a != '\0') a++;
+        }
+    }
+
+    if (!path) {
+        ARLOGe("Error: no raw video recording specified. Use -file=filepath.\n");
+        ar2VideoDispOptionReplay();
+        goto bail;
+    }
+    if (mapFile(vid, path) < 0) {
+        ARLOGe("Error: unable to open raw video recording '%s'.\n", path);
+        goto bail;
+    }
+    if (indexFrames(vid, path) < 0) goto bail;
+
+    ARLOGi("Replaying %llu frames of %dx%d %s video from '%s'.\n", (unsigned long long)vid->frameCount, vid->width, vid->height, arVideoUtilGetPixelFormatName(vid->format), path);
+    free(path);
+    return vid;
+
+bail:
+    unmapFile(vid);
+    free(vid->frameOffsets);
+    free(path);
+    free(vid);
+    return (NULL);
+}
+
+int ar2VideoCloseReplay( AR2VideoParamReplayT *vid )
+{
+    if (!vid) return (-1); // Sanity check.
+
+    if (vid->capturing) ar2VideoCapStopReplay(vid);
+    unmapFile(vid);
+    free(vid->frameOffsets);
+    free(vid);
+
+    return 0;
+}
+
+int ar2VideoCapStartReplay( AR2VideoParamReplayT *vid )
+{
+    if (!vid) return (-1); // Sanity check.
+    if (vid->capturing) return (-1);
+
+    vid->frameNext = 0;
+    vid->loopOffset = 0;
+    vid->startTime = timeNow();
+    vid->capturing = 1;
+    return 0;
+}
+
+int ar2VideoCapStopReplay( AR2VideoParamReplayT *vid )
+{
+    if (!vid) return (-1); // Sanity check.
+    if (!vid->capturing) return (-1);
+
+    vid->capturing = 0;
+    return 0;
+}
+
+AR2VideoBufferT *ar2VideoGetImageReplay( AR2VideoParamReplayT *vid )
+{
+    const ARVideoRecordFrameHeaderT *fh;
+    uint64_t frame, t;
+    ARUint8 *data;
+
+    if (!vid || !vid->capturing) return (NULL);
+
+    if (vid->realtime) {
+        // Find the latest frame due at the current playback time.
+        uint64_t elapsed = timeNow() - vid->startTime;
+        if (elapsed >= vid->duration) {
+            if (!vid->loop) {
+                if (vid->frameNext >= vid->frameCount) return (NULL);
+                elapsed = vid->duration;
+            } else {
+                uint64_t loops = elapsed / vid->duration;
+                vid->startTime += loops * vid->duration;
+                vid->loopOffset += loops * vid->duration;
+                vid->frameNext = 0;
+                elapsed -= loops * vid->duration;
+            }
+        }
+        frame = vid->frameNext;
+        while (frame + 1 < vid->frameCount && frameTime(frameHeader(vid, frame + 1)) - vid->frameTime0 <= elapsed) frame++;
+        if (frame >= vid->frameCount || frameTime(frameHeader(vid, frame)) - vid->frameTime0 > elapsed) return (NULL); // Not yet due.
+    } else {
+        if (vid->frameNext >= vid->frameCount) {
+            if (!vid->loop) return (NULL);
+            vid->frameNext = 0;
+            vid->loopOffset += vid->duration;
+        }
+        frame = vid->frameNext;
+    }
+    vid->frameNext = frame + 1;
+
+    fh = frameHeader(vid, frame);
+    data = (ARUint8 *)fh + sizeof(ARVideoRecordFrameHeaderT);
+    if (vid->planeCount) {
+        vid->bufPlanes[0] = data;
+        vid->bufPlanes[1] = data + alignUp(fh->planeSize[0]);
+        vid->buffer.bufPlanes = vid->bufPlanes;
+        vid->buffer.bufPlaneCount = 2;
+    } else {
+        vid->buffer.bufPlanes = NULL;
+        vid->buffer.bufPlaneCount = 0;
+    }
+    vid->buffer.buff = data;
+    vid->buffer.buffLuma = (vid->format == AR_PIXEL_FORMAT_MONO || vid->format == AR_PIXEL_FORMAT_420v || vid->format == AR_PIXEL_FORMAT_420f || vid->format == AR_PIXEL_FORMAT_NV21 ? data : NULL);
+    vid->buffer.fillFlag = 1;
+    t = frameTime(fh) + vid->loopOffset;
+    vid->buffer.time.sec = t / 1000000ull;
+    vid->buffer.time.usec = (uint32_t)(t % 1000000ull);
+
+    return &(vid->buffer);
+}
+
+int ar2VideoGetSizeReplay(AR2VideoParamReplayT *vid, int *x,int *y)
+{
+    if (!vid) return (-1); // Sanity check.
+    if (x) *x = vid->width;
+    if (y) *y = vid->height;
+
+    return 0;
+}
+
+AR_PIXEL_FORMAT ar2VideoGetPixelFormatReplay( AR2VideoParamReplayT *vid )
+{
+    if (!vid) return (AR_PIXEL_FORMAT_INVALID);
+    return (vid->format);
+}
+
+int ar2VideoGetBufferSizeReplay(AR2VideoParamReplayT *vid, int *width, int *height)
+{
+    if (!vid) return (-1);
+    if (width) *width = vid->bufWidth;
+    if (height) *height = vid->bufHeight;
+    return (0);
+}
+
+int ar2VideoGetIdReplay( AR2VideoParamReplayT *vid, ARUint32 *id0, ARUint32 *id1 )
+{
+    return -1;
+}
+
+int ar2VideoGetParamiReplay( AR2VideoParamReplayT *vid, int paramName, int *value )
+{
+    if (!value) return -1;
+
+    if (paramName == AR_VIDEO_PARAM_GET_IMAGE_ASYNC) {
+        *value = 0;
+        return 0;
+    }
+
+    return -1;
+}
+
+int ar2VideoSetParamiReplay( AR2VideoParamReplayT *vid, int paramName, int  value )
+{
+    return -1;
+}
+
+int ar2VideoGetParamdReplay( AR2VideoParamReplayT *vid, int paramName, double *value )
+{
+    return -1;
+}
+
+int ar2VideoSetParamdReplay( AR2VideoParamReplayT *vid, int paramName, double  value )
+{
+    return -1;
+}
+
+int ar2VideoGetParamsReplay( AR2VideoParamReplayT *vid, const int paramName, char **value )
+{
+    if (!vid || !value) return (-1);
+
+    switch (paramName) {
+        default:
+            return (-1);
+    }
+    return (0);
+}
+
+int ar2VideoSetParamsReplay( AR2VideoParamReplayT *vid, const int paramName, const char  *value )
+{
+    if (!vid) return (-1);
+
+    switch (paramName) {
+        default:
+            return (-1);
+    }
+    return (0);
+}
+
+#endif //  ARVIDEO_INPUT_REPLAY
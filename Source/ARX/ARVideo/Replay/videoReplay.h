@@ -0,0 +1,68 @@
+/*
+ *  videoReplay.h
+ *  artoolkitX
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ */
+
+#ifndef AR_VIDEO_REPLAY_H
+#define AR_VIDEO_REPLAY_H
+
+#include <ARX/ARVideo/video.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+typedef struct _AR2VideoParamReplayT AR2VideoParamReplayT;
+
+int                    ar2VideoDispOptionReplay     ( void );
+AR2VideoParamReplayT  *ar2VideoOpenReplay           ( const char *config );
+int                    ar2VideoCloseReplay          ( AR2VideoParamReplayT *vid );
+int                    ar2VideoGetIdReplay          ( AR2VideoParamReplayT *vid, ARUint32 *id0, ARUint32 *id1 );
+int                    ar2VideoGetSizeReplay        ( AR2VideoParamReplayT *vid, int *x,int *y );
+AR_PIXEL_FORMAT        ar2VideoGetPixelFormatReplay ( AR2VideoParamReplayT *vid );
+AR2VideoBufferT       *ar2VideoGetImageReplay       ( AR2VideoParamReplayT *vid );
+int                    ar2VideoCapStartReplay       ( AR2VideoParamReplayT *vid );
+int                    ar2VideoCapStopReplay        ( AR2VideoParamReplayT *vid );
+
+int                    ar2VideoGetParamiReplay      ( AR2VideoParamReplayT *vid, int paramName, int *value );
+int                    ar2VideoSetParamiReplay      ( AR2VideoParamReplayT *vid, int paramName, int  value );
+int                    ar2VideoGetParamdReplay      ( AR2VideoParamReplayT *vid, int paramName, double *value );
+int                    ar2VideoSetParamdReplay      ( AR2VideoParamReplayT *vid, int paramName, double  value );
+int                    ar2VideoGetParamsReplay      ( AR2VideoParamReplayT *vid, const int paramName, char **value );
+int                    ar2VideoSetParamsReplay      ( AR2VideoParamReplayT *vid, const int paramName, const char  *value );
+
+int ar2VideoGetBufferSizeReplay(AR2VideoParamReplayT *vid, int *width, int *height);
+
+#ifdef  __cplusplus
+}
+#endif
+#endif // AR_VIDEO_REPLAY_H
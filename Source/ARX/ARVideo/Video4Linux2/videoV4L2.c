@@ -62,6 +62,7 @@
 #include <stdbool.h>
 #include <string.h> // memset()
 #include <errno.h>
+#include <poll.h>
 #include <linux/types.h>
 #include <linux/videodev2.h>
 #include <libudev.h>
@@ -107,6 +108,8 @@ struct _AR2VideoParamV4L2T {
     
     AR2VideoInternalBufferSetV4LT *internalBufferSet;
     int                    internalBufferCount;
+    int                    internalBufferCountRequested;
+    int                    internalBufferHeld; // Index of the dequeued buffer currently handed out to the caller, or -1.
     AR_PIXEL_FORMAT        format;
     AR2VideoBufferT        buffer;
     AR_PIXEL_FORMAT        formatConverted;
@@ -273,6 +276,8 @@ int ar2VideoDispOptionV4L2(void)
     ARPRINT("    0=Don't convert.\n");
     ARPRINT(" -frameduration=N/D.\n");
     ARPRINT("    request frames of duration N/D (numerator / denominator) seconds.\n");
+    ARPRINT(" -buffers=N\n");
+    ARPRINT("    number of capture buffers to request from the driver (2 <-> %d, default %d).\n", AR_VIDEO_V4L2_BUFFER_COUNT_MAX, AR_VIDEO_V4L2_DEFAULT_BUFFER_COUNT);
     ARPRINT("IMAGE CONTROLS (WARNING: not all options are not supported by every camera):\n");
     ARPRINT(" -brightness=N\n");
     ARPRINT("    specifies brightness. (0.0 <-> 1.0)\n");
@@ -417,6 +422,8 @@ AR2VideoParamV4L2T *ar2VideoOpenV4L2(const char *config)
     vid->debug      = 1;
     vid->formatConverted = AR_VIDEO_V4L2_DEFAULT_FORMAT_CONVERSION;
     vid->frameDurationNumer = vid->frameDurationDenom = 0;
+    vid->internalBufferCountRequested = AR_VIDEO_V4L2_DEFAULT_BUFFER_COUNT;
+    vid->internalBufferHeld = -1;
     
     a = config;
     if (a != NULL) {
@@ -488,6 +495,11 @@ AR2VideoParamV4L2T *ar2VideoOpenV4L2(const char *config)
                 if (sscanf(&line[15], "%d/%d", &vid->frameDurationNumer,  &vid->frameDurationDenom) != 2) {
                     err_i = 1;
                 }
+            } else if (strncmp(a, "-buffers=", 9) == 0) {
+                if (sscanf(&line[9], "%d", &vid->internalBufferCountRequested) != 1 ||
+                    vid->internalBufferCountRequested < 2 || vid->internalBufferCountRequested > AR_VIDEO_V4L2_BUFFER_COUNT_MAX) {
+                    err_i = 1;
+                }
             } else if (strncmp(a, "-contrast=", 10) == 0) {
                 if (sscanf(&line[10], "%d", &vid->contrast) == 0) {
                     err_i = 1;
@@ -889,7 +901,7 @@ AR2VideoParamV4L2T *ar2VideoOpenV4L2(const char *config)
 
     // Setup memory mapping
     memset(&req, 0, sizeof(req));
-    req.count = 2;
+    req.count = vid->internalBufferCountRequested;
     req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     req.memory = V4L2_MEMORY_MMAP;
     
@@ -903,6 +915,9 @@ AR2VideoParamV4L2T *ar2VideoOpenV4L2(const char *config)
         ARLOGe("(req.count < 2)\n");
         goto bail2;
     }
+    if (req.count != vid->internalBufferCountRequested) {
+        ARLOGi("Driver allocated %d capture buffers (%d requested).\n", req.count, vid->internalBufferCountRequested);
+    }
     
     vid->internalBufferSet = (AR2VideoInternalBufferSetV4LT *)calloc(req.count , sizeof(AR2VideoInternalBufferSetV4LT));
     if (!vid->internalBufferSet) {
@@ -1020,6 +1035,7 @@ int ar2VideoCapStartV4L2(AR2VideoParamV4L2T *vid)
     }
     
     vid->video_cont_num = 0;
+    vid->internalBufferHeld = -1;
     
     for (i = 0; i < vid->internalBufferCount; ++i) {
         memset(&buf, 0, sizeof(buf));
@@ -1058,11 +1074,26 @@ int ar2VideoCapStopV4L2(AR2VideoParamV4L2T *vid)
         return -1;
     }
     
+    // STREAMOFF returns all buffers, including any held by us, to the dequeued state.
     vid->video_cont_num = -1;
+    vid->internalBufferHeld = -1;
     
     return 0;
 }
 
+static void requeueBuffer(AR2VideoParamV4L2T *vid, int index)
+{
+    struct v4l2_buffer buf;
+    
+    memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = index;
+    if (xioctl(vid->fd, VIDIOC_QBUF, &buf)) {
+        ARLOGe("ar2VideoGetImage: Error calling VIDIOC_QBUF: %d\n", errno);
+    }
+}
+
 AR2VideoBufferT *ar2VideoGetImageV4L2(AR2VideoParamV4L2T *vid)
 {
     if (!vid) return NULL;
@@ -1081,6 +1112,19 @@ AR2VideoBufferT *ar2VideoGetImageV4L2(AR2VideoParamV4L2T *vid)
         ARLOGe("Error calling VIDIOC_DQBUF: %d\n", errno);
         return NULL;
     }
+    // If the caller has fallen behind and further frames are already waiting, skip to the newest,
+    // returning the older buffers to the driver.
+    for (;;) {
+        struct pollfd pfd = {vid->fd, POLLIN, 0};
+        struct v4l2_buffer buf_newer;
+        if (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & POLLIN)) break;
+        memset(&buf_newer, 0, sizeof(buf_newer));
+        buf_newer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf_newer.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(vid->fd, VIDIOC_DQBUF, &buf_newer) < 0) break;
+        requeueBuffer(vid, buf.index);
+        buf = buf_newer;
+    }
     vid->video_cont_num = buf.index;
 #ifdef AR2VIDEO_V4L2_DEBUG
     ARLOGd("v4l2_buffer.timestamp=(%ld, %d)\n", buf.timestamp.tv_sec, buf.timestamp.tv_usec);
@@ -1113,21 +1157,21 @@ AR2VideoBufferT *ar2VideoGetImageV4L2(AR2VideoParamV4L2T *vid)
             vid->bufferConverted.time.sec = vid->buffer.time.sec;
             vid->bufferConverted.time.usec = vid->buffer.time.usec;
             vid->bufferConverted.fillFlag = 1;
-            vid->bufferConverted.buffLuma = NULL;
+            // Luma can still be supplied directly from the held capture buffer, avoiding a conversion from the RGBA output.
+            vid->bufferConverted.buffLuma = vid->buffer.buffLuma;
             ret = &vid->bufferConverted;
         } else {
             ret = &vid->buffer;
         }
     }
     
-    // Queue a buffer.
-    struct v4l2_buffer buf_next;
-    memset(&buf_next, 0, sizeof(buf_next));
-    buf_next.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    buf_next.memory = V4L2_MEMORY_MMAP;
-    buf_next.index = vid->video_cont_num;
-    if (xioctl(vid->fd, VIDIOC_QBUF, &buf_next)) {
-        ARLOGe("ar2VideoCapNext: Error calling VIDIOC_QBUF: %d\n", errno);
+    // The buffer handed out by the previous call is held dequeued (so the driver can't overwrite it while the
+    // caller reads it) until a newer frame replaces it; at that point it is checked back in to the driver.
+    if (ret) {
+        if (vid->internalBufferHeld >= 0) requeueBuffer(vid, vid->internalBufferHeld);
+        vid->internalBufferHeld = buf.index;
+    } else {
+        requeueBuffer(vid, buf.index); // Invalid timestamp; the previous frame remains valid.
     }
 
     return (ret);
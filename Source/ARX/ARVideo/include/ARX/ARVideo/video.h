@@ -79,7 +79,8 @@ typedef enum {
     AR_VIDEO_MODULE_WINDOWS_MEDIA_CAPTURE = 17,
     AR_VIDEO_MODULE_V4L2               = 18,
     AR_VIDEO_MODULE_EMSCRIPTEN         = 19,
-    AR_VIDEO_MODULE_MAX                = 19,
+    AR_VIDEO_MODULE_REPLAY             = 20,
+    AR_VIDEO_MODULE_MAX                = 20,
 } AR_VIDEO_MODULE;
 
 //
@@ -322,6 +323,7 @@ typedef struct {
     int module;
     void *moduleParam;
     ARVideoLumaInfo *lumaInfo;
+    struct _ARVideoRecorder *recorder;
 } AR2VideoParamT;
 
 // AR2VideoBufferT is defined in <ARX/AR/ar.h>
@@ -458,6 +460,18 @@ ARVIDEO_EXTERN int               arVideoLoadParam       (char *filename);
 ARVIDEO_EXTERN int               arVideoSetBufferSize   (const int width, const int height);
 ARVIDEO_EXTERN int               arVideoGetBufferSize   (int *width, int *height);
 
+/*!
+    @brief Begin recording frames from the active video module to a raw video file.
+    @see ar2VideoRecordStart
+ */
+ARVIDEO_EXTERN int               arVideoRecordStart     (const char *path);
+
+/*!
+    @brief Stop recording frames from the active video module.
+    @see ar2VideoRecordStop
+ */
+ARVIDEO_EXTERN int               arVideoRecordStop      (void);
+
 ARVIDEO_EXTERN int               arVideoGetCParam       (ARParam *cparam);
 ARVIDEO_EXTERN int               arVideoGetCParamAsync  (void (*callback)(const ARParam *, void *), void *userdata);
 
@@ -603,6 +617,33 @@ ARVIDEO_EXTERN int               ar2VideoSaveParam       (AR2VideoParamT *vid, c
 ARVIDEO_EXTERN int               ar2VideoLoadParam       (AR2VideoParamT *vid, char *filename);
 ARVIDEO_EXTERN int               ar2VideoSetBufferSize   (AR2VideoParamT *vid, const int width, const int height);
 ARVIDEO_EXTERN int               ar2VideoGetBufferSize   (AR2VideoParamT *vid, int *width, int *height);
+
+/*!
+    @brief Begin recording frames to a raw video file.
+    @details Every frame subsequently returned by ar2VideoGetImage is appended, exactly as delivered
+        by the video module, to a file which can be played back with the "Replay" video module
+        (e.g. "-module=Replay -file=<path>"). Recording can also be enabled without changes to the
+        calling application by setting the environment variable ARTOOLKITX_VIDEO_RECORD to the path of
+        the file to record to before the video module is opened.
+        Writing frames costs the time to copy each frame into the file system's cache on the
+        thread calling ar2VideoGetImage, so recording is intended for diagnostic use.
+    @param vid Video control object.
+    @param path Path of the file to write. Any existing file at this path will be replaced.
+        The file is created when the first frame arrives.
+    @return -1 in case of error, 0 in case of no error.
+    @see ar2VideoRecordStop videoRecord.h
+ */
+ARVIDEO_EXTERN int               ar2VideoRecordStart     (AR2VideoParamT *vid, const char *path);
+
+/*!
+    @brief Stop recording frames and complete the raw video file.
+    @details Recording is also stopped automatically by ar2VideoClose.
+    @param vid Video control object.
+    @return -1 in case of error, or if not recording, 0 in case of no error.
+    @see ar2VideoRecordStart
+ */
+ARVIDEO_EXTERN int               ar2VideoRecordStop      (AR2VideoParamT *vid);
+
 ARVIDEO_EXTERN int               ar2VideoGetCParam       (AR2VideoParamT *vid, ARParam *cparam);
 ARVIDEO_EXTERN int               ar2VideoGetCParamAsync  (AR2VideoParamT *vid, void (*callback)(const ARParam *, void *), void *userdata);
 
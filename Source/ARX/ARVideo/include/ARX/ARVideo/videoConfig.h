@@ -55,6 +55,8 @@ extern "C" {
 #define   AR_VIDEO_V4L2_DEFAULT_CHANNEL       0
 #define   AR_VIDEO_V4L2_DEFAULT_MODE          AR_VIDEO_V4L2_MODE_NTSC
 #define   AR_VIDEO_V4L2_DEFAULT_FORMAT_CONVERSION AR_PIXEL_FORMAT_BGRA // Options include AR_PIXEL_FORMAT_INVALID for no conversion, AR_PIXEL_FORMAT_BGRA, and AR_PIXEL_FORMAT_RGBA.
+#define   AR_VIDEO_V4L2_DEFAULT_BUFFER_COUNT  4 // Number of driver buffers; one is held by the caller, the others are filled while it is in use.
+#define   AR_VIDEO_V4L2_BUFFER_COUNT_MAX      32
 #endif
 
 
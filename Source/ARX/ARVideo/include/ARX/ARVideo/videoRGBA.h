@@ -48,6 +48,12 @@ extern "C" {
 ARVIDEO_EXTERN int videoRGBA(uint32_t *destRGBA, AR2VideoBufferT *source, int width, int height, AR_PIXEL_FORMAT pixelFormat);
 ARVIDEO_EXTERN int videoBGRA(uint32_t *destBGRA, AR2VideoBufferT *source, int width, int height, AR_PIXEL_FORMAT pixelFormat);
 
+// Large frames are converted on a pool of worker threads. Each videoRGBAInit() should be matched by a call to
+// videoRGBAFinal(), and the pool is stopped when the last user calls videoRGBAFinal(). ar2VideoOpen and
+// ar2VideoClose do this for each video source.
+ARVIDEO_EXTERN void videoRGBAInit(void);
+ARVIDEO_EXTERN void videoRGBAFinal(void);
+
 #ifdef  __cplusplus
 }
 #endif
@@ -0,0 +1,134 @@
+/*
+ *  videoRecord.h
+ *  artoolkitX
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ */
+
+/*!
+    @file videoRecord.h
+    @brief Raw video frame recording.
+    @details
+        Frames are written exactly as delivered by the video module (pixel format, buffer
+        dimensions, planes and timestamp) to a simple uncompressed container, which the
+        "Replay" video module can then memory-map and serve back without copying or decoding.
+
+        The container consists of an ARVideoRecordFileHeaderT followed by a sequence of
+        frame records. Each frame record is an ARVideoRecordFrameHeaderT followed by the
+        pixel data of each plane. The file header, frame headers and the start of each plane
+        are aligned to AR_VIDEO_RECORD_ALIGNMENT bytes. All fields are stored in the byte
+        order of the recording machine, indicated by the byteOrder field.
+
+        A file which was not closed cleanly (e.g. because the recording process was killed)
+        remains readable up to the last complete frame record.
+ */
+
+#ifndef AR_VIDEO_RECORD_H
+#define AR_VIDEO_RECORD_H
+
+#include <ARX/ARVideo/video.h>
+#include <stdint.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#define AR_VIDEO_RECORD_MAGIC           "ARXVRAW"   ///< Including terminating nul, fills ARVideoRecordFileHeaderT.magic.
+#define AR_VIDEO_RECORD_VERSION         1
+#define AR_VIDEO_RECORD_BYTE_ORDER      0x01020304u
+#define AR_VIDEO_RECORD_FRAME_MAGIC     0x46525641u ///< "AVRF" on little-endian machines.
+#define AR_VIDEO_RECORD_ALIGNMENT       64
+#define AR_VIDEO_RECORD_PLANES_MAX      4
+
+typedef struct {
+    char     magic[8];          ///< AR_VIDEO_RECORD_MAGIC.
+    uint32_t version;           ///< AR_VIDEO_RECORD_VERSION.
+    uint32_t byteOrder;         ///< AR_VIDEO_RECORD_BYTE_ORDER, as written by the recording machine.
+    uint32_t headerSize;        ///< sizeof(ARVideoRecordFileHeaderT); the first frame record follows at this offset.
+    uint32_t frameHeaderSize;   ///< sizeof(ARVideoRecordFrameHeaderT).
+    uint64_t frameCount;        ///< Number of frames, filled in when the recording is closed. 0 if the recording was not closed cleanly.
+    uint8_t  reserved[32];
+} ARVideoRecordFileHeaderT;
+
+typedef struct {
+    uint32_t magic;             ///< AR_VIDEO_RECORD_FRAME_MAGIC.
+    int32_t  format;            ///< AR_PIXEL_FORMAT of the frame.
+    int32_t  width;             ///< Width of the video image, in pixels.
+    int32_t  height;            ///< Height of the video image, in pixels.
+    int32_t  bufWidth;          ///< Width of the stored buffer, in pixels. May be larger than width if the module pads its buffers.
+    int32_t  bufHeight;         ///< Height of the stored buffer, in pixels.
+    uint32_t planeCount;        ///< Number of planes stored. 0 indicates a single non-planar buffer (planeSize[0] bytes).
+    uint32_t timeUsec;          ///< Capture timestamp, microseconds part.
+    uint64_t timeSec;           ///< Capture timestamp, seconds part.
+    uint64_t recordSize;        ///< Total size of this record, including header, pixel data and padding, i.e. the offset to the next record.
+    uint32_t planeSize[AR_VIDEO_RECORD_PLANES_MAX]; ///< Size in bytes of each plane. Each plane begins on an AR_VIDEO_RECORD_ALIGNMENT boundary.
+} ARVideoRecordFrameHeaderT;
+
+typedef struct _ARVideoRecorder ARVideoRecorderT;
+
+/*!
+    @brief Create a recorder which will write frames to a file.
+    @details The file is not created until the first frame is written, so a recorder
+        which never receives a frame leaves no file behind.
+    @param path Path of the file to write. Any existing file at this path will be replaced.
+    @return A recorder, or NULL in case of error.
+ */
+ARVIDEO_EXTERN ARVideoRecorderT *arVideoRecorderOpen(const char *path);
+
+/*!
+    @brief Append a frame to a recording.
+    @param rec The recorder.
+    @param buffer The frame, as returned by ar2VideoGetImage. If buffer->bufPlaneCount is non-zero,
+        each plane is recorded, otherwise buffer->buff is recorded.
+    @param width Width of the video image, in pixels.
+    @param height Height of the video image, in pixels.
+    @param bufWidth Width of the video buffer, in pixels, or 0 if the buffer is not padded (i.e. same as width).
+    @param bufHeight Height of the video buffer, in pixels, or 0 if the buffer is not padded (i.e. same as height).
+    @param format Pixel format of the frame.
+    @return 0 if the frame was written, or -1 in case of error.
+ */
+ARVIDEO_EXTERN int arVideoRecorderWriteFrame(ARVideoRecorderT *rec, const AR2VideoBufferT *buffer, int width, int height, int bufWidth, int bufHeight, AR_PIXEL_FORMAT format);
+
+/*!
+    @brief Get the number of frames written so far.
+ */
+ARVIDEO_EXTERN uint64_t arVideoRecorderGetFrameCount(ARVideoRecorderT *rec);
+
+/*!
+    @brief Finish a recording, close the file and dispose of the recorder.
+    @param rec_p Pointer to the recorder. On return, *rec_p is set to NULL.
+    @return 0 if successful, or -1 if the file could not be completed.
+ */
+ARVIDEO_EXTERN int arVideoRecorderClose(ARVideoRecorderT **rec_p);
+
+#ifdef  __cplusplus
+}
+#endif
+#endif // !AR_VIDEO_RECORD_H
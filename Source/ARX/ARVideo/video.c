@@ -250,6 +250,20 @@ int arVideoGetBufferSize(int *width, int *height)
     return ar2VideoGetBufferSize( vid, width, height );
 }
 
+int arVideoRecordStart(const char *path)
+{
+    if (!vid) return -1;
+
+    return ar2VideoRecordStart( vid, path );
+}
+
+int arVideoRecordStop(void)
+{
+    if (!vid) return -1;
+
+    return ar2VideoRecordStop( vid );
+}
+
 int arVideoGetCParam(ARParam *cparam)
 {
     if (vid == NULL) return -1;
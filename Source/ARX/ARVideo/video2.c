@@ -47,6 +47,7 @@
 #include <ARX/ARVideo/video.h>
 #include <ARX/AR/config.h>
 #include <ARX/ARUtil/time.h>
+#include <ARX/ARUtil/stage_timing.h>
 #ifdef ARVIDEO_INPUT_DUMMY
 #include "Dummy/videoDummy.h"
 #endif
@@ -80,6 +81,11 @@
 #ifdef ARVIDEO_INPUT_EMSCRIPTEN
 #include "Emscripten/videoEmscripten.h"
 #endif
+#ifdef ARVIDEO_INPUT_REPLAY
+#include "Replay/videoReplay.h"
+#endif
+#include <ARX/ARVideo/videoRecord.h>
+#include <ARX/ARVideo/videoRGBA.h>
     
 
 static const char *ar2VideoGetConfig(const char *config_in)
@@ -151,6 +157,8 @@ static int ar2VideoGetModuleWithConfig(const char *config, const char **configSt
                 module = AR_VIDEO_MODULE_WINDOWS_MEDIA_CAPTURE;
             } else if (strcmp(b, "-module=Emscripten") == 0)    {
                 module = AR_VIDEO_MODULE_EMSCRIPTEN;
+            } else if (strcmp(b, "-module=Replay") == 0)    {
+                module = AR_VIDEO_MODULE_REPLAY;
             }
 
             while (*a != ' ' && *a != '\t' && *a != '\0') a++;
@@ -169,6 +177,16 @@ static int ar2VideoGetModuleWithConfig(const char *config, const char **configSt
     return (module);
 }
 
+static void ar2VideoRecordStartFromEnvironment(AR2VideoParamT *vid)
+{
+#ifndef _WINRT
+    char *path = getenv("ARTOOLKITX_VIDEO_RECORD");
+    if (path && path[0]) {
+        ar2VideoRecordStart(vid, path);
+    }
+#endif // !_WINRT
+}
+
 ARVideoSourceInfoListT *ar2VideoCreateSourceInfoList(const char *config_in)
 {
     int module = ar2VideoGetModuleWithConfig(ar2VideoGetConfig(config_in), NULL);
@@ -226,6 +244,11 @@ ARVideoSourceInfoListT *ar2VideoCreateSourceInfoList(const char *config_in)
     if (module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         return (NULL);
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (module == AR_VIDEO_MODULE_REPLAY) {
+        return (NULL);
+    }
 #endif
     return (NULL);
 }
@@ -259,6 +282,8 @@ AR2VideoParamT *ar2VideoOpen(const char *config_in)
     arMallocClear(vid, AR2VideoParamT, 1);
     config = ar2VideoGetConfig(config_in);
     vid->module = ar2VideoGetModuleWithConfig(config, &configStringFollowingDevice);
+    ar2VideoRecordStartFromEnvironment(vid);
+    videoRGBAInit();
 
     if (vid->module == AR_VIDEO_MODULE_DUMMY) {
 #ifdef ARVIDEO_INPUT_DUMMY
@@ -337,7 +362,16 @@ AR2VideoParamT *ar2VideoOpen(const char *config_in)
         ARLOGe("ar2VideoOpen: Error: module \"Emscripten\" not supported on this build/architecture/system.\n");
 #endif
     }
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+#ifdef ARVIDEO_INPUT_REPLAY
+        if ((vid->moduleParam = (void *)ar2VideoOpenReplay(config)) != NULL) return vid;
+#else
+        ARLOGe("ar2VideoOpen: Error: module \"Replay\" not supported on this build/architecture/system.\n");
+#endif
+    }
 
+    videoRGBAFinal();
+    if (vid->recorder) arVideoRecorderClose(&vid->recorder);
     free(vid);
     return NULL;
 }
@@ -355,6 +389,8 @@ AR2VideoParamT *ar2VideoOpenAsync(const char *config_in, void (*callback)(void *
     arMallocClear(vid, AR2VideoParamT, 1);
     config = ar2VideoGetConfig(config_in);
     vid->module = ar2VideoGetModuleWithConfig(config, &configStringFollowingDevice);
+    ar2VideoRecordStartFromEnvironment(vid);
+    videoRGBAInit();
 
     if (vid->module == AR_VIDEO_MODULE_EXTERNAL) {
 #ifdef ARVIDEO_INPUT_EXTERNAL
@@ -378,6 +414,8 @@ AR2VideoParamT *ar2VideoOpenAsync(const char *config_in, void (*callback)(void *
 #endif
     }
 
+    videoRGBAFinal();
+    if (vid->recorder) arVideoRecorderClose(&vid->recorder);
     free(vid);
     return NULL;
 }
@@ -392,6 +430,7 @@ int ar2VideoClose(AR2VideoParamT *vid)
             ARLOGe("ar2VideoClose: Error disposing of luma info.\n");
         }
     }
+    if (vid->recorder) ar2VideoRecordStop(vid);
     ret = -1;
 #ifdef ARVIDEO_INPUT_DUMMY
     if (vid->module == AR_VIDEO_MODULE_DUMMY) {
@@ -448,6 +487,12 @@ int ar2VideoClose(AR2VideoParamT *vid)
         ret = ar2VideoCloseEmscripten((AR2VideoParamEmscriptenT *)vid->moduleParam);
     }
 #endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        ret = ar2VideoCloseReplay((AR2VideoParamReplayT *)vid->moduleParam);
+    }
+#endif
+    videoRGBAFinal();
     free (vid);
     return (ret);
 }
@@ -509,6 +554,11 @@ int ar2VideoDispOption(AR2VideoParamT *vid)
     if (vid->module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         return ar2VideoDispOptionEmscripten();
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        return ar2VideoDispOptionReplay();
+    }
 #endif
     return (-1);
 }
@@ -576,6 +626,11 @@ int ar2VideoGetId(AR2VideoParamT *vid, ARUint32 *id0, ARUint32 *id1)
     if (vid->module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         return ar2VideoGetIdEmscripten((AR2VideoParamEmscriptenT *)vid->moduleParam, id0, id1);
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        return ar2VideoGetIdReplay((AR2VideoParamReplayT *)vid->moduleParam, id0, id1);
+    }
 #endif
     return (-1);
 }
@@ -637,6 +692,11 @@ int ar2VideoGetSize(AR2VideoParamT *vid, int *x,int *y)
     if (vid->module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         return ar2VideoGetSizeEmscripten((AR2VideoParamEmscriptenT *)vid->moduleParam, x, y);
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        return ar2VideoGetSizeReplay((AR2VideoParamReplayT *)vid->moduleParam, x, y);
+    }
 #endif
     return (-1);
 }
@@ -703,6 +763,11 @@ AR_PIXEL_FORMAT ar2VideoGetPixelFormat(AR2VideoParamT *vid)
     if (vid->module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         return ar2VideoGetPixelFormatEmscripten((AR2VideoParamEmscriptenT *)vid->moduleParam);
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        return ar2VideoGetPixelFormatReplay((AR2VideoParamReplayT *)vid->moduleParam);
+    }
 #endif
     return (AR_PIXEL_FORMAT_INVALID);
 }
@@ -766,6 +831,11 @@ AR2VideoBufferT *ar2VideoGetImage(AR2VideoParamT *vid)
     if (vid->module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         ret = ar2VideoGetImageEmscripten((AR2VideoParamEmscriptenT *)vid->moduleParam);
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        ret = ar2VideoGetImageReplay((AR2VideoParamReplayT *)vid->moduleParam);
+    }
 #endif
     if (ret) {
         // Supply a timestamp if the video module didn't provide one.
@@ -795,7 +865,16 @@ AR2VideoBufferT *ar2VideoGetImage(AR2VideoParamT *vid)
                         return (NULL);
                     }
                 }
+                AR_STAGE_TIMING_BEGIN(AR_STAGE_VIDEO_LUMA);
                 ret->buffLuma = arVideoLuma(vid->lumaInfo, ret->buff);
+                AR_STAGE_TIMING_END(AR_STAGE_VIDEO_LUMA);
+            }
+        }
+        if (vid->recorder) {
+            int xsize, ysize, bufWidth = 0, bufHeight = 0;
+            if (ar2VideoGetSize(vid, &xsize, &ysize) == 0) {
+                ar2VideoGetBufferSize(vid, &bufWidth, &bufHeight);
+                arVideoRecorderWriteFrame(vid->recorder, ret, xsize, ysize, bufWidth, bufHeight, ar2VideoGetPixelFormat(vid));
             }
         }
     }
@@ -859,6 +938,11 @@ int ar2VideoCapStart(AR2VideoParamT *vid)
     if (vid->module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         return ar2VideoCapStartEmscripten((AR2VideoParamEmscriptenT *)vid->moduleParam);
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        return ar2VideoCapStartReplay((AR2VideoParamReplayT *)vid->moduleParam);
+    }
 #endif
     return (-1);
 }
@@ -931,6 +1015,11 @@ int ar2VideoCapStop(AR2VideoParamT *vid)
     if (vid->module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         return ar2VideoCapStopEmscripten((AR2VideoParamEmscriptenT *)vid->moduleParam);
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        return ar2VideoCapStopReplay((AR2VideoParamReplayT *)vid->moduleParam);
+    }
 #endif
     return (-1);
 }
@@ -1007,6 +1096,11 @@ int ar2VideoGetParami(AR2VideoParamT *vid, int paramName, int *value)
     if (vid->module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         return ar2VideoGetParamiEmscripten((AR2VideoParamEmscriptenT *)vid->moduleParam, paramName, value);
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        return ar2VideoGetParamiReplay((AR2VideoParamReplayT *)vid->moduleParam, paramName, value);
+    }
 #endif
     return (-1);
 }
@@ -1068,6 +1162,11 @@ int ar2VideoSetParami(AR2VideoParamT *vid, int paramName, int value)
     if (vid->module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         return ar2VideoSetParamiEmscripten((AR2VideoParamEmscriptenT *)vid->moduleParam, paramName, value);
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        return ar2VideoSetParamiReplay((AR2VideoParamReplayT *)vid->moduleParam, paramName, value);
+    }
 #endif
     return (-1);
 }
@@ -1129,6 +1228,11 @@ int ar2VideoGetParamd(AR2VideoParamT *vid, int paramName, double *value)
     if (vid->module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         return ar2VideoGetParamdEmscripten((AR2VideoParamEmscriptenT *)vid->moduleParam, paramName, value);
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        return ar2VideoGetParamdReplay((AR2VideoParamReplayT *)vid->moduleParam, paramName, value);
+    }
 #endif
     return (-1);
 }
@@ -1190,6 +1294,11 @@ int ar2VideoSetParamd(AR2VideoParamT *vid, int paramName, double value)
     if (vid->module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         return ar2VideoSetParamdEmscripten((AR2VideoParamEmscriptenT *)vid->moduleParam, paramName, value);
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        return ar2VideoSetParamdReplay((AR2VideoParamReplayT *)vid->moduleParam, paramName, value);
+    }
 #endif
     return (-1);
 }
@@ -1252,6 +1361,11 @@ int ar2VideoGetParams(AR2VideoParamT *vid, const int paramName, char **value)
     if (vid->module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         return ar2VideoGetParamsEmscripten((AR2VideoParamEmscriptenT *)vid->moduleParam, paramName, value);
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        return ar2VideoGetParamsReplay((AR2VideoParamReplayT *)vid->moduleParam, paramName, value);
+    }
 #endif
     return (-1);
 }
@@ -1313,6 +1427,11 @@ int ar2VideoSetParams(AR2VideoParamT *vid, const int paramName, const char *valu
     if (vid->module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         return ar2VideoSetParamsEmscripten((AR2VideoParamEmscriptenT *)vid->moduleParam, paramName, value);
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        return ar2VideoSetParamsReplay((AR2VideoParamReplayT *)vid->moduleParam, paramName, value);
+    }
 #endif
     return (-1);
 }
@@ -1387,10 +1506,32 @@ int ar2VideoGetBufferSize(AR2VideoParamT *vid, int *width, int *height)
     if (vid->module == AR_VIDEO_MODULE_EMSCRIPTEN) {
         return ar2VideoGetBufferSizeEmscripten((AR2VideoParamEmscriptenT *)vid->moduleParam, width, height);
     }
+#endif
+#ifdef ARVIDEO_INPUT_REPLAY
+    if (vid->module == AR_VIDEO_MODULE_REPLAY) {
+        return ar2VideoGetBufferSizeReplay((AR2VideoParamReplayT *)vid->moduleParam, width, height);
+    }
 #endif
     return (-1);
 }
 
+int ar2VideoRecordStart(AR2VideoParamT *vid, const char *path)
+{
+    if (!vid || !path) return -1;
+    if (vid->recorder) {
+        ARLOGe("ar2VideoRecordStart: Error: already recording.\n");
+        return -1;
+    }
+    if (!(vid->recorder = arVideoRecorderOpen(path))) return -1;
+    return 0;
+}
+
+int ar2VideoRecordStop(AR2VideoParamT *vid)
+{
+    if (!vid || !vid->recorder) return -1;
+    return arVideoRecorderClose(&vid->recorder);
+}
+
 int ar2VideoGetCParam(AR2VideoParamT *vid, ARParam *cparam)
 {
     if (!vid) return -1;
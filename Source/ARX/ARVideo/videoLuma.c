@@ -88,6 +88,13 @@ static void arVideoLumaRGBAtoL_Intel_simd_asm(uint8_t * __restrict dest, uint8_t
 static void arVideoLumaABGRtoL_Intel_simd_asm(uint8_t * __restrict dest, uint8_t * __restrict src, int32_t numPixels);
 static void arVideoLumaARGBtoL_Intel_simd_asm(uint8_t * __restrict dest, uint8_t * __restrict src, int32_t numPixels);
 #endif
+#if HAVE_ARM_NEON || HAVE_ARM64_NEON
+static void arVideoLuma3ChanneltoL_ARM_neon(uint8_t * __restrict dest, const uint8_t * __restrict src, int32_t numPixels, uint8_t w0, uint8_t w1, uint8_t w2);
+static void arVideoLumaYUV422toL_ARM_neon(uint8_t * __restrict dest, const uint8_t * __restrict src, int32_t numPixels, int lumaOffset);
+#elif HAVE_INTEL_SIMD
+static void arVideoLuma3ChanneltoL_Intel_simd(uint8_t * __restrict dest, const uint8_t * __restrict src, int32_t numPixels, uint8_t w0, uint8_t w1, uint8_t w2);
+static void arVideoLumaYUV422toL_Intel_simd(uint8_t * __restrict dest, const uint8_t * __restrict src, int32_t numPixels, int lumaOffset);
+#endif
 
 
 ARVideoLumaInfo *arVideoLumaInit(int xsize, int ysize, AR_PIXEL_FORMAT pixFormat)
@@ -112,12 +119,18 @@ ARVideoLumaInfo *arVideoLumaInit(int xsize, int ysize, AR_PIXEL_FORMAT pixFormat
     
     // Accelerated RGB to luma conversion.
 #if HAVE_ARM_NEON || HAVE_ARM64_NEON || HAVE_INTEL_SIMD
-    vli->fastPath = (xsize * ysize % 8 == 0
-                     && (pixFormat == AR_PIXEL_FORMAT_RGBA
-                         || pixFormat == AR_PIXEL_FORMAT_BGRA
-                         || pixFormat == AR_PIXEL_FORMAT_ABGR
-                         ||pixFormat == AR_PIXEL_FORMAT_ARGB
-                         )
+    vli->fastPath = ((xsize * ysize % 8 == 0
+                      && (pixFormat == AR_PIXEL_FORMAT_RGBA
+                          || pixFormat == AR_PIXEL_FORMAT_BGRA
+                          || pixFormat == AR_PIXEL_FORMAT_ABGR
+                          ||pixFormat == AR_PIXEL_FORMAT_ARGB
+                          )
+                      )
+                     // These handle any trailing pixels themselves, so have no size restriction.
+                     || pixFormat == AR_PIXEL_FORMAT_RGB
+                     || pixFormat == AR_PIXEL_FORMAT_BGR
+                     || pixFormat == AR_PIXEL_FORMAT_yuvs
+                     || pixFormat == AR_PIXEL_FORMAT_2vuy
                      );
     // Under Windows, Linux and OS X, we assume a minimum of Intel Core2, which satifisfies the requirement for SSE2, SSE3 and SSSE3 support.
     // Under iOS, we assume a minimum of ARMv7a with NEON.
@@ -167,8 +180,16 @@ ARUint8 *__restrict arVideoLuma(ARVideoLumaInfo *vli, const ARUint8 *__restrict
             arVideoLumaRGBAtoL_ARM_neon_asm(vli->buff, (unsigned char *__restrict)dataPtr, vli->buffSize);
         } else if (pixFormat == AR_PIXEL_FORMAT_ABGR) {
             arVideoLumaABGRtoL_ARM_neon_asm(vli->buff, (unsigned char *__restrict)dataPtr, vli->buffSize);
-        } else /*(pixFormat == AR_PIXEL_FORMAT_ARGB)*/ {
+        } else if (pixFormat == AR_PIXEL_FORMAT_ARGB) {
             arVideoLumaARGBtoL_ARM_neon_asm(vli->buff, (unsigned char *__restrict)dataPtr, vli->buffSize);
+        } else if (pixFormat == AR_PIXEL_FORMAT_RGB) {
+            arVideoLuma3ChanneltoL_ARM_neon(vli->buff, dataPtr, vli->buffSize, R8_CCIR601, G8_CCIR601, B8_CCIR601);
+        } else if (pixFormat == AR_PIXEL_FORMAT_BGR) {
+            arVideoLuma3ChanneltoL_ARM_neon(vli->buff, dataPtr, vli->buffSize, B8_CCIR601, G8_CCIR601, R8_CCIR601);
+        } else if (pixFormat == AR_PIXEL_FORMAT_yuvs) {
+            arVideoLumaYUV422toL_ARM_neon(vli->buff, dataPtr, vli->buffSize, 0);
+        } else /*(pixFormat == AR_PIXEL_FORMAT_2vuy)*/ {
+            arVideoLumaYUV422toL_ARM_neon(vli->buff, dataPtr, vli->buffSize, 1);
         }
         return (vli->buff);
     }
@@ -180,8 +201,16 @@ ARUint8 *__restrict arVideoLuma(ARVideoLumaInfo *vli, const ARUint8 *__restrict
             arVideoLumaRGBAtoL_Intel_simd_asm(vli->buff, (unsigned char *__restrict)dataPtr, vli->buffSize);
         } else if (pixFormat == AR_PIXEL_FORMAT_ABGR) {
             arVideoLumaABGRtoL_Intel_simd_asm(vli->buff, (unsigned char *__restrict)dataPtr, vli->buffSize);
-        } else /*(pixFormat == AR_PIXEL_FORMAT_ARGB)*/ {
+        } else if (pixFormat == AR_PIXEL_FORMAT_ARGB) {
             arVideoLumaARGBtoL_Intel_simd_asm(vli->buff, (unsigned char *__restrict)dataPtr, vli->buffSize);
+        } else if (pixFormat == AR_PIXEL_FORMAT_RGB) {
+            arVideoLuma3ChanneltoL_Intel_simd(vli->buff, dataPtr, vli->buffSize, R8_CCIR601, G8_CCIR601, B8_CCIR601);
+        } else if (pixFormat == AR_PIXEL_FORMAT_BGR) {
+            arVideoLuma3ChanneltoL_Intel_simd(vli->buff, dataPtr, vli->buffSize, B8_CCIR601, G8_CCIR601, R8_CCIR601);
+        } else if (pixFormat == AR_PIXEL_FORMAT_yuvs) {
+            arVideoLumaYUV422toL_Intel_simd(vli->buff, dataPtr, vli->buffSize, 0);
+        } else /*(pixFormat == AR_PIXEL_FORMAT_2vuy)*/ {
+            arVideoLumaYUV422toL_Intel_simd(vli->buff, dataPtr, vli->buffSize, 1);
         }
         return (vli->buff);
     }
@@ -651,3 +680,120 @@ static void arVideoLumaARGBtoL_Intel_simd_asm(uint8_t * __restrict dest, uint8_t
 
 #endif // HAVE_ARM_NEON|HAVE_ARM64_NEON|HAVE_INTEL_SIMD
 
+#if HAVE_ARM_NEON || HAVE_ARM64_NEON
+
+// 16 pixels per iteration. Same arithmetic as the scalar path, so results are identical.
+static void arVideoLuma3ChanneltoL_ARM_neon(uint8_t * __restrict dest, const uint8_t * __restrict src, int32_t numPixels, uint8_t w0, uint8_t w1, uint8_t w2)
+{
+    uint8x8_t w0v = vdup_n_u8(w0);
+    uint8x8_t w1v = vdup_n_u8(w1);
+    uint8x8_t w2v = vdup_n_u8(w2);
+    int32_t i;
+
+    for (i = numPixels >> 4; i > 0; i--) {
+        uint8x16x3_t px = vld3q_u8(src); // De-interleave channel 0 into val[0], channel 1 into val[1], channel 2 into val[2].
+        uint16x8_t lo = vmull_u8(vget_low_u8(px.val[0]), w0v);
+        uint16x8_t hi = vmull_u8(vget_high_u8(px.val[0]), w0v);
+        lo = vmlal_u8(lo, vget_low_u8(px.val[1]), w1v);
+        hi = vmlal_u8(hi, vget_high_u8(px.val[1]), w1v);
+        lo = vmlal_u8(lo, vget_low_u8(px.val[2]), w2v);
+        hi = vmlal_u8(hi, vget_high_u8(px.val[2]), w2v);
+        vst1q_u8(dest, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+        src += 16*3;
+        dest += 16;
+    }
+    for (i = numPixels & 15; i > 0; i--) {
+        *dest++ = (w0*src[0] + w1*src[1] + w2*src[2]) >> 8;
+        src += 3;
+    }
+}
+
+// Packed 4:2:2 Y'CbCr. lumaOffset is 0 for yuvs (Y0 Cb Y1 Cr), 1 for 2vuy (Cb Y0 Cr Y1).
+static void arVideoLumaYUV422toL_ARM_neon(uint8_t * __restrict dest, const uint8_t * __restrict src, int32_t numPixels, int lumaOffset)
+{
+    int32_t i;
+
+    for (i = numPixels >> 4; i > 0; i--) {
+        uint8x16x2_t px = vld2q_u8(src); // Even bytes into val[0], odd bytes into val[1].
+        vst1q_u8(dest, lumaOffset ? px.val[1] : px.val[0]);
+        src += 16*2;
+        dest += 16;
+    }
+    for (i = numPixels & 15; i > 0; i--) {
+        *dest++ = src[lumaOffset];
+        src += 2;
+    }
+}
+
+#elif HAVE_INTEL_SIMD
+
+// 16 pixels per iteration. SSSE3 byte shuffles de-interleave the three 16-byte loads into one
+// register per channel. The weighted sum can't exceed 255*256, so 16-bit arithmetic with a
+// logical shift gives results identical to the scalar path.
+static void arVideoLuma3ChanneltoL_Intel_simd(uint8_t * __restrict dest, const uint8_t * __restrict src, int32_t numPixels, uint8_t w0, uint8_t w1, uint8_t w2)
+{
+    const __m128i c0s0 = _mm_setr_epi8( 0,  3,  6,  9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i c0s1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1,  2,  5,  8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i c0s2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  1,  4,  7, 10, 13);
+    const __m128i c1s0 = _mm_setr_epi8( 1,  4,  7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i c1s1 = _mm_setr_epi8(-1, -1, -1, -1, -1,  0,  3,  6,  9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i c1s2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  2,  5,  8, 11, 14);
+    const __m128i c2s0 = _mm_setr_epi8( 2,  5,  8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i c2s1 = _mm_setr_epi8(-1, -1, -1, -1, -1,  1,  4,  7, 10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i c2s2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0,  3,  6,  9, 12, 15);
+    const __m128i w0v = _mm_set1_epi16(w0);
+    const __m128i w1v = _mm_set1_epi16(w1);
+    const __m128i w2v = _mm_set1_epi16(w2);
+    const __m128i zero = _mm_setzero_si128();
+    int32_t i;
+
+    for (i = numPixels >> 4; i > 0; i--) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)src);
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(src + 16));
+        __m128i v2 = _mm_loadu_si128((const __m128i *)(src + 32));
+        __m128i c0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, c0s0), _mm_shuffle_epi8(v1, c0s1)), _mm_shuffle_epi8(v2, c0s2));
+        __m128i c1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, c1s0), _mm_shuffle_epi8(v1, c1s1)), _mm_shuffle_epi8(v2, c1s2));
+        __m128i c2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, c2s0), _mm_shuffle_epi8(v1, c2s1)), _mm_shuffle_epi8(v2, c2s2));
+        __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(c0, zero), w0v),
+                                                 _mm_mullo_epi16(_mm_unpacklo_epi8(c1, zero), w1v)),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(c2, zero), w2v));
+        __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(c0, zero), w0v),
+                                                 _mm_mullo_epi16(_mm_unpackhi_epi8(c1, zero), w1v)),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(c2, zero), w2v));
+        _mm_storeu_si128((__m128i *)dest, _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+        src += 16*3;
+        dest += 16;
+    }
+    for (i = numPixels & 15; i > 0; i--) {
+        *dest++ = (w0*src[0] + w1*src[1] + w2*src[2]) >> 8;
+        src += 3;
+    }
+}
+
+// Packed 4:2:2 Y'CbCr. lumaOffset is 0 for yuvs (Y0 Cb Y1 Cr), 1 for 2vuy (Cb Y0 Cr Y1).
+static void arVideoLumaYUV422toL_Intel_simd(uint8_t * __restrict dest, const uint8_t * __restrict src, int32_t numPixels, int lumaOffset)
+{
+    const __m128i lumaMask = _mm_set1_epi16(0x00ff);
+    int32_t i;
+
+    for (i = numPixels >> 4; i > 0; i--) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)src);
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(src + 16));
+        if (lumaOffset) {
+            v0 = _mm_srli_epi16(v0, 8);
+            v1 = _mm_srli_epi16(v1, 8);
+        } else {
+            v0 = _mm_and_si128(v0, lumaMask);
+            v1 = _mm_and_si128(v1, lumaMask);
+        }
+        _mm_storeu_si128((__m128i *)dest, _mm_packus_epi16(v0, v1));
+        src += 16*2;
+        dest += 16;
+    }
+    for (i = numPixels & 15; i > 0; i--) {
+        *dest++ = src[lumaOffset];
+        src += 2;
+    }
+}
+
+#endif // HAVE_ARM_NEON|HAVE_ARM64_NEON|HAVE_INTEL_SIMD
@@ -36,13 +36,18 @@
  *
  */
 #include <stdbool.h>
+#include <pthread.h>
 #include <ARX/ARVideo/videoRGBA.h>
+#include <ARX/ARUtil/thread_sub.h>
 
 #if HAVE_ARM_NEON || HAVE_ARM64_NEON
 #  include <arm_neon.h>
-#  ifdef ANDROID
-#    include "cpu-features.h"
-#  endif
+#elif HAVE_INTEL_SIMD
+#  include <emmintrin.h> // SSE2.
+#  include <tmmintrin.h> // SSSE3. _mm_shuffle_epi8, _mm_alignr_epi8
+#endif
+#if defined(ANDROID) && (HAVE_ARM_NEON || HAVE_INTEL_SIMD)
+#  include "cpu-features.h"
 #endif
 
 #define MAX(x,y) (x > y ? x : y)
@@ -51,6 +56,8 @@
 
 #if defined(ANDROID) && HAVE_ARM_NEON
 int gHaveARMv7aWithNEON = -1;
+#elif defined(ANDROID) && HAVE_INTEL_SIMD
+static int gHaveSSSE3 = -1;
 #endif
 
 #if HAVE_ARM_NEON
@@ -470,155 +477,616 @@ static void YCrCb422BiPlanarToRGBA_ARM_neon_asm(uint8_t * __restrict dest, uint8
 }
 #endif
 
-int videoRGBA(uint32_t *destRGBA, AR2VideoBufferT *source, int width, int height, AR_PIXEL_FORMAT pixelFormat)
+#if HAVE_ARM_NEON || HAVE_ARM64_NEON || HAVE_INTEL_SIMD
+static bool videoRGBAHaveSIMD(void)
 {
-#if HAVE_ARM_NEON || HAVE_ARM64_NEON
-    bool fastPath;
-#endif
-    
-    if (!destRGBA || !source || width <= 0 || height <= 0 || pixelFormat == AR_PIXEL_FORMAT_INVALID) return (-1); // Sanity check.
-
-#if HAVE_ARM_NEON || HAVE_ARM64_NEON
-    if (width % 16 != 0 || height % 2 != 0) {
-        fastPath = false;
-    } else {
 #  if defined(ANDROID) && HAVE_ARM_NEON
-        if (gHaveARMv7aWithNEON == -1) {
-            // Not all Android devices with ARMv7 are guaranteed to have NEON, so check.
-            uint64_t features = android_getCpuFeatures();
-            gHaveARMv7aWithNEON = (features & ANDROID_CPU_ARM_FEATURE_ARMv7) && (features & ANDROID_CPU_ARM_FEATURE_NEON);
-            ARLOGi("videoRGBA() will%s use ARM NEON acceleration.\n", (gHaveARMv7aWithNEON ? "" : " not"));
-        }
-        fastPath = gHaveARMv7aWithNEON;
+    if (gHaveARMv7aWithNEON == -1) {
+        // Not all Android devices with ARMv7 are guaranteed to have NEON, so check.
+        uint64_t features = android_getCpuFeatures();
+        gHaveARMv7aWithNEON = (features & ANDROID_CPU_ARM_FEATURE_ARMv7) && (features & ANDROID_CPU_ARM_FEATURE_NEON);
+        ARLOGi("videoRGBA() will%s use ARM NEON acceleration.\n", (gHaveARMv7aWithNEON ? "" : " not"));
+    }
+    return (gHaveARMv7aWithNEON != 0);
+#  elif defined(ANDROID) && HAVE_INTEL_SIMD
+    if (gHaveSSSE3 == -1) {
+        // Android x86 devices are not all guaranteed to have SSSE3, so check.
+        gHaveSSSE3 = ((android_getCpuFeatures() & ANDROID_CPU_X86_FEATURE_SSSE3) != 0);
+        ARLOGi("videoRGBA() will%s use Intel SIMD acceleration.\n", (gHaveSSSE3 ? "" : " not"));
+    }
+    return (gHaveSSSE3 != 0);
 #  else
-        fastPath = true;
+    // Under Windows, Linux and OS X, we assume a minimum of Intel Core2, which satisfies the requirement for SSSE3 support.
+    // Under iOS, we assume a minimum of ARMv7a with NEON.
+    return true;
 #  endif
-    }
+}
 #endif
-    
-    int pixelSize = arUtilGetPixelSize(pixelFormat);
-    switch (pixelFormat) {
-        case AR_PIXEL_FORMAT_BGRA:
-        case AR_PIXEL_FORMAT_BGR:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destRGBA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | (*(inp + 0) << 16) | (*(inp + 1) << 8) | (*(inp + 2));
+
+//
+// Packed formats are converted by row functions which process n contiguous pixels.
+// Output is written in memory order, so the same code serves both byte orders.
+// order[i] is the source component which goes into byte i of each output pixel, and byte 3
+// is always alpha = 255. For formats with one byte per component, the component is its byte
+// offset within the source pixel. For the 16-bit formats, it is 0 = red, 1 = green, 2 = blue.
+//
+typedef void (*VideoRGBARowFunc)(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3]);
+
+// The NEON row functions have not yet been built and checked on an ARM target, so are only used
+// if VIDEO_RGBA_USE_ARM_NEON_ROWS is defined. Otherwise, ARM builds use the scalar row functions.
+#if (HAVE_ARM_NEON || HAVE_ARM64_NEON) && defined(VIDEO_RGBA_USE_ARM_NEON_ROWS)
+#  define VIDEO_RGBA_ARM_NEON_ROWS 1
 #else
-                    *outp = (*(inp + 2) << 24) | (*(inp + 1) << 16) | (*(inp + 0) << 8) | 0xff;
+#  define VIDEO_RGBA_ARM_NEON_ROWS 0
 #endif
-                    inp += pixelSize;
-                    outp++;
-                }
-            }
+
+static void videoRGBARowRGB24(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    for (; n > 0; n--) {
+        dest[0] = src[order[0]];
+        dest[1] = src[order[1]];
+        dest[2] = src[order[2]];
+        dest[3] = 0xff;
+        src += 3;
+        dest += 4;
+    }
+}
+
+static void videoRGBARowRGB32(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    for (; n > 0; n--) {
+        dest[0] = src[order[0]];
+        dest[1] = src[order[1]];
+        dest[2] = src[order[2]];
+        dest[3] = 0xff;
+        src += 4;
+        dest += 4;
+    }
+}
+
+static void videoRGBARowMono(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    for (; n > 0; n--) {
+        dest[0] = dest[1] = dest[2] = *src++;
+        dest[3] = 0xff;
+        dest += 4;
+    }
+}
+
+static void videoRGBARowRGB565(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    const bool bgr = (order[0] == 2); // The 16-bit formats are only ever converted in RGB or BGR order.
+    uint8_t r, g, b;
+
+    for (; n > 0; n--) {
+        r = src[0] & 0xf8;
+        g = ((src[0] & 0x07) << 5) | ((src[1] & 0xe0) >> 3);
+        b = (src[1] & 0x1f) << 3;
+        dest[0] = (bgr ? b : r);
+        dest[1] = g;
+        dest[2] = (bgr ? r : b);
+        dest[3] = 0xff;
+        src += 2;
+        dest += 4;
+    }
+}
+
+static void videoRGBARowRGBA5551(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    const bool bgr = (order[0] == 2); // The 16-bit formats are only ever converted in RGB or BGR order.
+    uint8_t r, g, b;
+
+    for (; n > 0; n--) {
+        r = src[0] & 0xf8;
+        g = ((src[0] & 0x07) << 5) | ((src[1] & 0xc0) >> 3);
+        b = (src[1] & 0x3e) << 2;
+        dest[0] = (bgr ? b : r);
+        dest[1] = g;
+        dest[2] = (bgr ? r : b);
+        dest[3] = 0xff;
+        src += 2;
+        dest += 4;
+    }
+}
+
+static void videoRGBARowRGBA4444(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    const bool bgr = (order[0] == 2); // The 16-bit formats are only ever converted in RGB or BGR order.
+    uint8_t r, g, b;
+
+    for (; n > 0; n--) {
+        r = src[0] & 0xf0;
+        g = (src[0] & 0x0f) << 4;
+        b = src[1] & 0xf0;
+        dest[0] = (bgr ? b : r);
+        dest[1] = g;
+        dest[2] = (bgr ? r : b);
+        dest[3] = 0xff;
+        src += 2;
+        dest += 4;
+    }
+}
+
+#if VIDEO_RGBA_ARM_NEON_ROWS
+
+// 16 pixels per iteration, with any trailing pixels done by the scalar row function.
+static void videoRGBARowRGB24_ARM_neon(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    const uint8x16_t alpha = vdupq_n_u8(0xff);
+    int i;
+
+    for (i = n >> 4; i > 0; i--) {
+        uint8x16x3_t in = vld3q_u8(src);
+        uint8x16x4_t out;
+        out.val[0] = in.val[order[0]];
+        out.val[1] = in.val[order[1]];
+        out.val[2] = in.val[order[2]];
+        out.val[3] = alpha;
+        vst4q_u8(dest, out);
+        src += 16*3;
+        dest += 16*4;
+    }
+    videoRGBARowRGB24(dest, src, n & 15, order);
+}
+
+static void videoRGBARowRGB32_ARM_neon(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    const uint8x16_t alpha = vdupq_n_u8(0xff);
+    int i;
+
+    for (i = n >> 4; i > 0; i--) {
+        uint8x16x4_t in = vld4q_u8(src);
+        uint8x16x4_t out;
+        out.val[0] = in.val[order[0]];
+        out.val[1] = in.val[order[1]];
+        out.val[2] = in.val[order[2]];
+        out.val[3] = alpha;
+        vst4q_u8(dest, out);
+        src += 16*4;
+        dest += 16*4;
+    }
+    videoRGBARowRGB32(dest, src, n & 15, order);
+}
+
+static void videoRGBARowMono_ARM_neon(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    uint8x16x4_t out;
+    int i;
+
+    out.val[3] = vdupq_n_u8(0xff);
+    for (i = n >> 4; i > 0; i--) {
+        out.val[0] = out.val[1] = out.val[2] = vld1q_u8(src);
+        vst4q_u8(dest, out);
+        src += 16;
+        dest += 16*4;
+    }
+    videoRGBARowMono(dest, src, n & 15, order);
+}
+
+// Interleaves three 16-pixel component vectors in the requested order, plus alpha.
+static inline void videoRGBAStore16_ARM_neon(uint8_t * __restrict dest, const uint8x16_t c[3], const uint8_t order[3])
+{
+    uint8x16x4_t out;
+    out.val[0] = c[order[0]];
+    out.val[1] = c[order[1]];
+    out.val[2] = c[order[2]];
+    out.val[3] = vdupq_n_u8(0xff);
+    vst4q_u8(dest, out);
+}
+
+static void videoRGBARowRGB565_ARM_neon(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    uint8x16_t c[3];
+    int i;
+
+    for (i = n >> 4; i > 0; i--) {
+        uint8x16x2_t in = vld2q_u8(src); // First byte of each pixel into val[0], second into val[1].
+        c[0] = vandq_u8(in.val[0], vdupq_n_u8(0xf8));
+        c[1] = vorrq_u8(vshlq_n_u8(in.val[0], 5), vandq_u8(vshrq_n_u8(in.val[1], 3), vdupq_n_u8(0x1c)));
+        c[2] = vshlq_n_u8(in.val[1], 3);
+        videoRGBAStore16_ARM_neon(dest, c, order);
+        src += 16*2;
+        dest += 16*4;
+    }
+    videoRGBARowRGB565(dest, src, n & 15, order);
+}
+
+static void videoRGBARowRGBA5551_ARM_neon(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    uint8x16_t c[3];
+    int i;
+
+    for (i = n >> 4; i > 0; i--) {
+        uint8x16x2_t in = vld2q_u8(src);
+        c[0] = vandq_u8(in.val[0], vdupq_n_u8(0xf8));
+        c[1] = vorrq_u8(vshlq_n_u8(in.val[0], 5), vandq_u8(vshrq_n_u8(in.val[1], 3), vdupq_n_u8(0x18)));
+        c[2] = vandq_u8(vshlq_n_u8(in.val[1], 2), vdupq_n_u8(0xf8));
+        videoRGBAStore16_ARM_neon(dest, c, order);
+        src += 16*2;
+        dest += 16*4;
+    }
+    videoRGBARowRGBA5551(dest, src, n & 15, order);
+}
+
+static void videoRGBARowRGBA4444_ARM_neon(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    uint8x16_t c[3];
+    int i;
+
+    for (i = n >> 4; i > 0; i--) {
+        uint8x16x2_t in = vld2q_u8(src);
+        c[0] = vandq_u8(in.val[0], vdupq_n_u8(0xf0));
+        c[1] = vshlq_n_u8(in.val[0], 4);
+        c[2] = vandq_u8(in.val[1], vdupq_n_u8(0xf0));
+        videoRGBAStore16_ARM_neon(dest, c, order);
+        src += 16*2;
+        dest += 16*4;
+    }
+    videoRGBARowRGBA4444(dest, src, n & 15, order);
+}
+
+#elif HAVE_INTEL_SIMD
+
+// Shuffle control which places component order[i] of each of four source pixels of pixelSize bytes
+// into byte i of each output pixel, and zeroes byte 3 ready for alpha to be OR'ed in.
+static __m128i videoRGBAShuffleMask_Intel_simd(const uint8_t order[3], int pixelSize)
+{
+    int8_t m[16];
+    int i;
+    for (i = 0; i < 4; i++) {
+        m[i*4 + 0] = (int8_t)(i*pixelSize + order[0]);
+        m[i*4 + 1] = (int8_t)(i*pixelSize + order[1]);
+        m[i*4 + 2] = (int8_t)(i*pixelSize + order[2]);
+        m[i*4 + 3] = -1;
+    }
+    return _mm_loadu_si128((const __m128i *)m);
+}
+
+// 16 pixels per iteration. The three 16-byte loads are realigned so that each group of four
+// pixels starts at byte 0, then a single shuffle places all four.
+static void videoRGBARowRGB24_Intel_simd(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    const __m128i mask = videoRGBAShuffleMask_Intel_simd(order, 3);
+    const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+    int i;
+
+    for (i = n >> 4; i > 0; i--) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)src);
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(src + 16));
+        __m128i v2 = _mm_loadu_si128((const __m128i *)(src + 32));
+        _mm_storeu_si128((__m128i *)dest,        _mm_or_si128(_mm_shuffle_epi8(v0, mask), alpha));
+        _mm_storeu_si128((__m128i *)(dest + 16), _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(v1, v0, 12), mask), alpha));
+        _mm_storeu_si128((__m128i *)(dest + 32), _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(v2, v1, 8), mask), alpha));
+        _mm_storeu_si128((__m128i *)(dest + 48), _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(v2, 4), mask), alpha));
+        src += 16*3;
+        dest += 16*4;
+    }
+    videoRGBARowRGB24(dest, src, n & 15, order);
+}
+
+static void videoRGBARowRGB32_Intel_simd(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    const __m128i mask = videoRGBAShuffleMask_Intel_simd(order, 4);
+    const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+    int i;
+
+    for (i = n >> 2; i > 0; i--) {
+        _mm_storeu_si128((__m128i *)dest, _mm_or_si128(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)src), mask), alpha));
+        src += 4*4;
+        dest += 4*4;
+    }
+    videoRGBARowRGB32(dest, src, n & 3, order);
+}
+
+static void videoRGBARowMono_Intel_simd(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+    int i;
+
+    for (i = n >> 4; i > 0; i--) {
+        __m128i v = _mm_loadu_si128((const __m128i *)src);
+        __m128i lo = _mm_unpacklo_epi8(v, v); // Each byte doubled.
+        __m128i hi = _mm_unpackhi_epi8(v, v);
+        _mm_storeu_si128((__m128i *)dest,        _mm_or_si128(_mm_unpacklo_epi16(lo, lo), alpha));
+        _mm_storeu_si128((__m128i *)(dest + 16), _mm_or_si128(_mm_unpackhi_epi16(lo, lo), alpha));
+        _mm_storeu_si128((__m128i *)(dest + 32), _mm_or_si128(_mm_unpacklo_epi16(hi, hi), alpha));
+        _mm_storeu_si128((__m128i *)(dest + 48), _mm_or_si128(_mm_unpackhi_epi16(hi, hi), alpha));
+        src += 16;
+        dest += 16*4;
+    }
+    videoRGBARowMono(dest, src, n & 15, order);
+}
+
+// The 16-bit formats are done 8 pixels per iteration. Each pixel is loaded as a little-endian
+// 16-bit word, so the first source byte is in bits 0-7 and the second in bits 8-15. Components
+// are extracted into the low byte of each word, then interleaved in the requested order with alpha.
+static inline void videoRGBAStore8_Intel_simd(uint8_t * __restrict dest, const __m128i c[3], const uint8_t order[3])
+{
+    __m128i b01 = _mm_or_si128(c[order[0]], _mm_slli_epi16(c[order[1]], 8));
+    __m128i b23 = _mm_or_si128(c[order[2]], _mm_set1_epi16((short)0xff00));
+    _mm_storeu_si128((__m128i *)dest,        _mm_unpacklo_epi16(b01, b23));
+    _mm_storeu_si128((__m128i *)(dest + 16), _mm_unpackhi_epi16(b01, b23));
+}
+
+static void videoRGBARowRGB565_Intel_simd(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    const __m128i maskF8 = _mm_set1_epi16(0x00f8);
+    const __m128i maskE0 = _mm_set1_epi16(0x00e0);
+    const __m128i mask1C = _mm_set1_epi16(0x001c);
+    __m128i c[3];
+    int i;
+
+    for (i = n >> 3; i > 0; i--) {
+        __m128i v = _mm_loadu_si128((const __m128i *)src);
+        c[0] = _mm_and_si128(v, maskF8);
+        c[1] = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(v, 5), maskE0), _mm_and_si128(_mm_srli_epi16(v, 11), mask1C));
+        c[2] = _mm_and_si128(_mm_srli_epi16(v, 5), maskF8);
+        videoRGBAStore8_Intel_simd(dest, c, order);
+        src += 8*2;
+        dest += 8*4;
+    }
+    videoRGBARowRGB565(dest, src, n & 7, order);
+}
+
+static void videoRGBARowRGBA5551_Intel_simd(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    const __m128i maskF8 = _mm_set1_epi16(0x00f8);
+    const __m128i maskE0 = _mm_set1_epi16(0x00e0);
+    const __m128i mask18 = _mm_set1_epi16(0x0018);
+    __m128i c[3];
+    int i;
+
+    for (i = n >> 3; i > 0; i--) {
+        __m128i v = _mm_loadu_si128((const __m128i *)src);
+        c[0] = _mm_and_si128(v, maskF8);
+        c[1] = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(v, 5), maskE0), _mm_and_si128(_mm_srli_epi16(v, 11), mask18));
+        c[2] = _mm_and_si128(_mm_srli_epi16(v, 6), maskF8);
+        videoRGBAStore8_Intel_simd(dest, c, order);
+        src += 8*2;
+        dest += 8*4;
+    }
+    videoRGBARowRGBA5551(dest, src, n & 7, order);
+}
+
+static void videoRGBARowRGBA4444_Intel_simd(uint8_t * __restrict dest, const uint8_t * __restrict src, int n, const uint8_t order[3])
+{
+    const __m128i maskF0 = _mm_set1_epi16(0x00f0);
+    __m128i c[3];
+    int i;
+
+    for (i = n >> 3; i > 0; i--) {
+        __m128i v = _mm_loadu_si128((const __m128i *)src);
+        c[0] = _mm_and_si128(v, maskF0);
+        c[1] = _mm_and_si128(_mm_slli_epi16(v, 4), maskF0);
+        c[2] = _mm_and_si128(_mm_srli_epi16(v, 8), maskF0);
+        videoRGBAStore8_Intel_simd(dest, c, order);
+        src += 8*2;
+        dest += 8*4;
+    }
+    videoRGBARowRGBA4444(dest, src, n & 7, order);
+}
+
+#endif // VIDEO_RGBA_ARM_NEON_ROWS|HAVE_INTEL_SIMD
+
+//
+// Large frames are split into bands of whole rows, converted concurrently by a pool of worker
+// threads shared by all callers. The pool is created on first use and sized to the number of
+// CPUs, and stopped by videoRGBAFinal(). Only one conversion uses the pool at a time; if it is
+// busy, the caller converts on its own.
+//
+#define VIDEO_RGBA_BAND_MAX 8
+#define VIDEO_RGBA_BAND_ROWS_MIN 64
+#define VIDEO_RGBA_BANDED_PIXELS_MIN (640*480)
+
+typedef struct {
+    VideoRGBARowFunc rowFunc;
+    const uint8_t   *order;
+    uint8_t         *dest;
+    const uint8_t   *src;
+    int              n;
+} VideoRGBABand;
+
+static pthread_mutex_t gVideoRGBABandLock = PTHREAD_MUTEX_INITIALIZER;
+static int gVideoRGBABandNum = 0; // 0 until the pool has been created.
+static int gVideoRGBAUserCount = 0; // Number of videoRGBAInit() calls not yet matched by videoRGBAFinal().
+static VideoRGBABand gVideoRGBABand[VIDEO_RGBA_BAND_MAX];
+static THREAD_HANDLE_T *gVideoRGBABandThreadHandle[VIDEO_RGBA_BAND_MAX]; // Band 0 is converted on the calling thread, so [0] is unused.
+
+static void *videoRGBABandWorker(THREAD_HANDLE_T *threadHandle)
+{
+    VideoRGBABand *b = (VideoRGBABand *)threadGetArg(threadHandle);
+
+    while (threadStartWait(threadHandle) == 0) {
+        b->rowFunc(b->dest, b->src, b->n, b->order);
+        threadEndSignal(threadHandle);
+    }
+    return (NULL);
+}
+
+// Must be called with gVideoRGBABandLock held.
+static void videoRGBABandInit(void)
+{
+    int bandNum = threadGetCPU();
+    int i;
+
+    if (bandNum > VIDEO_RGBA_BAND_MAX) bandNum = VIDEO_RGBA_BAND_MAX;
+    for (i = 1; i < bandNum; i++) {
+        gVideoRGBABandThreadHandle[i] = threadInit(i, &gVideoRGBABand[i], videoRGBABandWorker);
+        if (!gVideoRGBABandThreadHandle[i]) {
+            ARLOGw("Warning: unable to start videoRGBA worker thread.\n");
             break;
-        case AR_PIXEL_FORMAT_RGBA:
+        }
+    }
+    gVideoRGBABandNum = (i < 1 ? 1 : i);
+}
+
+void videoRGBAInit(void)
+{
+    pthread_mutex_lock(&gVideoRGBABandLock);
+    gVideoRGBAUserCount++;
+    pthread_mutex_unlock(&gVideoRGBABandLock);
+}
+
+// Stops the worker threads when the last user has finished. They are restarted on next use.
+void videoRGBAFinal(void)
+{
+    int i;
+
+    pthread_mutex_lock(&gVideoRGBABandLock);
+    if (gVideoRGBAUserCount > 0) gVideoRGBAUserCount--;
+    if (gVideoRGBAUserCount == 0) {
+        for (i = 1; i < gVideoRGBABandNum; i++) {
+            threadWaitQuit(gVideoRGBABandThreadHandle[i]);
+            threadFree(&gVideoRGBABandThreadHandle[i]);
+        }
+        gVideoRGBABandNum = 0;
+    }
+    pthread_mutex_unlock(&gVideoRGBABandLock);
+}
+
+static void videoRGBAConvert(VideoRGBARowFunc rowFunc, const uint8_t order[3], uint8_t *dest, const uint8_t *src, int width, int height, int pixelSize)
+{
+    int bandNum, rowStart, rowEnd, i;
+
+    if (width * height < VIDEO_RGBA_BANDED_PIXELS_MIN || height < 2*VIDEO_RGBA_BAND_ROWS_MIN || pthread_mutex_trylock(&gVideoRGBABandLock) != 0) {
+        rowFunc(dest, src, width * height, order);
+        return;
+    }
+    if (!gVideoRGBABandNum) videoRGBABandInit();
+    bandNum = MIN(gVideoRGBABandNum, height / VIDEO_RGBA_BAND_ROWS_MIN);
+    if (bandNum < 2) {
+        pthread_mutex_unlock(&gVideoRGBABandLock);
+        rowFunc(dest, src, width * height, order);
+        return;
+    }
+
+    for (i = 0; i < bandNum; i++) {
+        rowStart = height * i / bandNum;
+        rowEnd = height * (i + 1) / bandNum;
+        gVideoRGBABand[i].rowFunc = rowFunc;
+        gVideoRGBABand[i].order = order;
+        gVideoRGBABand[i].dest = dest + (size_t)rowStart * width * 4;
+        gVideoRGBABand[i].src = src + (size_t)rowStart * width * pixelSize;
+        gVideoRGBABand[i].n = (rowEnd - rowStart) * width;
+        if (i > 0) threadStartSignal(gVideoRGBABandThreadHandle[i]);
+    }
+    rowFunc(gVideoRGBABand[0].dest, gVideoRGBABand[0].src, gVideoRGBABand[0].n, order);
+    for (i = 1; i < bandNum; i++) threadEndWait(gVideoRGBABandThreadHandle[i]);
+
+    pthread_mutex_unlock(&gVideoRGBABandLock);
+}
+
+// Converts any of the packed formats, with output in RGBA or, if destBGRA is true, BGRA byte order.
+static int videoRGBAConvertPacked(uint8_t *dest, const ARUint8 *src, int width, int height, AR_PIXEL_FORMAT pixelFormat, bool destBGRA)
+{
+    static const uint8_t order012[3] = {0, 1, 2};
+    static const uint8_t order210[3] = {2, 1, 0};
+    static const uint8_t order123[3] = {1, 2, 3};
+    static const uint8_t order321[3] = {3, 2, 1};
+    VideoRGBARowFunc rowFunc;
+    const uint8_t *order;
+#if VIDEO_RGBA_ARM_NEON_ROWS || HAVE_INTEL_SIMD
+    bool simd = videoRGBAHaveSIMD();
+#endif
+
+    switch (pixelFormat) {
         case AR_PIXEL_FORMAT_RGB:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destRGBA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | (*(inp + 2) << 16) | (*(inp + 1) << 8) | (*(inp + 0));
+        case AR_PIXEL_FORMAT_BGR:
+#if VIDEO_RGBA_ARM_NEON_ROWS
+            rowFunc = (simd ? videoRGBARowRGB24_ARM_neon : videoRGBARowRGB24);
+#elif HAVE_INTEL_SIMD
+            rowFunc = (simd ? videoRGBARowRGB24_Intel_simd : videoRGBARowRGB24);
 #else
-                    *outp = (*(inp + 0) << 24) | (*(inp + 1) << 16) | (*(inp + 2) << 8) | 0xff;
+            rowFunc = videoRGBARowRGB24;
 #endif
-                    inp += pixelSize;
-                    outp++;
-                }
-            }
+            order = ((pixelFormat == AR_PIXEL_FORMAT_BGR) != destBGRA ? order210 : order012);
             break;
+        case AR_PIXEL_FORMAT_RGBA:
+        case AR_PIXEL_FORMAT_BGRA:
         case AR_PIXEL_FORMAT_ARGB:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destRGBA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | (*(inp + 3) << 16) | (*(inp + 2) << 8) | (*(inp + 1));
-#else
-                    *outp = (*(inp + 1) << 24) | (*(inp + 2) << 16) | (*(inp + 3) << 8) | 0xff;
-#endif
-                    inp += pixelSize;
-                    outp++;
-                }
-            }
-            break;
         case AR_PIXEL_FORMAT_ABGR:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destRGBA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | (*(inp + 1) << 16) | (*(inp + 2) << 8) | (*(inp + 3));
+#if VIDEO_RGBA_ARM_NEON_ROWS
+            rowFunc = (simd ? videoRGBARowRGB32_ARM_neon : videoRGBARowRGB32);
+#elif HAVE_INTEL_SIMD
+            rowFunc = (simd ? videoRGBARowRGB32_Intel_simd : videoRGBARowRGB32);
 #else
-                    *outp = (*(inp + 3) << 24) | (*(inp + 2) << 16) | (*(inp + 1) << 8) | 0xff;
+            rowFunc = videoRGBARowRGB32;
 #endif
-                    inp += pixelSize;
-                    outp++;
-                }
-            }
+            if (pixelFormat == AR_PIXEL_FORMAT_RGBA || pixelFormat == AR_PIXEL_FORMAT_BGRA) order = ((pixelFormat == AR_PIXEL_FORMAT_BGRA) != destBGRA ? order210 : order012);
+            else order = ((pixelFormat == AR_PIXEL_FORMAT_ABGR) != destBGRA ? order321 : order123);
             break;
         case AR_PIXEL_FORMAT_MONO:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destRGBA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | (*inp << 16) | (*inp << 8) | *inp;
+#if VIDEO_RGBA_ARM_NEON_ROWS
+            rowFunc = (simd ? videoRGBARowMono_ARM_neon : videoRGBARowMono);
+#elif HAVE_INTEL_SIMD
+            rowFunc = (simd ? videoRGBARowMono_Intel_simd : videoRGBARowMono);
 #else
-                    *outp = (*inp << 24) | (*inp << 16) | (*inp << 8) | 0xff;
+            rowFunc = videoRGBARowMono;
 #endif
-                    inp++;
-                    outp++;
-                }
-            }
+            order = order012;
             break;
         case AR_PIXEL_FORMAT_RGB_565:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destRGBA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | ((*(inp + 1) & 0x1f) << 19) | ((*(inp + 1) & 0xe0) << 5) | ((*(inp + 0) & 0x07) << 13) | (*(inp + 0) & 0xf8);
+#if VIDEO_RGBA_ARM_NEON_ROWS
+            rowFunc = (simd ? videoRGBARowRGB565_ARM_neon : videoRGBARowRGB565);
+#elif HAVE_INTEL_SIMD
+            rowFunc = (simd ? videoRGBARowRGB565_Intel_simd : videoRGBARowRGB565);
 #else
-                    *outp = ((*(inp + 0) & 0xf8) << 24) | ((*(inp + 0) & 0x07) << 21) | ((*(inp + 1) & 0xe0) << 13) | ((*(inp + 1) & 0x1f) << 11) | 0xff;
+            rowFunc = videoRGBARowRGB565;
 #endif
-                    inp += pixelSize;
-                    outp++;
-                }
-            }
+            order = (destBGRA ? order210 : order012);
             break;
         case AR_PIXEL_FORMAT_RGBA_5551:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destRGBA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | ((*(inp + 1) & 0x3e) << 18) | ((*(inp + 1) & 0xc0) << 5) | ((*(inp + 0) & 0x07) << 13) | (*(inp + 0) & 0xf8);
+#if VIDEO_RGBA_ARM_NEON_ROWS
+            rowFunc = (simd ? videoRGBARowRGBA5551_ARM_neon : videoRGBARowRGBA5551);
+#elif HAVE_INTEL_SIMD
+            rowFunc = (simd ? videoRGBARowRGBA5551_Intel_simd : videoRGBARowRGBA5551);
 #else
-                    *outp = ((*(inp + 0) & 0xf8) << 24) | ((*(inp + 0) & 0x07) << 21) | ((*(inp + 1) & 0xc0) << 13) | ((*(inp + 1) & 0x3e) << 10) | 0xff;
+            rowFunc = videoRGBARowRGBA5551;
 #endif
-                    inp += pixelSize;
-                    outp++;
-                }
-            }
+            order = (destBGRA ? order210 : order012);
             break;
         case AR_PIXEL_FORMAT_RGBA_4444:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destRGBA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | ((*(inp + 1) & 0xf0) << 16) | ((*(inp + 0) & 0x0f) << 12) | (*(inp + 0) & 0xf0);
+#if VIDEO_RGBA_ARM_NEON_ROWS
+            rowFunc = (simd ? videoRGBARowRGBA4444_ARM_neon : videoRGBARowRGBA4444);
+#elif HAVE_INTEL_SIMD
+            rowFunc = (simd ? videoRGBARowRGBA4444_Intel_simd : videoRGBARowRGBA4444);
 #else
-                    *outp = ((*(inp + 0) & 0xf0) << 24) | ((*(inp + 0) & 0x0f) << 20) | ((*(inp + 1) & 0xf0) << 8) | 0xff;
+            rowFunc = videoRGBARowRGBA4444;
 #endif
-                    inp += pixelSize;
-                    outp++;
-                }
-            }
+            order = (destBGRA ? order210 : order012);
+            break;
+        default:
+            return (-1);
+    }
+
+    videoRGBAConvert(rowFunc, order, dest, src, width, height, arUtilGetPixelSize(pixelFormat));
+    return (0);
+}
+int videoRGBA(uint32_t *destRGBA, AR2VideoBufferT *source, int width, int height, AR_PIXEL_FORMAT pixelFormat)
+{
+#if HAVE_ARM_NEON || HAVE_ARM64_NEON
+    bool fastPath;
+#endif
+    
+    if (!destRGBA || !source || width <= 0 || height <= 0 || pixelFormat == AR_PIXEL_FORMAT_INVALID) return (-1); // Sanity check.
+
+#if HAVE_ARM_NEON || HAVE_ARM64_NEON
+    fastPath = (width % 16 == 0 && height % 2 == 0 && videoRGBAHaveSIMD());
+#endif
+    
+    int pixelSize = arUtilGetPixelSize(pixelFormat);
+    switch (pixelFormat) {
+        case AR_PIXEL_FORMAT_RGBA:
+        case AR_PIXEL_FORMAT_BGRA:
+        case AR_PIXEL_FORMAT_ARGB:
+        case AR_PIXEL_FORMAT_ABGR:
+        case AR_PIXEL_FORMAT_RGB:
+        case AR_PIXEL_FORMAT_BGR:
+        case AR_PIXEL_FORMAT_MONO:
+        case AR_PIXEL_FORMAT_RGB_565:
+        case AR_PIXEL_FORMAT_RGBA_5551:
+        case AR_PIXEL_FORMAT_RGBA_4444:
+            videoRGBAConvertPacked((uint8_t *)destRGBA, source->buff, width, height, pixelFormat, false);
             break;
         case AR_PIXEL_FORMAT_420f:
         {
@@ -1310,148 +1778,24 @@ int videoBGRA(uint32_t *destBGRA, AR2VideoBufferT *source, int width, int height
 #endif
     
     if (!destBGRA || !source || width <= 0 || height <= 0 || pixelFormat == AR_PIXEL_FORMAT_INVALID) return (-1); // Sanity check.
-    
+
 #if HAVE_ARM_NEON || HAVE_ARM64_NEON
-    if (width % 16 != 0 || height % 2 != 0) {
-        fastPath = false;
-    } else {
-#  if defined(ANDROID) && HAVE_ARM_NEON
-        if (gHaveARMv7aWithNEON == -1) {
-            // Not all Android devices with ARMv7 are guaranteed to have NEON, so check.
-            uint64_t features = android_getCpuFeatures();
-            gHaveARMv7aWithNEON = (features & ANDROID_CPU_ARM_FEATURE_ARMv7) && (features & ANDROID_CPU_ARM_FEATURE_NEON);
-            ARLOGi("videoRGBA() will%s use ARM NEON acceleration.\n", (gHaveARMv7aWithNEON ? "" : " not"));
-        }
-        fastPath = gHaveARMv7aWithNEON;
-#  else
-        fastPath = true;
-#  endif
-    }
+    fastPath = (width % 16 == 0 && height % 2 == 0 && videoRGBAHaveSIMD());
 #endif
     
     int pixelSize = arUtilGetPixelSize(pixelFormat);
     switch (pixelFormat) {
-        case AR_PIXEL_FORMAT_BGRA:
-        case AR_PIXEL_FORMAT_BGR:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destBGRA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | (*(inp + 2) << 16) | (*(inp + 1) << 8) | (*(inp + 0));
-#else
-                    *outp = (*(inp + 0) << 24) | (*(inp + 1) << 16) | (*(inp + 2) << 8) | 0xff;
-#endif
-                    inp += pixelSize;
-                    outp++;
-                }
-            }
-            break;
         case AR_PIXEL_FORMAT_RGBA:
-        case AR_PIXEL_FORMAT_RGB:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destBGRA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | (*(inp + 0) << 16) | (*(inp + 1) << 8) | (*(inp + 2));
-#else
-                    *outp = (*(inp + 2) << 24) | (*(inp + 1) << 16) | (*(inp + 0) << 8) | 0xff;
-#endif
-                    inp += pixelSize;
-                    outp++;
-                }
-            }
-            break;
+        case AR_PIXEL_FORMAT_BGRA:
         case AR_PIXEL_FORMAT_ARGB:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destBGRA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | (*(inp + 1) << 16) | (*(inp + 2) << 8) | (*(inp + 3));
-#else
-                    *outp = (*(inp + 3) << 24) | (*(inp + 2) << 16) | (*(inp + 1) << 8) | 0xff;
-#endif
-                    inp += pixelSize;
-                    outp++;
-                }
-            }
-            break;
         case AR_PIXEL_FORMAT_ABGR:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destBGRA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | (*(inp + 3) << 16) | (*(inp + 2) << 8) | (*(inp + 1));
-#else
-                    *outp = (*(inp + 1) << 24) | (*(inp + 2) << 16) | (*(inp + 3) << 8) | 0xff;
-#endif
-                    inp += pixelSize;
-                    outp++;
-                }
-            }
-            break;
+        case AR_PIXEL_FORMAT_RGB:
+        case AR_PIXEL_FORMAT_BGR:
         case AR_PIXEL_FORMAT_MONO:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destBGRA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | (*inp << 16) | (*inp << 8) | *inp;
-#else
-                    *outp = (*inp << 24) | (*inp << 16) | (*inp << 8) | 0xff;
-#endif
-                    inp++;
-                    outp++;
-                }
-            }
-            break;
         case AR_PIXEL_FORMAT_RGB_565:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destBGRA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | ((*(inp + 0) & 0xf8) << 19) | ((*(inp + 1) & 0xe0) << 5) | ((*(inp + 0) & 0x07) << 13) | (*(inp + 1) & 0x1f);
-#else
-                    *outp = ((*(inp + 1) & 0x1f) << 24) | ((*(inp + 0) & 0x07) << 21) | ((*(inp + 1) & 0xe0) << 13) | ((*(inp + 0) & 0xf8) << 11) | 0xff;
-#endif
-                    inp += pixelSize;
-                    outp++;
-                }
-            }
-            break;
         case AR_PIXEL_FORMAT_RGBA_5551:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destBGRA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | ((*(inp + 0) & 0xf8) << 18) | ((*(inp + 1) & 0xc0) << 5) | ((*(inp + 0) & 0x07) << 13) | (*(inp + 1) & 0x3e);
-#else
-                    *outp = ((*(inp + 1) & 0x3e) << 24) | ((*(inp + 0) & 0x07) << 21) | ((*(inp + 1) & 0xc0) << 13) | ((*(inp + 0) & 0xf8) << 10) | 0xff;
-#endif
-                    inp += pixelSize;
-                    outp++;
-                }
-            }
-            break;
         case AR_PIXEL_FORMAT_RGBA_4444:
-            for (int y = 0; y < height; y++) {
-                ARUint8 *inp = &(source->buff[width*y*pixelSize]);
-                uint32_t *outp = &destBGRA[width*y];
-                for (int pixelsToGo = width; pixelsToGo > 0; pixelsToGo--) {
-#ifdef AR_LITTLE_ENDIAN
-                    *outp = 0xff000000 | ((*(inp + 0) & 0xf0) << 16) | ((*(inp + 0) & 0x0f) << 12) | (*(inp + 1) & 0xf0);
-#else
-                    *outp = ((*(inp + 1) & 0xf0) << 24) | ((*(inp + 0) & 0x0f) << 20) | ((*(inp + 0) & 0xf0) << 8) | 0xff;
-#endif
-                    inp += pixelSize;
-                    outp++;
-                }
-            }
+            videoRGBAConvertPacked((uint8_t *)destBGRA, source->buff, width, height, pixelFormat, true);
             break;
         case AR_PIXEL_FORMAT_420f:
         {
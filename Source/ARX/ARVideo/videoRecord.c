@@ -0,0 +1,213 @@
+/*
+ *  videoRecord.c
+ *  artoolkitX
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ */
+
+#include <ARX/ARVideo/videoRecord.h>
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+// Frames are large, so give stdio a buffer big enough to hand whole rows of them to the OS at once.
+#define AR_VIDEO_RECORD_STDIO_BUFFER_SIZE (1024*1024)
+
+struct _ARVideoRecorder {
+    char     *path;
+    FILE     *fp;
+    char     *fpBuf;
+    uint64_t  frameCount;
+    int       error;
+};
+
+static const uint8_t zeroes[AR_VIDEO_RECORD_ALIGNMENT] = {0};
+
+static size_t alignUp(size_t size)
+{
+    return ((size + AR_VIDEO_RECORD_ALIGNMENT - 1) / AR_VIDEO_RECORD_ALIGNMENT) * AR_VIDEO_RECORD_ALIGNMENT;
+}
+
+static int writePadded(FILE *fp, const void *data, size_t size)
+{
+    size_t padding = alignUp(size) - size;
+    if (size && fwrite(data, size, 1, fp) != 1) return -1;
+    if (padding && fwrite(zeroes, padding, 1, fp) != 1) return -1;
+    return 0;
+}
+
+static int recorderCreateFile(ARVideoRecorderT *rec)
+{
+    ARVideoRecordFileHeaderT header;
+
+    if (!(rec->fp = fopen(rec->path, "wb"))) {
+        ARLOGe("Error: unable to create video recording file '%s'.\n", rec->path);
+        ARLOGperror(NULL);
+        return -1;
+    }
+    rec->fpBuf = (char *)malloc(AR_VIDEO_RECORD_STDIO_BUFFER_SIZE);
+    if (rec->fpBuf) setvbuf(rec->fp, rec->fpBuf, _IOFBF, AR_VIDEO_RECORD_STDIO_BUFFER_SIZE);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, AR_VIDEO_RECORD_MAGIC, sizeof(AR_VIDEO_RECORD_MAGIC));
+    header.version = AR_VIDEO_RECORD_VERSION;
+    header.byteOrder = AR_VIDEO_RECORD_BYTE_ORDER;
+    header.headerSize = sizeof(ARVideoRecordFileHeaderT);
+    header.frameHeaderSize = sizeof(ARVideoRecordFrameHeaderT);
+    if (fwrite(&header, sizeof(header), 1, rec->fp) != 1) {
+        ARLOGe("Error writing video recording file '%s'.\n", rec->path);
+        return -1;
+    }
+
+    ARLOGi("Recording video to '%s'.\n", rec->path);
+    return 0;
+}
+
+ARVideoRecorderT *arVideoRecorderOpen(const char *path)
+{
+    ARVideoRecorderT *rec;
+
+    if (!path || !*path) return NULL;
+
+    arMallocClear(rec, ARVideoRecorderT, 1);
+    arMalloc(rec->path, char, strlen(path) + 1);
+    strcpy(rec->path, path);
+    return rec;
+}
+
+int arVideoRecorderWriteFrame(ARVideoRecorderT *rec, const AR2VideoBufferT *buffer, int width, int height, int bufWidth, int bufHeight, AR_PIXEL_FORMAT format)
+{
+    ARVideoRecordFrameHeaderT frameHeader;
+    const ARUint8 *planes[AR_VIDEO_RECORD_PLANES_MAX];
+    size_t lumaSize;
+    int biPlanar;
+    int pixelSize;
+    uint32_t i, planesToWrite;
+
+    if (!rec || !buffer || width <= 0 || height <= 0) return -1;
+    if (rec->error) return -1;
+
+    if (!bufWidth) bufWidth = width;
+    if (!bufHeight) bufHeight = height;
+    if (bufWidth < width || bufHeight < height) return -1;
+    if ((pixelSize = arVideoUtilGetPixelSize(format)) == 0) {
+        ARLOGe("Error: unable to record video frames in pixel format %s.\n", arVideoUtilGetPixelFormatName(format));
+        rec->error = 1;
+        return -1;
+    }
+    biPlanar = (format == AR_PIXEL_FORMAT_420v || format == AR_PIXEL_FORMAT_420f || format == AR_PIXEL_FORMAT_NV21);
+    lumaSize = (size_t)bufWidth * bufHeight;
+
+    memset(&frameHeader, 0, sizeof(frameHeader));
+    frameHeader.magic = AR_VIDEO_RECORD_FRAME_MAGIC;
+    frameHeader.format = format;
+    frameHeader.width = width;
+    frameHeader.height = height;
+    frameHeader.bufWidth = bufWidth;
+    frameHeader.bufHeight = bufHeight;
+    frameHeader.timeSec = buffer->time.sec;
+    frameHeader.timeUsec = buffer->time.usec;
+    if (buffer->bufPlaneCount) {
+        if (!biPlanar || buffer->bufPlaneCount != 2 || !buffer->bufPlanes) return -1;
+        frameHeader.planeCount = 2;
+        frameHeader.planeSize[0] = (uint32_t)lumaSize;
+        frameHeader.planeSize[1] = (uint32_t)(lumaSize / 2);
+        planes[0] = buffer->bufPlanes[0];
+        planes[1] = buffer->bufPlanes[1];
+        planesToWrite = 2;
+    } else {
+        if (!buffer->buff) return -1;
+        frameHeader.planeCount = 0;
+        // Bi-planar formats delivered in a single buffer have the chroma plane immediately following the luma plane.
+        frameHeader.planeSize[0] = (uint32_t)(biPlanar ? lumaSize + lumaSize / 2 : lumaSize * pixelSize);
+        planes[0] = buffer->buff;
+        planesToWrite = 1;
+    }
+    frameHeader.recordSize = sizeof(ARVideoRecordFrameHeaderT);
+    for (i = 0; i < planesToWrite; i++) frameHeader.recordSize += alignUp(frameHeader.planeSize[i]);
+
+    if (!rec->fp) {
+        if (recorderCreateFile(rec) < 0) {
+            rec->error = 1;
+            return -1;
+        }
+    }
+
+    if (fwrite(&frameHeader, sizeof(frameHeader), 1, rec->fp) != 1) goto bail;
+    for (i = 0; i < planesToWrite; i++) {
+        if (writePadded(rec->fp, planes[i], frameHeader.planeSize[i]) < 0) goto bail;
+    }
+    rec->frameCount++;
+    return 0;
+
+bail:
+    ARLOGe("Error writing video recording file '%s'. Recording stopped after %llu frames.\n", rec->path, (unsigned long long)rec->frameCount);
+    rec->error = 1;
+    return -1;
+}
+
+uint64_t arVideoRecorderGetFrameCount(ARVideoRecorderT *rec)
+{
+    if (!rec) return 0;
+    return rec->frameCount;
+}
+
+int arVideoRecorderClose(ARVideoRecorderT **rec_p)
+{
+    ARVideoRecorderT *rec;
+    int ret = 0;
+
+    if (!rec_p || !*rec_p) return -1;
+    rec = *rec_p;
+
+    if (rec->fp) {
+        // Patch the final frame count into the file header.
+        if (fflush(rec->fp) != 0 ||
+            fseek(rec->fp, offsetof(ARVideoRecordFileHeaderT, frameCount), SEEK_SET) != 0 ||
+            fwrite(&rec->frameCount, sizeof(rec->frameCount), 1, rec->fp) != 1) {
+            ret = -1;
+        }
+        if (fclose(rec->fp) != 0) ret = -1;
+        if (ret == 0 && !rec->error) {
+            ARLOGi("Recorded %llu video frames to '%s'.\n", (unsigned long long)rec->frameCount, rec->path);
+        } else {
+            ARLOGe("Error completing video recording file '%s'.\n", rec->path);
+            ret = -1;
+        }
+    }
+    free(rec->fpBuf);
+    free(rec->path);
+    free(rec);
+    *rec_p = NULL;
+
+    return ret;
+}
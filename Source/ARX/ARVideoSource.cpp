@@ -262,7 +262,13 @@ bool ARVideoSource::open3(const ARParam *cparam_p)
 #endif
             arParamChangeSize(&cparam, videoWidth, videoHeight, &cparam);
         }
-        if (!(cparamLT = arParamLTCreate(&cparam, AR_PARAM_LT_DEFAULT_OFFSET))) {
+        // If a cache directory is supplied in the environment, share lookup tables between processes and sessions.
+        const char *cacheDir = NULL;
+#ifndef _WINRT
+        cacheDir = getenv("ARTOOLKITX_PARAMLT_CACHE_DIR");
+        if (cacheDir && !cacheDir[0]) cacheDir = NULL;
+#endif
+        if (!(cparamLT = arParamLTCreateCached(&cparam, AR_PARAM_LT_DEFAULT_OFFSET, cacheDir))) {
             ARLOGe("Error: failed to create camera parameters lookup table.\n");
             this->close();
             return false;
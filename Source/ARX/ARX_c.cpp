@@ -57,6 +57,7 @@
 #  include <pthread.h>
 #endif
 #include <inttypes.h>
+#include <ARX/ARUtil/profile.h>
 
 // ----------------------------------------------------------------------------------------------------
 
@@ -68,9 +69,13 @@ static union { unsigned char __c[4]; float __d; } __nan_union = { __nan_bytes };
 
 // ----------------------------------------------------------------------------------------------------
 
-static ARController *gARTK = NULL;
+struct ARWSession {
+    ARController *arController;
+    PFN_TRACKABLEEVENTCALLBACK matrixModeAutoCreatedCallback;
+};
+
+static ARWSession *gSession = NULL; // Session used by the arw* functions which don't take a session parameter.
 static ARVideoSourceInfoListT *gARVideoSourceInfoList = NULL;
-static PFN_TRACKABLEEVENTCALLBACK gMatrixModeAutoCreatedCallback = nullptr;
 
 // ----------------------------------------------------------------------------------------------------
 
@@ -90,18 +95,44 @@ void arwSetLogLevel(const int logLevel)
 #pragma mark  artoolkitX lifecycle functions
 // ----------------------------------------------------------------------------------------------------
 
+ARWSession *arwCreateSession(void)
+{
+    ARWSession *session = new ARWSession;
+    session->arController = new ARController;
+    session->matrixModeAutoCreatedCallback = nullptr;
+    return session;
+}
+
+void arwDeleteSession(ARWSession *session)
+{
+    if (!session) return;
+    delete session->arController; // Delete the artoolkitX instance to initiate shutdown.
+    delete session;
+}
+
 bool arwInitialiseAR()
 {
-    if (!gARTK) gARTK = new ARController;
-	return gARTK->initialiseBase();
+    if (!gSession) gSession = arwCreateSession();
+    return arwSessionInitialiseAR(gSession);
+}
+
+bool arwSessionInitialiseAR(ARWSession *session)
+{
+    if (!session) return false;
+	return session->arController->initialiseBase();
 }
 
 bool arwGetARToolKitVersion(char *buffer, int length)
+{
+    return arwSessionGetARToolKitVersion(gSession, buffer, length);
+}
+
+bool arwSessionGetARToolKitVersion(ARWSession *session, char *buffer, int length)
 {
 	if (!buffer) return false;
-    if (!gARTK) return false;
+    if (!session) return false;
 
-	if (const char *version = gARTK->getARToolKitVersion()) {
+	if (const char *version = session->arController->getARToolKitVersion()) {
 		strncpy(buffer, version, length - 1); buffer[length - 1] = '\0';
 		return true;
 	}
@@ -110,8 +141,13 @@ bool arwGetARToolKitVersion(char *buffer, int length)
 
 int arwGetError()
 {
-    if (!gARTK) return ARX_ERROR_NONE;
-    return gARTK->getError();
+    return arwSessionGetError(gSession);
+}
+
+int arwSessionGetError(ARWSession *session)
+{
+    if (!session) return ARX_ERROR_NONE;
+    return session->arController->getError();
 }
 
 bool arwChangeToResourcesDir(const char *resourcesDirectoryPath)
@@ -135,59 +171,91 @@ bool arwChangeToResourcesDir(const char *resourcesDirectoryPath)
 
 bool arwStartRunning(const char *vconf, const char *cparaName)
 {
-    if (!gARTK) return false;
-	return gARTK->startRunning(vconf, cparaName, NULL, 0);
+    return arwSessionStartRunning(gSession, vconf, cparaName);
+}
+
+bool arwSessionStartRunning(ARWSession *session, const char *vconf, const char *cparaName)
+{
+    if (!session) return false;
+	return session->arController->startRunning(vconf, cparaName, NULL, 0);
 }
 
 bool arwStartRunningB(const char *vconf, const char *cparaBuff, const int cparaBuffLen)
 {
-    if (!gARTK) return false;
-	return gARTK->startRunning(vconf, NULL, cparaBuff, cparaBuffLen);
+    return arwSessionStartRunningB(gSession, vconf, cparaBuff, cparaBuffLen);
+}
+
+bool arwSessionStartRunningB(ARWSession *session, const char *vconf, const char *cparaBuff, const int cparaBuffLen)
+{
+    if (!session) return false;
+	return session->arController->startRunning(vconf, NULL, cparaBuff, cparaBuffLen);
 }
 
 bool arwStartRunningStereo(const char *vconfL, const char *cparaNameL, const char *vconfR, const char *cparaNameR, const char *transL2RName)
 {
-    if (!gARTK) return false;
-	return gARTK->startRunningStereo(vconfL, cparaNameL, NULL, 0L, vconfR, cparaNameR, NULL, 0L, transL2RName, NULL, 0L);
+    return arwSessionStartRunningStereo(gSession, vconfL, cparaNameL, vconfR, cparaNameR, transL2RName);
+}
+
+bool arwSessionStartRunningStereo(ARWSession *session, const char *vconfL, const char *cparaNameL, const char *vconfR, const char *cparaNameR, const char *transL2RName)
+{
+    if (!session) return false;
+	return session->arController->startRunningStereo(vconfL, cparaNameL, NULL, 0L, vconfR, cparaNameR, NULL, 0L, transL2RName, NULL, 0L);
 }
 
 bool arwStartRunningStereoB(const char *vconfL, const char *cparaBuffL, const int cparaBuffLenL, const char *vconfR, const char *cparaBuffR, const int cparaBuffLenR, const char *transL2RBuff, const int transL2RBuffLen)
 {
-    if (!gARTK) return false;
-	return gARTK->startRunningStereo(vconfL, NULL, cparaBuffL, cparaBuffLenL, vconfR, NULL, cparaBuffR, cparaBuffLenR, NULL, transL2RBuff, transL2RBuffLen);
+    return arwSessionStartRunningStereoB(gSession, vconfL, cparaBuffL, cparaBuffLenL, vconfR, cparaBuffR, cparaBuffLenR, transL2RBuff, transL2RBuffLen);
+}
+
+bool arwSessionStartRunningStereoB(ARWSession *session, const char *vconfL, const char *cparaBuffL, const int cparaBuffLenL, const char *vconfR, const char *cparaBuffR, const int cparaBuffLenR, const char *transL2RBuff, const int transL2RBuffLen)
+{
+    if (!session) return false;
+	return session->arController->startRunningStereo(vconfL, NULL, cparaBuffL, cparaBuffLenL, vconfR, NULL, cparaBuffR, cparaBuffLenR, NULL, transL2RBuff, transL2RBuffLen);
 }
 
 bool arwIsRunning()
 {
-    if (!gARTK) return false;
-	return gARTK->isRunning();
+    return arwSessionIsRunning(gSession);
+}
+
+bool arwSessionIsRunning(ARWSession *session)
+{
+    if (!session) return false;
+	return session->arController->isRunning();
 }
 
 bool arwIsInited()
 {
-    if (!gARTK) return false;
-	return gARTK->isInited();
+    return arwSessionIsInited(gSession);
+}
+
+bool arwSessionIsInited(ARWSession *session)
+{
+    if (!session) return false;
+	return session->arController->isInited();
 }
 
 bool arwStopRunning()
 {
-    if (!gARTK) return false;
-	return gARTK->stopRunning();
+    return arwSessionStopRunning(gSession);
+}
+
+bool arwSessionStopRunning(ARWSession *session)
+{
+    if (!session) return false;
+	return session->arController->stopRunning();
 }
 
 bool arwShutdownAR()
 {
-    if (gARTK) {
-        delete gARTK; // Delete the artoolkitX instance to initiate shutdown.
-        gARTK = NULL;
+    if (gSession) {
+        arwDeleteSession(gSession);
+        gSession = NULL;
     }
     if (gARVideoSourceInfoList) {
         free(gARVideoSourceInfoList);
         gARVideoSourceInfoList = nullptr;
     }
-    if (gMatrixModeAutoCreatedCallback) {
-        gMatrixModeAutoCreatedCallback = nullptr;
-    }
 
     return (true);
 }
@@ -199,24 +267,34 @@ bool arwShutdownAR()
 
 bool arwGetProjectionMatrix(const float nearPlane, const float farPlane, float p[16])
 {
-    return arwGetProjectionMatrixStereo(nearPlane, farPlane, p, nullptr);
+    return arwSessionGetProjectionMatrix(gSession, nearPlane, farPlane, p);
+}
+
+bool arwSessionGetProjectionMatrix(ARWSession *session, const float nearPlane, const float farPlane, float p[16])
+{
+    return arwSessionGetProjectionMatrixStereo(session, nearPlane, farPlane, p, nullptr);
 }
 
 bool arwGetProjectionMatrixStereo(const float nearPlane, const float farPlane, float pL[16], float pR[16])
 {
-    if (!gARTK) return false;
+    return arwSessionGetProjectionMatrixStereo(gSession, nearPlane, farPlane, pL, pR);
+}
+
+bool arwSessionGetProjectionMatrixStereo(ARWSession *session, const float nearPlane, const float farPlane, float pL[16], float pR[16])
+{
+    if (!session) return false;
 
 #ifdef ARDOUBLE_IS_FLOAT
-    return ((!pL || gARTK->projectionMatrix(0, nearPlane, farPlane, pL)) && (!pR || gARTK->projectionMatrix(1, nearPlane, farPlane, pR)));
+    return ((!pL || session->arController->projectionMatrix(0, nearPlane, farPlane, pL)) && (!pR || session->arController->projectionMatrix(1, nearPlane, farPlane, pR)));
 #else
     if (pL) {
         ARdouble p0L[16];
-        if (!gARTK->projectionMatrix(0, nearPlane, farPlane, p0L)) return false;
+        if (!session->arController->projectionMatrix(0, nearPlane, farPlane, p0L)) return false;
         for (int i = 0; i < 16; i++) pL[i] = (float)p0L[i];
     }
     if (pR) {
         ARdouble p0R[16];
-        if (!gARTK->projectionMatrix(1, nearPlane, farPlane, p0R)) return false;
+        if (!session->arController->projectionMatrix(1, nearPlane, farPlane, p0R)) return false;
         for (int i = 0; i < 16; i++) pR[i] = (float)p0R[i];
     }
     return true;
@@ -225,10 +303,20 @@ bool arwGetProjectionMatrixStereo(const float nearPlane, const float farPlane, f
 
 ARX_EXTERN bool arwGetProjectionMatrixForViewportSizeAndFittingMode(const int width, const int height, const int scaleMode, const int hAlign, const int vAlign, const float nearPlane, const float farPlane, float p[16])
 {
-    return arwGetProjectionMatrixForViewportSizeAndFittingModeStereo(width, height, scaleMode, hAlign, vAlign, nearPlane, farPlane, p, nullptr);
+    return arwSessionGetProjectionMatrixForViewportSizeAndFittingMode(gSession, width, height, scaleMode, hAlign, vAlign, nearPlane, farPlane, p);
+}
+
+ARX_EXTERN bool arwSessionGetProjectionMatrixForViewportSizeAndFittingMode(ARWSession *session, const int width, const int height, const int scaleMode, const int hAlign, const int vAlign, const float nearPlane, const float farPlane, float p[16])
+{
+    return arwSessionGetProjectionMatrixForViewportSizeAndFittingModeStereo(session, width, height, scaleMode, hAlign, vAlign, nearPlane, farPlane, p, nullptr);
 }
 
 ARX_EXTERN bool arwGetProjectionMatrixForViewportSizeAndFittingModeStereo(const int width, const int height, const int scaleMode, const int hAlign, const int vAlign, const float nearPlane, const float farPlane, float pL[16], float pR[16])
+{
+    return arwSessionGetProjectionMatrixForViewportSizeAndFittingModeStereo(gSession, width, height, scaleMode, hAlign, vAlign, nearPlane, farPlane, pL, pR);
+}
+
+ARX_EXTERN bool arwSessionGetProjectionMatrixForViewportSizeAndFittingModeStereo(ARWSession *session, const int width, const int height, const int scaleMode, const int hAlign, const int vAlign, const float nearPlane, const float farPlane, float pL[16], float pR[16])
 {
     ARVideoSource::ScalingMode s;
     switch (scaleMode) {
@@ -238,16 +326,16 @@ ARX_EXTERN bool arwGetProjectionMatrixForViewportSizeAndFittingModeStereo(const
         default /*ARW_SCALE_MODE_STRETCH*/: s = ARVideoSource::ScalingMode::SCALE_MODE_STRETCH; break;
     }
 #ifdef ARDOUBLE_IS_FLOAT
-    return ((!pL || gARTK->projectionForViewportSizeAndFittingMode(0, {width, height}, s, nearPlane, farPlane, pL)) && (!pR || gARTK->projectionForViewportSizeAndFittingMode(1, {width, height}, s, nearPlane, farPlane, pR)));
+    return ((!pL || session->arController->projectionForViewportSizeAndFittingMode(0, {width, height}, s, nearPlane, farPlane, pL)) && (!pR || session->arController->projectionForViewportSizeAndFittingMode(1, {width, height}, s, nearPlane, farPlane, pR)));
 #else
     if (pL) {
         ARdouble p0L[16];
-        if (!gARTK->projectionForViewportSizeAndFittingMode(0, {width, height}, s, nearPlane, farPlane, p0L)) return false;
+        if (!session->arController->projectionForViewportSizeAndFittingMode(0, {width, height}, s, nearPlane, farPlane, p0L)) return false;
         for (int i = 0; i < 16; i++) pL[i] = (float)p0L[i];
     }
     if (pR) {
         ARdouble p0R[16];
-        if (!gARTK->projectionForViewportSizeAndFittingMode(1, {width, height}, s, nearPlane, farPlane, p0R)) return false;
+        if (!session->arController->projectionForViewportSizeAndFittingMode(1, {width, height}, s, nearPlane, farPlane, p0R)) return false;
         for (int i = 0; i < 16; i++) pR[i] = (float)p0R[i];
     }
     return true;
@@ -255,11 +343,16 @@ ARX_EXTERN bool arwGetProjectionMatrixForViewportSizeAndFittingModeStereo(const
 }
 
 bool arwGetVideoParams(int *width, int *height, int *pixelSize, char *pixelFormatStringBuffer, int pixelFormatStringBufferLen)
+{
+    return arwSessionGetVideoParams(gSession, width, height, pixelSize, pixelFormatStringBuffer, pixelFormatStringBufferLen);
+}
+
+bool arwSessionGetVideoParams(ARWSession *session, int *width, int *height, int *pixelSize, char *pixelFormatStringBuffer, int pixelFormatStringBufferLen)
 {
     AR_PIXEL_FORMAT pf;
 
-    if (!gARTK) return false;
-	if (!gARTK->videoParameters(0, width, height, &pf)) return false;
+    if (!session) return false;
+	if (!session->arController->videoParameters(0, width, height, &pf)) return false;
     if (pixelSize) *pixelSize = arUtilGetPixelSize(pf);
     if (pixelFormatStringBuffer && pixelFormatStringBufferLen > 0) {
         strncpy(pixelFormatStringBuffer, arUtilGetPixelFormatName(pf), pixelFormatStringBufferLen);
@@ -269,16 +362,21 @@ bool arwGetVideoParams(int *width, int *height, int *pixelSize, char *pixelForma
 }
 
 bool arwGetVideoParamsStereo(int *widthL, int *heightL, int *pixelSizeL, char *pixelFormatStringBufferL, int pixelFormatStringBufferLenL, int *widthR, int *heightR, int *pixelSizeR, char *pixelFormatStringBufferR, int pixelFormatStringBufferLenR)
+{
+    return arwSessionGetVideoParamsStereo(gSession, widthL, heightL, pixelSizeL, pixelFormatStringBufferL, pixelFormatStringBufferLenL, widthR, heightR, pixelSizeR, pixelFormatStringBufferR, pixelFormatStringBufferLenR);
+}
+
+bool arwSessionGetVideoParamsStereo(ARWSession *session, int *widthL, int *heightL, int *pixelSizeL, char *pixelFormatStringBufferL, int pixelFormatStringBufferLenL, int *widthR, int *heightR, int *pixelSizeR, char *pixelFormatStringBufferR, int pixelFormatStringBufferLenR)
 {
     AR_PIXEL_FORMAT pfL, pfR;
 
-    if (!gARTK) return false;
+    if (!session) return false;
     if (widthL || heightL || pixelSizeL) {
-        if (!gARTK->videoParameters(0, widthL, heightL, &pfL)) return false;
+        if (!session->arController->videoParameters(0, widthL, heightL, &pfL)) return false;
         if (pixelSizeL) *pixelSizeL = arUtilGetPixelSize(pfL);
     }
     if (widthR || heightR || pixelSizeR) {
-        if (!gARTK->videoParameters(1, widthR, heightR, &pfR)) return false;
+        if (!session->arController->videoParameters(1, widthR, heightR, &pfR)) return false;
         if (pixelSizeR) *pixelSizeR = arUtilGetPixelSize(pfR);
     }
     if (pixelFormatStringBufferL && pixelFormatStringBufferLenL > 0) {
@@ -294,32 +392,52 @@ bool arwGetVideoParamsStereo(int *widthL, int *heightL, int *pixelSizeL, char *p
 
 bool arwCapture()
 {
-    if (!gARTK) return false;
-    return (gARTK->capture());
+    return arwSessionCapture(gSession);
+}
+
+bool arwSessionCapture(ARWSession *session)
+{
+    if (!session) return false;
+    return (session->arController->capture());
 }
 
 bool arwUpdateAR()
 {
-    if (!gARTK) return false;
-    return gARTK->update();
+    return arwSessionUpdateAR(gSession);
+}
+
+bool arwSessionUpdateAR(ARWSession *session)
+{
+    if (!session) return false;
+    return session->arController->update();
 }
 
 bool arwUpdateTexture32(uint32_t *buffer)
 {
-    if (!gARTK) return false;
-    return gARTK->updateTextureRGBA32(0, buffer);
+    return arwSessionUpdateTexture32(gSession, buffer);
+}
+
+bool arwSessionUpdateTexture32(ARWSession *session, uint32_t *buffer)
+{
+    if (!session) return false;
+    return session->arController->updateTextureRGBA32(0, buffer);
 }
 
 bool arwUpdateTexture32Stereo(uint32_t *bufferL, uint32_t *bufferR)
 {
-    if (!gARTK) return false;
+    return arwSessionUpdateTexture32Stereo(gSession, bufferL, bufferR);
+}
+
+bool arwSessionUpdateTexture32Stereo(ARWSession *session, uint32_t *bufferL, uint32_t *bufferR)
+{
+    if (!session) return false;
     if (bufferL) {
-        if (!gARTK->updateTextureRGBA32(0, bufferL)) {
+        if (!session->arController->updateTextureRGBA32(0, bufferL)) {
             return false;
         }
     }
     if (bufferR) {
-        if (!gARTK->updateTextureRGBA32(1, bufferR)) {
+        if (!session->arController->updateTextureRGBA32(1, bufferR)) {
             return false;
         }
     }
@@ -331,28 +449,38 @@ bool arwUpdateTexture32Stereo(uint32_t *bufferL, uint32_t *bufferR)
 // ----------------------------------------------------------------------------------------------------
 int arwVideoPushInit(int videoSourceIndex, int width, int height, const char *pixelFormat, int cameraIndex, int cameraPosition)
 {
-    if (!gARTK) return -1;
+    return arwSessionVideoPushInit(gSession, videoSourceIndex, width, height, pixelFormat, cameraIndex, cameraPosition);
+}
+
+int arwSessionVideoPushInit(ARWSession *session, int videoSourceIndex, int width, int height, const char *pixelFormat, int cameraIndex, int cameraPosition)
+{
+    if (!session) return -1;
 
-    return (gARTK->videoPushInit(videoSourceIndex, width, height, pixelFormat, cameraIndex, cameraPosition));
+    return (session->arController->videoPushInit(videoSourceIndex, width, height, pixelFormat, cameraIndex, cameraPosition));
+}
+
+int arwVideoPush(int videoSourceIndex, uint8_t *buf0p, int buf0Size, int buf0PixelStride, int buf0RowStride, uint8_t *buf1p, int buf1Size, int buf1PixelStride, int buf1RowStride, uint8_t *buf2p, int buf2Size, int buf2PixelStride, int buf2RowStride, uint8_t *buf3p, int buf3Size, int buf3PixelStride, int buf3RowStride, PFN_VIDEOPUSHRELEASECALLBACK releaseCallback, void *releaseCallbackUserdata)
+{
+    return arwSessionVideoPush(gSession, videoSourceIndex, buf0p, buf0Size, buf0PixelStride, buf0RowStride, buf1p, buf1Size, buf1PixelStride, buf1RowStride, buf2p, buf2Size, buf2PixelStride, buf2RowStride, buf3p, buf3Size, buf3PixelStride, buf3RowStride, releaseCallback, releaseCallbackUserdata);
 }
 
-int arwVideoPush(int videoSourceIndex,
-                uint8_t *buf0p, int buf0Size, int buf0PixelStride, int buf0RowStride,
-                uint8_t *buf1p, int buf1Size, int buf1PixelStride, int buf1RowStride,
-                uint8_t *buf2p, int buf2Size, int buf2PixelStride, int buf2RowStride,
-                uint8_t *buf3p, int buf3Size, int buf3PixelStride, int buf3RowStride,
-                PFN_VIDEOPUSHRELEASECALLBACK releaseCallback, void *releaseCallbackUserdata)
+int arwSessionVideoPush(ARWSession *session, int videoSourceIndex, uint8_t *buf0p, int buf0Size, int buf0PixelStride, int buf0RowStride, uint8_t *buf1p, int buf1Size, int buf1PixelStride, int buf1RowStride, uint8_t *buf2p, int buf2Size, int buf2PixelStride, int buf2RowStride, uint8_t *buf3p, int buf3Size, int buf3PixelStride, int buf3RowStride, PFN_VIDEOPUSHRELEASECALLBACK releaseCallback, void *releaseCallbackUserdata)
 {
-    if (!gARTK) return -1;
+    if (!session) return -1;
 
-    return (gARTK->videoPush(videoSourceIndex, buf0p, buf0Size, buf0PixelStride, buf0RowStride, buf1p, buf1Size, buf1PixelStride, buf1RowStride, buf2p, buf2Size, buf2PixelStride, buf2RowStride, buf3p, buf3Size, buf3PixelStride, buf3RowStride, releaseCallback, releaseCallbackUserdata));
+    return (session->arController->videoPush(videoSourceIndex, buf0p, buf0Size, buf0PixelStride, buf0RowStride, buf1p, buf1Size, buf1PixelStride, buf1RowStride, buf2p, buf2Size, buf2PixelStride, buf2RowStride, buf3p, buf3Size, buf3PixelStride, buf3RowStride, releaseCallback, releaseCallbackUserdata));
 }
 
 int arwVideoPushFinal(int videoSourceIndex)
 {
-    if (!gARTK) return -1;
+    return arwSessionVideoPushFinal(gSession, videoSourceIndex);
+}
+
+int arwSessionVideoPushFinal(ARWSession *session, int videoSourceIndex)
+{
+    if (!session) return -1;
 
-    return (gARTK->videoPushFinal(videoSourceIndex));
+    return (session->arController->videoPushFinal(videoSourceIndex));
 }
 
 // ----------------------------------------------------------------------------------------------------
@@ -360,30 +488,50 @@ int arwVideoPushFinal(int videoSourceIndex)
 // ----------------------------------------------------------------------------------------------------
 bool arwDrawVideoInit(const int videoSourceIndex)
 {
-    if (!gARTK) return false;
+    return arwSessionDrawVideoInit(gSession, videoSourceIndex);
+}
+
+bool arwSessionDrawVideoInit(ARWSession *session, const int videoSourceIndex)
+{
+    if (!session) return false;
 
-    return (gARTK->drawVideoInit(videoSourceIndex));
+    return (session->arController->drawVideoInit(videoSourceIndex));
 }
 
 bool arwDrawVideoSettings(int videoSourceIndex, int width, int height, bool rotate90, bool flipH, bool flipV, int hAlign, int vAlign, int scalingMode, int32_t viewport[4])
 {
-    if (!gARTK)return false;
+    return arwSessionDrawVideoSettings(gSession, videoSourceIndex, width, height, rotate90, flipH, flipV, hAlign, vAlign, scalingMode, viewport);
+}
+
+bool arwSessionDrawVideoSettings(ARWSession *session, int videoSourceIndex, int width, int height, bool rotate90, bool flipH, bool flipV, int hAlign, int vAlign, int scalingMode, int32_t viewport[4])
+{
+    if (!session)return false;
 
-    return (gARTK->drawVideoSettings(videoSourceIndex, width, height, rotate90, flipH, flipV, (ARVideoView::HorizontalAlignment)hAlign, (ARVideoView::VerticalAlignment)vAlign, (ARVideoView::ScalingMode)scalingMode, viewport));
+    return (session->arController->drawVideoSettings(videoSourceIndex, width, height, rotate90, flipH, flipV, (ARVideoView::HorizontalAlignment)hAlign, (ARVideoView::VerticalAlignment)vAlign, (ARVideoView::ScalingMode)scalingMode, viewport));
 }
 
 bool arwDrawVideo(const int videoSourceIndex)
 {
-    if (!gARTK)return false;
+    return arwSessionDrawVideo(gSession, videoSourceIndex);
+}
 
-    return (gARTK->drawVideo(videoSourceIndex));
+bool arwSessionDrawVideo(ARWSession *session, const int videoSourceIndex)
+{
+    if (!session)return false;
+
+    return (session->arController->drawVideo(videoSourceIndex));
 }
 
 bool arwDrawVideoFinal(const int videoSourceIndex)
 {
-    if (!gARTK) return false;
+    return arwSessionDrawVideoFinal(gSession, videoSourceIndex);
+}
 
-    return (gARTK->drawVideoFinal(videoSourceIndex));
+bool arwSessionDrawVideoFinal(ARWSession *session, const int videoSourceIndex)
+{
+    if (!session) return false;
+
+    return (session->arController->drawVideoFinal(videoSourceIndex));
 }
 
 // ----------------------------------------------------------------------------------------------------
@@ -392,45 +540,59 @@ bool arwDrawVideoFinal(const int videoSourceIndex)
 
 void arwSetTrackerOptionBool(int option, bool value)
 {
-    if (!gARTK) return;
+    arwSessionSetTrackerOptionBool(gSession, option, value);
+}
+
+void arwSessionSetTrackerOptionBool(ARWSession *session, int option, bool value)
+{
+    if (!session) return;
 
     if (option == ARW_TRACKER_OPTION_SQUARE_MATRIX_MODE_AUTOCREATE_NEW_TRACKABLES) {
-        gARTK->getSquareTracker()->setMatrixModeAutoCreateNewTrackables(value);
+        session->arController->getSquareTracker()->setMatrixModeAutoCreateNewTrackables(value);
     } else if (option == ARW_TRACKER_OPTION_NFT_MULTIMODE) {
 #if HAVE_NFT
-        gARTK->getNFTTracker()->setNFTMultiMode(value);
+        session->arController->getNFTTracker()->setNFTMultiMode(value);
 #endif
         return;
     } else if (option == ARW_TRACKER_OPTION_SQUARE_DEBUG_MODE) {
-        gARTK->getSquareTracker()->setDebugMode(value);
+        session->arController->getSquareTracker()->setDebugMode(value);
     } else if (option == ARW_TRACKER_OPTION_2D_THREADED) {
 #if HAVE_2D
-        gARTK->get2dTracker()->setThreaded(value);
+        session->arController->get2dTracker()->setThreaded(value);
 #endif
+    } else if (option == ARW_TRACKER_OPTION_PARALLEL_TRACKER_UPDATE) {
+        session->arController->setParallelTrackerUpdate(value);
     }
 }
 
 void arwSetTrackerOptionInt(int option, int value)
 {
-    if (!gARTK) return;
+    arwSessionSetTrackerOptionInt(gSession, option, value);
+}
+
+void arwSessionSetTrackerOptionInt(ARWSession *session, int option, int value)
+{
+    if (!session) return;
 
     if (option == ARW_TRACKER_OPTION_SQUARE_THRESHOLD) {
         if (value < 0 || value > 255) return;
-        gARTK->getSquareTracker()->setThreshold(value);
+        session->arController->getSquareTracker()->setThreshold(value);
     } else if (option == ARW_TRACKER_OPTION_SQUARE_THRESHOLD_MODE) {
-        gARTK->getSquareTracker()->setThresholdMode((AR_LABELING_THRESH_MODE)value);
+        session->arController->getSquareTracker()->setThresholdMode((AR_LABELING_THRESH_MODE)value);
     } else if (option == ARW_TRACKER_OPTION_SQUARE_LABELING_MODE) {
-        gARTK->getSquareTracker()->setLabelingMode(value);
+        session->arController->getSquareTracker()->setLabelingMode(value);
+    } else if (option == ARW_TRACKER_OPTION_SQUARE_LABELING_THREAD_COUNT) {
+        session->arController->getSquareTracker()->setLabelingThreadCount(value);
     } else if (option == ARW_TRACKER_OPTION_SQUARE_PATTERN_DETECTION_MODE) {
-        gARTK->getSquareTracker()->setPatternDetectionMode(value);
+        session->arController->getSquareTracker()->setPatternDetectionMode(value);
     } else if (option == ARW_TRACKER_OPTION_SQUARE_MATRIX_CODE_TYPE) {
-        gARTK->getSquareTracker()->setMatrixCodeType((AR_MATRIX_CODE_TYPE)value);
+        session->arController->getSquareTracker()->setMatrixCodeType((AR_MATRIX_CODE_TYPE)value);
     } else if (option == ARW_TRACKER_OPTION_SQUARE_IMAGE_PROC_MODE) {
-        gARTK->getSquareTracker()->setImageProcMode(value);
+        session->arController->getSquareTracker()->setImageProcMode(value);
     } else if (option == ARW_TRACKER_OPTION_SQUARE_PATTERN_SIZE) {
-        gARTK->getSquareTracker()->setPatternSize(value);
+        session->arController->getSquareTracker()->setPatternSize(value);
     } else if (option == ARW_TRACKER_OPTION_SQUARE_PATTERN_COUNT_MAX) {
-        gARTK->getSquareTracker()->setPatternCountMax(value);
+        session->arController->getSquareTracker()->setPatternCountMax(value);
     } else if (option == ARW_TRACKER_OPTION_2D_TRACKER_FEATURE_TYPE) {
 #if HAVE_2D
         PlanarTracker::FeatureDetectorType type;
@@ -442,71 +604,90 @@ void arwSetTrackerOptionInt(int option, int value)
             case 4: type = PlanarTracker::FeatureDetectorType::SIFT; break;
             default: return;
         }
-        gARTK->get2dTracker()->setDetectorType(type);
+        session->arController->get2dTracker()->setDetectorType(type);
 #endif
     } else if (option == ARW_TRACKER_OPTION_2D_MAXIMUM_MARKERS_TO_TRACK) {
 #if HAVE_2D
-        gARTK->get2dTracker()->setMaxMarkersToTrack(value);
+        session->arController->get2dTracker()->setMaxMarkersToTrack(value);
 #endif
     }
 }
 
 void arwSetTrackerOptionFloat(int option, float value)
 {
-    if (!gARTK) return;
+    arwSessionSetTrackerOptionFloat(gSession, option, value);
+}
+
+void arwSessionSetTrackerOptionFloat(ARWSession *session, int option, float value)
+{
+    if (!session) return;
 
     if (option == ARW_TRACKER_OPTION_SQUARE_BORDER_SIZE) {
         if (value <= 0.0f || value >= 0.5f) return;
-        gARTK->getSquareTracker()->setPattRatio(1.0f - 2.0f*value); // Convert from border size to pattern ratio.
+        session->arController->getSquareTracker()->setPattRatio(1.0f - 2.0f*value); // Convert from border size to pattern ratio.
     } else if (option == ARW_TRACKER_OPTION_SQUARE_MATRIX_MODE_AUTOCREATE_NEW_TRACKABLES_DEFAULT_WIDTH) {
         if (value <= 0.0f) return;
-        gARTK->getSquareTracker()->setMatrixModeAutoCreateNewTrackablesDefaultWidth(value);
+        session->arController->getSquareTracker()->setMatrixModeAutoCreateNewTrackablesDefaultWidth(value);
     }
 }
 
 bool arwGetTrackerOptionBool(int option)
 {
-    if (!gARTK) return false;
+    return arwSessionGetTrackerOptionBool(gSession, option);
+}
+
+bool arwSessionGetTrackerOptionBool(ARWSession *session, int option)
+{
+    if (!session) return false;
 
     if (option == ARW_TRACKER_OPTION_SQUARE_MATRIX_MODE_AUTOCREATE_NEW_TRACKABLES) {
-        return gARTK->getSquareTracker()->matrixModeAutoCreateNewTrackables();
+        return session->arController->getSquareTracker()->matrixModeAutoCreateNewTrackables();
     } else if (option == ARW_TRACKER_OPTION_NFT_MULTIMODE) {
 #if HAVE_NFT
-        return  gARTK->getNFTTracker()->NFTMultiMode();
+        return  session->arController->getNFTTracker()->NFTMultiMode();
 #endif
     } else if (option == ARW_TRACKER_OPTION_SQUARE_DEBUG_MODE) {
-        return gARTK->getSquareTracker()->debugMode();
+        return session->arController->getSquareTracker()->debugMode();
     } else if (option == ARW_TRACKER_OPTION_2D_THREADED) {
 #if HAVE_2D
-        return gARTK->get2dTracker()->threaded();
+        return session->arController->get2dTracker()->threaded();
 #endif
+    } else if (option == ARW_TRACKER_OPTION_PARALLEL_TRACKER_UPDATE) {
+        return session->arController->parallelTrackerUpdate();
     }
     return false;
 }
 
 int arwGetTrackerOptionInt(int option)
 {
-    if (!gARTK) return (INT_MAX);
+    return arwSessionGetTrackerOptionInt(gSession, option);
+}
+
+int arwSessionGetTrackerOptionInt(ARWSession *session, int option)
+{
+    if (!session) return (INT_MAX);
 
     if (option == ARW_TRACKER_OPTION_SQUARE_THRESHOLD) {
-        return gARTK->getSquareTracker()->threshold();
+        return session->arController->getSquareTracker()->threshold();
     } else if (option == ARW_TRACKER_OPTION_SQUARE_THRESHOLD_MODE) {
-        return gARTK->getSquareTracker()->thresholdMode();
+        return session->arController->getSquareTracker()->thresholdMode();
     } else if (option == ARW_TRACKER_OPTION_SQUARE_LABELING_MODE) {
-        return (int)gARTK->getSquareTracker()->labelingMode();
+        return (int)session->arController->getSquareTracker()->labelingMode();
+    } else if (option == ARW_TRACKER_OPTION_SQUARE_LABELING_THREAD_COUNT) {
+        return session->arController->getSquareTracker()->labelingThreadCount();
     } else if (option == ARW_TRACKER_OPTION_SQUARE_PATTERN_DETECTION_MODE) {
-        return gARTK->getSquareTracker()->patternDetectionMode();
+        return session->arController->getSquareTracker()->patternDetectionMode();
     } else if (option == ARW_TRACKER_OPTION_SQUARE_MATRIX_CODE_TYPE) {
-        return (int)gARTK->getSquareTracker()->matrixCodeType();
+        return (int)session->arController->getSquareTracker()->matrixCodeType();
     } else if (option == ARW_TRACKER_OPTION_SQUARE_IMAGE_PROC_MODE) {
-        return gARTK->getSquareTracker()->imageProcMode();
+        return session->arController->getSquareTracker()->imageProcMode();
     } else if (option == ARW_TRACKER_OPTION_SQUARE_PATTERN_SIZE) {
-        return gARTK->getSquareTracker()->patternSize();
+        return session->arController->getSquareTracker()->patternSize();
     } else if (option == ARW_TRACKER_OPTION_SQUARE_PATTERN_COUNT_MAX) {
-        return gARTK->getSquareTracker()->patternCountMax();
+        return session->arController->getSquareTracker()->patternCountMax();
     } else if (option == ARW_TRACKER_OPTION_2D_TRACKER_FEATURE_TYPE) {
 #if HAVE_2D
-        PlanarTracker::FeatureDetectorType type = gARTK->get2dTracker()->getDetectorType();
+        PlanarTracker::FeatureDetectorType type = session->arController->get2dTracker()->getDetectorType();
         switch (type) {
             case PlanarTracker::FeatureDetectorType::Akaze: return 0;
             case PlanarTracker::FeatureDetectorType::ORB: return 1;
@@ -518,7 +699,7 @@ int arwGetTrackerOptionInt(int option)
 #endif
     } else if (option == ARW_TRACKER_OPTION_2D_MAXIMUM_MARKERS_TO_TRACK) {
 #if HAVE_2D
-        return gARTK->get2dTracker()->getMaxMarkersToTrack();
+        return session->arController->get2dTracker()->getMaxMarkersToTrack();
 #endif
     }
     return (INT_MAX);
@@ -526,13 +707,18 @@ int arwGetTrackerOptionInt(int option)
 
 float arwGetTrackerOptionFloat(int option)
 {
-    if (!gARTK) return (NAN);
+    return arwSessionGetTrackerOptionFloat(gSession, option);
+}
+
+float arwSessionGetTrackerOptionFloat(ARWSession *session, int option)
+{
+    if (!session) return (NAN);
 
     if (option == ARW_TRACKER_OPTION_SQUARE_BORDER_SIZE) {
-        float value = gARTK->getSquareTracker()->pattRatio();
+        float value = session->arController->getSquareTracker()->pattRatio();
         if (value > 0.0f && value < 1.0f) return (1.0f - value)/2.0f; // Convert from pattern ratio to border size.
     } else if (option == ARW_TRACKER_OPTION_SQUARE_MATRIX_MODE_AUTOCREATE_NEW_TRACKABLES_DEFAULT_WIDTH) {
-        return gARTK->getSquareTracker()->matrixModeAutoCreateNewTrackablesDefaultWidth();
+        return session->arController->getSquareTracker()->matrixModeAutoCreateNewTrackablesDefaultWidth();
     }
     return (NAN);
 }
@@ -541,36 +727,57 @@ float arwGetTrackerOptionFloat(int option)
 #pragma mark  Trackable management
 // ---------------------------------------------------------------------------------------------
 
-static void matrixModeAutoCreatedShim(const ARTrackableSquare& trackable)
+static void matrixModeAutoCreatedShim(const ARTrackableSquare& trackable, void *userdata)
 {
-    if (gMatrixModeAutoCreatedCallback) (*gMatrixModeAutoCreatedCallback)(ARW_TRACKABLE_EVENT_TYPE_AUTOCREATED, trackable.UID);
+    ARWSession *session = (ARWSession *)userdata;
+    if (session->matrixModeAutoCreatedCallback) (*session->matrixModeAutoCreatedCallback)(ARW_TRACKABLE_EVENT_TYPE_AUTOCREATED, trackable.UID);
 }
 
 void arwRegisterTrackableEventCallback(PFN_TRACKABLEEVENTCALLBACK callback)
 {
-    if (!gARTK) return;
-    gMatrixModeAutoCreatedCallback = callback;
-    gARTK->getSquareTracker()->setMatrixModeAutoCreateNewTrackablesCallback(callback ? matrixModeAutoCreatedShim : nullptr);
+    arwSessionRegisterTrackableEventCallback(gSession, callback);
+}
+
+void arwSessionRegisterTrackableEventCallback(ARWSession *session, PFN_TRACKABLEEVENTCALLBACK callback)
+{
+    if (!session) return;
+    session->matrixModeAutoCreatedCallback = callback;
+    session->arController->getSquareTracker()->setMatrixModeAutoCreateNewTrackablesCallback(callback ? matrixModeAutoCreatedShim : nullptr, session);
 }
 
 int arwAddTrackable(const char *cfg)
 {
-    if (!gARTK) return -1;
-	return gARTK->addTrackable(cfg);
+    return arwSessionAddTrackable(gSession, cfg);
+}
+
+int arwSessionAddTrackable(ARWSession *session, const char *cfg)
+{
+    if (!session) return -1;
+	return session->arController->addTrackable(cfg);
 }
 
 int arwGetTrackableCount(void)
 {
-    if (!gARTK) return -1;
-    return gARTK->countTrackables();
+    return arwSessionGetTrackableCount(gSession);
+}
+
+int arwSessionGetTrackableCount(ARWSession *session)
+{
+    if (!session) return -1;
+    return session->arController->countTrackables();
 }
 
 bool arwGetTrackableStatuses(ARWTrackableStatus *statuses, int statusesCount)
 {
-    if (!gARTK) return false;
+    return arwSessionGetTrackableStatuses(gSession, statuses, statusesCount);
+}
+
+bool arwSessionGetTrackableStatuses(ARWSession *session, ARWTrackableStatus *statuses, int statusesCount)
+{
+    if (!session) return false;
     if (!statuses || statusesCount < 1) return false;
 
-    std::vector<std::shared_ptr<ARTrackable>> trackables = gARTK->getAllTrackables();
+    std::vector<std::shared_ptr<ARTrackable>> trackables = session->arController->getAllTrackables();
     int i = 0;
     std::vector<std::shared_ptr<ARTrackable>>::iterator it = trackables.begin();
     while (i < statusesCount && it != trackables.end()) {
@@ -592,36 +799,61 @@ bool arwGetTrackableStatuses(ARWTrackableStatus *statuses, int statusesCount)
 
 bool arwRemoveTrackable(int trackableUID)
 {
-    if (!gARTK) return false;
-	return gARTK->removeTrackable(trackableUID);
+    return arwSessionRemoveTrackable(gSession, trackableUID);
+}
+
+bool arwSessionRemoveTrackable(ARWSession *session, int trackableUID)
+{
+    if (!session) return false;
+	return session->arController->removeTrackable(trackableUID);
 }
 
 int arwRemoveAllTrackables()
 {
-    if (!gARTK) return 0;
-	return gARTK->removeAllTrackables();
+    return arwSessionRemoveAllTrackables(gSession);
+}
+
+int arwSessionRemoveAllTrackables(ARWSession *session)
+{
+    if (!session) return 0;
+	return session->arController->removeAllTrackables();
 }
 
 #if HAVE_2D
 bool arwLoad2dTrackableDatabase(const char *databaseFileName)
 {
-    if (!gARTK) return false;
-    return gARTK->load2DTrackerImageDatabase(databaseFileName);
+    return arwSessionLoad2dTrackableDatabase(gSession, databaseFileName);
+}
+
+bool arwSessionLoad2dTrackableDatabase(ARWSession *session, const char *databaseFileName)
+{
+    if (!session) return false;
+    return session->arController->load2DTrackerImageDatabase(databaseFileName);
 }
 
 bool arwSave2dTrackableDatabase(const char *databaseFileName)
 {
-    if (!gARTK) return false;
-    return gARTK->save2DTrackerImageDatabase(databaseFileName);
+    return arwSessionSave2dTrackableDatabase(gSession, databaseFileName);
+}
+
+bool arwSessionSave2dTrackableDatabase(ARWSession *session, const char *databaseFileName)
+{
+    if (!session) return false;
+    return session->arController->save2DTrackerImageDatabase(databaseFileName);
 }
 #endif // HAVE_2D
 
 bool arwQueryTrackableVisibilityAndTransformation(int trackableUID, float matrix[16])
+{
+    return arwSessionQueryTrackableVisibilityAndTransformation(gSession, trackableUID, matrix);
+}
+
+bool arwSessionQueryTrackableVisibilityAndTransformation(ARWSession *session, int trackableUID, float matrix[16])
 {
     std::shared_ptr<ARTrackable> trackable;
 
-    if (!gARTK) return false;
-	if (!(trackable = gARTK->findTrackable(trackableUID))) {
+    if (!session) return false;
+	if (!(trackable = session->arController->findTrackable(trackableUID))) {
         ARLOGe("arwQueryTrackableVisibilityAndTransformation(): Couldn't locate trackable with UID %d.\n", trackableUID);
         return false;
     }
@@ -630,11 +862,16 @@ bool arwQueryTrackableVisibilityAndTransformation(int trackableUID, float matrix
 }
 
 bool arwQueryTrackableVisibilityAndTransformationStereo(int trackableUID, float matrixL[16], float matrixR[16])
+{
+    return arwSessionQueryTrackableVisibilityAndTransformationStereo(gSession, trackableUID, matrixL, matrixR);
+}
+
+bool arwSessionQueryTrackableVisibilityAndTransformationStereo(ARWSession *session, int trackableUID, float matrixL[16], float matrixR[16])
 {
     std::shared_ptr<ARTrackable> trackable;
 
-    if (!gARTK) return false;
-	if (!(trackable = gARTK->findTrackable(trackableUID))) {
+    if (!session) return false;
+	if (!(trackable = session->arController->findTrackable(trackableUID))) {
         ARLOGe("arwQueryTrackableVisibilityAndTransformationStereo(): Couldn't locate trackable with UID %d.\n", trackableUID);
         return false;
     }
@@ -648,11 +885,16 @@ bool arwQueryTrackableVisibilityAndTransformationStereo(int trackableUID, float
 // ---------------------------------------------------------------------------------------------
 
 int arwGetTrackablePatternCount(int trackableUID)
+{
+    return arwSessionGetTrackablePatternCount(gSession, trackableUID);
+}
+
+int arwSessionGetTrackablePatternCount(ARWSession *session, int trackableUID)
 {
     std::shared_ptr<ARTrackable> trackable;
 
-    if (!gARTK) return 0;
-	if (!(trackable = gARTK->findTrackable(trackableUID))) {
+    if (!session) return 0;
+	if (!(trackable = session->arController->findTrackable(trackableUID))) {
         ARLOGe("arwGetTrackablePatternCount(): Couldn't locate trackable with UID %d.\n", trackableUID);
         return 0;
     }
@@ -660,11 +902,16 @@ int arwGetTrackablePatternCount(int trackableUID)
 }
 
 bool arwGetTrackablePatternConfig(int trackableUID, int patternIndex, float matrix[16], float *width, float *height, int *imageSizeX, int *imageSizeY)
+{
+    return arwSessionGetTrackablePatternConfig(gSession, trackableUID, patternIndex, matrix, width, height, imageSizeX, imageSizeY);
+}
+
+bool arwSessionGetTrackablePatternConfig(ARWSession *session, int trackableUID, int patternIndex, float matrix[16], float *width, float *height, int *imageSizeX, int *imageSizeY)
 {
     std::shared_ptr<ARTrackable> trackable;
 
-    if (!gARTK) return false;
-	if (!(trackable = gARTK->findTrackable(trackableUID))) {
+    if (!session) return false;
+	if (!(trackable = session->arController->findTrackable(trackableUID))) {
         ARLOGe("arwGetTrackablePatternConfig(): Couldn't locate trackable with UID %d.\n", trackableUID);
         return false;
     }
@@ -678,7 +925,7 @@ bool arwGetTrackablePatternConfig(int trackableUID, int patternIndex, float matr
     if (width) *width = size.first;
     if (height) *height = size.second;
     if (imageSizeX || imageSizeY) {
-        std::pair<int, int> imageSize = trackable->getPatternImageSize(patternIndex, trackable->type == ARTrackable::SINGLE || trackable->type == ARTrackable::MULTI || trackable->type == ARTrackable::MULTI_AUTO ? gARTK->getSquareTracker()->matrixCodeType() : (AR_MATRIX_CODE_TYPE)0);
+        std::pair<int, int> imageSize = trackable->getPatternImageSize(patternIndex, trackable->type == ARTrackable::SINGLE || trackable->type == ARTrackable::MULTI || trackable->type == ARTrackable::MULTI_AUTO ? session->arController->getSquareTracker()->matrixCodeType() : (AR_MATRIX_CODE_TYPE)0);
         if (imageSizeX) *imageSizeX = imageSize.first;
         if (imageSizeY) *imageSizeY = imageSize.second;
     }
@@ -686,16 +933,21 @@ bool arwGetTrackablePatternConfig(int trackableUID, int patternIndex, float matr
 }
 
 bool arwGetTrackablePatternImage(int trackableUID, int patternIndex, uint32_t *buffer)
+{
+    return arwSessionGetTrackablePatternImage(gSession, trackableUID, patternIndex, buffer);
+}
+
+bool arwSessionGetTrackablePatternImage(ARWSession *session, int trackableUID, int patternIndex, uint32_t *buffer)
 {
     std::shared_ptr<ARTrackable> trackable;
 
-    if (!gARTK) return false;
-	if (!(trackable = gARTK->findTrackable(trackableUID))) {
+    if (!session) return false;
+	if (!(trackable = session->arController->findTrackable(trackableUID))) {
         ARLOGe("arwGetTrackablePatternImage(): Couldn't locate trackable with UID %d.\n", trackableUID);
         return false;
     }
 
-    return trackable->getPatternImage(patternIndex, buffer, trackable->type == ARTrackable::SINGLE || trackable->type == ARTrackable::MULTI || trackable->type == ARTrackable::MULTI_AUTO ? gARTK->getSquareTracker()->matrixCodeType() : (AR_MATRIX_CODE_TYPE)0);
+    return trackable->getPatternImage(patternIndex, buffer, trackable->type == ARTrackable::SINGLE || trackable->type == ARTrackable::MULTI || trackable->type == ARTrackable::MULTI_AUTO ? session->arController->getSquareTracker()->matrixCodeType() : (AR_MATRIX_CODE_TYPE)0);
 }
 
 // ----------------------------------------------------------------------------------------------------
@@ -703,11 +955,16 @@ bool arwGetTrackablePatternImage(int trackableUID, int patternIndex, uint32_t *b
 // ---------------------------------------------------------------------------------------------
 
 bool arwGetTrackableOptionBool(int trackableUID, int option)
+{
+    return arwSessionGetTrackableOptionBool(gSession, trackableUID, option);
+}
+
+bool arwSessionGetTrackableOptionBool(ARWSession *session, int trackableUID, int option)
 {
     std::shared_ptr<ARTrackable> trackable;
 
-    if (!gARTK) return false;
-	if (!(trackable = gARTK->findTrackable(trackableUID))) {
+    if (!session) return false;
+	if (!(trackable = session->arController->findTrackable(trackableUID))) {
         ARLOGe("arwGetTrackableOptionBool(): Couldn't locate trackable with UID %d.\n", trackableUID);
         return false;
     }
@@ -727,11 +984,16 @@ bool arwGetTrackableOptionBool(int trackableUID, int option)
 }
 
 void arwSetTrackableOptionBool(int trackableUID, int option, bool value)
+{
+    arwSessionSetTrackableOptionBool(gSession, trackableUID, option, value);
+}
+
+void arwSessionSetTrackableOptionBool(ARWSession *session, int trackableUID, int option, bool value)
 {
     std::shared_ptr<ARTrackable> trackable;
 
-    if (!gARTK) return;
-	if (!(trackable = gARTK->findTrackable(trackableUID))) {
+    if (!session) return;
+	if (!(trackable = session->arController->findTrackable(trackableUID))) {
         ARLOGe("arwSetTrackableOptionBool(): Couldn't locate trackable with UID %d.\n", trackableUID);
         return;
     }
@@ -750,11 +1012,16 @@ void arwSetTrackableOptionBool(int trackableUID, int option, bool value)
 }
 
 int arwGetTrackableOptionInt(int trackableUID, int option)
+{
+    return arwSessionGetTrackableOptionInt(gSession, trackableUID, option);
+}
+
+int arwSessionGetTrackableOptionInt(ARWSession *session, int trackableUID, int option)
 {
     std::shared_ptr<ARTrackable> trackable;
 
-    if (!gARTK) return INT_MIN;
-	if (!(trackable = gARTK->findTrackable(trackableUID))) {
+    if (!session) return INT_MIN;
+	if (!(trackable = session->arController->findTrackable(trackableUID))) {
         ARLOGe("arwGetTrackableOptionBool(): Couldn't locate trackable with UID %d.\n", trackableUID);
         return (INT_MIN);
     }
@@ -796,11 +1063,16 @@ int arwGetTrackableOptionInt(int trackableUID, int option)
 }
 
 void arwSetTrackableOptionInt(int trackableUID, int option, int value)
+{
+    arwSessionSetTrackableOptionInt(gSession, trackableUID, option, value);
+}
+
+void arwSessionSetTrackableOptionInt(ARWSession *session, int trackableUID, int option, int value)
 {
     std::shared_ptr<ARTrackable> trackable;
 
-    if (!gARTK) return;
-	if (!(trackable = gARTK->findTrackable(trackableUID))) {
+    if (!session) return;
+	if (!(trackable = session->arController->findTrackable(trackableUID))) {
         ARLOGe("arwSetTrackableOptionInt(): Couldn't locate trackable with UID %d.\n", trackableUID);
         return;
     }
@@ -816,11 +1088,16 @@ void arwSetTrackableOptionInt(int trackableUID, int option, int value)
 }
 
 float arwGetTrackableOptionFloat(int trackableUID, int option)
+{
+    return arwSessionGetTrackableOptionFloat(gSession, trackableUID, option);
+}
+
+float arwSessionGetTrackableOptionFloat(ARWSession *session, int trackableUID, int option)
 {
     std::shared_ptr<ARTrackable> trackable;
 
-    if (!gARTK) return (NAN);
-	if (!(trackable = gARTK->findTrackable(trackableUID))) {
+    if (!session) return (NAN);
+	if (!(trackable = session->arController->findTrackable(trackableUID))) {
         ARLOGe("arwGetTrackableOptionBool(): Couldn't locate trackable with UID %d.\n", trackableUID);
         return (NAN);
     }
@@ -880,11 +1157,16 @@ float arwGetTrackableOptionFloat(int trackableUID, int option)
 }
 
 void arwSetTrackableOptionFloat(int trackableUID, int option, float value)
+{
+    arwSessionSetTrackableOptionFloat(gSession, trackableUID, option, value);
+}
+
+void arwSessionSetTrackableOptionFloat(ARWSession *session, int trackableUID, int option, float value)
 {
     std::shared_ptr<ARTrackable> trackable;
 
-    if (!gARTK) return;
-	if (!(trackable = gARTK->findTrackable(trackableUID))) {
+    if (!session) return;
+	if (!(trackable = session->arController->findTrackable(trackableUID))) {
         ARLOGe("arwSetTrackableOptionFloat(): Couldn't locate trackable with UID %d.\n", trackableUID);
         return;
     }
@@ -928,11 +1210,16 @@ void arwSetTrackableOptionFloat(int trackableUID, int option, float value)
 }
 
 bool arwGetTrackableOptionString(int trackableUID, int option, char *buf, int bufLen)
+{
+    return arwSessionGetTrackableOptionString(gSession, trackableUID, option, buf, bufLen);
+}
+
+bool arwSessionGetTrackableOptionString(ARWSession *session, int trackableUID, int option, char *buf, int bufLen)
 {
     std::shared_ptr<ARTrackable> trackable;
 
-    if (!gARTK || !buf || bufLen < 2) return false;
-    if (!(trackable = gARTK->findTrackable(trackableUID))) {
+    if (!session || !buf || bufLen < 2) return false;
+    if (!(trackable = session->arController->findTrackable(trackableUID))) {
         ARLOGe("arwGetTrackableOptionString(): Couldn't locate trackable with UID %d.\n", trackableUID);
         return false;
     }
@@ -961,11 +1248,16 @@ bool arwGetTrackableOptionString(int trackableUID, int option, char *buf, int bu
 }
 
 void arwSetTrackableOptionString(int trackableUID, int option, char *str)
+{
+    arwSessionSetTrackableOptionString(gSession, trackableUID, option, str);
+}
+
+void arwSessionSetTrackableOptionString(ARWSession *session, int trackableUID, int option, char *str)
 {
     std::shared_ptr<ARTrackable> trackable;
 
-    if (!gARTK) return;
-    if (!(trackable = gARTK->findTrackable(trackableUID))) {
+    if (!session) return;
+    if (!(trackable = session->arController->findTrackable(trackableUID))) {
         ARLOGe("arwSetTrackableOptionString(): Couldn't locate trackable with UID %d.\n", trackableUID);
         return;
     }
@@ -984,13 +1276,18 @@ void arwSetTrackableOptionString(int trackableUID, int option, char *str)
 // ----------------------------------------------------------------------------------------------------
 bool arwLoadOpticalParams(const char *optical_param_name, const char *optical_param_buff, const int optical_param_buffLen, const float projectionNearPlane, const float projectionFarPlane, float *fovy_p, float *aspect_p, float m[16], float p[16])
 {
-    if (!gARTK) return false;
+    return arwSessionLoadOpticalParams(gSession, optical_param_name, optical_param_buff, optical_param_buffLen, projectionNearPlane, projectionFarPlane, fovy_p, aspect_p, m, p);
+}
+
+bool arwSessionLoadOpticalParams(ARWSession *session, const char *optical_param_name, const char *optical_param_buff, const int optical_param_buffLen, const float projectionNearPlane, const float projectionFarPlane, float *fovy_p, float *aspect_p, float m[16], float p[16])
+{
+    if (!session) return false;
 
 #ifdef ARDOUBLE_IS_FLOAT
-    return gARTK->loadOpticalParams(optical_param_name, optical_param_buff, optical_param_buffLen, projectionNearPlane, projectionFarPlane, fovy_p, aspect_p, m, p);
+    return session->arController->loadOpticalParams(optical_param_name, optical_param_buff, optical_param_buffLen, projectionNearPlane, projectionFarPlane, fovy_p, aspect_p, m, p);
 #else
     ARdouble fovy, aspect, m0[16], p0[16];
-	if (!gARTK->loadOpticalParams(optical_param_name, optical_param_buff, optical_param_buffLen, projectionNearPlane, projectionFarPlane, &fovy, &aspect, m0, (p ? p0 : NULL))) {
+	if (!session->arController->loadOpticalParams(optical_param_name, optical_param_buff, optical_param_buffLen, projectionNearPlane, projectionFarPlane, &fovy, &aspect, m0, (p ? p0 : NULL))) {
         return false;
     }
     *fovy_p = (float)fovy;
@@ -1001,6 +1298,88 @@ bool arwLoadOpticalParams(const char *optical_param_name, const char *optical_pa
 #endif
 }
 
+// ----------------------------------------------------------------------------------------------------
+#pragma mark  Profiling
+// ----------------------------------------------------------------------------------------------------
+void arwSetProfilingEnabled(bool enable)
+{
+    arUtilProfileSetEnabled(enable ? 1 : 0);
+}
+
+bool arwGetProfilingEnabled(void)
+{
+    return (arUtilProfileGetEnabled() != 0);
+}
+
+void arwResetProfiling(void)
+{
+    arUtilProfileReset();
+}
+
+int arwGetProfilingStats(ARWProfileStats *stats, int statsCount)
+{
+    if (!stats || statsCount <= 0) return arUtilProfileGetStats(NULL, 0);
+
+    std::vector<ARUtilProfileStats> s(statsCount);
+    int count = arUtilProfileGetStats(s.data(), statsCount);
+    int n = (count < statsCount ? count : statsCount);
+    for (int i = 0; i < n; i++) {
+        strncpy(stats[i].path, s[i].path, sizeof(stats[i].path));
+        stats[i].path[sizeof(stats[i].path) - 1] = '\0';
+        stats[i].depth = s[i].depth;
+        stats[i].count = (int)s[i].count;
+        stats[i].totalMs = s[i].total*1000.0;
+        stats[i].meanMs = (s[i].count ? s[i].total/s[i].count*1000.0 : 0.0);
+        stats[i].minMs = s[i].min*1000.0;
+        stats[i].maxMs = s[i].max*1000.0;
+    }
+    return count;
+}
+
+// ----------------------------------------------------------------------------------------------------
+#pragma mark  Timing statistics
+// ----------------------------------------------------------------------------------------------------
+bool arwGetTimingStats(int stage, ARWTimingStats *stats)
+{
+    return arwSessionGetTimingStats(gSession, stage, stats);
+}
+
+bool arwSessionGetTimingStats(ARWSession *session, int stage, ARWTimingStats *stats)
+{
+    if (!session || !stats) return false;
+
+    ARTimingStats::Summary summary;
+    if (!session->arController->getTimingStats((ARController::TimingStage)stage, &summary)) return false;
+    stats->count = summary.count;
+    stats->minMs = summary.min*1000.0;
+    stats->meanMs = summary.mean*1000.0;
+    stats->p95Ms = summary.p95*1000.0;
+    stats->maxMs = summary.max*1000.0;
+    return true;
+}
+
+void arwResetTimingStats(void)
+{
+    arwSessionResetTimingStats(gSession);
+}
+
+void arwSessionResetTimingStats(ARWSession *session)
+{
+    if (!session) return;
+    session->arController->resetTimingStats();
+}
+
+void arwSetTimingStatsWindowSize(int frames)
+{
+    arwSessionSetTimingStatsWindowSize(gSession, frames);
+}
+
+void arwSessionSetTimingStatsWindowSize(ARWSession *session, int frames)
+{
+    if (!session) return;
+    session->arController->setTimingStatsWindowSize(frames);
+}
+
 // ----------------------------------------------------------------------------------------------------
 #pragma mark  Video source info list management
 // ----------------------------------------------------------------------------------------------------
@@ -1473,7 +1852,7 @@ JNIEXPORT jfloat JNICALL JNIFUNCTION(arwGetTrackableOptionFloat(JNIEnv *env, job
 
 JNIEXPORT jint JNICALL JNIFUNCTION(arwVideoPushInit(JNIEnv *env, jobject obj, jint videoSourceIndex, jint width, jint height, jstring pixelFormat, jint cameraIndex, jint cameraPosition))
 {
-    if (!gARTK) {
+    if (!gSession) {
         return -1;
     }
 
@@ -1481,7 +1860,7 @@ JNIEXPORT jint JNICALL JNIFUNCTION(arwVideoPushInit(JNIEnv *env, jobject obj, ji
     jint ret;
 
     const char *pixelFormatC = env->GetStringUTFChars(pixelFormat, &isCopy);
-    ret = gARTK->videoPushInit(videoSourceIndex, width, height, pixelFormatC, cameraIndex, cameraPosition);
+    ret = gSession->arController->videoPushInit(videoSourceIndex, width, height, pixelFormatC, cameraIndex, cameraPosition);
     env->ReleaseStringUTFChars(pixelFormat, pixelFormatC);
     return ret;
 }
@@ -1536,7 +1915,7 @@ JNIEXPORT jint JNICALL JNIFUNCTION(arwVideoPush(JNIEnv *env, jobject obj, jint v
                                                 jobject buf3, jint buf3PixelStride, jint buf3RowStride,
                                                 jobject releaseCallbackClassInstance, jstring releaseCallbackMethodName, jobject releaseCallbackUserdata))
 {
-    if (!gARTK) {
+    if (!gSession) {
         return -1;
     }
     uint8_t *buf0p = NULL, *buf1p = NULL, *buf2p = NULL, *buf3p = NULL;
@@ -1581,7 +1960,7 @@ JNIEXPORT jint JNICALL JNIFUNCTION(arwVideoPush(JNIEnv *env, jobject obj, jint v
                                 data->callbackObjectInstanceGlobalRef = callbackObjectInstanceGlobalRef;
                                 data->callbackMethod = callbackMethod;
                                 data->callbackUserdataGlobalRef = callbackUserdataGlobalRef;
-                                return gARTK->videoPush(videoSourceIndex, buf0p, buf0Size, buf0PixelStride, buf0RowStride, buf1p, buf1Size, buf1PixelStride, buf1RowStride, buf2p, buf2Size, buf2PixelStride, buf2RowStride, buf3p, buf3Size, buf3PixelStride, buf3RowStride, arwVideoPushJNICallbackStub, data);
+                                return gSession->arController->videoPush(videoSourceIndex, buf0p, buf0Size, buf0PixelStride, buf0RowStride, buf1p, buf1Size, buf1PixelStride, buf1RowStride, buf2p, buf2Size, buf2PixelStride, buf2RowStride, buf3p, buf3Size, buf3PixelStride, buf3RowStride, arwVideoPushJNICallbackStub, data);
                             }
                         }                    
                     }
@@ -1590,16 +1969,16 @@ JNIEXPORT jint JNICALL JNIFUNCTION(arwVideoPush(JNIEnv *env, jobject obj, jint v
         }
     }
 
-    return gARTK->videoPush(videoSourceIndex, buf0p, buf0Size, buf0PixelStride, buf0RowStride, buf1p, buf1Size, buf1PixelStride, buf1RowStride, buf2p, buf2Size, buf2PixelStride, buf2RowStride, buf3p, buf3Size, buf3PixelStride, buf3RowStride, NULL, NULL);
+    return gSession->arController->videoPush(videoSourceIndex, buf0p, buf0Size, buf0PixelStride, buf0RowStride, buf1p, buf1Size, buf1PixelStride, buf1RowStride, buf2p, buf2Size, buf2PixelStride, buf2RowStride, buf3p, buf3Size, buf3PixelStride, buf3RowStride, NULL, NULL);
 }
 
 JNIEXPORT jint JNICALL JNIFUNCTION(arwVideoPushFinal(JNIEnv *env, jobject obj, jint videoSourceIndex))
 {
-    if (!gARTK) {
+    if (!gSession) {
         return -1;
     }
 
-    return gARTK->videoPushFinal(videoSourceIndex);
+    return gSession->arController->videoPushFinal(videoSourceIndex);
 }
 
 JNIEXPORT jint JNICALL JNIFUNCTION(arwCreateVideoSourceInfoList(JNIEnv *env, jobject obj, jstring config))
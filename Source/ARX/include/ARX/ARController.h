@@ -54,6 +54,8 @@
 #  include <ARX/ARTracker2d.h>
 #endif
 #include <ARX/ARTrackable.h>
+#include <ARX/ARTimingStats.h>
+#include <ARX/ARUtil/thread_sub.h>
 
 
 #include <vector>
@@ -113,6 +115,21 @@ private:
     std::shared_ptr<ARTracker2d> m_twoDTracker;
 #endif
 
+    static const int kTrackerCountMax = 3;      ///< Square, NFT and 2D.
+    typedef struct {
+        ARTrackerVideo *tracker;
+        const char *trackerName;                ///< Profiling scope name.
+        AR2VideoBufferT *buff0;
+        AR2VideoBufferT *buff1;
+        ARTimingStats *timingStats;
+    } TrackerUpdateWorkerData;
+    bool m_parallelTrackerUpdate;               ///< If true, trackers are updated concurrently on the same frame.
+    TrackerUpdateWorkerData m_trackerUpdateWorkerData[kTrackerCountMax - 1];
+    THREAD_HANDLE_T *m_trackerUpdateWorkers[kTrackerCountMax - 1];
+    static void *trackerUpdateWorker(THREAD_HANDLE_T *threadHandle);
+    static void trackerUpdateTimed(ARTrackerVideo *tracker, const char *trackerName, ARTimingStats *stats, AR2VideoBufferT *buff0, AR2VideoBufferT *buff1);
+    void trackerUpdateWorkersFinal();
+
     int m_error;
     void setError(int error);
 
@@ -154,6 +171,64 @@ public:
     std::shared_ptr<ARTracker2d> get2dTracker() { return m_twoDTracker; };
 #endif
 
+    /**
+     * Enables or disables concurrent update of trackers.
+     * When enabled and more than one tracker has trackables loaded, update() dispatches each
+     * tracker's update to a worker thread against the same checked-out frame, and waits for all
+     * trackers to complete before checking the frame back in and returning. The square tracker
+     * (if active) always runs on the calling thread, so its callbacks are not affected.
+     * Defaults to false.
+     * @param on true to update trackers concurrently, false to update them one after another.
+     * @see parallelTrackerUpdate()
+     */
+    void setParallelTrackerUpdate(bool on);
+
+    /**
+     * Returns whether trackers are updated concurrently.
+     * @return true if trackers are updated concurrently.
+     * @see setParallelTrackerUpdate()
+     */
+    bool parallelTrackerUpdate() const { return m_parallelTrackerUpdate; }
+
+    /**
+     * Stages of update() for which timing statistics are kept.
+     * @see getTimingStats()
+     */
+    typedef enum {
+        TIMING_STAGE_FRAME_CHECKOUT = 0,    ///< Checking out the video frame(s) for tracking.
+        TIMING_STAGE_SQUARE_UPDATE,         ///< Square tracker update.
+        TIMING_STAGE_NFT_UPDATE,            ///< NFT tracker update.
+        TIMING_STAGE_2D_UPDATE,             ///< 2D tracker update.
+        TIMING_STAGE_POSE_FILTER,           ///< Pose filtering, summed over all trackables, in frames in which any pose was filtered.
+        TIMING_STAGE_UPDATE,                ///< The whole of update(), for frames which were tracked.
+        TIMING_STAGE_COUNT
+    } TimingStage;
+
+    /**
+     * Gets rolling statistics of the time taken by a stage of update().
+     * Statistics cover the most recent frames in which the stage ran, up to the window size.
+     * Tracker update times are measured on the thread which ran the tracker, so when trackers are
+     * updated concurrently, they may sum to more than the update time.
+     * For timing of the stages within each tracker (e.g. labeling or KPM), see arUtilStageTimingSetCallback().
+     * May be called from any thread.
+     * @param stage The stage.
+     * @param summary Filled with the statistics, in seconds.
+     * @return false if stage is invalid, otherwise true.
+     * @see resetTimingStats(), setTimingStatsWindowSize()
+     */
+    bool getTimingStats(TimingStage stage, ARTimingStats::Summary *summary);
+
+    /**
+     * Discards the timing statistics of all stages.
+     */
+    void resetTimingStats();
+
+    /**
+     * Sets the number of most-recent samples over which timing statistics are calculated.
+     * Defaults to ARTimingStats::kWindowSizeDefault. Discards the timing statistics of all stages.
+     */
+    void setTimingStatsWindowSize(int samples);
+
 	/**
 	 * Report whether artoolkit was initialized and a trackable can be added.
      * Trackables can be added once basic initialisation has occurred.
@@ -440,6 +515,8 @@ public:
     bool save2DTrackerImageDatabase(const char* databaseFileName);
 #endif // HAVE_2D
 
+private:
+    ARTimingStats m_timingStats[TIMING_STAGE_COUNT]; // Declared after TimingStage, which sizes it.
 };
 
 
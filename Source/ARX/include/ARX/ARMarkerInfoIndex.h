@@ -0,0 +1,86 @@
+/*
+ *  ARMarkerInfoIndex.h
+ *  artoolkitX
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ *  Author(s): Philip Lamb
+ *
+ */
+
+#ifndef ARMARKERINFOINDEX_H
+#define ARMARKERINFOINDEX_H
+
+#include <ARX/AR/ar.h>
+#include <unordered_map>
+#include <map>
+#include <utility>
+#include <vector>
+
+/**
+ * Per-frame index from pattern and barcode IDs to entries in an array of detected markers.
+ *
+ * Built once per frame by the square tracker, so that each trackable need only examine
+ * the detected markers carrying its own IDs, rather than scanning the whole array.
+ * Candidate lists are returned in ascending array order, so matching against them gives
+ * the same result as a full scan.
+ */
+class ARMarkerInfoIndex {
+
+private:
+    std::unordered_map<int, std::vector<int>> m_template;      ///< idPatt -> indices.
+    std::unordered_map<int, std::vector<int>> m_matrix;        ///< idMatrix -> indices, for markers not carrying a global ID.
+    std::unordered_map<uint64_t, std::vector<int>> m_globalID; ///< globalID -> indices, for markers carrying a global ID.
+    mutable std::map<std::pair<int, uint64_t>, std::vector<int>> m_merged; ///< (idMatrix, globalID) -> merged indices, filled on demand.
+    const std::vector<int> m_empty;
+
+public:
+    /**
+     * Rebuild the index for a new array of detected markers.
+     * @param markerInfo Array of detected markers.
+     * @param markerNum Number of items in the array.
+     */
+    void build(const ARMarkerInfo *markerInfo, int markerNum);
+
+    /**
+     * Indices of detected markers whose template matched pattern ID pattID.
+     * The returned reference remains valid until the next call to build().
+     */
+    const std::vector<int>& templateCandidates(int pattID) const;
+
+    /**
+     * Indices of detected markers whose matrix code matched barcode ID pattID or, for
+     * markers carrying a global ID, matched globalID (if non-zero).
+     * The returned reference remains valid until the next call to build(). Not safe to
+     * call from more than one thread at once.
+     */
+    const std::vector<int>& matrixCandidates(int pattID, uint64_t globalID) const;
+};
+
+#endif // !ARMARKERINFOINDEX_H
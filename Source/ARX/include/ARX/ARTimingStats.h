@@ -0,0 +1,106 @@
+/*
+ *  ARTimingStats.h
+ *  artoolkitX
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ *  Author(s): Philip Lamb
+ *
+ */
+
+#ifndef ARTIMINGSTATS_H
+#define ARTIMINGSTATS_H
+
+#include <vector>
+#if !defined(_WINRT)
+#  include <pthread.h>
+#else
+#  define pthread_mutex_t               CRITICAL_SECTION
+#  define pthread_mutex_init(pm, a)     InitializeCriticalSectionEx(pm, 4000, CRITICAL_SECTION_NO_DEBUG_INFO)
+#  define pthread_mutex_lock(pm)        EnterCriticalSection(pm)
+#  define pthread_mutex_unlock(pm)      LeaveCriticalSection(pm)
+#  define pthread_mutex_destroy(pm)     DeleteCriticalSection(pm)
+#endif
+
+/**
+ * Rolling statistics over the most recent samples of a duration.
+ *
+ * Samples are added by the thread doing the work being timed, and the statistics may be
+ * read from any other thread.
+ */
+class ARTimingStats {
+
+public:
+    static const int kWindowSizeDefault = 300; ///< Samples. 10 seconds at 30 frames per second.
+
+    struct Summary {
+        int count;      ///< Number of samples in the window.
+        double min;     ///< Seconds.
+        double mean;    ///< Seconds.
+        double p95;     ///< 95th percentile (nearest rank), in seconds.
+        double max;     ///< Seconds.
+    };
+
+    ARTimingStats();
+    ~ARTimingStats();
+
+    /**
+     * Add a sample, replacing the oldest sample if the window is full.
+     * @param seconds The duration.
+     */
+    void add(double seconds);
+
+    /**
+     * Get statistics over the samples in the window.
+     * @param summary Filled with the statistics. If there are no samples, all fields are 0.
+     */
+    void summarise(Summary *summary);
+
+    /**
+     * Discard all samples.
+     */
+    void reset();
+
+    /**
+     * Set the number of most-recent samples over which statistics are calculated. Discards all samples.
+     */
+    void setWindowSize(int samples);
+    int windowSize();
+
+private:
+    ARTimingStats(const ARTimingStats&) = delete;
+    ARTimingStats& operator=(const ARTimingStats&) = delete;
+
+    pthread_mutex_t m_lock;
+    std::vector<double> m_samples;
+    int m_windowSize;
+    int m_next;             ///< Index at which the next sample will be stored, once the window is full.
+};
+
+#endif // !ARTIMINGSTATS_H
@@ -65,6 +65,7 @@ private:
     ARFilterTransMatInfo *m_ftmi;
     ARdouble   m_filterCutoffFrequency;
     ARdouble   m_filterSampleRate;
+    double     m_filterTime;                ///< Seconds spent filtering since last call to takeFilterTime().
 
 protected:
     ARdouble trans[3][4];                   ///< Transformation from camera to this trackable. If stereo, transform from left camera to this trackable.
@@ -133,6 +134,8 @@ public:
     void setFilterSampleRate(ARdouble rate);
     ARdouble filterCutoffFrequency();
     void setFilterCutoffFrequency(ARdouble freq);
+    /// Time spent filtering the pose, in seconds, since the last call to this function.
+    double takeFilterTime();
 
 };
 
@@ -41,6 +41,7 @@
 
 #include <ARX/ARTrackable.h>
 #include <ARX/AR/arMulti.h>
+#include <ARX/ARMarkerInfoIndex.h>
 
 /**
  * Multiple marker type of ARTrackable.
@@ -53,6 +54,11 @@ private:
     
 protected:
     bool unload();
+    /**
+     * Associate each submarker with its best-matching unmatched detected marker using an index,
+     * setting config->marker[i].visible (or visibleR if right is true).
+     */
+    void associateSubmarkers(ARMarkerInfo* markerInfo, const ARMarkerInfoIndex *index, bool right);
 
 public:
 
@@ -70,10 +76,11 @@ public:
      * @param markerInfo		Array containing detected marker information
      * @param markerNum			Number of items in the array
      * @param ar3DHandle        AR3DHandle used to extract marker pose.
+     * @param index             Optional index of markerInfo by ID. If NULL, the whole array is scanned.
      */
-	bool updateWithDetectedMarkers(ARMarkerInfo *markerInfo, int markerNum, AR3DHandle *ar3DHandle);
+	bool updateWithDetectedMarkers(ARMarkerInfo *markerInfo, int markerNum, AR3DHandle *ar3DHandle, const ARMarkerInfoIndex *index = nullptr);
 
-    bool updateWithDetectedMarkersStereo(ARMarkerInfo* markerInfoL, int markerNumL, ARMarkerInfo* markerInfoR, int markerNumR, AR3DStereoHandle *handle, ARdouble transL2R[3][4]);
+    bool updateWithDetectedMarkersStereo(ARMarkerInfo* markerInfoL, int markerNumL, ARMarkerInfo* markerInfoR, int markerNumR, AR3DStereoHandle *handle, ARdouble transL2R[3][4], const ARMarkerInfoIndex *indexL = nullptr, const ARMarkerInfoIndex *indexR = nullptr);
 
     int getPatternCount() override;
     std::pair<float, float> getPatternSize(int patternIndex) override;
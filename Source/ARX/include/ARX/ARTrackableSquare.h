@@ -40,6 +40,7 @@
 #define ARMARKERSQUARE_H
 
 #include <ARX/ARTrackable.h>
+#include <ARX/ARMarkerInfoIndex.h>
 
 #define    AR_PATTERN_TYPE_TEMPLATE    0
 #define    AR_PATTERN_TYPE_MATRIX      1
@@ -60,6 +61,12 @@ protected:
     
     bool unload();
     
+    /**
+     * Find the best-matching unmatched detected marker for this trackable, and mark its id, cf and dir.
+     * @return Index into markerInfo of the match, or -1 if none.
+     */
+    int findDetectedMarker(ARMarkerInfo* markerInfo, int markerNum, const ARMarkerInfoIndex *index);
+    
 public:
 	
 	int patt_id;							///< Pattern ID provided by libAR.
@@ -93,10 +100,11 @@ public:
      * @param markerInfo		Array containing detected marker information
      * @param markerNum			Number of items in the array
      * @param ar3DHandle        AR3DHandle used to extract marker pose.
+     * @param index             Optional index of markerInfo by ID. If NULL, the whole array is scanned.
      */
-	bool updateWithDetectedMarkers(ARMarkerInfo* markerInfo, int markerNum, AR3DHandle *ar3DHandle);
+	bool updateWithDetectedMarkers(ARMarkerInfo* markerInfo, int markerNum, AR3DHandle *ar3DHandle, const ARMarkerInfoIndex *index = nullptr);
 
-    bool updateWithDetectedMarkersStereo(ARMarkerInfo* markerInfoL, int markerNumL, ARMarkerInfo* markerInfoR, int markerNumR, AR3DStereoHandle *handle, ARdouble transL2R[3][4]);
+    bool updateWithDetectedMarkersStereo(ARMarkerInfo* markerInfoL, int markerNumL, ARMarkerInfo* markerInfoR, int markerNumR, AR3DStereoHandle *handle, ARdouble transL2R[3][4], const ARMarkerInfoIndex *indexL = nullptr, const ARMarkerInfoIndex *indexR = nullptr);
 
     int getPatternCount() override;
     std::pair<float, float> getPatternSize(int patternIndex) override;
@@ -93,6 +93,11 @@ public:
      */
     virtual bool deleteTrackable(int UID) = 0;
     virtual void deleteAllTrackables() = 0;
+    /**
+     * Returns the time spent filtering the poses of this tracker's trackables since the last call.
+     * @return The time, in seconds.
+     */
+    virtual double takeFilterTime() = 0;
 };
 
 
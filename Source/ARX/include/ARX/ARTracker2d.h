@@ -85,6 +85,7 @@ public:
     std::vector<std::shared_ptr<ARTrackable>> getAllTrackables() override;
     bool deleteTrackable(int UID) override;
     void deleteAllTrackables() override;
+    double takeFilterTime() override;
 
     bool loadImageDatabase(std::string filename);
     bool saveImageDatabase(std::string filename);
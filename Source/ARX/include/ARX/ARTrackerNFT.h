@@ -87,6 +87,7 @@ public:
     std::vector<std::shared_ptr<ARTrackable>> getAllTrackables() override;
     bool deleteTrackable(int UID) override;
     void deleteAllTrackables() override;
+    double takeFilterTime() override;
 
 private:
     std::vector<std::shared_ptr<ARTrackable>> m_trackables;
@@ -129,6 +129,20 @@ public:
      */
     int labelingMode() const;
     
+    /**
+     * Sets the number of threads used for labeling.
+     * @param threadCount     Number of threads, or AR_LABELING_THREAD_COUNT_AUTO for one per CPU.
+     * @see                    labelingThreadCount()
+     */
+    void setLabelingThreadCount(int threadCount);
+    
+    /**
+     * Returns the number of threads used for labeling.
+     * @return                The current labeling thread count.
+     * @see                    setLabelingThreadCount()
+     */
+    int labelingThreadCount() const;
+    
     void setPatternDetectionMode(int mode);
     
     int patternDetectionMode() const;
@@ -153,8 +167,8 @@ public:
 
     bool matrixModeAutoCreateNewTrackables() const { return m_matrixModeAutoCreateNewTrackables; }
 
-    typedef void (*MatrixModeAutoCreateNewTrackablesCallback_t)(const ARTrackableSquare& trackable);
-    void setMatrixModeAutoCreateNewTrackablesCallback(MatrixModeAutoCreateNewTrackablesCallback_t callback) { m_matrixModeAutoCreateNewTrackablesCallback = callback; }
+    typedef void (*MatrixModeAutoCreateNewTrackablesCallback_t)(const ARTrackableSquare& trackable, void *userdata);
+    void setMatrixModeAutoCreateNewTrackablesCallback(MatrixModeAutoCreateNewTrackablesCallback_t callback, void *userdata = nullptr) { m_matrixModeAutoCreateNewTrackablesCallback = callback; m_matrixModeAutoCreateNewTrackablesCallbackUserdata = userdata; }
     MatrixModeAutoCreateNewTrackablesCallback_t matrixModeAutoCreateNewTrackablesCallback() const { return m_matrixModeAutoCreateNewTrackablesCallback; }
 
 
@@ -178,6 +192,7 @@ public:
     std::vector<std::shared_ptr<ARTrackable>> getAllTrackables() override;
     bool deleteTrackable(int UID) override;
     void deleteAllTrackables() override;
+    double takeFilterTime() override;
 
     bool updateDebugTextureRGBA32(const int videoSourceIndex, uint32_t* buffer);
     
@@ -187,6 +202,7 @@ private:
     AR_LABELING_THRESH_MODE m_thresholdMode;
     int m_imageProcMode;
     int m_labelingMode;
+    int m_labelingThreadCount;
     ARdouble m_pattRatio;
     int m_patternDetectionMode;
     AR_MATRIX_CODE_TYPE m_matrixCodeType;
@@ -196,6 +212,7 @@ private:
     bool m_matrixModeAutoCreateNewTrackables;
     float m_matrixModeAutoCreateNewTrackablesDefaultWidth;
     MatrixModeAutoCreateNewTrackablesCallback_t m_matrixModeAutoCreateNewTrackablesCallback;
+    void *m_matrixModeAutoCreateNewTrackablesCallbackUserdata;
 
     ARHandle *m_arHandle0;              ///< Structure containing square tracker state.
     ARHandle *m_arHandle1;              ///< For stereo tracking, structure containing square tracker state for second tracker in stereo pair.
@@ -203,6 +220,8 @@ private:
     AR3DHandle *m_ar3DHandle;           ///< Structure used to compute 3D poses from tracking data.
     ARdouble m_transL2R[3][4];          ///< For stereo tracking, transformation matrix from left camera to right camera.
     AR3DStereoHandle *m_ar3DStereoHandle; ///< For stereo tracking, additional tracker state.
+    ARMarkerInfoIndex m_markerInfoIndex0; ///< Per-frame index of detected markers by ID.
+    ARMarkerInfoIndex m_markerInfoIndex1; ///< For stereo tracking, per-frame index of detected markers by ID for second tracker in stereo pair.
 };
 
 #endif // !ARTRACKERSQUARE_H
@@ -431,6 +431,8 @@ extern "C" {
         ARW_TRACKER_OPTION_SQUARE_MATRIX_MODE_AUTOCREATE_NEW_TRACKABLES = 13, ///< If true, when the square tracker is detecting matrix (barcode) markers, new trackables will be created for unmatched markers. Defaults to false. bool.
         ARW_TRACKER_OPTION_SQUARE_MATRIX_MODE_AUTOCREATE_NEW_TRACKABLES_DEFAULT_WIDTH = 14, ///< If ARW_TRACKER_OPTION_SQUARE_MATRIX_MODE_AUTOCREATE_NEW_TRACKABLES is true, this value will be used for the initial width of new trackables for unmatched markers. Defaults to 80.0f. float.
         ARW_TRACKER_OPTION_2D_THREADED = 15,                           ///< bool, If false, 2D tracking updates synchronously, and arwUpdateAR will not return until 2D tracking is complete. If true, 2D tracking updates asychronously on a secondary thread, and arwUpdateAR will not block if the track is busy. Defaults to true.
+        ARW_TRACKER_OPTION_PARALLEL_TRACKER_UPDATE = 16,               ///< bool, If true, and more than one tracker (square, NFT, 2D) has trackables loaded, the trackers are updated concurrently on the same video frame, and arwUpdateAR returns once all have completed. Defaults to false.
+        ARW_TRACKER_OPTION_SQUARE_LABELING_THREAD_COUNT = 17,          ///< Number of threads used to label the image, each labeling a horizontal band. -1 means one thread per CPU. Defaults to 1. int.
     };
 
     /**
@@ -742,6 +744,95 @@ extern "C" {
      */
     ARX_EXTERN bool arwLoadOpticalParams(const char *optical_param_name, const char *optical_param_buff, const int optical_param_buffLen, const float projectionNearPlane, const float projectionFarPlane, float *fovy_p, float *aspect_p, float m[16], float p[16]);
 
+    // ----------------------------------------------------------------------------------------------------
+#pragma mark  Profiling
+    // ----------------------------------------------------------------------------------------------------
+
+#pragma pack(push, 4)
+    typedef struct {
+        char path[256];     ///< Scope names separated by '/', e.g. "update/square/labeling".
+        int depth;          ///< Nesting depth of the scope. Outermost scopes have depth 0.
+        int count;          ///< Number of times the scope was completed.
+        double totalMs;     ///< Total time spent in the scope, in milliseconds.
+        double meanMs;
+        double minMs;
+        double maxMs;
+    } ARWProfileStats;
+#pragma pack(pop)
+
+    /**
+     * Enables or disables profiling of the stages of tracking.
+     * Profiling is process-wide, covering all sessions and all threads, including the KPM, 2D and AR2 worker threads.
+     * It is disabled by default.
+     * @param enable true to enable profiling, false to disable it.
+     */
+    ARX_EXTERN void arwSetProfilingEnabled(bool enable);
+
+    /**
+     * Gets whether profiling is enabled.
+     */
+    ARX_EXTERN bool arwGetProfilingEnabled(void);
+
+    /**
+     * Clears all profiling statistics.
+     */
+    ARX_EXTERN void arwResetProfiling(void);
+
+    /**
+     * Gets profiling statistics, aggregated across all threads since profiling was enabled or last reset.
+     * Scopes are reported depth-first, so each scope follows the scope enclosing it.
+     * @param stats Pointer to the first element of an array of statistics, allocated by the caller, or NULL to just count the scopes.
+     * @param statsCount The number of elements in the stats array. If fewer than the number of scopes, only the first statsCount scopes will be reported.
+     * @return The number of scopes for which statistics are available, which may be more than statsCount.
+     */
+    ARX_EXTERN int arwGetProfilingStats(ARWProfileStats *stats, int statsCount);
+
+    // ----------------------------------------------------------------------------------------------------
+#pragma mark  Timing statistics
+    // ----------------------------------------------------------------------------------------------------
+
+    enum {
+        ARW_TIMING_STAGE_FRAME_CHECKOUT = 0,    ///< Checking out the video frame(s) for tracking.
+        ARW_TIMING_STAGE_SQUARE_UPDATE = 1,     ///< Square tracker update.
+        ARW_TIMING_STAGE_NFT_UPDATE = 2,        ///< NFT tracker update.
+        ARW_TIMING_STAGE_2D_UPDATE = 3,         ///< 2D tracker update.
+        ARW_TIMING_STAGE_POSE_FILTER = 4,       ///< Pose filtering, summed over all trackables.
+        ARW_TIMING_STAGE_UPDATE = 5,            ///< The whole of arwUpdateAR, for frames which were tracked.
+    };
+
+#pragma pack(push, 4)
+    typedef struct {
+        int count;          ///< Number of frames the statistics cover.
+        double minMs;
+        double meanMs;
+        double p95Ms;       ///< 95th percentile.
+        double maxMs;
+    } ARWTimingStats;
+#pragma pack(pop)
+
+    /**
+     * Gets rolling statistics of the time taken by a stage of arwUpdateAR.
+     * Unlike profiling, timing statistics are always collected, per session, and cover only the most
+     * recent frames in which the stage ran (300 by default, see arwSetTimingStatsWindowSize).
+     * May be called from any thread.
+     * @param stage One of the ARW_TIMING_STAGE_* constants.
+     * @param stats Pointer to statistics to be filled, in milliseconds.
+     * @return true if the statistics were retrieved, false if an error occurred.
+     */
+    ARX_EXTERN bool arwGetTimingStats(int stage, ARWTimingStats *stats);
+
+    /**
+     * Discards the timing statistics of all stages.
+     */
+    ARX_EXTERN void arwResetTimingStats(void);
+
+    /**
+     * Sets the number of most-recent frames over which timing statistics are calculated.
+     * Discards the timing statistics of all stages.
+     * @param frames Number of frames, greater than 0.
+     */
+    ARX_EXTERN void arwSetTimingStatsWindowSize(int frames);
+
     // ----------------------------------------------------------------------------------------------------
 #pragma mark  Video source info list management
     // ----------------------------------------------------------------------------------------------------
@@ -791,6 +882,97 @@ extern "C" {
      */
     ARX_EXTERN void arwDeleteVideoSourceInfoList(void);
 
+    // ----------------------------------------------------------------------------------------------------
+#pragma mark  Sessions
+    // ----------------------------------------------------------------------------------------------------
+
+    /**
+     * Opaque handle to an independent artoolkitX session.
+     *
+     * Each session owns its own controller, video source(s), trackers and trackables, so that
+     * several sessions (e.g. one per camera) can run in a single process. The arw* functions
+     * which do not take a session parameter operate on a default session, which is created
+     * by arwInitialiseAR() and deleted by arwShutdownAR().
+     *
+     * Calls on a single session must not be made concurrently from more than one thread,
+     * but different sessions may be used concurrently from different threads.
+     */
+    typedef struct ARWSession ARWSession;
+
+    /**
+     * Creates a new session.
+     * The session must be initialised with arwSessionInitialiseAR() before use.
+     * @return The new session. When no longer required, it must be deleted with arwDeleteSession().
+     * @see arwDeleteSession
+     */
+    ARX_EXTERN ARWSession *arwCreateSession(void);
+
+    /**
+     * Shuts down a session and frees all its resources.
+     * @param session The session to delete.
+     * @see arwCreateSession
+     */
+    ARX_EXTERN void arwDeleteSession(ARWSession *session);
+
+    ARX_EXTERN bool arwSessionInitialiseAR(ARWSession *session); ///< Session variant of arwInitialiseAR().
+    ARX_EXTERN bool arwSessionGetARToolKitVersion(ARWSession *session, char *buffer, int length); ///< Session variant of arwGetARToolKitVersion().
+    ARX_EXTERN int arwSessionGetError(ARWSession *session); ///< Session variant of arwGetError().
+    ARX_EXTERN bool arwSessionStartRunning(ARWSession *session, const char *vconf, const char *cparaName); ///< Session variant of arwStartRunning().
+    ARX_EXTERN bool arwSessionStartRunningB(ARWSession *session, const char *vconf, const char *cparaBuff, const int cparaBuffLen); ///< Session variant of arwStartRunningB().
+    ARX_EXTERN bool arwSessionStartRunningStereo(ARWSession *session, const char *vconfL, const char *cparaNameL, const char *vconfR, const char *cparaNameR, const char *transL2RName); ///< Session variant of arwStartRunningStereo().
+    ARX_EXTERN bool arwSessionStartRunningStereoB(ARWSession *session, const char *vconfL, const char *cparaBuffL, const int cparaBuffLenL, const char *vconfR, const char *cparaBuffR, const int cparaBuffLenR, const char *transL2RBuff, const int transL2RBuffLen); ///< Session variant of arwStartRunningStereoB().
+    ARX_EXTERN bool arwSessionIsRunning(ARWSession *session); ///< Session variant of arwIsRunning().
+    ARX_EXTERN bool arwSessionIsInited(ARWSession *session); ///< Session variant of arwIsInited().
+    ARX_EXTERN bool arwSessionStopRunning(ARWSession *session); ///< Session variant of arwStopRunning().
+    ARX_EXTERN bool arwSessionGetProjectionMatrix(ARWSession *session, const float nearPlane, const float farPlane, float p[16]); ///< Session variant of arwGetProjectionMatrix().
+    ARX_EXTERN bool arwSessionGetProjectionMatrixStereo(ARWSession *session, const float nearPlane, const float farPlane, float pL[16], float pR[16]); ///< Session variant of arwGetProjectionMatrixStereo().
+    ARX_EXTERN bool arwSessionGetProjectionMatrixForViewportSizeAndFittingMode(ARWSession *session, const int width, const int height, const int scaleMode, const int hAlign, const int vAlign, const float nearPlane, const float farPlane, float p[16]); ///< Session variant of arwGetProjectionMatrixForViewportSizeAndFittingMode().
+    ARX_EXTERN bool arwSessionGetProjectionMatrixForViewportSizeAndFittingModeStereo(ARWSession *session, const int width, const int height, const int scaleMode, const int hAlign, const int vAlign, const float nearPlane, const float farPlane, float pL[16], float pR[16]); ///< Session variant of arwGetProjectionMatrixForViewportSizeAndFittingModeStereo().
+    ARX_EXTERN bool arwSessionGetVideoParams(ARWSession *session, int *width, int *height, int *pixelSize, char *pixelFormatStringBuffer, int pixelFormatStringBufferLen); ///< Session variant of arwGetVideoParams().
+    ARX_EXTERN bool arwSessionGetVideoParamsStereo(ARWSession *session, int *widthL, int *heightL, int *pixelSizeL, char *pixelFormatStringBufferL, int pixelFormatStringBufferLenL, int *widthR, int *heightR, int *pixelSizeR, char *pixelFormatStringBufferR, int pixelFormatStringBufferLenR); ///< Session variant of arwGetVideoParamsStereo().
+    ARX_EXTERN bool arwSessionCapture(ARWSession *session); ///< Session variant of arwCapture().
+    ARX_EXTERN bool arwSessionUpdateAR(ARWSession *session); ///< Session variant of arwUpdateAR().
+    ARX_EXTERN bool arwSessionUpdateTexture32(ARWSession *session, uint32_t *buffer); ///< Session variant of arwUpdateTexture32().
+    ARX_EXTERN bool arwSessionUpdateTexture32Stereo(ARWSession *session, uint32_t *bufferL, uint32_t *bufferR); ///< Session variant of arwUpdateTexture32Stereo().
+    ARX_EXTERN int arwSessionVideoPushInit(ARWSession *session, int videoSourceIndex, int width, int height, const char *pixelFormat, int cameraIndex, int cameraPosition); ///< Session variant of arwVideoPushInit().
+    ARX_EXTERN int arwSessionVideoPush(ARWSession *session, int videoSourceIndex, uint8_t *buf0p, int buf0Size, int buf0PixelStride, int buf0RowStride, uint8_t *buf1p, int buf1Size, int buf1PixelStride, int buf1RowStride, uint8_t *buf2p, int buf2Size, int buf2PixelStride, int buf2RowStride, uint8_t *buf3p, int buf3Size, int buf3PixelStride, int buf3RowStride, PFN_VIDEOPUSHRELEASECALLBACK releaseCallback, void *releaseCallbackUserdata); ///< Session variant of arwVideoPush().
+    ARX_EXTERN int arwSessionVideoPushFinal(ARWSession *session, int videoSourceIndex); ///< Session variant of arwVideoPushFinal().
+    ARX_EXTERN bool arwSessionDrawVideoInit(ARWSession *session, const int videoSourceIndex); ///< Session variant of arwDrawVideoInit().
+    ARX_EXTERN bool arwSessionDrawVideoSettings(ARWSession *session, int videoSourceIndex, int width, int height, bool rotate90, bool flipH, bool flipV, int hAlign, int vAlign, int scalingMode, int32_t viewport[4]); ///< Session variant of arwDrawVideoSettings().
+    ARX_EXTERN bool arwSessionDrawVideo(ARWSession *session, const int videoSourceIndex); ///< Session variant of arwDrawVideo().
+    ARX_EXTERN bool arwSessionDrawVideoFinal(ARWSession *session, const int videoSourceIndex); ///< Session variant of arwDrawVideoFinal().
+    ARX_EXTERN void arwSessionSetTrackerOptionBool(ARWSession *session, int option, bool value); ///< Session variant of arwSetTrackerOptionBool().
+    ARX_EXTERN void arwSessionSetTrackerOptionInt(ARWSession *session, int option, int value); ///< Session variant of arwSetTrackerOptionInt().
+    ARX_EXTERN void arwSessionSetTrackerOptionFloat(ARWSession *session, int option, float value); ///< Session variant of arwSetTrackerOptionFloat().
+    ARX_EXTERN bool arwSessionGetTrackerOptionBool(ARWSession *session, int option); ///< Session variant of arwGetTrackerOptionBool().
+    ARX_EXTERN int arwSessionGetTrackerOptionInt(ARWSession *session, int option); ///< Session variant of arwGetTrackerOptionInt().
+    ARX_EXTERN float arwSessionGetTrackerOptionFloat(ARWSession *session, int option); ///< Session variant of arwGetTrackerOptionFloat().
+    ARX_EXTERN void arwSessionRegisterTrackableEventCallback(ARWSession *session, PFN_TRACKABLEEVENTCALLBACK callback); ///< Session variant of arwRegisterTrackableEventCallback().
+    ARX_EXTERN int arwSessionAddTrackable(ARWSession *session, const char *cfg); ///< Session variant of arwAddTrackable().
+    ARX_EXTERN int arwSessionGetTrackableCount(ARWSession *session); ///< Session variant of arwGetTrackableCount().
+    ARX_EXTERN bool arwSessionGetTrackableStatuses(ARWSession *session, ARWTrackableStatus *statuses, int statusesCount); ///< Session variant of arwGetTrackableStatuses().
+    ARX_EXTERN bool arwSessionRemoveTrackable(ARWSession *session, int trackableUID); ///< Session variant of arwRemoveTrackable().
+    ARX_EXTERN int arwSessionRemoveAllTrackables(ARWSession *session); ///< Session variant of arwRemoveAllTrackables().
+    ARX_EXTERN bool arwSessionLoad2dTrackableDatabase(ARWSession *session, const char *databaseFileName); ///< Session variant of arwLoad2dTrackableDatabase().
+    ARX_EXTERN bool arwSessionSave2dTrackableDatabase(ARWSession *session, const char *databaseFileName); ///< Session variant of arwSave2dTrackableDatabase().
+    ARX_EXTERN bool arwSessionQueryTrackableVisibilityAndTransformation(ARWSession *session, int trackableUID, float matrix[16]); ///< Session variant of arwQueryTrackableVisibilityAndTransformation().
+    ARX_EXTERN bool arwSessionQueryTrackableVisibilityAndTransformationStereo(ARWSession *session, int trackableUID, float matrixL[16], float matrixR[16]); ///< Session variant of arwQueryTrackableVisibilityAndTransformationStereo().
+    ARX_EXTERN int arwSessionGetTrackablePatternCount(ARWSession *session, int trackableUID); ///< Session variant of arwGetTrackablePatternCount().
+    ARX_EXTERN bool arwSessionGetTrackablePatternConfig(ARWSession *session, int trackableUID, int patternIndex, float matrix[16], float *width, float *height, int *imageSizeX, int *imageSizeY); ///< Session variant of arwGetTrackablePatternConfig().
+    ARX_EXTERN bool arwSessionGetTrackablePatternImage(ARWSession *session, int trackableUID, int patternIndex, uint32_t *buffer); ///< Session variant of arwGetTrackablePatternImage().
+    ARX_EXTERN bool arwSessionGetTrackableOptionBool(ARWSession *session, int trackableUID, int option); ///< Session variant of arwGetTrackableOptionBool().
+    ARX_EXTERN void arwSessionSetTrackableOptionBool(ARWSession *session, int trackableUID, int option, bool value); ///< Session variant of arwSetTrackableOptionBool().
+    ARX_EXTERN int arwSessionGetTrackableOptionInt(ARWSession *session, int trackableUID, int option); ///< Session variant of arwGetTrackableOptionInt().
+    ARX_EXTERN void arwSessionSetTrackableOptionInt(ARWSession *session, int trackableUID, int option, int value); ///< Session variant of arwSetTrackableOptionInt().
+    ARX_EXTERN float arwSessionGetTrackableOptionFloat(ARWSession *session, int trackableUID, int option); ///< Session variant of arwGetTrackableOptionFloat().
+    ARX_EXTERN void arwSessionSetTrackableOptionFloat(ARWSession *session, int trackableUID, int option, float value); ///< Session variant of arwSetTrackableOptionFloat().
+    ARX_EXTERN bool arwSessionGetTrackableOptionString(ARWSession *session, int trackableUID, int option, char *buf, int bufLen); ///< Session variant of arwGetTrackableOptionString().
+    ARX_EXTERN void arwSessionSetTrackableOptionString(ARWSession *session, int trackableUID, int option, char *str); ///< Session variant of arwSetTrackableOptionString().
+    ARX_EXTERN bool arwSessionLoadOpticalParams(ARWSession *session, const char *optical_param_name, const char *optical_param_buff, const int optical_param_buffLen, const float projectionNearPlane, const float projectionFarPlane, float *fovy_p, float *aspect_p, float m[16], float p[16]); ///< Session variant of arwLoadOpticalParams().
+    ARX_EXTERN bool arwSessionGetTimingStats(ARWSession *session, int stage, ARWTimingStats *stats); ///< Session variant of arwGetTimingStats().
+    ARX_EXTERN void arwSessionResetTimingStats(ARWSession *session); ///< Session variant of arwResetTimingStats().
+    ARX_EXTERN void arwSessionSetTimingStatsWindowSize(ARWSession *session, int frames); ///< Session variant of arwSetTimingStatsWindowSize().
+
 #ifdef __cplusplus
 }
 #endif
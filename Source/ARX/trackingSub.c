@@ -44,6 +44,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ARX/ARUtil/stage_timing.h>
 
 typedef struct {
     KpmHandle              *kpmHandle;      // KPM-related data.
@@ -173,7 +174,9 @@ static void *trackingInitMain( THREAD_HANDLE_T *threadHandle )
     for(;;) {
         if( threadStartWait(threadHandle) < 0 ) break;
 
+        AR_STAGE_TIMING_BEGIN(AR_STAGE_NFT_KPM);
         kpmMatching(kpmHandle, imageLumaPtr);
+        AR_STAGE_TIMING_END(AR_STAGE_NFT_KPM);
         trackingInitHandle->flag = 0;
         for( i = 0; i < kpmResultNum; i++ ) {
             if( kpmResult[i].camPoseF != 0 ) continue;
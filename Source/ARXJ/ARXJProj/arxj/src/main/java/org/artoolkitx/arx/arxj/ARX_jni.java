@@ -456,7 +456,9 @@ public class ARX_jni {
 							ARW_TRACKER_OPTION_2D_MAXIMUM_MARKERS_TO_TRACK = 12,           ///< Maximum number of markers able to be tracked simultaneously. Defaults to 1. Should not be set higher than the number of 2D markers loaded.
 							ARW_TRACKER_OPTION_SQUARE_MATRIX_MODE_AUTOCREATE_NEW_TRACKABLES = 13, ///< If true, when the square tracker is detecting matrix (barcode) markers, new trackables will be created for unmatched markers. Defaults to false. bool.
 							ARW_TRACKER_OPTION_SQUARE_MATRIX_MODE_AUTOCREATE_NEW_TRACKABLES_DEFAULT_WIDTH = 14, ///< If ARW_TRACKER_OPTION_SQUARE_MATRIX_MODE_AUTOCREATE_NEW_TRACKABLES is true, this value will be used for the initial width of new trackables for unmatched markers. Defaults to 80.0f. float.
-							ARW_TRACKER_OPTION_2D_THREADED = 15;                           ///< bool, If false, 2D tracking updates synchronously, and arwUpdateAR will not return until 2D tracking is complete. If true, 2D tracking updates asychronously on a secondary thread, and arwUpdateAR will not block if the track is busy. Defaults to true.
+							ARW_TRACKER_OPTION_2D_THREADED = 15,                           ///< bool, If false, 2D tracking updates synchronously, and arwUpdateAR will not return until 2D tracking is complete. If true, 2D tracking updates asychronously on a secondary thread, and arwUpdateAR will not block if the track is busy. Defaults to true.
+							ARW_TRACKER_OPTION_PARALLEL_TRACKER_UPDATE = 16,               ///< bool, If true, and more than one tracker (square, NFT, 2D) has trackables loaded, the trackers are updated concurrently on the same video frame, and arwUpdateAR returns once all have completed. Defaults to false.
+							ARW_TRACKER_OPTION_SQUARE_LABELING_THREAD_COUNT = 17;          ///< Number of threads used to label the image, each labeling a horizontal band. -1 means one thread per CPU. Defaults to 1. int.
 
     // ARW_TRACKER_OPTION_SQUARE_THRESHOLD_MODE
     public static final int AR_LABELING_THRESH_MODE_MANUAL = 0,
@@ -0,0 +1,342 @@
+/*
+ *  benchmark.cpp
+ *  artoolkitX
+ *
+ *  Headless end-to-end benchmark of the tracking pipeline. Drives ARController
+ *  over a recorded video (or any other video source) with a chosen mix of
+ *  trackables, and reports the time taken by each stage of the pipeline.
+ *
+ *  Run with --help for usage.
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ */
+
+
+// ============================================================================
+//	Includes
+// ============================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <algorithm>
+#include <ARX/ARController.h>
+#include <ARX/ARUtil/time.h>
+#include <ARX/ARUtil/stage_timing.h>
+#include <ARX/ARUtil/profile.h>
+
+
+// ============================================================================
+//	Constants
+// ============================================================================
+
+#define WARMUP_FRAMES_DEFAULT 10
+#define IDLE_TIMEOUT 2.0    // Seconds without a new frame after which the video source is assumed to have finished.
+
+// Frame-level measurements, reported after the per-stage measurements.
+enum {
+    FRAME_CAPTURE = 0,
+    FRAME_UPDATE,
+    FRAME_TOTAL,
+    FRAME_COUNT
+};
+static const char *frameNames[FRAME_COUNT] = {"capture()", "update()", "frame total"};
+
+
+// ============================================================================
+//	Global variables
+// ============================================================================
+
+static const char *vconf = NULL;
+static const char *cpara = NULL;
+static std::vector<std::string> gTrackableConfigs;
+static long gFramesMax = 0;                 // 0 = until the video source runs out.
+static long gWarmupFrames = WARMUP_FRAMES_DEFAULT;
+static bool gParallel = false;
+static int gLabelingThreads = -2;           // -2 = leave at default.
+static bool gCSV = false;
+static bool gProfile = false;
+
+static std::mutex gSamplesLock;
+static bool gSampling = false;
+static std::vector<double> gStageSamples[AR_STAGE_COUNT];
+static std::vector<double> gFrameSamples[FRAME_COUNT];
+
+
+// ============================================================================
+//	Function prototypes
+// ============================================================================
+
+static void processCommandLineOptions(int argc, char *argv[]);
+static void usage(char *com);
+static void stageTimingCallback(AR_STAGE stage, double seconds, void *userData);
+static void report(long frames, double elapsed);
+
+// ============================================================================
+//	Functions
+// ============================================================================
+
+int main(int argc, char *argv[])
+{
+    arLogLevel = AR_LOG_LEVEL_WARN;
+
+    processCommandLineOptions(argc, argv);
+    if (gTrackableConfigs.empty()) {
+        ARLOGe("Error: no trackables specified.\n");
+        usage(argv[0]);
+    }
+
+    ARController *arController = new ARController;
+    if (!arController->initialiseBase()) {
+        ARLOGe("Error initialising ARController.\n");
+        return -1;
+    }
+    for (const std::string& cfg : gTrackableConfigs) {
+        if (arController->addTrackable(cfg) < 0) {
+            ARLOGe("Error adding trackable '%s'.\n", cfg.c_str());
+            return -1;
+        }
+    }
+    arController->setParallelTrackerUpdate(gParallel);
+    if (gLabelingThreads != -2) arController->getSquareTracker()->setLabelingThreadCount(gLabelingThreads);
+
+    if (!arController->startRunning(vconf, cpara, NULL, 0)) {
+        ARLOGe("Error starting video.\n");
+        return -1;
+    }
+
+    arUtilStageTimingSetCallback(stageTimingCallback, NULL);
+
+    // Main loop. Frames are processed as fast as the video source can supply them.
+    long frames = 0, framesMeasured = 0;
+    double idleStart = 0.0, measureStart = arUtilTimeMonotonic(), measureEnd = measureStart;
+    if (gWarmupFrames == 0) {
+        gSampling = true;
+        if (gProfile) arUtilProfileSetEnabled(1);
+    }
+    while (gFramesMax == 0 || framesMeasured < gFramesMax) {
+        double t0 = arUtilTimeMonotonic();
+        if (!arController->capture()) {
+            if (idleStart == 0.0) idleStart = t0;
+            else if (t0 - idleStart > IDLE_TIMEOUT) break;
+            arUtilSleep(1);
+            continue;
+        }
+        idleStart = 0.0;
+        double t1 = arUtilTimeMonotonic();
+        if (!arController->update()) {
+            ARLOGe("Error in ARController::update().\n");
+            break;
+        }
+        double t2 = arUtilTimeMonotonic();
+
+        frames++;
+        if (frames <= gWarmupFrames) {
+            if (frames == gWarmupFrames) {
+                std::lock_guard<std::mutex> lock(gSamplesLock);
+                gSampling = true;
+                measureStart = t2;
+                if (gProfile) arUtilProfileSetEnabled(1);
+            }
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(gSamplesLock);
+            gFrameSamples[FRAME_CAPTURE].push_back(t1 - t0);
+            gFrameSamples[FRAME_UPDATE].push_back(t2 - t1);
+            gFrameSamples[FRAME_TOTAL].push_back(t2 - t0);
+        }
+        framesMeasured++;
+        measureEnd = t2;
+    }
+
+    arController->stopRunning();
+    arUtilStageTimingSetCallback(NULL, NULL);
+    arController->shutdown();
+    delete arController;
+
+    if (!framesMeasured) {
+        ARLOGe("Error: no frames were measured (%ld frames processed, %ld warmup).\n", frames, gWarmupFrames);
+        return -1;
+    }
+    report(framesMeasured, measureEnd - measureStart);
+    if (gProfile) arUtilProfilePrint();
+    return 0;
+}
+
+static void stageTimingCallback(AR_STAGE stage, double seconds, void *userData)
+{
+    std::lock_guard<std::mutex> lock(gSamplesLock);
+    if (gSampling) gStageSamples[stage].push_back(seconds);
+}
+
+// Nearest-rank percentile of a sorted sample.
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    size_t rank = (size_t)ceil(p/100.0 * sorted.size());
+    if (rank < 1) rank = 1;
+    return sorted[rank - 1];
+}
+
+static void reportRow(const char *name, std::vector<double>& samples, long frames)
+{
+    if (samples.empty()) return;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    double mean = sum / samples.size();
+    if (gCSV) {
+        ARPRINT("%s,%zu,%.3f,%.4f,%.4f,%.4f,%.4f,%.4f\n", name, samples.size(), (double)samples.size()/frames,
+                mean*1000.0, percentile(samples, 50)*1000.0, percentile(samples, 90)*1000.0, percentile(samples, 99)*1000.0, samples.back()*1000.0);
+    } else {
+        ARPRINT("%-14s %8zu %7.2f %9.3f %9.3f %9.3f %9.3f %9.3f\n", name, samples.size(), (double)samples.size()/frames,
+                mean*1000.0, percentile(samples, 50)*1000.0, percentile(samples, 90)*1000.0, percentile(samples, 99)*1000.0, samples.back()*1000.0);
+    }
+}
+
+static void report(long frames, double elapsed)
+{
+    std::lock_guard<std::mutex> lock(gSamplesLock);
+
+    if (gCSV) {
+        ARPRINT("stage,calls,calls_per_frame,mean_ms,p50_ms,p90_ms,p99_ms,max_ms\n");
+    } else {
+        ARPRINT("%ld frames in %.3f s (%.1f frames/s), after %ld warmup frames.\n", frames, elapsed, (elapsed > 0.0 ? frames/elapsed : 0.0), gWarmupFrames);
+        ARPRINT("%-14s %8s %7s %9s %9s %9s %9s %9s\n", "stage", "calls", "/frame", "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms");
+    }
+    for (int i = 0; i < AR_STAGE_COUNT; i++) reportRow(arUtilStageTimingName((AR_STAGE)i), gStageSamples[i], frames);
+    for (int i = 0; i < FRAME_COUNT; i++) reportRow(frameNames[i], gFrameSamples[i], frames);
+}
+
+static void processCommandLineOptions(int argc, char *argv[])
+{
+    int i, gotTwoPartOption;
+    long tempL;
+    int tempI;
+
+    //
+    // Command-line options.
+    //
+
+    i = 1; // argv[0] is name of app, so start at 1.
+    while (i < argc) {
+        gotTwoPartOption = FALSE;
+        // Look for two-part options first.
+        if ((i + 1) < argc) {
+            if (strcmp(argv[i], "--vconf") == 0) {
+                i++;
+                vconf = argv[i];
+                gotTwoPartOption = TRUE;
+            } else if (strcmp(argv[i], "--cpara") == 0) {
+                i++;
+                cpara = argv[i];
+                gotTwoPartOption = TRUE;
+            } else if (strcmp(argv[i], "--trackable") == 0) {
+                i++;
+                gTrackableConfigs.push_back(argv[i]);
+                gotTwoPartOption = TRUE;
+            } else if (strcmp(argv[i], "--frames") == 0) {
+                i++;
+                if (sscanf(argv[i], "%ld", &tempL) == 1 && tempL >= 0) gFramesMax = tempL;
+                else ARLOGe("Error: argument '%s' to --frames invalid.\n", argv[i]);
+                gotTwoPartOption = TRUE;
+            } else if (strcmp(argv[i], "--warmup") == 0) {
+                i++;
+                if (sscanf(argv[i], "%ld", &tempL) == 1 && tempL >= 0) gWarmupFrames = tempL;
+                else ARLOGe("Error: argument '%s' to --warmup invalid.\n", argv[i]);
+                gotTwoPartOption = TRUE;
+            } else if (strcmp(argv[i], "--labelingThreads") == 0) {
+                i++;
+                if (strcmp(argv[i], "auto") == 0) gLabelingThreads = AR_LABELING_THREAD_COUNT_AUTO;
+                else if (sscanf(argv[i], "%d", &tempI) == 1 && tempI >= 1) gLabelingThreads = tempI;
+                else ARLOGe("Error: argument '%s' to --labelingThreads invalid.\n", argv[i]);
+                gotTwoPartOption = TRUE;
+            }
+        }
+        if (!gotTwoPartOption) {
+            // Look for single-part options.
+            if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-help") == 0 || strcmp(argv[i], "-h") == 0) {
+                usage(argv[0]);
+            } else if (strcmp(argv[i], "--version") == 0 || strcmp(argv[i], "-version") == 0 || strcmp(argv[i], "-v") == 0) {
+                ARPRINT("%s version %s\n", argv[0], AR_HEADER_VERSION_STRING);
+                exit(0);
+            } else if (strcmp(argv[i], "--parallel") == 0) {
+                gParallel = true;
+            } else if (strcmp(argv[i], "--csv") == 0) {
+                gCSV = true;
+            } else if (strcmp(argv[i], "--profile") == 0) {
+                gProfile = true;
+            } else if( strncmp(argv[i], "-loglevel=", 10) == 0 ) {
+                if (strcmp(&(argv[i][10]), "DEBUG") == 0) arLogLevel = AR_LOG_LEVEL_DEBUG;
+                else if (strcmp(&(argv[i][10]), "INFO") == 0) arLogLevel = AR_LOG_LEVEL_INFO;
+                else if (strcmp(&(argv[i][10]), "WARN") == 0) arLogLevel = AR_LOG_LEVEL_WARN;
+                else if (strcmp(&(argv[i][10]), "ERROR") == 0) arLogLevel = AR_LOG_LEVEL_ERROR;
+                else usage(argv[0]);
+            } else {
+                ARLOGe("Error: invalid command line argument '%s'.\n", argv[i]);
+                usage(argv[0]);
+            }
+        }
+        i++;
+    }
+}
+
+static void usage(char *com)
+{
+    ARPRINT("Usage: %s [options] --trackable <config> [--trackable <config> ...]\n", com);
+    ARPRINT("Runs the tracking pipeline over a video source as fast as frames can be\n");
+    ARPRINT("supplied, and reports the time taken by each stage (luma, labeling,\n");
+    ARPRINT("pattern ID, pose, KPM, AR2, 2D matching) in milliseconds per call.\n");
+    ARPRINT("The trackers exercised are those required by the trackables added.\n");
+    ARPRINT("Options:\n");
+    ARPRINT("  --vconf <video parameter for the camera>\n");
+    ARPRINT("             For repeatable results, use a recording, e.g.\n");
+    ARPRINT("             \"-module=Replay -file=recording.arxv\".\n");
+    ARPRINT("  --cpara <camera parameter file for the camera>\n");
+    ARPRINT("  --trackable <config>: Add a trackable, using the same configuration\n");
+    ARPRINT("             string as ARController::addTrackable(), e.g.\n");
+    ARPRINT("             \"single;data/hiro.patt;80\" or \"nft;data/pinball\".\n");
+    ARPRINT("  --frames n: Measure n frames. Default is to measure until the video\n");
+    ARPRINT("             source supplies no new frame for %d seconds.\n", (int)IDLE_TIMEOUT);
+    ARPRINT("  --warmup n: Process n frames before measuring. Default %d.\n", WARMUP_FRAMES_DEFAULT);
+    ARPRINT("  --parallel: Update trackers in parallel.\n");
+    ARPRINT("  --labelingThreads n|auto: Number of threads used in square marker labeling.\n");
+    ARPRINT("  --csv: Output results as comma-separated values.\n");
+    ARPRINT("  --profile: Also print the hierarchical profile of all threads.\n");
+    ARPRINT("  -loglevel=l: Set the log level to l, where l is one of DEBUG INFO WARN ERROR.\n");
+    ARPRINT("             Default WARN.\n");
+    ARPRINT("  --version: Print artoolkitX version and exit.\n");
+    ARPRINT("  -h -help --help: show this message\n");
+    exit(0);
+}
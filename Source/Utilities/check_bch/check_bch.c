@@ -0,0 +1,171 @@
+/*
+ *  check_bch.c
+ *  artoolkitX
+ *
+ *  Checks that the table-driven BCH decoder used for the 4x4 and 5x5 BCH
+ *  matrix code types gives exactly the same results as the Berlekamp
+ *  decoder it was built from. For each code type, every possible received
+ *  word is decoded both ways, and the number of errors corrected (or
+ *  uncorrectable) and the decoded data bits are compared.
+ *
+ *  Exits with status 0 if all results match, 1 otherwise.
+ *
+ *  Run with "--help" parameter to see usage.
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ */
+
+
+// ============================================================================
+//	Includes
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+// The decoders are static, so the library source is compiled into this tool. See CMakeLists.txt.
+#include "arPattGetID.c"
+
+// ============================================================================
+//	Constants and types
+// ============================================================================
+
+typedef struct {
+    const char          *name;
+    AR_MATRIX_CODE_TYPE  matrixCodeType;
+} BCHCodeT;
+
+static const BCHCodeT codes[] = {
+    {"4x4 BCH(13,9,3)",  AR_MATRIX_CODE_4x4_BCH_13_9_3},
+    {"4x4 BCH(13,5,5)",  AR_MATRIX_CODE_4x4_BCH_13_5_5},
+    {"5x5 BCH(22,12,5)", AR_MATRIX_CODE_5x5_BCH_22_12_5},
+    {"5x5 BCH(22,7,7)",  AR_MATRIX_CODE_5x5_BCH_22_7_7},
+};
+#define CODE_NUM ((int)(sizeof(codes)/sizeof(codes[0])))
+
+// ============================================================================
+//	Global variables
+// ============================================================================
+
+static int verbose = 0;
+
+// ============================================================================
+//	Function prototypes
+// ============================================================================
+
+static void usage(char *com);
+static int decodeReference(const BCHTable *bch, uint32_t in, uint64_t *out_p);
+static int checkCode(const BCHCodeT *code, uint32_t *checkCount_p);
+
+int main(int argc, char *argv[])
+{
+    int i;
+    uint32_t checkCount = 0;
+    int failCount = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
+            verbose = 1;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "-help") == 0 || strcmp(argv[i], "--help") == 0) {
+            usage(argv[0]);
+        } else {
+            ARLOGe("Unrecognised option '%s'.\n", argv[i]);
+            usage(argv[0]);
+        }
+    }
+
+    for (i = 0; i < CODE_NUM; i++) {
+        failCount += checkCode(&codes[i], &checkCount);
+    }
+
+    ARPRINT("BCH table decoding: %u checks, %d mismatches.\n", checkCount, failCount);
+    return (failCount ? 1 : 0);
+}
+
+static void usage(char *com)
+{
+    ARPRINT("Usage: %s [options]\n", com);
+    ARPRINT("Compares table-driven and Berlekamp BCH decoding over every received word of each table-decoded matrix code type.\n");
+    ARPRINT("Options:\n");
+    ARPRINT("  -v, --verbose  Report every mismatch, not just the first per code type.\n");
+    ARPRINT("  -h, --help     Display this help.\n");
+    exit(0);
+}
+
+// As the non-table path of decode_bch().
+static int decodeReference(const BCHTable *bch, uint32_t in, uint64_t *out_p)
+{
+    uint8_t recd64[64];
+    uint64_t out_bit;
+    int i, ret;
+
+    for (i = 0; i < bch->length; i++) recd64[i] = (uint8_t)((in >> i) & 1);
+    ret = decode_bch_recd(bch->t, bch->n, bch->length, bch->alpha_to, bch->index_of, recd64);
+    if (ret < 0) return (ret);
+
+    *out_p = 0;
+    out_bit = 1;
+    for (i = bch->length - bch->k; i < bch->length; i++) {
+        *out_p += (uint64_t)recd64[i] * out_bit;
+        out_bit <<= 1;
+    }
+    return (ret);
+}
+
+// Returns the number of mismatches.
+static int checkCode(const BCHCodeT *code, uint32_t *checkCount_p)
+{
+    const BCHTable *bch;
+    uint32_t in, inNum;
+    uint64_t out0, out1;
+    int ret0, ret1;
+    int failCount = 0;
+
+    if (arPattBCHTableInit(code->matrixCodeType) < 0 || !(bch = bch_table_get(code->matrixCodeType))) {
+        ARLOGe("Unable to build decoding table for %s.\n", code->name);
+        return (1);
+    }
+
+    inNum = 1u << bch->length;
+    for (in = 0; in < inNum; in++) {
+        out0 = out1 = 0;
+        ret0 = decode_bch(code->matrixCodeType, in, NULL, &out0);
+        ret1 = decodeReference(bch, in, &out1);
+        if (ret0 != ret1 || (ret0 >= 0 && out0 != out1)) {
+            ARLOGe("Mismatch: %s, received word 0x%06x (table %d errors corrected, data 0x%llx; Berlekamp %d errors corrected, data 0x%llx).\n",
+                   code->name, in, ret0, (unsigned long long)out0, ret1, (unsigned long long)out1);
+            failCount++;
+            if (!verbose) break;
+        }
+    }
+    *checkCount_p += in;
+    if (verbose) ARPRINT("%s: %u received words checked.\n", code->name, in);
+    return (failCount);
+}
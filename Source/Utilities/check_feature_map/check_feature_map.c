@@ -0,0 +1,312 @@
+/*
+ *  check_feature_map.c
+ *  artoolkitX
+ *
+ *  Checks that the incremental feature map mode (AR2_FEATURE_MAP_MODE_INCREMENTAL)
+ *  agrees with the exact mode (AR2_FEATURE_MAP_MODE_EXACT) within the tolerance
+ *  documented in featureSet.h. An image is read and scaled to a set of
+ *  resolutions as genTexData would, and at each resolution the two modes'
+ *  feature maps and the features selected from them at each tracking
+ *  extraction level are compared.
+ *
+ *  Exits with status 0 if all results agree, 1 otherwise.
+ *
+ *  Run with "--help" parameter to see usage.
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ */
+
+
+// ============================================================================
+//	Includes
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ARX/AR/ar.h>
+#include <ARX/AR2/config.h>
+#include <ARX/AR2/imageFormat.h>
+#include <ARX/AR2/imageSet.h>
+#include <ARX/AR2/featureSet.h>
+
+// ============================================================================
+//	Constants and types
+// ============================================================================
+
+// Largest permitted difference between the two modes' scores, as documented in featureSet.h.
+#define SCORE_TOLERANCE     2e-3f
+
+#define LEVEL_NUM           5
+
+// The tracking extraction levels of genTexData.
+typedef struct {
+    float sd_thresh;
+    float min_sim_thresh;
+    float max_sim_thresh;
+    int   occ_size;
+} ExtractionLevelT;
+
+static const ExtractionLevelT levels[LEVEL_NUM] = {
+    {AR2_DEFAULT_SD_THRESH_L0, AR2_DEFAULT_MIN_SIM_THRESH_L0, AR2_DEFAULT_MAX_SIM_THRESH_L0, AR2_DEFAULT_OCCUPANCY_SIZE},
+    {AR2_DEFAULT_SD_THRESH_L1, AR2_DEFAULT_MIN_SIM_THRESH_L1, AR2_DEFAULT_MAX_SIM_THRESH_L1, AR2_DEFAULT_OCCUPANCY_SIZE},
+    {AR2_DEFAULT_SD_THRESH_L2, AR2_DEFAULT_MIN_SIM_THRESH_L2, AR2_DEFAULT_MAX_SIM_THRESH_L2, AR2_DEFAULT_OCCUPANCY_SIZE*2/3},
+    {AR2_DEFAULT_SD_THRESH_L3, AR2_DEFAULT_MIN_SIM_THRESH_L3, AR2_DEFAULT_MAX_SIM_THRESH_L3, AR2_DEFAULT_OCCUPANCY_SIZE*2/3},
+    {AR2_DEFAULT_SD_THRESH_L3, AR2_DEFAULT_MIN_SIM_THRESH_L3, AR2_DEFAULT_MAX_SIM_THRESH_L3, AR2_DEFAULT_OCCUPANCY_SIZE*1/2}
+};
+
+// Resolutions, as fractions of the image's own resolution, at which the modes are compared by default.
+static const float defaultScales[] = {0.5f, 0.3f};
+
+// ============================================================================
+//	Global variables
+// ============================================================================
+
+static int verbose = 0;
+
+// ============================================================================
+//	Function prototypes
+// ============================================================================
+
+static void usage(char *com);
+static int checkScale(AR2ImageT *image, int *checkCount_p);
+static int compareMaps(const AR2FeatureMapT *exact, const AR2FeatureMapT *incr, float dpi);
+static int compareFeatures(const AR2FeatureCoordT *exact, int exactNum, const AR2FeatureCoordT *incr, int incrNum,
+                           const AR2FeatureMapT *exactMap, const AR2FeatureMapT *incrMap, const ExtractionLevelT *level, int levelIndex, float dpi);
+static int nearThreshold(float score, const ExtractionLevelT *level);
+
+int main(int argc, char *argv[])
+{
+    int i;
+    int checkCount = 0;
+    int failCount = 0;
+    char *filename = NULL;
+    FILE *fp;
+    float dpiList[16];
+    int dpiNum = 0;
+    AR2JpegImageT *jpegImage;
+    AR2ImageSetT *imageSet;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
+            verbose = 1;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "-help") == 0 || strcmp(argv[i], "--help") == 0) {
+            usage(argv[0]);
+        } else if (strncmp(argv[i], "-dpi=", 5) == 0) {
+            if (dpiNum == sizeof(dpiList)/sizeof(dpiList[0]) || sscanf(&argv[i][5], "%f", &dpiList[dpiNum]) != 1 || dpiList[dpiNum] <= 0.0f) usage(argv[0]);
+            dpiNum++;
+        } else if (argv[i][0] == '-') {
+            ARLOGe("Unrecognised option '%s'.\n", argv[i]);
+            usage(argv[0]);
+        } else if (!filename) {
+            filename = argv[i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (!filename) usage(argv[0]);
+    arLogLevel = (verbose ? AR_LOG_LEVEL_INFO : AR_LOG_LEVEL_WARN); // Feature selection logs every feature at info level.
+
+    if (!(fp = fopen(filename, "rb"))) {
+        ARLOGe("Unable to open image '%s'.\n", filename);
+        ARLOGperror(NULL);
+        return (1);
+    }
+    jpegImage = ar2ReadJpegImage2(fp);
+    fclose(fp);
+    if (!jpegImage) {
+        ARLOGe("Unable to read image '%s'.\n", filename);
+        return (1);
+    }
+    if (jpegImage->dpi <= 0.0f) jpegImage->dpi = 72.0f;
+    if (!dpiNum) {
+        for (i = 0; i < (int)(sizeof(defaultScales)/sizeof(defaultScales[0])); i++) dpiList[dpiNum++] = jpegImage->dpi*defaultScales[i];
+    }
+    for (i = 0; i < dpiNum; i++) {
+        if (dpiList[i] > jpegImage->dpi) {
+            ARLOGe("Resolution %.3f dpi is greater than the image's own resolution of %.3f dpi.\n", dpiList[i], jpegImage->dpi);
+            ar2FreeJpegImage(&jpegImage);
+            return (1);
+        }
+    }
+    imageSet = ar2GenImageSet(jpegImage->image, jpegImage->xsize, jpegImage->ysize, jpegImage->nc, jpegImage->dpi, dpiList, dpiNum);
+    ar2FreeJpegImage(&jpegImage);
+    if (!imageSet) {
+        ARLOGe("Unable to generate image set.\n");
+        return (1);
+    }
+
+    for (i = 0; i < imageSet->num; i++) {
+        failCount += checkScale(imageSet->scale[i], &checkCount);
+    }
+    ar2FreeImageSet(&imageSet);
+
+    ARPRINT("Feature map modes: %d checks, %d disagreements.\n", checkCount, failCount);
+    return (failCount ? 1 : 0);
+}
+
+static void usage(char *com)
+{
+    ARPRINT("Usage: %s [options] image.jpg\n", com);
+    ARPRINT("Compares the exact and incremental feature map modes, and the features selected from each, on a JPEG image.\n");
+    ARPRINT("Options:\n");
+    ARPRINT("  -dpi=<dpi>     Compare at this resolution. May be given more than once.\n");
+    ARPRINT("                 Default is %.1f and %.1f times the image's resolution.\n", defaultScales[0], defaultScales[1]);
+    ARPRINT("  -v, --verbose  Report every disagreement, and the scores at every resolution.\n");
+    ARPRINT("  -h, --help     Display this help.\n");
+    exit(0);
+}
+
+// Returns the number of disagreeing checks.
+static int checkScale(AR2ImageT *image, int *checkCount_p)
+{
+    AR2FeatureMapT *map[2];
+    AR2FeatureCoordT *coord[2];
+    int num[2];
+    int i, mode;
+    int failCount = 0;
+
+    for (mode = 0; mode < 2; mode++) {
+        map[mode] = ar2GenFeatureMap2(image,
+                                      AR2_DEFAULT_TS1*AR2_TEMP_SCALE, AR2_DEFAULT_TS2*AR2_TEMP_SCALE,
+                                      AR2_DEFAULT_GEN_FEATURE_MAP_SEARCH_SIZE1, AR2_DEFAULT_GEN_FEATURE_MAP_SEARCH_SIZE2,
+                                      AR2_DEFAULT_MAX_SIM_THRESH2, AR2_DEFAULT_SD_THRESH2,
+                                      (mode == 0 ? AR2_FEATURE_MAP_MODE_EXACT : AR2_FEATURE_MAP_MODE_INCREMENTAL), AR2_FEATURE_MAP_DEFAULT_THREAD_NUM);
+        if (!map[mode]) {
+            ARLOGe("Unable to generate feature map at %.3f dpi.\n", image->dpi);
+            if (mode) ar2FreeFeatureMap(map[0]);
+            (*checkCount_p)++;
+            return (1);
+        }
+    }
+
+    (*checkCount_p)++;
+    if (compareMaps(map[0], map[1], image->dpi) != 0) failCount++;
+
+    for (i = 0; i < LEVEL_NUM; i++) {
+        for (mode = 0; mode < 2; mode++) {
+            coord[mode] = ar2SelectFeature2(image, map[mode],
+                                            AR2_DEFAULT_TS1*AR2_TEMP_SCALE, AR2_DEFAULT_TS2*AR2_TEMP_SCALE, AR2_DEFAULT_GEN_FEATURE_MAP_SEARCH_SIZE2,
+                                            levels[i].occ_size, levels[i].max_sim_thresh, levels[i].min_sim_thresh, levels[i].sd_thresh, &num[mode]);
+            if (!coord[mode]) num[mode] = 0;
+        }
+        (*checkCount_p)++;
+        if (compareFeatures(coord[0], num[0], coord[1], num[1], map[0], map[1], &levels[i], i, image->dpi) != 0) failCount++;
+        free(coord[0]);
+        free(coord[1]);
+    }
+
+    ar2FreeFeatureMap(map[0]);
+    ar2FreeFeatureMap(map[1]);
+    return (failCount);
+}
+
+// A map entry of 1.0 marks a position with too little texture to be a feature. Scores over
+// AR2_DEFAULT_MAX_SIM_THRESH2 are the first similarity found over it, and so depend on the search
+// order, not just on precision; for those, only that both modes found such a score is checked.
+static int compareMaps(const AR2FeatureMapT *exact, const AR2FeatureMapT *incr, float dpi)
+{
+    int i, n;
+    int scored = 0, failCount = 0;
+    float a, b, d, maxDiff = 0.0f;
+
+    if (exact->xsize != incr->xsize || exact->ysize != incr->ysize) {
+        ARLOGe("Feature map sizes differ at %.3f dpi: exact %dx%d, incremental %dx%d.\n", dpi, exact->xsize, exact->ysize, incr->xsize, incr->ysize);
+        return (-1);
+    }
+    n = exact->xsize*exact->ysize;
+    for (i = 0; i < n; i++) {
+        a = exact->map[i];
+        b = incr->map[i];
+        if (a == 1.0f && b == 1.0f) continue;
+        scored++;
+        if (a == 1.0f || b == 1.0f) {
+            d = 1.0f;
+        } else if (a > AR2_DEFAULT_MAX_SIM_THRESH2 && b > AR2_DEFAULT_MAX_SIM_THRESH2) {
+            continue;
+        } else if (a > AR2_DEFAULT_MAX_SIM_THRESH2 || b > AR2_DEFAULT_MAX_SIM_THRESH2) {
+            // Either side of the threshold. Only the score below it is fully computed.
+            d = (a > b ? AR2_DEFAULT_MAX_SIM_THRESH2 - b : AR2_DEFAULT_MAX_SIM_THRESH2 - a);
+        } else {
+            d = fabsf(a - b);
+        }
+        if (d > maxDiff) maxDiff = d;
+        if (d > SCORE_TOLERANCE) {
+            if (!failCount || verbose) {
+                ARLOGe("Feature map scores differ at %.3f dpi, (%d, %d): exact %f, incremental %f.\n", dpi, i % exact->xsize, i / exact->xsize, a, b);
+            }
+            failCount++;
+        }
+    }
+    if (verbose) ARPRINT("%.3f dpi: %d positions scored, largest score difference %g.\n", dpi, scored, maxDiff);
+    if (failCount) {
+        ARLOGe("Feature map scores differ by more than %g at %d of %d positions at %.3f dpi.\n", SCORE_TOLERANCE, failCount, scored, dpi);
+        return (-1);
+    }
+    return (0);
+}
+
+// Selection is greedy, so once the lists diverge they may go on to differ anywhere. The lists may
+// legitimately diverge only at a feature whose score, in either map, is within tolerance of a
+// threshold.
+static int compareFeatures(const AR2FeatureCoordT *exact, int exactNum, const AR2FeatureCoordT *incr, int incrNum,
+                           const AR2FeatureMapT *exactMap, const AR2FeatureMapT *incrMap, const ExtractionLevelT *level, int levelIndex, float dpi)
+{
+    int i, pos;
+
+    for (i = 0; i < exactNum && i < incrNum; i++) {
+        if (exact[i].x != incr[i].x || exact[i].y != incr[i].y) break;
+    }
+    if (i == exactNum && i == incrNum) {
+        if (verbose) ARPRINT("%.3f dpi, level %d: %d features selected by both modes.\n", dpi, levelIndex, exactNum);
+        return (0);
+    }
+    if (i < exactNum) {
+        pos = exact[i].y*exactMap->xsize + exact[i].x;
+        if (nearThreshold(exactMap->map[pos], level) || nearThreshold(incrMap->map[pos], level)) goto near;
+    }
+    if (i < incrNum) {
+        pos = incr[i].y*incrMap->xsize + incr[i].x;
+        if (nearThreshold(exactMap->map[pos], level) || nearThreshold(incrMap->map[pos], level)) goto near;
+    }
+    ARLOGe("Selected features differ at %.3f dpi, level %d, from feature %d: exact %d features, incremental %d features.\n", dpi, levelIndex, i, exactNum, incrNum);
+    return (-1);
+
+near:
+    if (verbose) ARPRINT("%.3f dpi, level %d: selected features diverge from feature %d, at a score within tolerance of a threshold.\n", dpi, levelIndex, i);
+    return (0);
+}
+
+static int nearThreshold(float score, const ExtractionLevelT *level)
+{
+    return (fabsf(score - level->min_sim_thresh) <= SCORE_TOLERANCE || fabsf(score - level->max_sim_thresh) <= SCORE_TOLERANCE
+         || fabsf(score - AR2_DEFAULT_MAX_SIM_THRESH2) <= SCORE_TOLERANCE);
+}
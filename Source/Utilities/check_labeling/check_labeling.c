@@ -0,0 +1,395 @@
+/*
+ *  check_labeling.c
+ *  artoolkitX
+ *
+ *  Checks that the SIMD labeling paths produce exactly the same results as
+ *  the scalar labeling, over a corpus of synthetic frames and optionally
+ *  any number of 8-bit binary PGM frames given on the command line. Every
+ *  labeling variant (debug/non-debug, black/white region, frame/field image,
+ *  fixed/adaptive threshold) is run over every frame at a range of
+ *  thresholds, and the label images, binarised images, label counts, areas,
+ *  clip rectangles and centroids are compared bit-for-bit.
+ *
+ *  Exits with status 0 if all results match, 1 otherwise.
+ *
+ *  Run with "--help" parameter to see usage.
+ *
+ *  This file is part of artoolkitX.
+ *
+ *  artoolkitX is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  artoolkitX is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with artoolkitX.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2018 Realmax, Inc.
+ *
+ */
+
+
+// ============================================================================
+//	Includes
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ARX/AR/ar.h>
+#include "arLabelingSub/arLabelingPrivate.h"
+
+// ============================================================================
+//	Constants and types
+// ============================================================================
+
+#define CORPUS_PATTERN_NUM 6
+
+typedef int (*LabelingFuncT)(ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo);
+typedef int (*LabelingAdaptiveFuncT)(ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo);
+
+typedef struct {
+    const char            *name;
+    LabelingFuncT          func;
+    LabelingFuncT          scalarFunc;
+    LabelingAdaptiveFuncT  adaptiveFunc;
+    LabelingAdaptiveFuncT  scalarAdaptiveFunc;
+    int                    debugMode;
+    int                    fieldImage;
+} LabelingVariantT;
+
+// The scalar copies of the labeling variants. See CMakeLists.txt.
+int scalar_arLabelingSubDBIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo );
+int scalar_arLabelingSubDBRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo );
+int scalar_arLabelingSubDWIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo );
+int scalar_arLabelingSubDWRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo );
+int scalar_arLabelingSubDBZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo );
+int scalar_arLabelingSubDWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo );
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+int scalar_arLabelingSubEBIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo );
+int scalar_arLabelingSubEBRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo );
+int scalar_arLabelingSubEWIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo );
+int scalar_arLabelingSubEWRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo );
+int scalar_arLabelingSubEBZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo );
+int scalar_arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo );
+#endif
+
+static const LabelingVariantT variants[] = {
+    {"DBIC", arLabelingSubDBIC, scalar_arLabelingSubDBIC, NULL, NULL, 0, 1},
+    {"DBRC", arLabelingSubDBRC, scalar_arLabelingSubDBRC, NULL, NULL, 0, 0},
+    {"DWIC", arLabelingSubDWIC, scalar_arLabelingSubDWIC, NULL, NULL, 0, 1},
+    {"DWRC", arLabelingSubDWRC, scalar_arLabelingSubDWRC, NULL, NULL, 0, 0},
+    {"DBZ",  NULL, NULL, arLabelingSubDBZ, scalar_arLabelingSubDBZ, 0, 0},
+    {"DWZ",  NULL, NULL, arLabelingSubDWZ, scalar_arLabelingSubDWZ, 0, 0},
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+    {"EBIC", arLabelingSubEBIC, scalar_arLabelingSubEBIC, NULL, NULL, 1, 1},
+    {"EBRC", arLabelingSubEBRC, scalar_arLabelingSubEBRC, NULL, NULL, 1, 0},
+    {"EWIC", arLabelingSubEWIC, scalar_arLabelingSubEWIC, NULL, NULL, 1, 1},
+    {"EWRC", arLabelingSubEWRC, scalar_arLabelingSubEWRC, NULL, NULL, 1, 0},
+    {"EBZ",  NULL, NULL, arLabelingSubEBZ, scalar_arLabelingSubEBZ, 1, 0},
+    {"EWZ",  NULL, NULL, arLabelingSubEWZ, scalar_arLabelingSubEWZ, 1, 0},
+#endif
+};
+#define VARIANT_NUM ((int)(sizeof(variants)/sizeof(variants[0])))
+
+// Odd sizes exercise the row tails which the SIMD runs can't cover. The corpus is kept
+// small enough to run as a quick test; pass real frames on the command line for more.
+static const int corpusSizes[][2] = {
+    {641, 481},
+    {320, 240},
+    {97, 61},
+    {35, 19},
+};
+#define CORPUS_SIZE_NUM ((int)(sizeof(corpusSizes)/sizeof(corpusSizes[0])))
+
+static const int thresholds[] = {0, 60, 127, 180, 255};
+#define THRESHOLD_NUM ((int)(sizeof(thresholds)/sizeof(thresholds[0])))
+
+// ============================================================================
+//	Global variables
+// ============================================================================
+
+static int verbose = 0;
+static unsigned int randSeed = 1;
+static ARLabelInfo *labelInfo[2] = {NULL, NULL};
+
+// ============================================================================
+//	Function prototypes
+// ============================================================================
+
+static void usage(char *com);
+static unsigned int nextRand(void);
+static void genCorpusFrame(ARUint8 *image, int xsize, int ysize, int pattern);
+static void genThresholdImage(const ARUint8 *image, ARUint8 *image_thresh, int xsize, int ysize);
+static ARUint8 *readPGM(const char *filename, int *xsize_p, int *ysize_p);
+static int checkFrame(ARUint8 *image, int xsize, int ysize, const char *frameName, int *checkCount_p);
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+static int bwImageEqual(const ARUint8 *a, const ARUint8 *b, int lxsize, int lysize);
+#endif
+static int compareResults(const LabelingVariantT *v, int xsize, int ysize, int ret0, int ret1, const char *frameName, int thresh);
+
+int main(int argc, char *argv[])
+{
+    int i, j;
+    int checkCount = 0;
+    int failCount = 0;
+    int xsize, ysize;
+    ARUint8 *image;
+    char frameName[64];
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
+            verbose = 1;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "-help") == 0 || strcmp(argv[i], "--help") == 0) {
+            usage(argv[0]);
+        } else if (argv[i][0] == '-') {
+            ARLOGe("Unrecognised option '%s'.\n", argv[i]);
+            usage(argv[0]);
+        }
+    }
+
+    arMalloc(labelInfo[0], ARLabelInfo, 1);
+    arMalloc(labelInfo[1], ARLabelInfo, 1);
+
+    // Synthetic corpus.
+    for (i = 0; i < CORPUS_SIZE_NUM; i++) {
+        xsize = corpusSizes[i][0];
+        ysize = corpusSizes[i][1];
+        arMalloc(image, ARUint8, xsize*ysize);
+        for (j = 0; j < CORPUS_PATTERN_NUM; j++) {
+            genCorpusFrame(image, xsize, ysize, j);
+            snprintf(frameName, sizeof(frameName), "synthetic %dx%d pattern %d", xsize, ysize, j);
+            failCount += checkFrame(image, xsize, ysize, frameName, &checkCount);
+        }
+        free(image);
+    }
+
+    // User-supplied frames.
+    for (i = 1; i < argc; i++) {
+        if (argv[i][0] == '-') continue;
+        if (!(image = readPGM(argv[i], &xsize, &ysize))) {
+            failCount++;
+            continue;
+        }
+        failCount += checkFrame(image, xsize, ysize, argv[i], &checkCount);
+        free(image);
+    }
+
+    free(labelInfo[0]);
+    free(labelInfo[1]);
+
+#ifdef AR_LABELING_SIMD_RUN
+    ARPRINT("SIMD labeling: %d checks, %d mismatches.\n", checkCount, failCount);
+#else
+    ARPRINT("SIMD labeling not enabled in this build; %d checks of scalar labeling against itself, %d mismatches.\n", checkCount, failCount);
+#endif
+    return (failCount ? 1 : 0);
+}
+
+static void usage(char *com)
+{
+    ARPRINT("Usage: %s [options] [frame.pgm ...]\n", com);
+    ARPRINT("Compares SIMD and scalar labeling over a synthetic corpus and any 8-bit binary PGM frames given.\n");
+    ARPRINT("Options:\n");
+    ARPRINT("  -v, --verbose  Report every mismatch, not just the first per frame.\n");
+    ARPRINT("  -h, --help     Display this help.\n");
+    exit(0);
+}
+
+// Deterministic LCG so that the corpus is identical on every platform.
+static unsigned int nextRand(void)
+{
+    randSeed = randSeed*1103515245u + 12345u;
+    return ((randSeed >> 16) & 0x7fff);
+}
+
+static void genCorpusFrame(ARUint8 *image, int xsize, int ysize, int pattern)
+{
+    int x, y, v, cell, size;
+
+    switch (pattern) {
+        case 0: // Sparse dark speckles on a light background.
+            for (y = 0; y < ysize; y++) for (x = 0; x < xsize; x++) image[y*xsize + x] = (nextRand() % 100 < 3 ? 20 : 180);
+            break;
+        case 1: // Checkerboard with a random cell size, so runs end at every offset.
+            cell = 1 + nextRand() % 23;
+            for (y = 0; y < ysize; y++) for (x = 0; x < xsize; x++) image[y*xsize + x] = (((x/cell) + (y/(cell + 1))) & 1 ? 200 : 30);
+            break;
+        case 2: // Smooth gradient rings covering the full grey range.
+            for (y = 0; y < ysize; y++) for (x = 0; x < xsize; x++) image[y*xsize + x] = (ARUint8)(((x - xsize/2)*(x - xsize/2)/7 + (y - ysize/3)*(y - ysize/3)/5) & 0xff);
+            break;
+        case 3: // Marker-like dark square borders on a noisy light background.
+            size = 8 + nextRand() % 40;
+            for (y = 0; y < ysize; y++) for (x = 0; x < xsize; x++) {
+                int mx = x % (size*2), my = y % (size*2);
+                v = 170 + (int)(nextRand() % 40);
+                if (mx < size && my < size && (mx < size/4 || mx >= size - size/4 || my < size/4 || my >= size - size/4)) v = 30 + (int)(nextRand() % 40);
+                image[y*xsize + x] = (ARUint8)v;
+            }
+            break;
+        case 4: // Thin vertical and horizontal lines, just longer and shorter than a SIMD run.
+            for (y = 0; y < ysize; y++) for (x = 0; x < xsize; x++) image[y*xsize + x] = ((x % 17 == 0) || (y % 13 == 0 && (x % 34) < 15) ? 10 : 240);
+            break;
+        default: // Uniform noise.
+            for (y = 0; y < ysize; y++) for (x = 0; x < xsize; x++) image[y*xsize + x] = (ARUint8)(nextRand() & 0xff);
+            break;
+    }
+}
+
+// Per-pixel thresholds near the local horizontal mean, plus noise.
+static void genThresholdImage(const ARUint8 *image, ARUint8 *image_thresh, int xsize, int ysize)
+{
+    int x, y, v;
+
+    for (y = 0; y < ysize; y++) {
+        for (x = 0; x < xsize; x++) {
+            v = image[y*xsize + (x > 0 ? x - 1 : x)] + image[y*xsize + x] + image[y*xsize + (x < xsize - 1 ? x + 1 : x)];
+            v = v/3 + (int)(nextRand() % 31) - 15;
+            image_thresh[y*xsize + x] = (ARUint8)(v < 0 ? 0 : (v > 255 ? 255 : v));
+        }
+    }
+}
+
+static ARUint8 *readPGM(const char *filename, int *xsize_p, int *ysize_p)
+{
+    FILE *fp;
+    int xsize, ysize, maxval;
+    ARUint8 *image;
+
+    if (!(fp = fopen(filename, "rb"))) {
+        ARLOGe("Unable to open frame '%s'.\n", filename);
+        ARLOGperror(NULL);
+        return (NULL);
+    }
+    if (fscanf(fp, "P5 %d %d %d", &xsize, &ysize, &maxval) != 3 || xsize < 3 || ysize < 3 || maxval != 255 || fgetc(fp) == EOF) {
+        ARLOGe("Frame '%s' is not an 8-bit binary PGM image.\n", filename);
+        fclose(fp);
+        return (NULL);
+    }
+    arMalloc(image, ARUint8, xsize*ysize);
+    if (fread(image, 1, xsize*ysize, fp) != (size_t)(xsize*ysize)) {
+        ARLOGe("Frame '%s' is truncated.\n", filename);
+        free(image);
+        fclose(fp);
+        return (NULL);
+    }
+    fclose(fp);
+    *xsize_p = xsize;
+    *ysize_p = ysize;
+    return (image);
+}
+
+// Returns the number of mismatching checks.
+static int checkFrame(ARUint8 *image, int xsize, int ysize, const char *frameName, int *checkCount_p)
+{
+    int i, j, k;
+    int ret[2];
+    int failCount = 0;
+    ARUint8 *image_thresh;
+
+    arMalloc(image_thresh, ARUint8, xsize*ysize);
+    for (i = 0; i < 2; i++) {
+        if (arLabelingInfoInit(labelInfo[i], xsize, ysize) < 0) exit(-1);
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+        arMalloc(labelInfo[i]->bwImage, ARUint8, xsize*ysize);
+#endif
+    }
+
+    for (i = 0; i < VARIANT_NUM; i++) {
+        const LabelingVariantT *v = &variants[i];
+        for (j = 0; j < THRESHOLD_NUM; j++) {
+            for (k = 0; k < 2; k++) {
+                // Poison the outputs so that any unwritten element shows up as a mismatch.
+                memset(labelInfo[k]->labelImage, 0xA5 + k, xsize*ysize*sizeof(AR_LABELING_LABEL_TYPE));
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+                memset(labelInfo[k]->bwImage, 0xA5 + k, xsize*ysize);
+#endif
+            }
+            if (v->adaptiveFunc) {
+                // Adaptive variants take a fresh threshold image on each pass instead.
+                genThresholdImage(image, image_thresh, xsize, ysize);
+                ret[0] = (*v->adaptiveFunc)(image, xsize, ysize, image_thresh, labelInfo[0]);
+                ret[1] = (*v->scalarAdaptiveFunc)(image, xsize, ysize, image_thresh, labelInfo[1]);
+            } else {
+                ret[0] = (*v->func)(image, xsize, ysize, thresholds[j], labelInfo[0]);
+                ret[1] = (*v->scalarFunc)(image, xsize, ysize, thresholds[j], labelInfo[1]);
+            }
+            (*checkCount_p)++;
+            if (compareResults(v, xsize, ysize, ret[0], ret[1], frameName, (v->adaptiveFunc ? -1 : thresholds[j])) != 0) {
+                failCount++;
+                if (!verbose) goto done;
+            }
+        }
+    }
+
+done:
+    for (i = 0; i < 2; i++) {
+        arLabelingInfoFinal(labelInfo[i]);
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+        free(labelInfo[i]->bwImage);
+#endif
+    }
+    free(image_thresh);
+    return (failCount);
+}
+
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+// The labeling doesn't write the border pixels of the binarised image, so only the interior is compared.
+static int bwImageEqual(const ARUint8 *a, const ARUint8 *b, int lxsize, int lysize)
+{
+    int j;
+
+    for (j = 1; j < lysize - 1; j++) {
+        if (memcmp(&a[j*lxsize + 1], &b[j*lxsize + 1], lxsize - 2) != 0) return (0);
+    }
+    return (1);
+}
+#endif
+
+static int compareResults(const LabelingVariantT *v, int xsize, int ysize, int ret0, int ret1, const char *frameName, int thresh)
+{
+    ARLabelInfo *a = labelInfo[0], *b = labelInfo[1];
+    int lxsize, lysize;
+    const char *what = NULL;
+
+    if (v->fieldImage) {
+        lxsize = xsize / 2;
+        lysize = ysize / 2;
+    } else {
+        lxsize = xsize;
+        lysize = ysize;
+    }
+
+    if (ret0 != ret1) what = "return value";
+    else if (ret0 < 0) return (0);
+    else if (a->label_num != b->label_num) what = "label count";
+    else if (memcmp(a->labelImage, b->labelImage, lxsize*lysize*sizeof(AR_LABELING_LABEL_TYPE)) != 0) what = "label image";
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+    else if (v->debugMode && !bwImageEqual(a->bwImage, b->bwImage, lxsize, lysize)) what = "binarised image";
+#endif
+    else if (a->label_num == 0) return (0);
+    else if (memcmp(a->area, b->area, a->label_num*sizeof(a->area[0])) != 0) what = "areas";
+    else if (memcmp(a->clip, b->clip, a->label_num*sizeof(a->clip[0])) != 0) what = "clip rectangles";
+    else if (memcmp(a->pos, b->pos, a->label_num*sizeof(a->pos[0])) != 0) what = "centroids";
+    else return (0);
+
+    if (thresh < 0) ARLOGe("Mismatch in %s: %s, variant %s, adaptive threshold (SIMD %d labels, scalar %d labels).\n", what, frameName, v->name, a->label_num, b->label_num);
+    else ARLOGe("Mismatch in %s: %s, variant %s, threshold %d (SIMD %d labels, scalar %d labels).\n", what, frameName, v->name, thresh, a->label_num, b->label_num);
+    return (-1);
+}
@@ -53,6 +53,8 @@
 #include <ARX/AR2/featureSet.h>
 #include <ARX/AR2/util.h>
 #include <ARX/KPM/kpm.h>
+#include <ARX/ARUtil/thread_sub.h>
+#include <pthread.h>
 #ifdef _WIN32
 #  define MAXPATHLEN MAX_PATH
 #else
@@ -72,6 +74,7 @@
 #define          TRACKING_EXTRACTION_LEVEL_DEFAULT 2
 #define          INITIALIZATION_EXTRACTION_LEVEL_DEFAULT 1
 #define KPM_MINIMUM_IMAGE_SIZE 28 // Filter size for 1 octaves plus 1.
+#define GEN_TEX_DATA_BATCH_THREAD_MAX 64
 //#define KPM_MINIMUM_IMAGE_SIZE 196 // Filter size for 4 octaves plus 1.
 
 #ifndef MIN
@@ -91,6 +94,7 @@ enum {
 
 static int                  genfset = 1;
 static int                  genfset3 = 1;
+static int                  featureMapMode = AR2_FEATURE_MAP_MODE_EXACT;
 
 static char                 filename[MAXPATHLEN] = "";
 static AR2JpegImageT       *jpegImage;
@@ -112,6 +116,26 @@ static int                  occ_size = -1;
 static int                  tracking_extraction_level = -1; // Allows specification from command-line.
 static int                  initialization_extraction_level = -1;
 
+static char                 batchfile[MAXPATHLEN] = "";
+static int                  threadNum = -1;
+
+// One image listed in a -batch manifest.
+typedef struct {
+    char             filename[MAXPATHLEN];
+    float            dpiMin;            // -1 if not given.
+    float            dpiMax;            // -1 if not given.
+    float            dpi;               // -1 if not given.
+    int              err;
+} BatchImage;
+
+typedef struct {
+    BatchImage      *images;
+    int              imageNum;
+    int              next;              // Index of next image to be started.
+    int              featureMapThreadNum;
+    pthread_mutex_t  lock;              // Protects: next.
+} BatchQueue;
+
 static int                  background = 0;
 static char                 logfile[MAXPATHLEN] = "";
 static char                 exitcodefile[MAXPATHLEN] = "";
@@ -122,24 +146,19 @@ static char                 exitcode = -1;
 static void  usage( char *com );
 static int   readImageFromFile(const char *filename, ARUint8 **image_p, int *xsize_p, int *ysize_p, int *nc_p, float *dpi_p);
 static int   setDPI( void );
+static int   hasJPEGExtension( const char *path );
+static float getDPIMinAllowable( int xsize, int ysize, float dpi );
+static void  genDPIList( float minDpi, float maxDpi, float **dpi_list_p, int *dpi_num_p );
+static int   genDataSets( char *filename, AR2JpegImageT **jpegImage_p, float dpi, float *dpi_list, int dpi_num, int featureMapThreadNum );
+static int   genBatch( const char *manifest );
 static void  write_exitcode(void);
 
 int main( int argc, char *argv[] )
 {
-    AR2JpegImageT       *jpegImage = NULL;
     ARUint8             *image = NULL;
-    AR2ImageSetT        *imageSet = NULL;
-    AR2FeatureMapT      *featureMap = NULL;
-    AR2FeatureSetT      *featureSet = NULL;
-    KpmRefDataSet       *refDataSet = NULL;
-    float                scale1, scale2;
-    int                  procMode;
     char                 buf[1024];
-    int                  num;
-    int                  i, j;
-    char                *sep = NULL;
+    int                  i;
 	time_t				 clock;
-    int                  maxFeatureNum;
     int                  err;
 
     for( i = 1; i < argc; i++ ) {
@@ -177,6 +196,13 @@ int main( int argc, char *argv[] )
             genfset3 = 0;
         } else if( strcmp(argv[i], "-fset3") == 0 ) {
             genfset3 = 1;
+        } else if( strcmp(argv[i], "-fmap_incremental") == 0 ) {
+            featureMapMode = AR2_FEATURE_MAP_MODE_INCREMENTAL;
+        } else if( strncmp(argv[i], "-batch=", 7) == 0 ) {
+            strncpy(batchfile, &(argv[i][7]), sizeof(batchfile) - 1);
+            batchfile[sizeof(batchfile) - 1] = '\0'; // Ensure NULL termination.
+        } else if( strncmp(argv[i], "-threads=", 9) == 0 ) {
+            if( sscanf(&argv[i][9], "%d", &threadNum) != 1 || threadNum < 1 ) usage(argv[0]);
         } else if( strncmp(argv[i], "-log=", 5) == 0 ) {
             strncpy(logfile, &(argv[i][5]), sizeof(logfile) - 1);
             logfile[sizeof(logfile) - 1] = '\0'; // Ensure NULL termination.
@@ -204,18 +230,27 @@ int main( int argc, char *argv[] )
     }
     
     // Do some checks on the input.
-    if (filename[0] == '\0') {
-        ARPRINTE("Error: no input file specified. Exiting.\n");
-        usage(argv[0]);
-    }
-    sep = strrchr(filename, '.');
-    if (!sep || (strcmp(sep, ".jpeg") && strcmp(sep, ".jpg") && strcmp(sep, ".jpe") && strcmp(sep, ".JPEG") && strcmp(sep, ".JPE") && strcmp(sep, ".JPG"))) {
-        ARPRINTE("Error: input file must be a JPEG image (with suffix .jpeg/.jpg/.jpe). Exiting.\n");
-        usage(argv[0]);
+    if (batchfile[0]) {
+        if (filename[0] != '\0') {
+            ARPRINTE("Error: an input file cannot be specified with -batch. Exiting.\n");
+            usage(argv[0]);
+        }
+        // Batch mode never prompts, so use the default extraction levels unless told otherwise.
+        if (tracking_extraction_level == -1 && (sd_thresh == -1.0 || min_thresh == -1.0 || max_thresh == -1.0 || occ_size == -1)) tracking_extraction_level = TRACKING_EXTRACTION_LEVEL_DEFAULT;
+        if (initialization_extraction_level == -1 && featureDensity == -1) initialization_extraction_level = INITIALIZATION_EXTRACTION_LEVEL_DEFAULT;
+    } else {
+        if (filename[0] == '\0') {
+            ARPRINTE("Error: no input file specified. Exiting.\n");
+            usage(argv[0]);
+        }
+        if (!hasJPEGExtension(filename)) {
+            ARPRINTE("Error: input file must be a JPEG image (with suffix .jpeg/.jpg/.jpe). Exiting.\n");
+            usage(argv[0]);
+        }
     }
     if (background) {
 #if HAVE_DAEMON_FUNC
-        if (filename[0] != '/' || logfile[0] != '/' || exitcodefile[0] != '/') {
+        if ((batchfile[0] ? batchfile[0] : filename[0]) != '/' || logfile[0] != '/' || exitcodefile[0] != '/') {
             ARPRINTE("Error: -background flag requires full pathname of files (input, -log or -exitcode) to be specified. Exiting.\n");
             EXIT(E_BAD_PARAMETER);
         }
@@ -227,15 +262,16 @@ int main( int argc, char *argv[] )
             ARPRINTE("Error: -background flag requires -leveli or -surf_thresh to be set. Exiting.\n");
             EXIT(E_BAD_PARAMETER);
         }
-        if (dpi == -1.0) {
+        if (dpi == -1.0 && !batchfile[0]) {
             ARPRINTE("Error: -background flag requires -dpi to be set. Exiting.\n");
             EXIT(E_BAD_PARAMETER);
         }
-        if (dpiMin != -1.0f && (dpiMin <= 0.0f || dpiMin > dpi)) {
+        // In batch mode, resolutions are checked per image by genBatchImage().
+        if (!batchfile[0] && dpiMin != -1.0f && (dpiMin <= 0.0f || dpiMin > dpi)) {
             ARPRINTE("Error: -min_dpi must be greater than 0 and less than or equal to -dpi. Exiting.n\n");
             EXIT(E_BAD_PARAMETER);
         }
-        if (dpiMax != -1.0f && (dpiMax < dpiMin || dpiMax > dpi)) {
+        if (!batchfile[0] && dpiMax != -1.0f && (dpiMax < dpiMin || dpiMax > dpi)) {
             ARPRINTE("Error: -max_dpi must be greater than or equal to -min_dpi and less than or equal to -dpi. Exiting.n\n");
             EXIT(E_BAD_PARAMETER);
         }
@@ -349,27 +385,145 @@ int main( int argc, char *argv[] )
         ARPRINT("SURF_FEATURE = %d\n", featureDensity);
     }
 
-    if ((err = readImageFromFile(filename, &image, &xsize, &ysize, &nc, &dpi)) != 0) {
-        ARPRINTE("Error reading image from file '%s'.\n", filename);
-        EXIT(err);
+    if (batchfile[0]) {
+        if ((err = genBatch(batchfile)) != E_NO_ERROR) EXIT(err);
+    } else {
+        if ((err = readImageFromFile(filename, &image, &xsize, &ysize, &nc, &dpi)) != 0) {
+            ARPRINTE("Error reading image from file '%s'.\n", filename);
+            EXIT(err);
+        }
+
+        setDPI();
+
+        ar2UtilRemoveExt( filename );
+        if ((err = genDataSets(filename, &jpegImage, dpi, dpi_list, dpi_num, AR2_FEATURE_MAP_DEFAULT_THREAD_NUM)) != E_NO_ERROR) EXIT(err);
+    }
+
+    // Print the start date and time.
+    clock = time(NULL);
+    if (clock != (time_t)-1) {
+        struct tm *timeptr = localtime(&clock);
+        if (timeptr) {
+            char stime[26+8] = "";
+            if (strftime(stime, sizeof(stime), "%Y-%m-%d %H:%M:%S %z", timeptr)) // e.g. "1999-12-31 23:59:59 NZDT".
+                ARPRINT("Generator finished at %s\n--\n", stime);
+        }
     }
 
-    setDPI();
+    exitcode = E_NO_ERROR;
+    return (exitcode);
+}
+
+// Reads dpiMinAllowable, xsize, ysize, dpi, background, dpiMin, dpiMax.
+// Sets dpiMin, dpiMax, dpi_num, dpi_list.
+static int setDPI( void )
+{
+    float       dpiMinAllowable;
+    char		buf1[256];
+
+    // Determine minimum allowable DPI.
+    dpiMinAllowable = getDPIMinAllowable(xsize, ysize, dpi);
+    
+    if (background) {
+        if (dpiMin == -1.0f) dpiMin = dpiMinAllowable;
+        if (dpiMax == -1.0f) dpiMax = dpi;
+    }
+
+    if (dpiMin == -1.0f) {
+        for (;;) {
+            printf("Enter the minimum image resolution (DPI, in range [%.3f, %.3f]): ", dpiMinAllowable, (dpiMax == -1.0f ? dpi : dpiMax));
+            if( fgets( buf1, 256, stdin ) == NULL ) EXIT(E_USER_INPUT_CANCELLED);
+            if( sscanf(buf1, "%f", &dpiMin) == 0 ) continue;
+            if (dpiMin >= dpiMinAllowable && dpiMin <= (dpiMax == -1.0f ? dpi : dpiMax)) break;
+            else printf("Error: you entered %.3f, but value must be greater than or equal to %.3f and less than or equal to %.3f.\n", dpiMin, dpiMinAllowable, (dpiMax == -1.0f ? dpi : dpiMax));
+        }
+    } else if (dpiMin < dpiMinAllowable) {
+        ARPRINTE("Warning: -min_dpi=%.3f smaller than minimum allowable. Value will be adjusted to %.3f.\n", dpiMin, dpiMinAllowable);
+        dpiMin = dpiMinAllowable;
+    }
+    if (dpiMax == -1.0f) {
+        for (;;) {
+            printf("Enter the maximum image resolution (DPI, in range [%.3f, %.3f]): ", dpiMin, dpi);
+            if( fgets( buf1, 256, stdin ) == NULL ) EXIT(E_USER_INPUT_CANCELLED);
+            if( sscanf(buf1, "%f", &dpiMax) == 0 ) continue;
+            if (dpiMax >= dpiMin && dpiMax <= dpi) break;
+            else printf("Error: you entered %.3f, but value must be greater than or equal to minimum resolution (%.3f) and less than or equal to image resolution (%.3f).\n", dpiMax, dpiMin, dpi);
+        }
+    } else if (dpiMax > dpi) {
+        ARPRINTE("Warning: -max_dpi=%.3f larger than maximum allowable. Value will be adjusted to %.3f.\n", dpiMax, dpi);
+        dpiMax = dpi;
+    }
+    
+    genDPIList(dpiMin, dpiMax, &dpi_list, &dpi_num);
+
+    return 0;
+}
+
+// Chooses resolution levels from maxDpi down to minDpi, spaced by a factor of 2^(1/3).
+static void genDPIList( float minDpi, float maxDpi, float **dpi_list_p, int *dpi_num_p )
+{
+    float       dpiWork;
+    float      *list;
+    int         num;
+    int         i;
+
+    // Decide how many levels we need.
+    if (minDpi == maxDpi) {
+        num = 1;
+    } else {
+        dpiWork = minDpi;
+        for( i = 1;; i++ ) {
+            dpiWork *= powf(2.0f, 1.0f/3.0f); // *= 1.25992104989487
+            if( dpiWork >= maxDpi*0.95f ) {
+                break;
+            }
+        }
+        num = i + 1;
+    }
+    arMalloc(list, float, num);
+    
+    // Determine the DPI values of each level.
+    dpiWork = minDpi;
+    for( i = 0; i < num; i++ ) {
+        ARPRINT("Image DPI (%d): %f\n", i+1, dpiWork);
+        list[num - i - 1] = dpiWork; // Lowest value goes at tail of array, highest at head.
+        dpiWork *= powf(2.0f, 1.0f/3.0f);
+        if( dpiWork >= maxDpi*0.95f ) dpiWork = maxDpi;
+    }
+
+    *dpi_list_p = list;
+    *dpi_num_p = num;
+}
+
+// Generates and saves the .iset, and optionally the .fset and .fset3, for one image. filename has no extension.
+// The JPEG image is freed once the image set has been generated. Returns E_NO_ERROR or an error code.
+static int genDataSets( char *filename, AR2JpegImageT **jpegImage_p, float dpi, float *dpi_list, int dpi_num, int featureMapThreadNum )
+{
+    AR2ImageSetT        *imageSet = NULL;
+    AR2FeatureMapT      *featureMap = NULL;
+    AR2FeatureSetT      *featureSet = NULL;
+    KpmRefDataSet       *refDataSet = NULL;
+    float                scale1, scale2;
+    int                  procMode;
+    int                  num;
+    int                  i, j;
+    int                  maxFeatureNum;
+    int                  err = E_NO_ERROR;
 
     ARPRINT("Generating ImageSet...\n");
-    ARPRINT("   (Source image xsize=%d, ysize=%d, channels=%d, dpi=%.1f).\n", xsize, ysize, nc, dpi);
-    imageSet = ar2GenImageSet( image, xsize, ysize, nc, dpi, dpi_list, dpi_num );
-    ar2FreeJpegImage(&jpegImage);
+    ARPRINT("   (Source image xsize=%d, ysize=%d, channels=%d, dpi=%.1f).\n", (*jpegImage_p)->xsize, (*jpegImage_p)->ysize, (*jpegImage_p)->nc, dpi);
+    imageSet = ar2GenImageSet( (*jpegImage_p)->image, (*jpegImage_p)->xsize, (*jpegImage_p)->ysize, (*jpegImage_p)->nc, dpi, dpi_list, dpi_num );
+    ar2FreeJpegImage(jpegImage_p);
     if( imageSet == NULL ) {
         ARPRINTE("ImageSet generation error!!\n");
-        EXIT(E_DATA_PROCESSING_ERROR);
+        return (E_DATA_PROCESSING_ERROR);
     }
     ARPRINT("  Done.\n");
-    ar2UtilRemoveExt( filename );
     ARPRINT("Saving to %s.iset...\n", filename);
     if( ar2WriteImageSet( filename, imageSet ) < 0 ) {
         ARPRINTE("Save error: %s.iset\n", filename );
-        EXIT(E_DATA_PROCESSING_ERROR);
+        err = E_DATA_PROCESSING_ERROR;
+        goto done;
     }
     ARPRINT("  Done.\n");
 
@@ -382,13 +536,15 @@ int main( int argc, char *argv[] )
         for( i = 0; i < imageSet->num; i++ ) {
             ARPRINT("Start for %f dpi image.\n", imageSet->scale[i]->dpi);
             
-            featureMap = ar2GenFeatureMap( imageSet->scale[i],
+            featureMap = ar2GenFeatureMap2( imageSet->scale[i],
                                           AR2_DEFAULT_TS1*AR2_TEMP_SCALE, AR2_DEFAULT_TS2*AR2_TEMP_SCALE,
                                           AR2_DEFAULT_GEN_FEATURE_MAP_SEARCH_SIZE1, AR2_DEFAULT_GEN_FEATURE_MAP_SEARCH_SIZE2,
-                                          AR2_DEFAULT_MAX_SIM_THRESH2, AR2_DEFAULT_SD_THRESH2 );
+                                          AR2_DEFAULT_MAX_SIM_THRESH2, AR2_DEFAULT_SD_THRESH2, featureMapMode, featureMapThreadNum );
             if( featureMap == NULL ) {
                 ARPRINTE("Error!!\n");
-                EXIT(E_DATA_PROCESSING_ERROR);
+                featureSet->num = i; // Only the levels generated so far need freeing.
+                err = E_DATA_PROCESSING_ERROR;
+                goto done;
             }
             ARPRINT("  Done.\n");
             
@@ -445,7 +601,8 @@ int main( int argc, char *argv[] )
         ARPRINT("Saving FeatureSet...\n");
         if( ar2SaveFeatureSet( filename, "fset", featureSet ) < 0 ) {
             ARPRINTE("Save error: %s.fset\n", filename );
-            EXIT(E_DATA_PROCESSING_ERROR);
+            err = E_DATA_PROCESSING_ERROR;
+            goto done;
         }
         ARPRINT("  Done.\n");
         ar2FreeFeatureSet( &featureSet );
@@ -471,108 +628,293 @@ int main( int argc, char *argv[] )
                                   imageSet->scale[i]->dpi,
                                   procMode, KpmCompNull, maxFeatureNum, 1, i, &refDataSet) < 0 ) { // Page number set to 1 by default.
                 ARPRINTE("Error at kpmAddRefDataSet.\n");
-                EXIT(E_DATA_PROCESSING_ERROR);
+                err = E_DATA_PROCESSING_ERROR;
+                goto done;
             }
         }
         ARPRINT("  Done.\n");
         ARPRINT("Saving FeatureSet3...\n");
         if( kpmSaveRefDataSet(filename, "fset3", refDataSet) != 0 ) {
             ARPRINTE("Save error: %s.fset2\n", filename );
-            EXIT(E_DATA_PROCESSING_ERROR);
+            err = E_DATA_PROCESSING_ERROR;
+            goto done;
         }
         ARPRINT("  Done.\n");
-        kpmDeleteRefDataSet( &refDataSet );
     }
-    
+
+done:
+    if (featureSet) ar2FreeFeatureSet( &featureSet );
+    if (refDataSet) kpmDeleteRefDataSet( &refDataSet );
     ar2FreeImageSet( &imageSet );
+    return (err);
+}
 
-    // Print the start date and time.
-    clock = time(NULL);
-    if (clock != (time_t)-1) {
-        struct tm *timeptr = localtime(&clock);
-        if (timeptr) {
-            char stime[26+8] = "";
-            if (strftime(stime, sizeof(stime), "%Y-%m-%d %H:%M:%S %z", timeptr)) // e.g. "1999-12-31 23:59:59 NZDT".
-                ARPRINT("Generator finished at %s\n--\n", stime);
-        }
-    }
+static int hasJPEGExtension( const char *path )
+{
+    const char *sep = strrchr(path, '.');
+    return (sep && (!strcmp(sep, ".jpeg") || !strcmp(sep, ".jpg") || !strcmp(sep, ".jpe") || !strcmp(sep, ".JPEG") || !strcmp(sep, ".JPE") || !strcmp(sep, ".JPG")));
+}
 
-    exitcode = E_NO_ERROR;
-    return (exitcode);
+// Lowest resolution at which an image of the given size still meets KPM_MINIMUM_IMAGE_SIZE, truncated to 3 decimal places.
+static float getDPIMinAllowable( int xsize, int ysize, float dpi )
+{
+    return truncf(((float)KPM_MINIMUM_IMAGE_SIZE / (float)(MIN(xsize, ysize))) * dpi * 1000.0) / 1000.0f;
 }
 
-// Reads dpiMinAllowable, xsize, ysize, dpi, background, dpiMin, dpiMax.
-// Sets dpiMin, dpiMax, dpi_num, dpi_list.
-static int setDPI( void )
+static int isAbsolutePath( const char *path )
 {
-    float       dpiWork, dpiMinAllowable;
-    char		buf1[256];
-    int			i;
+#ifdef _WIN32
+    if( path[0] == '\\' || (path[0] && path[1] == ':') ) return (1);
+#endif
+    return (path[0] == '/');
+}
 
-    // Determine minimum allowable DPI, truncated to 3 decimal places.
-    dpiMinAllowable = truncf(((float)KPM_MINIMUM_IMAGE_SIZE / (float)(MIN(xsize, ysize))) * dpi * 1000.0) / 1000.0f;
-    
-    if (background) {
-        if (dpiMin == -1.0f) dpiMin = dpiMinAllowable;
-        if (dpiMax == -1.0f) dpiMax = dpi;
+// Parses the resolutions following the image path on a manifest line: none, minimum and maximum, or minimum,
+// maximum and source. Each must be a positive number, and nothing else may follow. Returns -1 if malformed.
+static int readBatchManifestDPIs( const char *s, BatchImage *bi )
+{
+    float *values[3] = {&bi->dpiMin, &bi->dpiMax, &bi->dpi};
+    char  *end;
+    int    n = 0;
+
+    bi->dpiMin = bi->dpiMax = bi->dpi = -1.0f;
+    for (;;) {
+        while( *s == ' ' || *s == '\t' ) s++;
+        if( *s == '\n' || *s == '\r' || *s == '\0' ) break;
+        if( n == 3 ) return (-1);
+        *values[n] = strtof(s, &end);
+        if( end == s || *values[n] <= 0.0f || (*end != ' ' && *end != '\t' && *end != '\n' && *end != '\r' && *end != '\0') ) return (-1);
+        s = end;
+        n++;
     }
+    if( n == 1 ) return (-1);
+    return (n);
+}
 
-    if (dpiMin == -1.0f) {
-        for (;;) {
-            printf("Enter the minimum image resolution (DPI, in range [%.3f, %.3f]): ", dpiMinAllowable, (dpiMax == -1.0f ? dpi : dpiMax));
-            if( fgets( buf1, 256, stdin ) == NULL ) EXIT(E_USER_INPUT_CANCELLED);
-            if( sscanf(buf1, "%f", &dpiMin) == 0 ) continue;
-            if (dpiMin >= dpiMinAllowable && dpiMin <= (dpiMax == -1.0f ? dpi : dpiMax)) break;
-            else printf("Error: you entered %.3f, but value must be greater than or equal to %.3f and less than or equal to %.3f.\n", dpiMin, dpiMinAllowable, (dpiMax == -1.0f ? dpi : dpiMax));
-        }
-    } else if (dpiMin < dpiMinAllowable) {
-        ARPRINTE("Warning: -min_dpi=%.3f smaller than minimum allowable. Value will be adjusted to %.3f.\n", dpiMin, dpiMinAllowable);
-        dpiMin = dpiMinAllowable;
+// Reads the manifest for -batch. Each line holds an image path, optionally followed by its minimum and maximum
+// resolution and its source resolution (all in DPI). Paths containing spaces must be enclosed in double quotes.
+// Relative paths are relative to the directory containing the manifest. Blank lines and lines beginning with '#'
+// are ignored.
+static int readBatchManifest( const char *path, BatchImage **images_p, int *imageNum_p )
+{
+    FILE       *fp;
+    char        line[MAXPATHLEN + 256];
+    char        dir[MAXPATHLEN];
+    char       *p, *end;
+    BatchImage *images = NULL;
+    int         imageNum = 0, lineNum = 0;
+    size_t      len, dirLen;
+
+    if( (fp = fopen(path, "r")) == NULL ) {
+        ARPRINTE("Error: unable to open batch manifest '%s'.\n", path);
+        return (E_INPUT_DATA_ERROR);
     }
-    if (dpiMax == -1.0f) {
-        for (;;) {
-            printf("Enter the maximum image resolution (DPI, in range [%.3f, %.3f]): ", dpiMin, dpi);
-            if( fgets( buf1, 256, stdin ) == NULL ) EXIT(E_USER_INPUT_CANCELLED);
-            if( sscanf(buf1, "%f", &dpiMax) == 0 ) continue;
-            if (dpiMax >= dpiMin && dpiMax <= dpi) break;
-            else printf("Error: you entered %.3f, but value must be greater than or equal to minimum resolution (%.3f) and less than or equal to image resolution (%.3f).\n", dpiMax, dpiMin, dpi);
+    if( !arUtilGetDirectoryNameFromPath(dir, path, sizeof(dir), 1) ) dir[0] = '\0';
+    dirLen = strlen(dir);
+    while( fgets(line, sizeof(line), fp) != NULL ) {
+        lineNum++;
+        p = line;
+        while( *p == ' ' || *p == '\t' ) p++;
+        if( *p == '#' || *p == '\n' || *p == '\r' || *p == '\0' ) continue;
+
+        if( *p == '"' ) {
+            p++;
+            end = strchr(p, '"');
+        } else {
+            end = p + strcspn(p, " \t\r\n");
         }
-    } else if (dpiMax > dpi) {
-        ARPRINTE("Warning: -max_dpi=%.3f larger than maximum allowable. Value will be adjusted to %.3f.\n", dpiMax, dpi);
-        dpiMax = dpi;
-    }
-    
-    // Decide how many levels we need.
-    if (dpiMin == dpiMax) {
-        dpi_num = 1;
-    } else {
-        dpiWork = dpiMin;
-        for( i = 1;; i++ ) {
-            dpiWork *= powf(2.0f, 1.0f/3.0f); // *= 1.25992104989487
-            if( dpiWork >= dpiMax*0.95f ) {
-                break;
+        if( !end || end == p || (len = end - p) >= MAXPATHLEN ) {
+            ARPRINTE("Error: bad image path on line %d of batch manifest '%s'.\n", lineNum, path);
+            goto bail;
+        }
+        images = (BatchImage *)realloc(images, sizeof(BatchImage)*(imageNum + 1));
+        if( !images ) {
+            ARPRINTE("Out of memory!!\n");
+            goto bail;
+        }
+        // Resolve relative paths here, so that they don't depend on the working directory, which -background changes.
+        memcpy(images[imageNum].filename, p, len);
+        images[imageNum].filename[len] = '\0';
+        if( !isAbsolutePath(images[imageNum].filename) && dirLen ) {
+            if( dirLen + len >= MAXPATHLEN ) {
+                ARPRINTE("Error: image path on line %d of batch manifest '%s' is too long.\n", lineNum, path);
+                goto bail;
             }
+            memmove(images[imageNum].filename + dirLen, images[imageNum].filename, len + 1);
+            memcpy(images[imageNum].filename, dir, dirLen);
+        }
+        if( !hasJPEGExtension(images[imageNum].filename) ) {
+            ARPRINTE("Error: image '%s' on line %d of batch manifest '%s' must be a JPEG image (with suffix .jpeg/.jpg/.jpe).\n", images[imageNum].filename, lineNum, path);
+            goto bail;
+        }
+        if( *end == '"' ) end++;
+        if( readBatchManifestDPIs(end, &images[imageNum]) < 0 ) {
+            ARPRINTE("Error: bad resolution on line %d of batch manifest '%s'. Expected <min_dpi> <max_dpi> [<dpi>].\n", lineNum, path);
+            goto bail;
         }
-        dpi_num = i + 1;
+        images[imageNum].err = E_NO_ERROR;
+        imageNum++;
     }
-    arMalloc(dpi_list, float, dpi_num);
-    
-    // Determine the DPI values of each level.
-    dpiWork = dpiMin;
-    for( i = 0; i < dpi_num; i++ ) {
-        ARPRINT("Image DPI (%d): %f\n", i+1, dpiWork);
-        dpi_list[dpi_num - i - 1] = dpiWork; // Lowest value goes at tail of array, highest at head.
-        dpiWork *= powf(2.0f, 1.0f/3.0f);
-        if( dpiWork >= dpiMax*0.95f ) dpiWork = dpiMax;
+    fclose(fp);
+    if( imageNum == 0 ) {
+        ARPRINTE("Error: no images listed in batch manifest '%s'.\n", path);
+        free(images);
+        return (E_INPUT_DATA_ERROR);
     }
+    *images_p = images;
+    *imageNum_p = imageNum;
+    return (E_NO_ERROR);
+
+bail:
+    fclose(fp);
+    free(images);
+    return (E_INPUT_DATA_ERROR);
+}
 
-    return 0;
+// Generates the data sets for one manifest entry without prompting. Resolutions not given in the manifest are taken
+// from the command line, then from the image itself, as for -background.
+static int genBatchImage( BatchQueue *queue, BatchImage *bi )
+{
+    AR2JpegImageT *jpeg;
+    char           name[MAXPATHLEN], ext[MAXPATHLEN];
+    float          imageDpi, minDpi, maxDpi, minAllowable;
+    float         *dpiList;
+    int            dpiNum;
+    int            err;
+
+    ar2UtilDivideExt( bi->filename, name, ext );
+    jpeg = ar2ReadJpegImage( name, ext );
+    if( jpeg == NULL ) {
+        ARPRINTE("Error: unable to read JPEG image from file '%s'.\n", bi->filename);
+        return (E_INPUT_DATA_ERROR);
+    }
+    if( jpeg->nc != 1 && jpeg->nc != 3 ) {
+        ARPRINTE("Error: JPEG image '%s' is in neither RGB nor grayscale format.\n", bi->filename);
+        err = E_INPUT_DATA_ERROR;
+        goto bail;
+    }
+    if( jpeg->xsize < KPM_MINIMUM_IMAGE_SIZE || jpeg->ysize < KPM_MINIMUM_IMAGE_SIZE ) {
+        ARPRINTE("Error: JPEG image '%s' width and height must be at least %d pixels.\n", bi->filename, KPM_MINIMUM_IMAGE_SIZE);
+        err = E_INPUT_DATA_ERROR;
+        goto bail;
+    }
+
+    imageDpi = (bi->dpi > 0.0f ? bi->dpi : (dpi > 0.0f ? dpi : jpeg->dpi));
+    if( imageDpi <= 0.0f ) {
+        ARPRINTE("Error: JPEG image '%s' does not contain embedded resolution data, and none was given in the manifest or with -dpi.\n", bi->filename);
+        err = E_INPUT_DATA_ERROR;
+        goto bail;
+    }
+    minAllowable = getDPIMinAllowable( jpeg->xsize, jpeg->ysize, imageDpi );
+    minDpi = (bi->dpiMin > 0.0f ? bi->dpiMin : (dpiMin > 0.0f ? dpiMin : minAllowable));
+    maxDpi = (bi->dpiMax > 0.0f ? bi->dpiMax : (dpiMax > 0.0f ? dpiMax : imageDpi));
+    if( minDpi < minAllowable ) {
+        ARPRINTE("Warning: minimum resolution %.3f for '%s' smaller than minimum allowable. Value will be adjusted to %.3f.\n", minDpi, bi->filename, minAllowable);
+        minDpi = minAllowable;
+    }
+    if( maxDpi > imageDpi ) {
+        ARPRINTE("Warning: maximum resolution %.3f for '%s' larger than maximum allowable. Value will be adjusted to %.3f.\n", maxDpi, bi->filename, imageDpi);
+        maxDpi = imageDpi;
+    }
+    if( maxDpi < minDpi ) {
+        ARPRINTE("Error: maximum resolution %.3f for '%s' is less than minimum resolution %.3f.\n", maxDpi, bi->filename, minDpi);
+        err = E_BAD_PARAMETER;
+        goto bail;
+    }
+    genDPIList( minDpi, maxDpi, &dpiList, &dpiNum );
+
+    strcpy( name, bi->filename );
+    ar2UtilRemoveExt( name );
+    err = genDataSets( name, &jpeg, imageDpi, dpiList, dpiNum, queue->featureMapThreadNum );
+    free( dpiList );
+
+bail:
+    if( jpeg ) ar2FreeJpegImage( &jpeg );
+    return (err);
+}
+
+static void genBatchImages( BatchQueue *queue )
+{
+    int i;
+
+    for (;;) {
+        pthread_mutex_lock(&queue->lock);
+        i = queue->next++;
+        pthread_mutex_unlock(&queue->lock);
+        if( i >= queue->imageNum ) break;
+
+        ARPRINT("Batch: starting '%s' (%d of %d).\n", queue->images[i].filename, i + 1, queue->imageNum);
+        queue->images[i].err = genBatchImage( queue, &(queue->images[i]) );
+        if( queue->images[i].err == E_NO_ERROR ) ARPRINT("Batch: finished '%s'.\n", queue->images[i].filename);
+        else ARPRINTE("Batch: failed '%s' (error %d).\n", queue->images[i].filename, queue->images[i].err);
+    }
+}
+
+static void *genBatchWorker( THREAD_HANDLE_T *threadHandle )
+{
+    BatchQueue *queue = (BatchQueue *)threadGetArg(threadHandle);
+
+    while( threadStartWait(threadHandle) == 0 ) {
+        genBatchImages( queue );
+        threadEndSignal(threadHandle);
+    }
+    return (NULL);
+}
+
+// Processes every image in the manifest on a pool of threadNum threads, one image per thread at a time.
+// Any threads left over when there are fewer images than threads are given to feature map generation.
+// Returns E_NO_ERROR if all images succeeded, otherwise the first error in manifest order.
+static int genBatch( const char *manifest )
+{
+    BatchQueue       queue;
+    THREAD_HANDLE_T *threadHandle[GEN_TEX_DATA_BATCH_THREAD_MAX];
+    int              workerNum, succeeded;
+    int              i, err;
+
+    if( (err = readBatchManifest(manifest, &queue.images, &queue.imageNum)) != E_NO_ERROR ) return (err);
+    queue.next = 0;
+    pthread_mutex_init(&queue.lock, NULL);
+
+    if( threadNum < 1 ) threadNum = threadGetCPU();
+    workerNum = MIN(threadNum, queue.imageNum);
+    if( workerNum > GEN_TEX_DATA_BATCH_THREAD_MAX ) workerNum = GEN_TEX_DATA_BATCH_THREAD_MAX;
+    if( workerNum < 1 ) workerNum = 1;
+    queue.featureMapThreadNum = (threadNum > workerNum ? threadNum / workerNum : 1);
+    ARPRINT("Batch: %d images, %d worker threads.\n", queue.imageNum, workerNum);
+
+    // The calling thread acts as worker 0.
+    for( i = 1; i < workerNum; i++ ) {
+        if( (threadHandle[i] = threadInit(i, &queue, genBatchWorker)) == NULL ) {
+            ARPRINTE("Unable to start batch worker thread.\n");
+            workerNum = i;
+            break;
+        }
+    }
+    for( i = 1; i < workerNum; i++ ) threadStartSignal( threadHandle[i] );
+    genBatchImages( &queue );
+    for( i = 1; i < workerNum; i++ ) {
+        threadEndWait( threadHandle[i] );
+        threadWaitQuit( threadHandle[i] );
+        threadFree( &threadHandle[i] );
+    }
+    pthread_mutex_destroy(&queue.lock);
+
+    succeeded = 0;
+    err = E_NO_ERROR;
+    for( i = 0; i < queue.imageNum; i++ ) {
+        if( queue.images[i].err == E_NO_ERROR ) succeeded++;
+        else if( err == E_NO_ERROR ) err = queue.images[i].err;
+    }
+    ARPRINT("Batch: generated data sets for %d of %d images.\n", succeeded, queue.imageNum);
+    free(queue.images);
+    return (err);
 }
 
 static void usage( char *com )
 {
     if (!background) {
         ARPRINT("%s <filename>\n", com);
+        ARPRINT("%s -batch=<manifest>\n", com);
         ARPRINT("    -level=n\n"
               "         (n is an integer in range 0 (few) to 4 (many). Default %d.'\n", TRACKING_EXTRACTION_LEVEL_DEFAULT);
         ARPRINT("    -sd_thresh=<sd_thresh>\n");
@@ -584,6 +926,15 @@ static void usage( char *com )
         ARPRINT("    -dpi=f: Override embedded JPEG DPI value.\n");
         ARPRINT("    -max_dpi=<max_dpi>\n");
         ARPRINT("    -min_dpi=<min_dpi>\n");
+        ARPRINT("    -fmap_incremental\n");
+        ARPRINT("         Compute feature maps with running window sums. Much faster; scores may differ by up to about 2e-3.\n");
+        ARPRINT("    -batch=<manifest>\n");
+        ARPRINT("         Generate data sets for each image listed in the manifest instead of a single input file.\n");
+        ARPRINT("         Each line is: <image path> [<min_dpi> <max_dpi> [<dpi>]]. Quote paths containing spaces.\n");
+        ARPRINT("         Relative image paths are relative to the manifest's directory.\n");
+        ARPRINT("         Values not given fall back to -min_dpi, -max_dpi and -dpi, then to the image's own limits.\n");
+        ARPRINT("    -threads=n\n");
+        ARPRINT("         Number of threads for -batch. Default is one per CPU.\n");
         ARPRINT("    -background\n");
         ARPRINT("         Run in background, i.e. as daemon detached from controlling terminal. (macOS and Linux only.)\n");
         ARPRINT("    -log=<path>\n");